@@ -0,0 +1,427 @@
+///////////////////////////////////////////////////////////////////////////////
+// assetpack.cpp
+// ============
+// memory mapped archive of the shaders, meshes and textures of the scene
+///////////////////////////////////////////////////////////////////////////////
+
+#include "AssetPack.h"
+#include "CompressedTexture.h"
+#include "TextureArrays.h"
+#include "TextureLoader.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+// declare the global variables
+namespace
+{
+	const int BYTES_PER_PIXEL = 4;
+
+	/***********************************************************
+	 *  AppendBytes()
+	 *
+	 *  Add raw bytes to the end of a payload.
+	 ***********************************************************/
+	void AppendBytes(std::vector<unsigned char>& payload, const void* data, size_t size)
+	{
+		const unsigned char* bytes = (const unsigned char*)data;
+		payload.insert(payload.end(), bytes, bytes + size);
+	}
+}
+
+/***********************************************************
+ *  AssetPack()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+AssetPack::AssetPack()
+{
+	m_pData = NULL;
+	m_size = 0;
+	m_pEntries = NULL;
+	m_entryCount = 0;
+}
+
+/***********************************************************
+ *  ~AssetPack()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+AssetPack::~AssetPack()
+{
+	Close();
+}
+
+/***********************************************************
+ *  Open()
+ *
+ *  This method is used to map a pack file into memory and
+ *  to check that its index only points inside the file.
+ *  Nothing is read yet - the pages are loaded by the system
+ *  as the payloads are used.
+ ***********************************************************/
+bool AssetPack::Open(const std::string& filename)
+{
+	Close();
+
+	// a missing pack is not an error unless it was asked for
+	if (m_file.Open(filename) == false)
+	{
+		return false;
+	}
+	m_pData = m_file.GetData();
+	m_size = m_file.GetSize();
+
+	const PACK_HEADER* pHeader = (const PACK_HEADER*)m_pData;
+	if ((m_size < sizeof(PACK_HEADER)) || (pHeader->magic != PACK_MAGIC) || (pHeader->version != PACK_VERSION) ||
+		(pHeader->entryCount > (m_size - sizeof(PACK_HEADER)) / sizeof(PACK_ENTRY)))
+	{
+		std::cout << "Not a valid asset pack:" << filename << std::endl;
+		Close();
+		return false;
+	}
+
+	m_pEntries = (const PACK_ENTRY*)(m_pData + sizeof(PACK_HEADER));
+	m_entryCount = pHeader->entryCount;
+
+	for (uint32_t i = 0; i < m_entryCount; i++)
+	{
+		const PACK_ENTRY& entry = m_pEntries[i];
+		if ((entry.offset > m_size) || (entry.size > m_size - entry.offset) ||
+			(entry.offset % PAYLOAD_ALIGNMENT != 0) || (entry.name[MAX_NAME_LENGTH - 1] != '\0'))
+		{
+			std::cout << "Asset pack index is damaged:" << filename << std::endl;
+			Close();
+			return false;
+		}
+	}
+
+	std::cout << "Mapped asset pack " << filename << ": " << m_entryCount << " entries, "
+		<< m_size / 1024 << " KB" << std::endl;
+
+	return true;
+}
+
+/***********************************************************
+ *  Close()
+ *
+ *  This method is used to unmap the pack file.
+ ***********************************************************/
+void AssetPack::Close()
+{
+	m_file.Close();
+
+	m_pData = NULL;
+	m_size = 0;
+	m_pEntries = NULL;
+	m_entryCount = 0;
+}
+
+/***********************************************************
+ *  IsOpen()
+ *
+ *  This method is used to check whether a pack is mapped.
+ ***********************************************************/
+bool AssetPack::IsOpen() const
+{
+	return m_pData != NULL;
+}
+
+/***********************************************************
+ *  FindEntry()
+ *
+ *  This method is used to find the payload of the entry
+ *  with the passed in type and name.
+ ***********************************************************/
+bool AssetPack::FindEntry(ENTRY_TYPE type, const std::string& name, const unsigned char*& payload, size_t& size) const
+{
+	for (uint32_t i = 0; i < m_entryCount; i++)
+	{
+		const PACK_ENTRY& entry = m_pEntries[i];
+		if ((entry.type == (uint32_t)type) && (name == entry.name))
+		{
+			payload = m_pData + entry.offset;
+			size = (size_t)entry.size;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/***********************************************************
+ *  FindShader()
+ *
+ *  This method is used to find the source text of a shader
+ *  by the name of its file.
+ ***********************************************************/
+bool AssetPack::FindShader(const std::string& name, const char*& source, GLint& length) const
+{
+	const unsigned char* payload = NULL;
+	size_t size = 0;
+
+	if (FindEntry(ENTRY_SHADER, name, payload, size) == false)
+	{
+		return false;
+	}
+
+	source = (const char*)payload;
+	length = (GLint)size;
+	return true;
+}
+
+/***********************************************************
+ *  FindMesh()
+ *
+ *  This method is used to find the vertex and index data of
+ *  a mesh by its name.
+ ***********************************************************/
+bool AssetPack::FindMesh(const std::string& name, MESH_VIEW& mesh) const
+{
+	const unsigned char* payload = NULL;
+	size_t size = 0;
+
+	if ((FindEntry(ENTRY_MESH, name, payload, size) == false) || (size < sizeof(MESH_HEADER)))
+	{
+		return false;
+	}
+
+	const MESH_HEADER* pHeader = (const MESH_HEADER*)payload;
+	size_t vertexBytes = (size_t)pHeader->vertexCount * pHeader->floatsPerVertex * sizeof(GLfloat);
+	size_t indexBytes = (size_t)pHeader->indexCount * sizeof(GLuint);
+	if (sizeof(MESH_HEADER) + vertexBytes + indexBytes != size)
+	{
+		std::cout << "Asset pack mesh has the wrong size:" << name << std::endl;
+		return false;
+	}
+
+	mesh.vertices = (const GLfloat*)(payload + sizeof(MESH_HEADER));
+	mesh.vertexCount = pHeader->vertexCount;
+	mesh.floatsPerVertex = pHeader->floatsPerVertex;
+	mesh.indices = (const GLuint*)(payload + sizeof(MESH_HEADER) + vertexBytes);
+	mesh.indexCount = pHeader->indexCount;
+	return true;
+}
+
+/***********************************************************
+ *  FindTexture()
+ *
+ *  This method is used to find a texture by the file name of
+ *  the image it was made from.
+ ***********************************************************/
+bool AssetPack::FindTexture(const std::string& name, TEXTURE_VIEW& texture) const
+{
+	const unsigned char* payload = NULL;
+	size_t size = 0;
+
+	if ((FindEntry(ENTRY_TEXTURE, name, payload, size) == false) || (size < sizeof(TEXTURE_HEADER)))
+	{
+		return false;
+	}
+
+	const TEXTURE_HEADER* pHeader = (const TEXTURE_HEADER*)payload;
+	texture.width = pHeader->width;
+	texture.height = pHeader->height;
+	texture.internalFormat = (GLenum)pHeader->internalFormat;
+	texture.levelCount = pHeader->levelCount;
+	texture.data = payload + sizeof(TEXTURE_HEADER);
+	texture.size = size - sizeof(TEXTURE_HEADER);
+
+	if ((texture.internalFormat == GL_RGBA8) &&
+		(texture.size != (size_t)texture.width * texture.height * BYTES_PER_PIXEL))
+	{
+		std::cout << "Asset pack texture has the wrong size:" << name << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+/***********************************************************
+ *  GetEntryName()
+ *
+ *  This method is used to get the name of the entry for a
+ *  file, which is the file name without its folders, so the
+ *  pack does not depend on where the files were packed from.
+ ***********************************************************/
+std::string AssetPack::GetEntryName(const std::string& filename)
+{
+	size_t folder = filename.find_last_of("/\\");
+	return (folder == std::string::npos) ? filename : filename.substr(folder + 1);
+}
+
+/***********************************************************
+ *  AddEntry()
+ *
+ *  This method is used to add an entry to the pack and to
+ *  get its payload to fill in.
+ ***********************************************************/
+std::vector<unsigned char>& AssetPackWriter::AddEntry(const std::string& name, AssetPack::ENTRY_TYPE type)
+{
+	PENDING_ENTRY entry;
+	entry.name = name;
+	entry.type = type;
+	m_entries.push_back(entry);
+
+	return m_entries.back().payload;
+}
+
+/***********************************************************
+ *  AddShaderFile()
+ *
+ *  This method is used to add the source text of a shader.
+ ***********************************************************/
+bool AssetPackWriter::AddShaderFile(const std::string& filename)
+{
+	std::ifstream file(filename, std::ios::binary);
+	if (!file)
+	{
+		std::cout << "ERROR: could not open shader file:" << filename << std::endl;
+		return false;
+	}
+
+	std::stringstream buffer;
+	buffer << file.rdbuf();
+	std::string source = buffer.str();
+
+	std::vector<unsigned char>& payload = AddEntry(AssetPack::GetEntryName(filename), AssetPack::ENTRY_SHADER);
+	AppendBytes(payload, source.data(), source.size());
+
+	return true;
+}
+
+/***********************************************************
+ *  AddMesh()
+ *
+ *  This method is used to add the vertex and index buffers
+ *  of a mesh.
+ ***********************************************************/
+void AssetPackWriter::AddMesh(const std::string& name, const std::vector<GLfloat>& vertices,
+	int floatsPerVertex, const std::vector<GLuint>& indices)
+{
+	AssetPack::MESH_HEADER header;
+	header.vertexCount = (uint32_t)(vertices.size() / floatsPerVertex);
+	header.indexCount = (uint32_t)indices.size();
+	header.floatsPerVertex = (uint32_t)floatsPerVertex;
+	header.reserved = 0;
+
+	std::vector<unsigned char>& payload = AddEntry(name, AssetPack::ENTRY_MESH);
+	AppendBytes(payload, &header, sizeof(header));
+	AppendBytes(payload, vertices.data(), vertices.size() * sizeof(GLfloat));
+	AppendBytes(payload, indices.data(), indices.size() * sizeof(GLuint));
+}
+
+/***********************************************************
+ *  AddTextureFile()
+ *
+ *  This method is used to add a texture.  When the image has
+ *  a DDS file next to it, its compressed mipmap levels are
+ *  added, otherwise the image is decoded, flipped and
+ *  resized to the size of its array layer.
+ ***********************************************************/
+bool AssetPackWriter::AddTextureFile(const std::string& filename)
+{
+	AssetPack::TEXTURE_HEADER header;
+	std::vector<unsigned char> pixels;
+	const unsigned char* pData = NULL;
+	size_t dataSize = 0;
+
+	CompressedTexture compressed;
+	std::string compressedFilename = CompressedTexture::GetCompressedFilename(filename);
+	if (compressed.ReadHeader(compressedFilename) && compressed.Read(compressedFilename))
+	{
+		header.width = (uint32_t)compressed.GetWidth();
+		header.height = (uint32_t)compressed.GetHeight();
+		header.internalFormat = (uint32_t)compressed.GetInternalFormat();
+		header.levelCount = (uint32_t)compressed.GetLevelCount();
+		pData = compressed.GetData().data();
+		dataSize = compressed.GetData().size();
+	}
+	else
+	{
+		int width = 0;
+		int height = 0;
+		int channels = 0;
+		if (TextureLoader::DecodeImage(filename, pixels, width, height, channels) == false)
+		{
+			std::cout << "Could not load image:" << filename << std::endl;
+			return false;
+		}
+		TextureArrays::ResizeToPowerOfTwo(pixels, width, height);
+
+		header.width = (uint32_t)width;
+		header.height = (uint32_t)height;
+		header.internalFormat = GL_RGBA8;
+		header.levelCount = 1;
+		pData = pixels.data();
+		dataSize = pixels.size();
+	}
+
+	std::vector<unsigned char>& payload = AddEntry(AssetPack::GetEntryName(filename), AssetPack::ENTRY_TEXTURE);
+	AppendBytes(payload, &header, sizeof(header));
+	AppendBytes(payload, pData, dataSize);
+
+	return true;
+}
+
+/***********************************************************
+ *  Write()
+ *
+ *  This method is used to write the header, the index and
+ *  the aligned payloads of all of the entries to a file.
+ ***********************************************************/
+bool AssetPackWriter::Write(const std::string& filename) const
+{
+	AssetPack::PACK_HEADER header;
+	header.magic = AssetPack::PACK_MAGIC;
+	header.version = AssetPack::PACK_VERSION;
+	header.entryCount = (uint32_t)m_entries.size();
+	header.reserved = 0;
+
+	// the payloads follow the index, each one aligned
+	std::vector<AssetPack::PACK_ENTRY> index(m_entries.size());
+	uint64_t offset = sizeof(header) + index.size() * sizeof(AssetPack::PACK_ENTRY);
+	for (size_t i = 0; i < m_entries.size(); i++)
+	{
+		if (m_entries[i].name.size() >= AssetPack::MAX_NAME_LENGTH)
+		{
+			std::cout << "Asset name is too long for the pack:" << m_entries[i].name << std::endl;
+			return false;
+		}
+
+		offset = (offset + AssetPack::PAYLOAD_ALIGNMENT - 1) / AssetPack::PAYLOAD_ALIGNMENT * AssetPack::PAYLOAD_ALIGNMENT;
+
+		memset(&index[i], 0, sizeof(AssetPack::PACK_ENTRY));
+		memcpy(index[i].name, m_entries[i].name.c_str(), m_entries[i].name.size());
+		index[i].type = (uint32_t)m_entries[i].type;
+		index[i].offset = offset;
+		index[i].size = m_entries[i].payload.size();
+
+		offset += m_entries[i].payload.size();
+	}
+
+	std::ofstream file(filename, std::ios::binary);
+	file.write((const char*)&header, sizeof(header));
+	file.write((const char*)index.data(), (std::streamsize)(index.size() * sizeof(AssetPack::PACK_ENTRY)));
+
+	const char padding[AssetPack::PAYLOAD_ALIGNMENT] = {};
+	for (size_t i = 0; i < m_entries.size(); i++)
+	{
+		std::streamoff position = file.tellp();
+		file.write(padding, (std::streamsize)(index[i].offset - (uint64_t)position));
+		file.write((const char*)m_entries[i].payload.data(), (std::streamsize)m_entries[i].payload.size());
+	}
+
+	if (!file)
+	{
+		std::cout << "Could not write asset pack:" << filename << std::endl;
+		return false;
+	}
+
+	std::cout << "Wrote asset pack " << filename << ": " << m_entries.size() << " entries, "
+		<< offset / 1024 << " KB" << std::endl;
+
+	return true;
+}
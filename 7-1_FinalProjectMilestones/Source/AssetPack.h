@@ -0,0 +1,180 @@
+///////////////////////////////////////////////////////////////////////////////
+// assetpack.h
+// ============
+// memory mapped archive of the shaders, meshes and textures of the scene
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "MappedFile.h"
+
+#include <GL/glew.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  AssetPack
+ *
+ *  This class opens a packed asset file by mapping it into
+ *  memory.  The file starts with an index of named entries,
+ *  followed by the payloads: shader sources, meshes with
+ *  their vertex and index buffers already built, and
+ *  textures already flipped, resized and optionally block
+ *  compressed.  The payloads are handed to OpenGL straight
+ *  from the mapped pages, so loading the scene reads no
+ *  files and parses nothing.
+ *
+ *  AssetPackWriter builds the file offline.
+ ***********************************************************/
+class AssetPack
+{
+public:
+	// kinds of entries in the pack
+	enum ENTRY_TYPE
+	{
+		ENTRY_SHADER = 1,
+		ENTRY_MESH = 2,
+		ENTRY_TEXTURE = 3
+	};
+
+	// a mesh in the pack - the vertices are interleaved
+	// position, normal and texture coordinate floats
+	struct MESH_VIEW
+	{
+		const GLfloat* vertices;
+		uint32_t vertexCount;
+		uint32_t floatsPerVertex;
+		const GLuint* indices;
+		uint32_t indexCount;
+	};
+
+	// a texture in the pack, with its rows stored bottom up -
+	// RGBA8 textures hold one level, compressed ones hold the
+	// blocks of every mipmap level
+	struct TEXTURE_VIEW
+	{
+		uint32_t width;
+		uint32_t height;
+		GLenum internalFormat;
+		uint32_t levelCount;
+		const unsigned char* data;
+		size_t size;
+	};
+
+	// constructor
+	AssetPack();
+	// destructor
+	~AssetPack();
+
+	// map a pack file into memory and check its index
+	bool Open(const std::string& filename);
+	// unmap the pack file - the views found in it become invalid
+	void Close();
+	bool IsOpen() const;
+
+	// find the source text of a shader by its file name
+	bool FindShader(const std::string& name, const char*& source, GLint& length) const;
+	// find a mesh by its name
+	bool FindMesh(const std::string& name, MESH_VIEW& mesh) const;
+	// find a texture by the file name of its image
+	bool FindTexture(const std::string& name, TEXTURE_VIEW& texture) const;
+
+	// the name of an entry for a file path, without folders
+	static std::string GetEntryName(const std::string& filename);
+
+private:
+	friend class AssetPackWriter;
+
+	// identifies the file and the version of its layout
+	static const uint32_t PACK_MAGIC = 0x4B505343;	// "CSPK"
+	static const uint32_t PACK_VERSION = 1;
+	// every payload starts on this boundary in the file
+	static const uint32_t PAYLOAD_ALIGNMENT = 16;
+	static const int MAX_NAME_LENGTH = 48;
+
+	// start of the file
+	struct PACK_HEADER
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t entryCount;
+		uint32_t reserved;
+	};
+
+	// one entry of the index that follows the header
+	struct PACK_ENTRY
+	{
+		char name[MAX_NAME_LENGTH];
+		uint32_t type;
+		uint32_t reserved;
+		uint64_t offset;
+		uint64_t size;
+	};
+
+	// start of a mesh payload, followed by the vertices and
+	// then the indices
+	struct MESH_HEADER
+	{
+		uint32_t vertexCount;
+		uint32_t indexCount;
+		uint32_t floatsPerVertex;
+		uint32_t reserved;
+	};
+
+	// start of a texture payload, followed by the levels
+	struct TEXTURE_HEADER
+	{
+		uint32_t width;
+		uint32_t height;
+		uint32_t internalFormat;
+		uint32_t levelCount;
+	};
+
+	MappedFile m_file;
+	const unsigned char* m_pData;
+	size_t m_size;
+	const PACK_ENTRY* m_pEntries;
+	uint32_t m_entryCount;
+
+	// find the payload of an entry by its type and name
+	bool FindEntry(ENTRY_TYPE type, const std::string& name, const unsigned char*& payload, size_t& size) const;
+};
+
+/***********************************************************
+ *  AssetPackWriter
+ *
+ *  This class collects the assets of the scene and writes
+ *  them into a pack file in the layout AssetPack reads.
+ ***********************************************************/
+class AssetPackWriter
+{
+public:
+	// add the source text of a shader file
+	bool AddShaderFile(const std::string& filename);
+	// add a mesh with interleaved vertices and indices
+	void AddMesh(const std::string& name, const std::vector<GLfloat>& vertices,
+		int floatsPerVertex, const std::vector<GLuint>& indices);
+	// add a texture image, using the blocks of its DDS file
+	// when there is one, or else its RGBA pixels resized to
+	// powers of two
+	bool AddTextureFile(const std::string& filename);
+
+	// write all of the added entries to a pack file
+	bool Write(const std::string& filename) const;
+
+private:
+	// an entry and its payload waiting to be written
+	struct PENDING_ENTRY
+	{
+		std::string name;
+		AssetPack::ENTRY_TYPE type;
+		std::vector<unsigned char> payload;
+	};
+
+	std::vector<PENDING_ENTRY> m_entries;
+
+	// add an entry and return its payload to fill in
+	std::vector<unsigned char>& AddEntry(const std::string& name, AssetPack::ENTRY_TYPE type);
+};
@@ -0,0 +1,469 @@
+///////////////////////////////////////////////////////////////////////////////
+// benchmarkrunner.cpp
+// ============
+// render the 3D scene headless for a fixed number of frames and report
+// the measured frame timings as machine-readable JSON
+///////////////////////////////////////////////////////////////////////////////
+
+#include "BenchmarkRunner.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+#ifdef _WIN32
+#include "GLFW/glfw3.h"
+#else
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+// declaration of the global variables and defines
+namespace
+{
+#ifdef _WIN32
+	// hidden window that owns the offscreen context
+	GLFWwindow* g_pHiddenWindow = nullptr;
+#else
+	// surfaceless EGL display and context
+	EGLDisplay g_eglDisplay = EGL_NO_DISPLAY;
+	EGLContext g_eglContext = EGL_NO_CONTEXT;
+
+	// context versions to try, newest first - llvmpipe may not
+	// expose the same version as the desktop drivers
+	const int g_contextVersions[][2] = { { 4, 6 }, { 4, 5 }, { 4, 3 }, { 3, 3 } };
+#endif
+
+	// convert the time between two clock samples into milliseconds
+	double ElapsedMilliseconds(
+		std::chrono::steady_clock::time_point start,
+		std::chrono::steady_clock::time_point end)
+	{
+		return std::chrono::duration<double, std::milli>(end - start).count();
+	}
+}
+
+/***********************************************************
+ *  BenchmarkRunner()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+BenchmarkRunner::BenchmarkRunner(const BENCHMARK_SETTINGS& settings)
+{
+	m_settings = settings;
+	m_framebufferID = 0;
+	m_colorBufferID = 0;
+	m_depthBufferID = 0;
+	m_primitivesQueryID = 0;
+}
+
+/***********************************************************
+ *  ~BenchmarkRunner()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+BenchmarkRunner::~BenchmarkRunner()
+{
+	DestroyFramebuffer();
+}
+
+/***********************************************************
+ *  CreateHeadlessContext()
+ *
+ *  This method is used to create an OpenGL context that can
+ *  render without a display.  On Linux a surfaceless EGL
+ *  context is used, which works with the Mesa llvmpipe
+ *  software renderer on machines without a GPU.
+ ***********************************************************/
+bool BenchmarkRunner::CreateHeadlessContext()
+{
+#ifdef _WIN32
+	// EGL is not generally available on Windows, so render
+	// through a window that is never shown
+	glfwInit();
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+	g_pHiddenWindow = glfwCreateWindow(64, 64, "benchmark", NULL, NULL);
+	if (g_pHiddenWindow == NULL)
+	{
+		std::cerr << "Failed to create hidden GLFW window" << std::endl;
+		glfwTerminate();
+		return false;
+	}
+	glfwMakeContextCurrent(g_pHiddenWindow);
+	glfwSwapInterval(0);
+
+	return true;
+#else
+	// prefer the Mesa surfaceless platform, which needs neither
+	// an X server nor a GPU device
+	PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+		(PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+	if (getPlatformDisplay != NULL)
+	{
+		g_eglDisplay = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+	}
+	if (g_eglDisplay == EGL_NO_DISPLAY)
+	{
+		g_eglDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	}
+
+	EGLint major = 0;
+	EGLint minor = 0;
+	if ((g_eglDisplay == EGL_NO_DISPLAY) || (eglInitialize(g_eglDisplay, &major, &minor) == EGL_FALSE))
+	{
+		std::cerr << "Failed to initialize EGL display" << std::endl;
+		return false;
+	}
+
+	if (eglBindAPI(EGL_OPENGL_API) == EGL_FALSE)
+	{
+		std::cerr << "EGL does not support desktop OpenGL" << std::endl;
+		eglTerminate(g_eglDisplay);
+		return false;
+	}
+
+	// no surface is ever created, so accept any surface type
+	const EGLint configAttributes[] = {
+		EGL_SURFACE_TYPE, 0,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_NONE };
+	EGLConfig config = NULL;
+	EGLint numConfigs = 0;
+	eglChooseConfig(g_eglDisplay, configAttributes, &config, 1, &numConfigs);
+	if (numConfigs == 0)
+	{
+		// relies on EGL_KHR_no_config_context
+		config = (EGLConfig)0;
+	}
+
+	for (int i = 0; (i < 4) && (g_eglContext == EGL_NO_CONTEXT); i++)
+	{
+		const EGLint contextAttributes[] = {
+			EGL_CONTEXT_MAJOR_VERSION, g_contextVersions[i][0],
+			EGL_CONTEXT_MINOR_VERSION, g_contextVersions[i][1],
+			EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+			EGL_NONE };
+		g_eglContext = eglCreateContext(g_eglDisplay, config, EGL_NO_CONTEXT, contextAttributes);
+	}
+
+	if (g_eglContext == EGL_NO_CONTEXT)
+	{
+		std::cerr << "Failed to create EGL OpenGL context" << std::endl;
+		eglTerminate(g_eglDisplay);
+		return false;
+	}
+
+	// relies on EGL_KHR_surfaceless_context - all rendering goes
+	// into the benchmark framebuffer object
+	if (eglMakeCurrent(g_eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, g_eglContext) == EGL_FALSE)
+	{
+		std::cerr << "Failed to make the surfaceless EGL context current" << std::endl;
+		DestroyHeadlessContext();
+		return false;
+	}
+
+	return true;
+#endif
+}
+
+/***********************************************************
+ *  DestroyHeadlessContext()
+ *
+ *  This method is used to release the headless context.
+ ***********************************************************/
+void BenchmarkRunner::DestroyHeadlessContext()
+{
+#ifdef _WIN32
+	if (g_pHiddenWindow != NULL)
+	{
+		glfwDestroyWindow(g_pHiddenWindow);
+		g_pHiddenWindow = NULL;
+	}
+	glfwTerminate();
+#else
+	if (g_eglDisplay != EGL_NO_DISPLAY)
+	{
+		eglMakeCurrent(g_eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		if (g_eglContext != EGL_NO_CONTEXT)
+		{
+			eglDestroyContext(g_eglDisplay, g_eglContext);
+			g_eglContext = EGL_NO_CONTEXT;
+		}
+		eglTerminate(g_eglDisplay);
+		g_eglDisplay = EGL_NO_DISPLAY;
+	}
+#endif
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used to create the offscreen render
+ *  target and make it the viewport, before the scene is
+ *  prepared.
+ ***********************************************************/
+bool BenchmarkRunner::Initialize()
+{
+	return CreateFramebuffer();
+}
+
+/***********************************************************
+ *  CreateFramebuffer()
+ *
+ *  This method is used to create the offscreen color and
+ *  depth buffers that the benchmark frames are rendered to.
+ ***********************************************************/
+bool BenchmarkRunner::CreateFramebuffer()
+{
+	glGenRenderbuffers(1, &m_colorBufferID);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_colorBufferID);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, m_settings.width, m_settings.height);
+
+	glGenRenderbuffers(1, &m_depthBufferID);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_depthBufferID);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, m_settings.width, m_settings.height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &m_framebufferID);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebufferID);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_colorBufferID);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_depthBufferID);
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cerr << "Benchmark framebuffer is incomplete" << std::endl;
+		return false;
+	}
+
+	glViewport(0, 0, m_settings.width, m_settings.height);
+	glGenQueries(1, &m_primitivesQueryID);
+
+	return true;
+}
+
+/***********************************************************
+ *  DestroyFramebuffer()
+ *
+ *  This method is used to free the offscreen render target.
+ ***********************************************************/
+void BenchmarkRunner::DestroyFramebuffer()
+{
+	if (m_primitivesQueryID != 0)
+	{
+		glDeleteQueries(1, &m_primitivesQueryID);
+		m_primitivesQueryID = 0;
+	}
+	if (m_framebufferID != 0)
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glDeleteFramebuffers(1, &m_framebufferID);
+		m_framebufferID = 0;
+	}
+	if (m_colorBufferID != 0)
+	{
+		glDeleteRenderbuffers(1, &m_colorBufferID);
+		m_colorBufferID = 0;
+	}
+	if (m_depthBufferID != 0)
+	{
+		glDeleteRenderbuffers(1, &m_depthBufferID);
+		m_depthBufferID = 0;
+	}
+}
+
+/***********************************************************
+ *  Run()
+ *
+ *  This method is used to render the warmup and measured
+ *  frames into the offscreen framebuffer.  Every frame is
+ *  finished with glFinish() so the frame time includes the
+ *  GPU work, while the CPU time only covers issuing it.
+ *  std::cout only goes to stdout while the report is
+ *  written, so nothing printed by the frames ends up in it.
+ ***********************************************************/
+bool BenchmarkRunner::Run(SceneManager* pSceneManager, const std::function<void()>& renderFrame, std::streambuf* pStdoutBuffer)
+{
+	if ((pSceneManager == NULL) || (m_framebufferID == 0))
+	{
+		return false;
+	}
+
+	std::vector<double> frameTimes;
+	std::vector<double> cpuTimes;
+	FRAME_COUNTERS totals = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+
+	frameTimes.reserve(m_settings.frameCount);
+	cpuTimes.reserve(m_settings.frameCount);
+
+	for (int frame = 0; frame < m_settings.warmupFrames + m_settings.frameCount; frame++)
+	{
+		std::chrono::steady_clock::time_point frameStart = std::chrono::steady_clock::now();
+
+		glBeginQuery(GL_PRIMITIVES_GENERATED, m_primitivesQueryID);
+		renderFrame();
+		glEndQuery(GL_PRIMITIVES_GENERATED);
+
+		std::chrono::steady_clock::time_point submitEnd = std::chrono::steady_clock::now();
+		glFinish();
+		std::chrono::steady_clock::time_point frameEnd = std::chrono::steady_clock::now();
+
+		// the warmup frames absorb shader and texture first-use costs
+		if (frame < m_settings.warmupFrames)
+		{
+			continue;
+		}
+
+		GLuint64 triangles = 0;
+		glGetQueryObjectui64v(m_primitivesQueryID, GL_QUERY_RESULT, &triangles);
+
+		frameTimes.push_back(ElapsedMilliseconds(frameStart, frameEnd));
+		cpuTimes.push_back(ElapsedMilliseconds(frameStart, submitEnd));
+		const SceneManager::RENDER_STATS& stats = pSceneManager->GetRenderStats();
+		totals.triangles += (double)triangles;
+		totals.drawCalls += (double)stats.drawCalls;
+		totals.drawCommands += (double)stats.drawCommands;
+		totals.instances += (double)stats.instances;
+		totals.stateChanges += (double)stats.stateChanges;
+		totals.stateCalls += (double)stats.stateCalls;
+		totals.elidedStateCalls += (double)stats.elidedStateCalls;
+		totals.uniformLookups += (double)stats.uniformLookups;
+		totals.clusterLights += (double)stats.clusterLights;
+		totals.transformUpdates += (double)stats.transformUpdates;
+		totals.visibleObjects += (double)stats.visibleObjects;
+		totals.culledObjects += (double)stats.culledObjects;
+		totals.occludedObjects += (double)stats.occludedObjects;
+		totals.reducedDetailObjects += (double)stats.reducedDetailObjects;
+		totals.shadowUpdates += (double)stats.shadowUpdates;
+		totals.shadowCasters += (double)stats.shadowCasters;
+	}
+
+	double frames = (double)std::max(m_settings.frameCount, 1);
+	FRAME_COUNTERS averages;
+	averages.triangles = totals.triangles / frames;
+	averages.drawCalls = totals.drawCalls / frames;
+	averages.drawCommands = totals.drawCommands / frames;
+	averages.instances = totals.instances / frames;
+	averages.stateChanges = totals.stateChanges / frames;
+	averages.stateCalls = totals.stateCalls / frames;
+	averages.elidedStateCalls = totals.elidedStateCalls / frames;
+	averages.uniformLookups = totals.uniformLookups / frames;
+	averages.clusterLights = totals.clusterLights / frames;
+	averages.transformUpdates = totals.transformUpdates / frames;
+	averages.visibleObjects = totals.visibleObjects / frames;
+	averages.culledObjects = totals.culledObjects / frames;
+	averages.occludedObjects = totals.occludedObjects / frames;
+	averages.reducedDetailObjects = totals.reducedDetailObjects / frames;
+	averages.shadowUpdates = totals.shadowUpdates / frames;
+	averages.shadowCasters = totals.shadowCasters / frames;
+
+	if (m_settings.outputPath.empty())
+	{
+		std::streambuf* pLogBuffer = std::cout.rdbuf(pStdoutBuffer);
+		WriteReport(std::cout, frameTimes, cpuTimes, averages);
+		std::cout.flush();
+		std::cout.rdbuf(pLogBuffer);
+	}
+	else
+	{
+		std::ofstream outputFile(m_settings.outputPath.c_str());
+		if (!outputFile)
+		{
+			std::cerr << "Could not open benchmark output file:" << m_settings.outputPath << std::endl;
+			return false;
+		}
+		WriteReport(outputFile, frameTimes, cpuTimes, averages);
+	}
+
+	return true;
+}
+
+/***********************************************************
+ *  Summarize()
+ *
+ *  This method is used to calculate the min, median, mean,
+ *  95th and 99th percentile and max of a list of samples.
+ *  Percentiles use the nearest-rank method.
+ ***********************************************************/
+BenchmarkRunner::SAMPLE_SUMMARY BenchmarkRunner::Summarize(std::vector<double> samples)
+{
+	SAMPLE_SUMMARY summary = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+
+	if (samples.empty())
+	{
+		return summary;
+	}
+
+	std::sort(samples.begin(), samples.end());
+
+	double total = 0.0;
+	for (size_t i = 0; i < samples.size(); i++)
+	{
+		total += samples[i];
+	}
+
+	size_t count = samples.size();
+	summary.min = samples.front();
+	summary.max = samples.back();
+	summary.mean = total / (double)count;
+	summary.median = samples[(count - 1) / 2];
+	summary.p95 = samples[std::min(count - 1, (size_t)((count * 95 + 99) / 100) - 1)];
+	summary.p99 = samples[std::min(count - 1, (size_t)((count * 99 + 99) / 100) - 1)];
+
+	return summary;
+}
+
+/***********************************************************
+ *  WriteReport()
+ *
+ *  This method is used to write the benchmark results to
+ *  the passed in stream as a single JSON object.
+ ***********************************************************/
+void BenchmarkRunner::WriteReport(
+	std::ostream& output,
+	const std::vector<double>& frameTimes,
+	const std::vector<double>& cpuTimes,
+	const FRAME_COUNTERS& averages)
+{
+	SAMPLE_SUMMARY frame = Summarize(frameTimes);
+	SAMPLE_SUMMARY cpu = Summarize(cpuTimes);
+	const char* renderer = (const char*)glGetString(GL_RENDERER);
+	const char* version = (const char*)glGetString(GL_VERSION);
+
+	output << std::fixed << std::setprecision(4);
+	output << "{\n";
+	output << "  \"renderer\": \"" << (renderer ? renderer : "unknown") << "\",\n";
+	output << "  \"glVersion\": \"" << (version ? version : "unknown") << "\",\n";
+	output << "  \"width\": " << m_settings.width << ",\n";
+	output << "  \"height\": " << m_settings.height << ",\n";
+	output << "  \"warmupFrames\": " << m_settings.warmupFrames << ",\n";
+	output << "  \"frames\": " << frameTimes.size() << ",\n";
+	output << "  \"frameTimeMs\": { \"min\": " << frame.min << ", \"median\": " << frame.median
+		<< ", \"mean\": " << frame.mean << ", \"p95\": " << frame.p95 << ", \"p99\": " << frame.p99
+		<< ", \"max\": " << frame.max << " },\n";
+	output << "  \"cpuTimeMs\": { \"min\": " << cpu.min << ", \"median\": " << cpu.median
+		<< ", \"mean\": " << cpu.mean << ", \"p95\": " << cpu.p95 << ", \"p99\": " << cpu.p99
+		<< ", \"max\": " << cpu.max << " },\n";
+	output << "  \"trianglesPerFrame\": " << averages.triangles << ",\n";
+	output << "  \"drawsPerFrame\": " << averages.drawCalls << ",\n";
+	output << "  \"drawCommandsPerFrame\": " << averages.drawCommands << ",\n";
+	output << "  \"instancesPerFrame\": " << averages.instances << ",\n";
+	output << "  \"stateChangesPerFrame\": " << averages.stateChanges << ",\n";
+	output << "  \"stateCallsPerFrame\": " << averages.stateCalls << ",\n";
+	output << "  \"elidedStateCallsPerFrame\": " << averages.elidedStateCalls << ",\n";
+	output << "  \"uniformLookupsPerFrame\": " << averages.uniformLookups << ",\n";
+	output << "  \"clusterLightsPerFrame\": " << averages.clusterLights << ",\n";
+	output << "  \"transformUpdatesPerFrame\": " << averages.transformUpdates << ",\n";
+	output << "  \"visibleObjectsPerFrame\": " << averages.visibleObjects << ",\n";
+	output << "  \"culledObjectsPerFrame\": " << averages.culledObjects << ",\n";
+	output << "  \"occludedObjectsPerFrame\": " << averages.occludedObjects << ",\n";
+	output << "  \"reducedDetailObjectsPerFrame\": " << averages.reducedDetailObjects << ",\n";
+	output << "  \"shadowUpdatesPerFrame\": " << averages.shadowUpdates << ",\n";
+	output << "  \"shadowCastersPerFrame\": " << averages.shadowCasters << "\n";
+	output << "}" << std::endl;
+}
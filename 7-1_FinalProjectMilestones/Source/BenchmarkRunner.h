@@ -0,0 +1,110 @@
+///////////////////////////////////////////////////////////////////////////////
+// benchmarkrunner.h
+// ============
+// render the 3D scene headless for a fixed number of frames and report
+// the measured frame timings as machine-readable JSON
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "SceneManager.h"
+
+#include <functional>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  BenchmarkRunner
+ *
+ *  This class contains the code for creating an offscreen
+ *  OpenGL context and framebuffer, rendering a number of
+ *  frames from a fixed camera, and reporting the timings.
+ ***********************************************************/
+class BenchmarkRunner
+{
+public:
+	// settings parsed from the --bench command line options
+	struct BENCHMARK_SETTINGS
+	{
+		int frameCount;
+		int warmupFrames;
+		int width;
+		int height;
+		std::string outputPath;
+	};
+
+	// constructor
+	BenchmarkRunner(const BENCHMARK_SETTINGS& settings);
+	// destructor
+	~BenchmarkRunner();
+
+	// create a context that needs no display (surfaceless EGL, or
+	// a hidden window where EGL is not available)
+	static bool CreateHeadlessContext();
+	// release the context created by CreateHeadlessContext()
+	static void DestroyHeadlessContext();
+
+	// create the offscreen framebuffer and size the viewport to
+	// it - call before the scene is prepared, so everything
+	// sized to the viewport is created at the benchmark's size
+	bool Initialize();
+	// render the configured frames and write the JSON report,
+	// to the passed in stdout buffer when there is no output
+	// file - std::cout is expected to point at stderr
+	bool Run(SceneManager* pSceneManager, const std::function<void()>& renderFrame, std::streambuf* pStdoutBuffer);
+
+private:
+	// summary of one series of per-frame samples
+	struct SAMPLE_SUMMARY
+	{
+		double min;
+		double median;
+		double mean;
+		double p95;
+		double p99;
+		double max;
+	};
+
+	// per frame counters, averaged over the measured frames
+	struct FRAME_COUNTERS
+	{
+		double triangles;
+		double drawCalls;
+		double drawCommands;
+		double instances;
+		double stateChanges;
+		double stateCalls;
+		double elidedStateCalls;
+		double uniformLookups;
+		double clusterLights;
+		double transformUpdates;
+		double visibleObjects;
+		double culledObjects;
+		double occludedObjects;
+		double reducedDetailObjects;
+		double shadowUpdates;
+		double shadowCasters;
+	};
+
+	BENCHMARK_SETTINGS m_settings;
+	// offscreen render target objects
+	GLuint m_framebufferID;
+	GLuint m_colorBufferID;
+	GLuint m_depthBufferID;
+	// query used for counting the generated triangles
+	GLuint m_primitivesQueryID;
+
+	// create and destroy the offscreen render target
+	bool CreateFramebuffer();
+	void DestroyFramebuffer();
+
+	// calculate the summary values for a list of samples
+	static SAMPLE_SUMMARY Summarize(std::vector<double> samples);
+	// write the benchmark results in JSON format
+	void WriteReport(
+		std::ostream& output,
+		const std::vector<double>& frameTimes,
+		const std::vector<double>& cpuTimes,
+		const FRAME_COUNTERS& averages);
+};
@@ -0,0 +1,385 @@
+///////////////////////////////////////////////////////////////////////////////
+// boundingvolumehierarchy.cpp
+// ============
+// tree of world space boxes for culling the scene against the view frustum
+///////////////////////////////////////////////////////////////////////////////
+
+#include "BoundingVolumeHierarchy.h"
+
+#include <algorithm>
+#include <cmath>
+
+// declare the global variables
+namespace
+{
+	// every plane of the frustum still needs to be tested
+	const int ALL_PLANES = 0x3F;
+
+	// result of testing a box against one plane
+	enum PLANE_SIDE
+	{
+		SIDE_OUTSIDE,
+		SIDE_CROSSING,
+		SIDE_INSIDE
+	};
+
+	/***********************************************************
+	 *  TestPlane()
+	 *
+	 *  Find which side of a plane a box is on, from the box
+	 *  corners furthest along and against the plane normal.
+	 ***********************************************************/
+	PLANE_SIDE TestPlane(const glm::vec4& plane, const BoundingVolumeHierarchy::BOUNDING_BOX& box)
+	{
+		glm::vec3 normal(plane);
+		glm::vec3 furthest(
+			(normal.x >= 0.0f) ? box.maximum.x : box.minimum.x,
+			(normal.y >= 0.0f) ? box.maximum.y : box.minimum.y,
+			(normal.z >= 0.0f) ? box.maximum.z : box.minimum.z);
+		if (glm::dot(normal, furthest) + plane.w < 0.0f)
+		{
+			return SIDE_OUTSIDE;
+		}
+
+		glm::vec3 nearest(
+			(normal.x >= 0.0f) ? box.minimum.x : box.maximum.x,
+			(normal.y >= 0.0f) ? box.minimum.y : box.maximum.y,
+			(normal.z >= 0.0f) ? box.minimum.z : box.maximum.z);
+		return (glm::dot(normal, nearest) + plane.w >= 0.0f) ? SIDE_INSIDE : SIDE_CROSSING;
+	}
+
+	/***********************************************************
+	 *  MergeBoxes()
+	 *
+	 *  Grow a box so it also holds another box.
+	 ***********************************************************/
+	void MergeBoxes(BoundingVolumeHierarchy::BOUNDING_BOX& box, const BoundingVolumeHierarchy::BOUNDING_BOX& other)
+	{
+		box.minimum = glm::min(box.minimum, other.minimum);
+		box.maximum = glm::max(box.maximum, other.maximum);
+	}
+}
+
+/***********************************************************
+ *  BoundingVolumeHierarchy()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+BoundingVolumeHierarchy::BoundingVolumeHierarchy()
+{
+	m_bRefitNeeded = false;
+}
+
+/***********************************************************
+ *  Build()
+ *
+ *  This method is used to build the tree over the bounds of
+ *  every item, replacing the tree that was there before.
+ ***********************************************************/
+void BoundingVolumeHierarchy::Build(const std::vector<BOUNDING_BOX>& bounds)
+{
+	m_bounds = bounds;
+	m_nodes.clear();
+	m_items.resize(bounds.size());
+	m_bRefitNeeded = false;
+
+	std::vector<glm::vec3> centers(bounds.size());
+	for (size_t i = 0; i < bounds.size(); i++)
+	{
+		m_items[i] = (int)i;
+		centers[i] = (bounds[i].minimum + bounds[i].maximum) * 0.5f;
+	}
+
+	if (m_items.empty() == false)
+	{
+		m_nodes.reserve(2 * m_items.size() / MAX_LEAF_ITEMS + 1);
+		BuildNode(0, (int)m_items.size(), centers);
+	}
+}
+
+/***********************************************************
+ *  BuildNode()
+ *
+ *  This method is used to build the node over a range of
+ *  the items.  Ranges with more than a few items are sorted
+ *  around the middle center along the longest side of the
+ *  box around the centers, and split in two halves.
+ ***********************************************************/
+int BoundingVolumeHierarchy::BuildNode(int firstItem, int itemCount, const std::vector<glm::vec3>& centers)
+{
+	int nodeIndex = (int)m_nodes.size();
+	BVH_NODE node;
+	node.box = m_bounds[m_items[firstItem]];
+	node.firstItem = firstItem;
+	node.itemCount = itemCount;
+	node.rightChild = -1;
+
+	glm::vec3 centerMinimum = centers[m_items[firstItem]];
+	glm::vec3 centerMaximum = centerMinimum;
+	for (int i = firstItem + 1; i < firstItem + itemCount; i++)
+	{
+		MergeBoxes(node.box, m_bounds[m_items[i]]);
+		centerMinimum = glm::min(centerMinimum, centers[m_items[i]]);
+		centerMaximum = glm::max(centerMaximum, centers[m_items[i]]);
+	}
+	m_nodes.push_back(node);
+
+	if (itemCount <= MAX_LEAF_ITEMS)
+	{
+		return nodeIndex;
+	}
+
+	glm::vec3 extent = centerMaximum - centerMinimum;
+	int axis = 0;
+	if (extent.y > extent[axis])
+	{
+		axis = 1;
+	}
+	if (extent.z > extent[axis])
+	{
+		axis = 2;
+	}
+
+	int leftCount = itemCount / 2;
+	std::nth_element(m_items.begin() + firstItem, m_items.begin() + firstItem + leftCount,
+		m_items.begin() + firstItem + itemCount,
+		[&centers, axis](int a, int b) { return centers[a][axis] < centers[b][axis]; });
+
+	BuildNode(firstItem, leftCount, centers);
+	int rightChild = BuildNode(firstItem + leftCount, itemCount - leftCount, centers);
+	m_nodes[nodeIndex].rightChild = rightChild;
+
+	return nodeIndex;
+}
+
+/***********************************************************
+ *  SetBounds()
+ *
+ *  This method is used to change the bounds of an item that
+ *  moved.  The tree keeps its shape, and its boxes grow or
+ *  shrink to the new bounds before the next cull.
+ ***********************************************************/
+void BoundingVolumeHierarchy::SetBounds(int item, const BOUNDING_BOX& bounds)
+{
+	m_bounds[item] = bounds;
+	m_bRefitNeeded = true;
+}
+
+/***********************************************************
+ *  Refit()
+ *
+ *  This method is used to bring every node box up to date.
+ *  The children always follow their parent in the node list,
+ *  so walking it backwards reaches them first.
+ ***********************************************************/
+void BoundingVolumeHierarchy::Refit()
+{
+	for (int i = (int)m_nodes.size() - 1; i >= 0; i--)
+	{
+		BVH_NODE& node = m_nodes[i];
+		if (node.rightChild < 0)
+		{
+			node.box = m_bounds[m_items[node.firstItem]];
+			for (int item = node.firstItem + 1; item < node.firstItem + node.itemCount; item++)
+			{
+				MergeBoxes(node.box, m_bounds[m_items[item]]);
+			}
+		}
+		else
+		{
+			node.box = m_nodes[i + 1].box;
+			MergeBoxes(node.box, m_nodes[node.rightChild].box);
+		}
+	}
+	m_bRefitNeeded = false;
+}
+
+/***********************************************************
+ *  Cull()
+ *
+ *  This method is used to collect the items whose bounds
+ *  are at least partly inside the frustum, in tree order.
+ ***********************************************************/
+int BoundingVolumeHierarchy::Cull(const FRUSTUM& frustum, std::vector<int>& visibleItems)
+{
+	visibleItems.clear();
+	if (m_nodes.empty())
+	{
+		return 0;
+	}
+
+	if (m_bRefitNeeded)
+	{
+		Refit();
+	}
+
+	return CullNode(0, frustum, ALL_PLANES, visibleItems);
+}
+
+/***********************************************************
+ *  CullNode()
+ *
+ *  This method is used to test a node against the frustum.
+ *  A plane the node is fully inside of is dropped from the
+ *  mask, since its children are inside of it as well, and
+ *  once no planes are left every item below is visible.
+ ***********************************************************/
+int BoundingVolumeHierarchy::CullNode(int nodeIndex, const FRUSTUM& frustum, int planeMask, std::vector<int>& visibleItems) const
+{
+	const BVH_NODE& node = m_nodes[nodeIndex];
+	for (int plane = 0; plane < 6; plane++)
+	{
+		if ((planeMask & (1 << plane)) == 0)
+		{
+			continue;
+		}
+
+		PLANE_SIDE side = TestPlane(frustum.planes[plane], node.box);
+		if (side == SIDE_OUTSIDE)
+		{
+			return 1;
+		}
+		if (side == SIDE_INSIDE)
+		{
+			planeMask &= ~(1 << plane);
+		}
+	}
+
+	if (planeMask == 0)
+	{
+		visibleItems.insert(visibleItems.end(), m_items.begin() + node.firstItem,
+			m_items.begin() + node.firstItem + node.itemCount);
+		return 1;
+	}
+
+	if (node.rightChild < 0)
+	{
+		for (int i = node.firstItem; i < node.firstItem + node.itemCount; i++)
+		{
+			if (IsBoxVisible(frustum, m_bounds[m_items[i]]))
+			{
+				visibleItems.push_back(m_items[i]);
+			}
+		}
+		return 1;
+	}
+
+	return 1 + CullNode(nodeIndex + 1, frustum, planeMask, visibleItems) +
+		CullNode(node.rightChild, frustum, planeMask, visibleItems);
+}
+
+/***********************************************************
+ *  GetItemCount()
+ *
+ *  This method is used to get the number of items the tree
+ *  was built over.
+ ***********************************************************/
+int BoundingVolumeHierarchy::GetItemCount() const
+{
+	return (int)m_bounds.size();
+}
+
+/***********************************************************
+ *  ExtractFrustum()
+ *
+ *  This method is used to read the frustum planes out of a
+ *  view projection matrix.  A point is inside the clip
+ *  volume when -w <= x, y, z <= w, and each of those six
+ *  limits is a plane made of the rows of the matrix.  The
+ *  same rows describe the box of an orthographic projection
+ *  and the pyramid of a perspective one.
+ ***********************************************************/
+BoundingVolumeHierarchy::FRUSTUM BoundingVolumeHierarchy::ExtractFrustum(const glm::mat4& viewProjection)
+{
+	glm::vec4 rows[4];
+	for (int row = 0; row < 4; row++)
+	{
+		rows[row] = glm::vec4(viewProjection[0][row], viewProjection[1][row],
+			viewProjection[2][row], viewProjection[3][row]);
+	}
+
+	FRUSTUM frustum;
+	frustum.planes[0] = rows[3] + rows[0];
+	frustum.planes[1] = rows[3] - rows[0];
+	frustum.planes[2] = rows[3] + rows[1];
+	frustum.planes[3] = rows[3] - rows[1];
+	frustum.planes[4] = rows[3] + rows[2];
+	frustum.planes[5] = rows[3] - rows[2];
+
+	// normalize the planes, so the sphere test can compare the
+	// distances with a radius
+	for (int plane = 0; plane < 6; plane++)
+	{
+		float length = glm::length(glm::vec3(frustum.planes[plane]));
+		if (length > 0.0f)
+		{
+			frustum.planes[plane] = frustum.planes[plane] * (1.0f / length);
+		}
+	}
+
+	return frustum;
+}
+
+/***********************************************************
+ *  TransformBounds()
+ *
+ *  This method is used to find the world space box around a
+ *  local box moved by a model matrix.  The center is moved
+ *  by the matrix, and the half size is spread over the axes
+ *  by the absolute values of its rotation and scale.
+ ***********************************************************/
+BoundingVolumeHierarchy::BOUNDING_BOX BoundingVolumeHierarchy::TransformBounds(
+	const glm::vec3& minimum, const glm::vec3& maximum, const glm::mat4& model)
+{
+	glm::vec3 center = glm::vec3(model * glm::vec4((minimum + maximum) * 0.5f, 1.0f));
+	glm::vec3 halfSize = (maximum - minimum) * 0.5f;
+
+	glm::vec3 extent(0.0f);
+	for (int column = 0; column < 3; column++)
+	{
+		extent += glm::abs(glm::vec3(model[column])) * halfSize[column];
+	}
+
+	BOUNDING_BOX box;
+	box.minimum = center - extent;
+	box.maximum = center + extent;
+	return box;
+}
+
+/***********************************************************
+ *  IsBoxVisible()
+ *
+ *  This method is used to check whether a box is at least
+ *  partly inside the frustum.  A box near a corner of the
+ *  frustum can pass while being outside of it, which only
+ *  costs a draw that is clipped away.
+ ***********************************************************/
+bool BoundingVolumeHierarchy::IsBoxVisible(const FRUSTUM& frustum, const BOUNDING_BOX& box)
+{
+	for (int plane = 0; plane < 6; plane++)
+	{
+		if (TestPlane(frustum.planes[plane], box) == SIDE_OUTSIDE)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+/***********************************************************
+ *  IsSphereVisible()
+ *
+ *  This method is used to check whether a sphere is at least
+ *  partly inside the frustum.
+ ***********************************************************/
+bool BoundingVolumeHierarchy::IsSphereVisible(const FRUSTUM& frustum, const glm::vec3& center, float radius)
+{
+	for (int plane = 0; plane < 6; plane++)
+	{
+		if (glm::dot(glm::vec3(frustum.planes[plane]), center) + frustum.planes[plane].w < -radius)
+		{
+			return false;
+		}
+	}
+	return true;
+}
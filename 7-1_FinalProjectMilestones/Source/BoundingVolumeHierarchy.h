@@ -0,0 +1,97 @@
+///////////////////////////////////////////////////////////////////////////////
+// boundingvolumehierarchy.h
+// ============
+// tree of world space boxes for culling the scene against the view frustum
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// GLM Math Header inclusions
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  BoundingVolumeHierarchy
+ *
+ *  This class keeps a binary tree of boxes over the world
+ *  space bounds of a list of items.  Each node covers a
+ *  contiguous range of the sorted items, split in half along
+ *  the longest side of the box around their centers, so a
+ *  node that lies outside the view frustum rejects all of
+ *  its items with one test and a node fully inside accepts
+ *  them without testing any of them.  Moving items only
+ *  refit the boxes of the tree, which is rebuilt when items
+ *  are added or removed.
+ ***********************************************************/
+class BoundingVolumeHierarchy
+{
+public:
+	// an axis aligned box
+	struct BOUNDING_BOX
+	{
+		glm::vec3 minimum;
+		glm::vec3 maximum;
+	};
+
+	// the six planes of a view frustum - left, right, bottom,
+	// top, near and far - with their normals pointing inwards
+	struct FRUSTUM
+	{
+		glm::vec4 planes[6];
+	};
+
+	// constructor
+	BoundingVolumeHierarchy();
+
+	// build the tree over the bounds of every item
+	void Build(const std::vector<BOUNDING_BOX>& bounds);
+	// change the bounds of an item - the tree boxes are refit
+	// by the next call to Cull()
+	void SetBounds(int item, const BOUNDING_BOX& bounds);
+	// collect the items whose bounds touch the frustum, and
+	// return the number of tree nodes that were tested
+	int Cull(const FRUSTUM& frustum, std::vector<int>& visibleItems);
+
+	int GetItemCount() const;
+
+	// read the frustum planes out of a view projection matrix,
+	// which works for perspective and orthographic projections
+	static FRUSTUM ExtractFrustum(const glm::mat4& viewProjection);
+	// the world space box around a local box moved by a matrix
+	static BOUNDING_BOX TransformBounds(const glm::vec3& minimum, const glm::vec3& maximum, const glm::mat4& model);
+	// check whether a box is at least partly inside a frustum
+	static bool IsBoxVisible(const FRUSTUM& frustum, const BOUNDING_BOX& box);
+	// check whether a sphere is at least partly inside a frustum
+	static bool IsSphereVisible(const FRUSTUM& frustum, const glm::vec3& center, float radius);
+
+private:
+	// items in a leaf before it is split
+	static const int MAX_LEAF_ITEMS = 4;
+
+	// one box of the tree - the left child directly follows
+	// its parent, and leaves have no right child
+	struct BVH_NODE
+	{
+		BOUNDING_BOX box;
+		int firstItem;
+		int itemCount;
+		int rightChild;
+	};
+
+	std::vector<BVH_NODE> m_nodes;
+	// the items in tree order, and the bounds of every item
+	std::vector<int> m_items;
+	std::vector<BOUNDING_BOX> m_bounds;
+	// items moved since the boxes were last refit
+	bool m_bRefitNeeded;
+
+	// build the node over a range of the sorted items, and
+	// return its index
+	int BuildNode(int firstItem, int itemCount, const std::vector<glm::vec3>& centers);
+	// bring every node box up to date with the item bounds
+	void Refit();
+	// test a node against the planes still in the mask and add
+	// its visible items, returns the number of nodes tested
+	int CullNode(int node, const FRUSTUM& frustum, int planeMask, std::vector<int>& visibleItems) const;
+};
@@ -0,0 +1,469 @@
+///////////////////////////////////////////////////////////////////////////////
+// clusteredlights.cpp
+// ============
+// store the scene point lights and bin them into view space clusters
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ClusteredLights.h"
+#include "GLStateCache.h"
+
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+// declare the global variables
+namespace
+{
+	// closest near plane used for the depth slices, since the
+	// slices are spaced on a logarithmic scale
+	const float MIN_NEAR_PLANE = 0.01f;
+
+	/***********************************************************
+	 *  Unproject()
+	 *
+	 *  Convert a point from normalized device coordinates back
+	 *  into view space.
+	 ***********************************************************/
+	glm::vec3 Unproject(const glm::mat4& inverseProjection, float x, float y, float z)
+	{
+		glm::vec4 point = inverseProjection * glm::vec4(x, y, z, 1.0f);
+		return glm::vec3(point) / point.w;
+	}
+}
+
+/***********************************************************
+ *  ClusteredLights()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ClusteredLights::ClusteredLights()
+{
+	m_bLightsDirty = true;
+	m_lightBufferID = 0;
+	m_clusterBufferID = 0;
+	m_lightIndexBufferID = 0;
+	m_projection = glm::mat4(1.0f);
+	m_viewportWidth = 0;
+	m_viewportHeight = 0;
+	m_bBoundsValid = false;
+	m_nearPlane = 0.1f;
+	m_farPlane = 100.0f;
+	m_tileWidth = 1.0f;
+	m_tileHeight = 1.0f;
+}
+
+/***********************************************************
+ *  ~ClusteredLights()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ClusteredLights::~ClusteredLights()
+{
+	GLuint bufferIDs[3] = { m_lightBufferID, m_clusterBufferID, m_lightIndexBufferID };
+	if (m_lightBufferID != 0)
+	{
+		GLStateCache::DeleteBuffers(3, bufferIDs);
+	}
+	m_lightBufferID = 0;
+	m_clusterBufferID = 0;
+	m_lightIndexBufferID = 0;
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used to create the light, cluster and
+ *  light index buffers and to attach them to their binding
+ *  points.  The buffers start out with empty cluster lists
+ *  so that the shader can be used before the first update.
+ ***********************************************************/
+bool ClusteredLights::Initialize()
+{
+	if (m_lightBufferID != 0)
+	{
+		return true;
+	}
+
+	GLuint bufferIDs[3];
+	glGenBuffers(3, bufferIDs);
+	m_lightBufferID = bufferIDs[0];
+	m_clusterBufferID = bufferIDs[1];
+	m_lightIndexBufferID = bufferIDs[2];
+
+	m_clusterRanges.assign(CLUSTER_COUNT, CLUSTER_RANGE());
+	memset(m_clusterRanges.data(), 0, m_clusterRanges.size() * sizeof(CLUSTER_RANGE));
+	m_lightIndices.clear();
+	m_bLightsDirty = true;
+	UploadBuffers();
+
+	GLStateCache::BindBufferBase(GL_SHADER_STORAGE_BUFFER, LIGHT_BUFFER_BINDING, m_lightBufferID);
+	GLStateCache::BindBufferBase(GL_SHADER_STORAGE_BUFFER, CLUSTER_BUFFER_BINDING, m_clusterBufferID);
+	GLStateCache::BindBufferBase(GL_SHADER_STORAGE_BUFFER, LIGHT_INDEX_BUFFER_BINDING, m_lightIndexBufferID);
+
+	return true;
+}
+
+/***********************************************************
+ *  AddLight()
+ *
+ *  This method is used to add a light to the scene.  The
+ *  light buffer is uploaded again on the next update.
+ ***********************************************************/
+int ClusteredLights::AddLight(const POINT_LIGHT& light)
+{
+	m_lights.push_back(light);
+	m_bLightsDirty = true;
+
+	return (int)m_lights.size() - 1;
+}
+
+/***********************************************************
+ *  SetLight()
+ *
+ *  This method is used to change a previously added light.
+ ***********************************************************/
+void ClusteredLights::SetLight(int index, const POINT_LIGHT& light)
+{
+	if ((index < 0) || (index >= (int)m_lights.size()))
+	{
+		std::cout << "Light index out of range:" << index << std::endl;
+		return;
+	}
+
+	m_lights[index] = light;
+	m_bLightsDirty = true;
+}
+
+/***********************************************************
+ *  ClearLights()
+ *
+ *  This method is used to remove all of the lights.
+ ***********************************************************/
+void ClusteredLights::ClearLights()
+{
+	m_lights.clear();
+	m_bLightsDirty = true;
+}
+
+/***********************************************************
+ *  GetLightCount()
+ *
+ *  This method is used to get the number of lights.
+ ***********************************************************/
+int ClusteredLights::GetLightCount() const
+{
+	return (int)m_lights.size();
+}
+
+/***********************************************************
+ *  GetLight()
+ *
+ *  This method is used to get a previously added light.
+ ***********************************************************/
+const ClusteredLights::POINT_LIGHT& ClusteredLights::GetLight(int index) const
+{
+	return m_lights[index];
+}
+
+/***********************************************************
+ *  GetDepthSlice()
+ *
+ *  This method is used to get the depth slice containing a
+ *  view space depth.  This must give the same result as the
+ *  calculation in the fragment shader.
+ ***********************************************************/
+int ClusteredLights::GetDepthSlice(float depth) const
+{
+	glm::vec4 parameters = GetClusterParameters();
+	int slice = (int)floorf(logf(depth) * parameters.z + parameters.w);
+
+	return glm::clamp(slice, 0, DEPTH_SLICES - 1);
+}
+
+/***********************************************************
+ *  GetClusterParameters()
+ *
+ *  This method is used to get the values the fragment shader
+ *  uses to find its cluster from the fragment coordinate and
+ *  the view space depth.  The depth slice is
+ *  floor(log(depth) * z + w).
+ ***********************************************************/
+glm::vec4 ClusteredLights::GetClusterParameters() const
+{
+	float sliceScale = (float)DEPTH_SLICES / logf(m_farPlane / m_nearPlane);
+	float sliceBias = -logf(m_nearPlane) * sliceScale;
+
+	return glm::vec4(m_tileWidth, m_tileHeight, sliceScale, sliceBias);
+}
+
+/***********************************************************
+ *  GetAssignedLightCount()
+ *
+ *  This method is used to get the total number of lights in
+ *  all of the cluster lists from the last update.
+ ***********************************************************/
+int ClusteredLights::GetAssignedLightCount() const
+{
+	return (int)m_assignedLights.size();
+}
+
+/***********************************************************
+ *  BuildClusterBounds()
+ *
+ *  This method is used to calculate the view space bounding
+ *  box of every cluster.  The corners of each screen tile
+ *  are unprojected onto the near and far planes, and the
+ *  lines between them are cut at the depths of each slice,
+ *  which works for perspective and orthographic projections.
+ ***********************************************************/
+void ClusteredLights::BuildClusterBounds()
+{
+	// read the near and far planes back out of the projection
+	const glm::mat4& projection = m_projection;
+	if (projection[2][3] != 0.0f)
+	{
+		m_nearPlane = projection[3][2] / (projection[2][2] - 1.0f);
+		m_farPlane = projection[3][2] / (projection[2][2] + 1.0f);
+	}
+	else
+	{
+		m_nearPlane = (projection[3][2] + 1.0f) / projection[2][2];
+		m_farPlane = (projection[3][2] - 1.0f) / projection[2][2];
+	}
+	m_nearPlane = glm::max(m_nearPlane, MIN_NEAR_PLANE);
+	m_farPlane = glm::max(m_farPlane, m_nearPlane * 2.0f);
+
+	m_tileWidth = ceilf((float)m_viewportWidth / (float)TILES_X);
+	m_tileHeight = ceilf((float)m_viewportHeight / (float)TILES_Y);
+
+	glm::mat4 inverseProjection = glm::inverse(projection);
+	float sliceDepths[DEPTH_SLICES + 1];
+	for (int slice = 0; slice <= DEPTH_SLICES; slice++)
+	{
+		sliceDepths[slice] = m_nearPlane * powf(m_farPlane / m_nearPlane, (float)slice / (float)DEPTH_SLICES);
+	}
+
+	m_clusterBounds.resize(CLUSTER_COUNT);
+	for (int tileY = 0; tileY < TILES_Y; tileY++)
+	{
+		for (int tileX = 0; tileX < TILES_X; tileX++)
+		{
+			float left = (tileX * m_tileWidth) / m_viewportWidth * 2.0f - 1.0f;
+			float right = ((tileX + 1) * m_tileWidth) / m_viewportWidth * 2.0f - 1.0f;
+			float bottom = (tileY * m_tileHeight) / m_viewportHeight * 2.0f - 1.0f;
+			float top = ((tileY + 1) * m_tileHeight) / m_viewportHeight * 2.0f - 1.0f;
+			float cornerX[4] = { left, right, left, right };
+			float cornerY[4] = { bottom, bottom, top, top };
+
+			glm::vec3 nearPoints[4];
+			glm::vec3 farPoints[4];
+			for (int corner = 0; corner < 4; corner++)
+			{
+				nearPoints[corner] = Unproject(inverseProjection, cornerX[corner], cornerY[corner], -1.0f);
+				farPoints[corner] = Unproject(inverseProjection, cornerX[corner], cornerY[corner], 1.0f);
+			}
+
+			for (int slice = 0; slice < DEPTH_SLICES; slice++)
+			{
+				CLUSTER_BOUNDS& bounds = m_clusterBounds[tileX + tileY * TILES_X + slice * TILES_X * TILES_Y];
+				bounds.minPoint = glm::vec3(INFINITY);
+				bounds.maxPoint = glm::vec3(-INFINITY);
+
+				for (int corner = 0; corner < 4; corner++)
+				{
+					float nearDepth = -nearPoints[corner].z;
+					float farDepth = -farPoints[corner].z;
+					for (int end = 0; end < 2; end++)
+					{
+						float t = (sliceDepths[slice + end] - nearDepth) / (farDepth - nearDepth);
+						glm::vec3 point = nearPoints[corner] + (farPoints[corner] - nearPoints[corner]) * t;
+						bounds.minPoint = glm::min(bounds.minPoint, point);
+						bounds.maxPoint = glm::max(bounds.maxPoint, point);
+					}
+				}
+			}
+		}
+	}
+
+	m_bBoundsValid = true;
+}
+
+/***********************************************************
+ *  AssignLights()
+ *
+ *  This method is used to add every light to the lists of
+ *  the clusters that its range touches.  The depth slices
+ *  and screen tiles covered by the bounding box of the
+ *  light limit the clusters that are tested against the
+ *  light sphere, so the cost follows the size of the light
+ *  on screen rather than the size of the grid.
+ ***********************************************************/
+void ClusteredLights::AssignLights(const glm::mat4& view)
+{
+	m_assignedClusters.clear();
+	m_assignedLights.clear();
+
+	for (int lightIndex = 0; lightIndex < (int)m_lights.size(); lightIndex++)
+	{
+		const POINT_LIGHT& light = m_lights[lightIndex];
+		glm::vec3 center = glm::vec3(view * glm::vec4(light.position, 1.0f));
+		float radius = light.range;
+		float depth = -center.z;
+
+		float minDepth = glm::max(depth - radius, m_nearPlane);
+		float maxDepth = glm::min(depth + radius, m_farPlane);
+		if (minDepth > maxDepth)
+		{
+			continue;
+		}
+
+		// project the bounding box of the light, cut to the
+		// visible depths, to find the screen tiles it covers
+		glm::vec2 minNDC(INFINITY, INFINITY);
+		glm::vec2 maxNDC(-INFINITY, -INFINITY);
+		for (int corner = 0; corner < 8; corner++)
+		{
+			glm::vec4 point(
+				center.x + ((corner & 1) ? radius : -radius),
+				center.y + ((corner & 2) ? radius : -radius),
+				(corner & 4) ? -maxDepth : -minDepth,
+				1.0f);
+			glm::vec4 clip = m_projection * point;
+			minNDC.x = glm::min(minNDC.x, clip.x / clip.w);
+			minNDC.y = glm::min(minNDC.y, clip.y / clip.w);
+			maxNDC.x = glm::max(maxNDC.x, clip.x / clip.w);
+			maxNDC.y = glm::max(maxNDC.y, clip.y / clip.w);
+		}
+		if ((maxNDC.x < -1.0f) || (minNDC.x > 1.0f) || (maxNDC.y < -1.0f) || (minNDC.y > 1.0f))
+		{
+			continue;
+		}
+
+		int firstTileX = glm::clamp((int)floorf((minNDC.x * 0.5f + 0.5f) * m_viewportWidth / m_tileWidth), 0, TILES_X - 1);
+		int lastTileX = glm::clamp((int)floorf((maxNDC.x * 0.5f + 0.5f) * m_viewportWidth / m_tileWidth), 0, TILES_X - 1);
+		int firstTileY = glm::clamp((int)floorf((minNDC.y * 0.5f + 0.5f) * m_viewportHeight / m_tileHeight), 0, TILES_Y - 1);
+		int lastTileY = glm::clamp((int)floorf((maxNDC.y * 0.5f + 0.5f) * m_viewportHeight / m_tileHeight), 0, TILES_Y - 1);
+		int firstSlice = GetDepthSlice(minDepth);
+		int lastSlice = GetDepthSlice(maxDepth);
+
+		for (int slice = firstSlice; slice <= lastSlice; slice++)
+		{
+			for (int tileY = firstTileY; tileY <= lastTileY; tileY++)
+			{
+				for (int tileX = firstTileX; tileX <= lastTileX; tileX++)
+				{
+					int clusterIndex = tileX + tileY * TILES_X + slice * TILES_X * TILES_Y;
+					const CLUSTER_BOUNDS& bounds = m_clusterBounds[clusterIndex];
+
+					// distance from the light to the closest point of the cluster
+					glm::vec3 closest = glm::min(glm::max(center, bounds.minPoint), bounds.maxPoint);
+					glm::vec3 offset = closest - center;
+					if (glm::dot(offset, offset) <= radius * radius)
+					{
+						m_assignedClusters.push_back((GLuint)clusterIndex);
+						m_assignedLights.push_back((GLuint)lightIndex);
+					}
+				}
+			}
+		}
+	}
+
+	// sort the light references by cluster with a counting sort
+	memset(m_clusterRanges.data(), 0, m_clusterRanges.size() * sizeof(CLUSTER_RANGE));
+	for (size_t i = 0; i < m_assignedClusters.size(); i++)
+	{
+		m_clusterRanges[m_assignedClusters[i]].count++;
+	}
+
+	GLuint offset = 0;
+	for (int cluster = 0; cluster < CLUSTER_COUNT; cluster++)
+	{
+		m_clusterRanges[cluster].offset = offset;
+		offset += m_clusterRanges[cluster].count;
+		m_clusterRanges[cluster].count = 0;
+	}
+
+	m_lightIndices.resize(m_assignedLights.size());
+	for (size_t i = 0; i < m_assignedClusters.size(); i++)
+	{
+		CLUSTER_RANGE& range = m_clusterRanges[m_assignedClusters[i]];
+		m_lightIndices[range.offset + range.count] = m_assignedLights[i];
+		range.count++;
+	}
+}
+
+/***********************************************************
+ *  UploadBuffers()
+ *
+ *  This method is used to copy the lights, when they have
+ *  changed, and the cluster lists into their buffers.  The
+ *  cluster lists are recreated every frame, which lets the
+ *  driver give them new storage instead of waiting for the
+ *  previous frame to finish reading them.
+ ***********************************************************/
+void ClusteredLights::UploadBuffers()
+{
+	// the buffers are never left empty, since binding a buffer
+	// without storage to the shader is an error
+	static const POINT_LIGHT emptyLight = {};
+	static const GLuint emptyIndex = 0;
+
+	if (m_bLightsDirty)
+	{
+		GLStateCache::BindBuffer(GL_SHADER_STORAGE_BUFFER, m_lightBufferID);
+		if (m_lights.empty())
+		{
+			glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(POINT_LIGHT), &emptyLight, GL_STATIC_DRAW);
+		}
+		else
+		{
+			glBufferData(GL_SHADER_STORAGE_BUFFER, m_lights.size() * sizeof(POINT_LIGHT), m_lights.data(), GL_STATIC_DRAW);
+		}
+		m_bLightsDirty = false;
+	}
+
+	GLStateCache::BindBuffer(GL_SHADER_STORAGE_BUFFER, m_clusterBufferID);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, m_clusterRanges.size() * sizeof(CLUSTER_RANGE), m_clusterRanges.data(), GL_STREAM_DRAW);
+
+	GLStateCache::BindBuffer(GL_SHADER_STORAGE_BUFFER, m_lightIndexBufferID);
+	if (m_lightIndices.empty())
+	{
+		glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GLuint), &emptyIndex, GL_STREAM_DRAW);
+	}
+	else
+	{
+		glBufferData(GL_SHADER_STORAGE_BUFFER, m_lightIndices.size() * sizeof(GLuint), m_lightIndices.data(), GL_STREAM_DRAW);
+	}
+
+	GLStateCache::BindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used to bin the lights into the clusters
+ *  of the passed in view and to upload the results.  The
+ *  cluster bounds only depend on the projection and the
+ *  viewport, so they are only rebuilt when those change.
+ ***********************************************************/
+void ClusteredLights::Update(const glm::mat4& view, const glm::mat4& projection, int viewportWidth, int viewportHeight)
+{
+	if ((m_lightBufferID == 0) || (viewportWidth <= 0) || (viewportHeight <= 0))
+	{
+		return;
+	}
+
+	if ((m_bBoundsValid == false) ||
+		(memcmp(&projection, &m_projection, sizeof(glm::mat4)) != 0) ||
+		(viewportWidth != m_viewportWidth) ||
+		(viewportHeight != m_viewportHeight))
+	{
+		m_projection = projection;
+		m_viewportWidth = viewportWidth;
+		m_viewportHeight = viewportHeight;
+		BuildClusterBounds();
+	}
+
+	AssignLights(view);
+	UploadBuffers();
+}
@@ -0,0 +1,133 @@
+///////////////////////////////////////////////////////////////////////////////
+// clusteredlights.h
+// ============
+// store the scene point lights and bin them into view space clusters
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+// GLM Math Header inclusions
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  ClusteredLights
+ *
+ *  This class keeps the point lights of the scene in a
+ *  shader storage buffer.  Every frame the view frustum is
+ *  split into a grid of screen tiles and exponential depth
+ *  slices, and each light is added to the list of every
+ *  cluster its range touches.  The fragment shader finds
+ *  its cluster and only shades with the lights in that list.
+ ***********************************************************/
+class ClusteredLights
+{
+public:
+	// size of the cluster grid - must match the defines in the
+	// fragment shader
+	static const int TILES_X = 16;
+	static const int TILES_Y = 9;
+	static const int DEPTH_SLICES = 24;
+	static const int CLUSTER_COUNT = TILES_X * TILES_Y * DEPTH_SLICES;
+
+	// shader storage buffer binding points - must match the
+	// fragment shader
+	static const GLuint LIGHT_BUFFER_BINDING = 1;
+	static const GLuint CLUSTER_BUFFER_BINDING = 2;
+	static const GLuint LIGHT_INDEX_BUFFER_BINDING = 3;
+
+	// properties of one point light, laid out to match the
+	// std430 light buffer of the fragment shader
+	struct POINT_LIGHT
+	{
+		glm::vec3 position;
+		// distance at which the light has faded out completely
+		float range;
+		glm::vec3 ambientColor;
+		float focalStrength;
+		glm::vec3 diffuseColor;
+		float specularIntensity;
+		glm::vec3 specularColor;
+		float padding;
+	};
+
+	// constructor
+	ClusteredLights();
+	// destructor
+	~ClusteredLights();
+
+	// create the shader storage buffers
+	bool Initialize();
+
+	// add a light and return its index
+	int AddLight(const POINT_LIGHT& light);
+	// change a previously added light
+	void SetLight(int index, const POINT_LIGHT& light);
+	// remove all of the lights
+	void ClearLights();
+	int GetLightCount() const;
+	const POINT_LIGHT& GetLight(int index) const;
+
+	// bin the lights into the clusters of the passed in view
+	// and upload the cluster lists for the next draws
+	void Update(const glm::mat4& view, const glm::mat4& projection, int viewportWidth, int viewportHeight);
+
+	// values the fragment shader needs to find its cluster -
+	// the tile size in pixels and the depth slice scale and bias
+	glm::vec4 GetClusterParameters() const;
+	// number of light references in all of the cluster lists
+	int GetAssignedLightCount() const;
+
+private:
+	// the part of the light index list used by one cluster
+	struct CLUSTER_RANGE
+	{
+		GLuint offset;
+		GLuint count;
+	};
+
+	// view space bounding box of one cluster
+	struct CLUSTER_BOUNDS
+	{
+		glm::vec3 minPoint;
+		glm::vec3 maxPoint;
+	};
+
+	std::vector<POINT_LIGHT> m_lights;
+	bool m_bLightsDirty;
+
+	GLuint m_lightBufferID;
+	GLuint m_clusterBufferID;
+	GLuint m_lightIndexBufferID;
+
+	// the projection and viewport the cluster bounds were
+	// built for, the bounds are only rebuilt when they change
+	glm::mat4 m_projection;
+	int m_viewportWidth;
+	int m_viewportHeight;
+	bool m_bBoundsValid;
+	float m_nearPlane;
+	float m_farPlane;
+	float m_tileWidth;
+	float m_tileHeight;
+	std::vector<CLUSTER_BOUNDS> m_clusterBounds;
+
+	// results of the last update
+	std::vector<CLUSTER_RANGE> m_clusterRanges;
+	std::vector<GLuint> m_lightIndices;
+	// cluster of every light reference before they are sorted
+	std::vector<GLuint> m_assignedClusters;
+	std::vector<GLuint> m_assignedLights;
+
+	// get the depth slice that contains a view space depth
+	int GetDepthSlice(float depth) const;
+	// build the view space bounds of every cluster
+	void BuildClusterBounds();
+	// add every light to the clusters that it touches
+	void AssignLights(const glm::mat4& view);
+	// copy the lights and cluster lists into the buffers
+	void UploadBuffers();
+};
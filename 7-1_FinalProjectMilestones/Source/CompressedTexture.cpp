@@ -0,0 +1,786 @@
+///////////////////////////////////////////////////////////////////////////////
+// compressedtexture.cpp
+// ============
+// block compressed textures with precomputed mipmaps in DDS files
+///////////////////////////////////////////////////////////////////////////////
+
+#include "CompressedTexture.h"
+#include "TextureArrays.h"
+#include "TextureLoader.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+// declare the global variables
+namespace
+{
+	const int BYTES_PER_PIXEL = 4;
+	const int BLOCK_SIZE = 4;
+	const int BLOCK_PIXELS = BLOCK_SIZE * BLOCK_SIZE;
+
+	// DDS file identifiers
+	const uint32_t DDS_MAGIC = 0x20534444;		// "DDS "
+	const uint32_t FOURCC_DXT1 = 0x31545844;	// "DXT1"
+	const uint32_t FOURCC_DXT5 = 0x35545844;	// "DXT5"
+
+	// DDS header flags
+	const uint32_t DDSD_CAPS = 0x1;
+	const uint32_t DDSD_HEIGHT = 0x2;
+	const uint32_t DDSD_WIDTH = 0x4;
+	const uint32_t DDSD_PIXELFORMAT = 0x1000;
+	const uint32_t DDSD_MIPMAPCOUNT = 0x20000;
+	const uint32_t DDSD_LINEARSIZE = 0x80000;
+	const uint32_t DDPF_FOURCC = 0x4;
+	const uint32_t DDSCAPS_COMPLEX = 0x8;
+	const uint32_t DDSCAPS_TEXTURE = 0x1000;
+	const uint32_t DDSCAPS_MIPMAP = 0x400000;
+
+	// pixel format part of the DDS header
+	struct DDS_PIXELFORMAT
+	{
+		uint32_t size;
+		uint32_t flags;
+		uint32_t fourCC;
+		uint32_t rgbBitCount;
+		uint32_t redMask;
+		uint32_t greenMask;
+		uint32_t blueMask;
+		uint32_t alphaMask;
+	};
+
+	// header that follows the magic number of a DDS file
+	struct DDS_HEADER
+	{
+		uint32_t size;
+		uint32_t flags;
+		uint32_t height;
+		uint32_t width;
+		uint32_t pitchOrLinearSize;
+		uint32_t depth;
+		uint32_t mipMapCount;
+		uint32_t reserved1[11];
+		DDS_PIXELFORMAT pixelFormat;
+		uint32_t caps;
+		uint32_t caps2;
+		uint32_t caps3;
+		uint32_t caps4;
+		uint32_t reserved2;
+	};
+
+	static_assert(sizeof(DDS_HEADER) == 124, "the DDS header must be 124 bytes");
+
+	/***********************************************************
+	 *  PackColor565()
+	 *
+	 *  Round an 8 bit per channel color to the 5:6:5 format of
+	 *  the block endpoints.
+	 ***********************************************************/
+	uint16_t PackColor565(const float color[3])
+	{
+		int red = (int)(color[0] * 31.0f / 255.0f + 0.5f);
+		int green = (int)(color[1] * 63.0f / 255.0f + 0.5f);
+		int blue = (int)(color[2] * 31.0f / 255.0f + 0.5f);
+		red = (red < 0) ? 0 : ((red > 31) ? 31 : red);
+		green = (green < 0) ? 0 : ((green > 63) ? 63 : green);
+		blue = (blue < 0) ? 0 : ((blue > 31) ? 31 : blue);
+		return (uint16_t)((red << 11) | (green << 5) | blue);
+	}
+
+	/***********************************************************
+	 *  UnpackColor565()
+	 *
+	 *  Expand a 5:6:5 endpoint back to 8 bits per channel the
+	 *  way the GPU decodes it.
+	 ***********************************************************/
+	void UnpackColor565(uint16_t packed, int color[3])
+	{
+		int red = (packed >> 11) & 31;
+		int green = (packed >> 5) & 63;
+		int blue = packed & 31;
+		color[0] = (red << 3) | (red >> 2);
+		color[1] = (green << 2) | (green >> 4);
+		color[2] = (blue << 3) | (blue >> 2);
+	}
+
+	/***********************************************************
+	 *  EncodeColorBlock()
+	 *
+	 *  Compress the colors of a 4x4 block into 8 bytes.  The
+	 *  endpoints lie on the principal axis of the colors, found
+	 *  with a few power iterations of their covariance, and are
+	 *  pulled in slightly so the interpolated colors are used.
+	 *  The first endpoint is always the larger one, which
+	 *  selects the four color mode.
+	 ***********************************************************/
+	void EncodeColorBlock(const unsigned char* block, unsigned char* output)
+	{
+		float mean[3] = { 0.0f, 0.0f, 0.0f };
+		for (int i = 0; i < BLOCK_PIXELS; i++)
+		{
+			for (int channel = 0; channel < 3; channel++)
+			{
+				mean[channel] += block[i * BYTES_PER_PIXEL + channel];
+			}
+		}
+		for (int channel = 0; channel < 3; channel++)
+		{
+			mean[channel] /= BLOCK_PIXELS;
+		}
+
+		float covariance[3][3] = {};
+		for (int i = 0; i < BLOCK_PIXELS; i++)
+		{
+			float offset[3];
+			for (int channel = 0; channel < 3; channel++)
+			{
+				offset[channel] = block[i * BYTES_PER_PIXEL + channel] - mean[channel];
+			}
+			for (int row = 0; row < 3; row++)
+			{
+				for (int column = 0; column < 3; column++)
+				{
+					covariance[row][column] += offset[row] * offset[column];
+				}
+			}
+		}
+
+		float axis[3] = { 1.0f, 1.0f, 1.0f };
+		for (int iteration = 0; iteration < 8; iteration++)
+		{
+			float next[3];
+			for (int row = 0; row < 3; row++)
+			{
+				next[row] = covariance[row][0] * axis[0] + covariance[row][1] * axis[1] + covariance[row][2] * axis[2];
+			}
+			float length = sqrtf(next[0] * next[0] + next[1] * next[1] + next[2] * next[2]);
+			if (length < 1e-6f)
+			{
+				break;
+			}
+			for (int channel = 0; channel < 3; channel++)
+			{
+				axis[channel] = next[channel] / length;
+			}
+		}
+
+		// project the colors onto the axis to find the endpoints
+		float minProjection = 0.0f;
+		float maxProjection = 0.0f;
+		for (int i = 0; i < BLOCK_PIXELS; i++)
+		{
+			float projection = 0.0f;
+			for (int channel = 0; channel < 3; channel++)
+			{
+				projection += (block[i * BYTES_PER_PIXEL + channel] - mean[channel]) * axis[channel];
+			}
+			minProjection = (projection < minProjection) ? projection : minProjection;
+			maxProjection = (projection > maxProjection) ? projection : maxProjection;
+		}
+
+		float inset = (maxProjection - minProjection) / 16.0f;
+		float maxColor[3];
+		float minColor[3];
+		for (int channel = 0; channel < 3; channel++)
+		{
+			maxColor[channel] = mean[channel] + axis[channel] * (maxProjection - inset);
+			minColor[channel] = mean[channel] + axis[channel] * (minProjection + inset);
+		}
+
+		uint16_t color0 = PackColor565(maxColor);
+		uint16_t color1 = PackColor565(minColor);
+		if (color0 < color1)
+		{
+			uint16_t swap = color0;
+			color0 = color1;
+			color1 = swap;
+		}
+
+		uint32_t indices = 0;
+		if (color0 != color1)
+		{
+			int palette[4][3];
+			UnpackColor565(color0, palette[0]);
+			UnpackColor565(color1, palette[1]);
+			for (int channel = 0; channel < 3; channel++)
+			{
+				palette[2][channel] = (2 * palette[0][channel] + palette[1][channel]) / 3;
+				palette[3][channel] = (palette[0][channel] + 2 * palette[1][channel]) / 3;
+			}
+
+			for (int i = 0; i < BLOCK_PIXELS; i++)
+			{
+				int bestIndex = 0;
+				int bestDistance = INT32_MAX;
+				for (int index = 0; index < 4; index++)
+				{
+					int distance = 0;
+					for (int channel = 0; channel < 3; channel++)
+					{
+						int difference = block[i * BYTES_PER_PIXEL + channel] - palette[index][channel];
+						distance += difference * difference;
+					}
+					if (distance < bestDistance)
+					{
+						bestDistance = distance;
+						bestIndex = index;
+					}
+				}
+				indices |= (uint32_t)bestIndex << (i * 2);
+			}
+		}
+
+		output[0] = (unsigned char)(color0 & 0xFF);
+		output[1] = (unsigned char)(color0 >> 8);
+		output[2] = (unsigned char)(color1 & 0xFF);
+		output[3] = (unsigned char)(color1 >> 8);
+		for (int i = 0; i < 4; i++)
+		{
+			output[4 + i] = (unsigned char)(indices >> (i * 8));
+		}
+	}
+
+	/***********************************************************
+	 *  EncodeAlphaBlock()
+	 *
+	 *  Compress the alpha values of a 4x4 block into 8 bytes,
+	 *  using the smallest and largest alpha as the endpoints of
+	 *  the eight value mode.
+	 ***********************************************************/
+	void EncodeAlphaBlock(const unsigned char* block, unsigned char* output)
+	{
+		int alpha0 = 0;
+		int alpha1 = 255;
+		for (int i = 0; i < BLOCK_PIXELS; i++)
+		{
+			int alpha = block[i * BYTES_PER_PIXEL + 3];
+			alpha0 = (alpha > alpha0) ? alpha : alpha0;
+			alpha1 = (alpha < alpha1) ? alpha : alpha1;
+		}
+
+		uint64_t indices = 0;
+		if (alpha0 != alpha1)
+		{
+			int palette[8];
+			palette[0] = alpha0;
+			palette[1] = alpha1;
+			for (int i = 1; i < 7; i++)
+			{
+				palette[i + 1] = ((7 - i) * alpha0 + i * alpha1) / 7;
+			}
+
+			for (int i = 0; i < BLOCK_PIXELS; i++)
+			{
+				int alpha = block[i * BYTES_PER_PIXEL + 3];
+				int bestIndex = 0;
+				int bestDistance = 256;
+				for (int index = 0; index < 8; index++)
+				{
+					int distance = abs(alpha - palette[index]);
+					if (distance < bestDistance)
+					{
+						bestDistance = distance;
+						bestIndex = index;
+					}
+				}
+				indices |= (uint64_t)bestIndex << (i * 3);
+			}
+		}
+
+		output[0] = (unsigned char)alpha0;
+		output[1] = (unsigned char)alpha1;
+		for (int i = 0; i < 6; i++)
+		{
+			output[2 + i] = (unsigned char)(indices >> (i * 8));
+		}
+	}
+
+	/***********************************************************
+	 *  DownsampleImage()
+	 *
+	 *  Halve an RGBA image with a 2x2 box filter to make the
+	 *  next mipmap level.  A side of one pixel stays one pixel.
+	 ***********************************************************/
+	void DownsampleImage(
+		const std::vector<unsigned char>& source, int sourceWidth, int sourceHeight,
+		std::vector<unsigned char>& destination, int width, int height)
+	{
+		destination.resize((size_t)width * height * BYTES_PER_PIXEL);
+
+		for (int y = 0; y < height; y++)
+		{
+			int y0 = (y * 2 < sourceHeight) ? y * 2 : sourceHeight - 1;
+			int y1 = (y * 2 + 1 < sourceHeight) ? y * 2 + 1 : sourceHeight - 1;
+			for (int x = 0; x < width; x++)
+			{
+				int x0 = (x * 2 < sourceWidth) ? x * 2 : sourceWidth - 1;
+				int x1 = (x * 2 + 1 < sourceWidth) ? x * 2 + 1 : sourceWidth - 1;
+				for (int channel = 0; channel < BYTES_PER_PIXEL; channel++)
+				{
+					int sum =
+						source[((size_t)y0 * sourceWidth + x0) * BYTES_PER_PIXEL + channel] +
+						source[((size_t)y0 * sourceWidth + x1) * BYTES_PER_PIXEL + channel] +
+						source[((size_t)y1 * sourceWidth + x0) * BYTES_PER_PIXEL + channel] +
+						source[((size_t)y1 * sourceWidth + x1) * BYTES_PER_PIXEL + channel];
+					destination[((size_t)y * width + x) * BYTES_PER_PIXEL + channel] = (unsigned char)((sum + 2) / 4);
+				}
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  CompressedTexture()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+CompressedTexture::CompressedTexture()
+{
+	m_width = 0;
+	m_height = 0;
+	m_levelCount = 0;
+	m_format = FORMAT_BC1;
+}
+
+/***********************************************************
+ *  ~CompressedTexture()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+CompressedTexture::~CompressedTexture()
+{
+}
+
+/***********************************************************
+ *  CalculateLevelOffsets()
+ *
+ *  This method is used to calculate where every mipmap level
+ *  starts in the data, and returns the size of all levels.
+ ***********************************************************/
+size_t CompressedTexture::CalculateLevelOffsets()
+{
+	size_t offset = 0;
+	m_levelOffsets.resize(m_levelCount + 1);
+
+	for (int level = 0; level < m_levelCount; level++)
+	{
+		m_levelOffsets[level] = offset;
+		offset += CalculateLevelSize(GetInternalFormat(), m_width, m_height, level);
+	}
+	m_levelOffsets[m_levelCount] = offset;
+
+	return offset;
+}
+
+/***********************************************************
+ *  ReadFileHeader()
+ *
+ *  This method is used to read the header of an open DDS
+ *  file.  Only BC1 and BC3 textures with a full mipmap chain
+ *  are accepted, since those are what CompressFile() writes.
+ ***********************************************************/
+bool CompressedTexture::ReadFileHeader(std::istream& file, const std::string& filename)
+{
+	uint32_t magic = 0;
+	DDS_HEADER header;
+
+	file.read((char*)&magic, sizeof(magic));
+	file.read((char*)&header, sizeof(header));
+	if (!file || (magic != DDS_MAGIC) || (header.size != sizeof(DDS_HEADER)) ||
+		((header.pixelFormat.flags & DDPF_FOURCC) == 0))
+	{
+		std::cout << "Not a valid DDS file:" << filename << std::endl;
+		return false;
+	}
+
+	if (header.pixelFormat.fourCC == FOURCC_DXT1)
+	{
+		m_format = FORMAT_BC1;
+	}
+	else if (header.pixelFormat.fourCC == FOURCC_DXT5)
+	{
+		m_format = FORMAT_BC3;
+	}
+	else
+	{
+		std::cout << "Unsupported DDS block format, only DXT1 and DXT5 are read:" << filename << std::endl;
+		return false;
+	}
+
+	m_width = (int)header.width;
+	m_height = (int)header.height;
+	m_levelCount = (header.flags & DDSD_MIPMAPCOUNT) ? (int)header.mipMapCount : 1;
+
+	if ((m_width <= 0) || (m_height <= 0) || (m_levelCount <= 0) ||
+		(m_levelCount > GetFullLevelCount(m_width, m_height)))
+	{
+		std::cout << "Invalid DDS texture size:" << filename << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+/***********************************************************
+ *  ReadHeader()
+ *
+ *  This method is used to read the size and format of a DDS
+ *  file without reading its blocks.  A missing file returns
+ *  false without a message, since the DDS files are optional.
+ ***********************************************************/
+bool CompressedTexture::ReadHeader(const std::string& filename)
+{
+	std::ifstream file(filename, std::ios::binary);
+	if (!file)
+	{
+		return false;
+	}
+
+	m_data.clear();
+	if (ReadFileHeader(file, filename) == false)
+	{
+		return false;
+	}
+	CalculateLevelOffsets();
+
+	return true;
+}
+
+/***********************************************************
+ *  Read()
+ *
+ *  This method is used to read a DDS file with the blocks of
+ *  all of its mipmap levels.  It does not use OpenGL, so it
+ *  can be called from any thread.
+ ***********************************************************/
+bool CompressedTexture::Read(const std::string& filename)
+{
+	std::ifstream file(filename, std::ios::binary);
+	if (!file)
+	{
+		std::cout << "Could not open DDS file:" << filename << std::endl;
+		return false;
+	}
+
+	m_data.clear();
+	if (ReadFileHeader(file, filename) == false)
+	{
+		return false;
+	}
+
+	m_data.resize(CalculateLevelOffsets());
+	file.read((char*)m_data.data(), (std::streamsize)m_data.size());
+	if (!file)
+	{
+		std::cout << "DDS file is truncated:" << filename << std::endl;
+		m_data.clear();
+		return false;
+	}
+
+	return true;
+}
+
+/***********************************************************
+ *  Write()
+ *
+ *  This method is used to write the texture with all of its
+ *  mipmap levels to a DDS file.
+ ***********************************************************/
+bool CompressedTexture::Write(const std::string& filename) const
+{
+	if (m_data.empty())
+	{
+		return false;
+	}
+
+	DDS_HEADER header;
+	memset(&header, 0, sizeof(header));
+	header.size = sizeof(DDS_HEADER);
+	header.flags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT | DDSD_LINEARSIZE;
+	header.height = (uint32_t)m_height;
+	header.width = (uint32_t)m_width;
+	header.pitchOrLinearSize = (uint32_t)GetLevelSize(0);
+	header.mipMapCount = (uint32_t)m_levelCount;
+	header.pixelFormat.size = sizeof(DDS_PIXELFORMAT);
+	header.pixelFormat.flags = DDPF_FOURCC;
+	header.pixelFormat.fourCC = (m_format == FORMAT_BC3) ? FOURCC_DXT5 : FOURCC_DXT1;
+	header.caps = DDSCAPS_COMPLEX | DDSCAPS_TEXTURE | DDSCAPS_MIPMAP;
+
+	std::ofstream file(filename, std::ios::binary);
+	file.write((const char*)&DDS_MAGIC, sizeof(DDS_MAGIC));
+	file.write((const char*)&header, sizeof(header));
+	file.write((const char*)m_data.data(), (std::streamsize)m_data.size());
+
+	if (!file)
+	{
+		std::cout << "Could not write DDS file:" << filename << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+/***********************************************************
+ *  Compress()
+ *
+ *  This method is used to compress RGBA pixels, stored with
+ *  the bottom row first, into every mipmap level down to
+ *  1x1.  Each level is box filtered from the one above it
+ *  before it is compressed.
+ ***********************************************************/
+void CompressedTexture::Compress(const unsigned char* pixels, int width, int height, COMPRESSION_FORMAT format)
+{
+	if (format == FORMAT_AUTO)
+	{
+		format = FORMAT_BC1;
+		for (size_t i = 0; i < (size_t)width * height; i++)
+		{
+			if (pixels[i * BYTES_PER_PIXEL + 3] != 255)
+			{
+				format = FORMAT_BC3;
+				break;
+			}
+		}
+	}
+
+	m_width = width;
+	m_height = height;
+	m_format = format;
+	m_levelCount = GetFullLevelCount(width, height);
+	m_data.assign(CalculateLevelOffsets(), 0);
+
+	std::vector<unsigned char> levelPixels(pixels, pixels + (size_t)width * height * BYTES_PER_PIXEL);
+	std::vector<unsigned char> nextPixels;
+	unsigned char block[BLOCK_PIXELS * BYTES_PER_PIXEL];
+
+	for (int level = 0; level < m_levelCount; level++)
+	{
+		int levelWidth = (width >> level) > 0 ? (width >> level) : 1;
+		int levelHeight = (height >> level) > 0 ? (height >> level) : 1;
+		unsigned char* output = &m_data[m_levelOffsets[level]];
+
+		for (int blockY = 0; blockY < levelHeight; blockY += BLOCK_SIZE)
+		{
+			for (int blockX = 0; blockX < levelWidth; blockX += BLOCK_SIZE)
+			{
+				// repeat the edge pixels in blocks past the image edge
+				for (int y = 0; y < BLOCK_SIZE; y++)
+				{
+					int sourceY = (blockY + y < levelHeight) ? blockY + y : levelHeight - 1;
+					for (int x = 0; x < BLOCK_SIZE; x++)
+					{
+						int sourceX = (blockX + x < levelWidth) ? blockX + x : levelWidth - 1;
+						memcpy(&block[(y * BLOCK_SIZE + x) * BYTES_PER_PIXEL],
+							&levelPixels[((size_t)sourceY * levelWidth + sourceX) * BYTES_PER_PIXEL],
+							BYTES_PER_PIXEL);
+					}
+				}
+
+				if (m_format == FORMAT_BC3)
+				{
+					EncodeAlphaBlock(block, output);
+					output += 8;
+				}
+				EncodeColorBlock(block, output);
+				output += 8;
+			}
+		}
+
+		if (level + 1 < m_levelCount)
+		{
+			int nextWidth = (levelWidth > 1) ? levelWidth / 2 : 1;
+			int nextHeight = (levelHeight > 1) ? levelHeight / 2 : 1;
+			DownsampleImage(levelPixels, levelWidth, levelHeight, nextPixels, nextWidth, nextHeight);
+			levelPixels.swap(nextPixels);
+		}
+	}
+}
+
+/***********************************************************
+ *  GetWidth()
+ *
+ *  This method is used to get the width of the top level.
+ ***********************************************************/
+int CompressedTexture::GetWidth() const
+{
+	return m_width;
+}
+
+/***********************************************************
+ *  GetHeight()
+ *
+ *  This method is used to get the height of the top level.
+ ***********************************************************/
+int CompressedTexture::GetHeight() const
+{
+	return m_height;
+}
+
+/***********************************************************
+ *  GetLevelCount()
+ *
+ *  This method is used to get the number of mipmap levels.
+ ***********************************************************/
+int CompressedTexture::GetLevelCount() const
+{
+	return m_levelCount;
+}
+
+/***********************************************************
+ *  GetInternalFormat()
+ *
+ *  This method is used to get the OpenGL internal format of
+ *  the compressed blocks.
+ ***********************************************************/
+GLenum CompressedTexture::GetInternalFormat() const
+{
+	return (m_format == FORMAT_BC3) ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+}
+
+/***********************************************************
+ *  GetFormatName()
+ *
+ *  This method is used to get the name of the block format.
+ ***********************************************************/
+const char* CompressedTexture::GetFormatName() const
+{
+	return (m_format == FORMAT_BC3) ? "BC3" : "BC1";
+}
+
+/***********************************************************
+ *  GetData()
+ *
+ *  This method is used to get the blocks of all of the
+ *  mipmap levels, starting with the largest level.
+ ***********************************************************/
+const std::vector<unsigned char>& CompressedTexture::GetData() const
+{
+	return m_data;
+}
+
+/***********************************************************
+ *  GetLevelOffset()
+ *
+ *  This method is used to get where a mipmap level starts
+ *  in the data.
+ ***********************************************************/
+size_t CompressedTexture::GetLevelOffset(int level) const
+{
+	return m_levelOffsets[level];
+}
+
+/***********************************************************
+ *  GetLevelSize()
+ *
+ *  This method is used to get the size of the blocks of a
+ *  mipmap level.
+ ***********************************************************/
+size_t CompressedTexture::GetLevelSize(int level) const
+{
+	return m_levelOffsets[level + 1] - m_levelOffsets[level];
+}
+
+/***********************************************************
+ *  GetCompressedFilename()
+ *
+ *  This method is used to get the name of the DDS file that
+ *  is loaded instead of an image file, which is the image
+ *  file name with a .dds extension.
+ ***********************************************************/
+std::string CompressedTexture::GetCompressedFilename(const std::string& imageFilename)
+{
+	size_t extension = imageFilename.find_last_of('.');
+	size_t folder = imageFilename.find_last_of("/\\");
+
+	if ((extension == std::string::npos) || ((folder != std::string::npos) && (extension < folder)))
+	{
+		return imageFilename + ".dds";
+	}
+	return imageFilename.substr(0, extension) + ".dds";
+}
+
+/***********************************************************
+ *  GetFullLevelCount()
+ *
+ *  This method is used to get the number of mipmap levels
+ *  from the passed in size down to 1x1.
+ ***********************************************************/
+int CompressedTexture::GetFullLevelCount(int width, int height)
+{
+	int levels = 1;
+	int size = (width > height) ? width : height;
+	while (size > 1)
+	{
+		size >>= 1;
+		levels++;
+	}
+	return levels;
+}
+
+/***********************************************************
+ *  CalculateLevelSize()
+ *
+ *  This method is used to get the size of the blocks of one
+ *  mipmap level of a BC1 or BC3 texture of the passed in
+ *  size.  Levels smaller than a block still use a block.
+ ***********************************************************/
+size_t CompressedTexture::CalculateLevelSize(GLenum internalFormat, int width, int height, int level)
+{
+	int levelWidth = (width >> level) > 0 ? (width >> level) : 1;
+	int levelHeight = (height >> level) > 0 ? (height >> level) : 1;
+	size_t blocks = (size_t)((levelWidth + BLOCK_SIZE - 1) / BLOCK_SIZE) * ((levelHeight + BLOCK_SIZE - 1) / BLOCK_SIZE);
+
+	return blocks * ((internalFormat == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT) ? 16 : 8);
+}
+
+/***********************************************************
+ *  CompressFile()
+ *
+ *  This method is used to convert an image file into a DDS
+ *  file offline.  The image is resized to powers of two, so
+ *  it fits its texture array without being resampled at
+ *  load time, then compressed with its full mipmap chain.
+ ***********************************************************/
+bool CompressedTexture::CompressFile(const std::string& inputFilename, const std::string& outputFilename, COMPRESSION_FORMAT format)
+{
+	int width = 0;
+	int height = 0;
+	int colorChannels = 0;
+	std::vector<unsigned char> pixels;
+
+	if (TextureLoader::DecodeImage(inputFilename, pixels, width, height, colorChannels) == false)
+	{
+		std::cout << "Could not load image:" << inputFilename << std::endl;
+		return false;
+	}
+
+	int textureWidth = width;
+	int textureHeight = height;
+	TextureArrays::ResizeToPowerOfTwo(pixels, textureWidth, textureHeight);
+
+	CompressedTexture texture;
+	texture.Compress(pixels.data(), textureWidth, textureHeight, format);
+	if (texture.Write(outputFilename) == false)
+	{
+		return false;
+	}
+
+	// the uncompressed size includes the mipmaps the GPU generated
+	size_t uncompressedBytes = 0;
+	for (int level = 0; level < texture.GetLevelCount(); level++)
+	{
+		int levelWidth = (textureWidth >> level) > 0 ? (textureWidth >> level) : 1;
+		int levelHeight = (textureHeight >> level) > 0 ? (textureHeight >> level) : 1;
+		uncompressedBytes += (size_t)levelWidth * levelHeight * BYTES_PER_PIXEL;
+	}
+
+	std::cout << "Compressed " << inputFilename << " (" << width << "x" << height << "x" << colorChannels
+		<< ") into " << outputFilename << ": " << textureWidth << "x" << textureHeight << " "
+		<< texture.GetFormatName() << ", " << texture.GetLevelCount() << " mipmap levels, "
+		<< texture.GetData().size() << " bytes instead of " << uncompressedBytes << std::endl;
+
+	return true;
+}
@@ -0,0 +1,91 @@
+///////////////////////////////////////////////////////////////////////////////
+// compressedtexture.h
+// ============
+// block compressed textures with precomputed mipmaps in DDS files
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  CompressedTexture
+ *
+ *  This class holds a BC1 or BC3 compressed texture with its
+ *  complete mipmap chain, and reads and writes it as a DDS
+ *  file.  The images are compressed offline, so at load time
+ *  the blocks go straight to the GPU without decoding the
+ *  image or generating any mipmaps.
+ *
+ *  The rows are stored bottom up, like the flipped images
+ *  of the stb_image path, so the blocks can be uploaded to
+ *  OpenGL without flipping them.
+ ***********************************************************/
+class CompressedTexture
+{
+public:
+	// block format chosen when compressing an image
+	enum COMPRESSION_FORMAT
+	{
+		// BC3 when the image has any transparency, BC1 otherwise
+		FORMAT_AUTO,
+		// opaque RGB, 8 bytes per 4x4 block
+		FORMAT_BC1,
+		// RGBA, 16 bytes per 4x4 block
+		FORMAT_BC3
+	};
+
+	// constructor
+	CompressedTexture();
+	// destructor
+	~CompressedTexture();
+
+	// read the size and format of a DDS file without its blocks
+	bool ReadHeader(const std::string& filename);
+	// read a DDS file with all of its mipmap levels
+	bool Read(const std::string& filename);
+	// write the texture to a DDS file
+	bool Write(const std::string& filename) const;
+
+	// compress bottom up RGBA pixels into every mipmap level
+	void Compress(const unsigned char* pixels, int width, int height, COMPRESSION_FORMAT format);
+
+	int GetWidth() const;
+	int GetHeight() const;
+	int GetLevelCount() const;
+	// OpenGL internal format of the blocks
+	GLenum GetInternalFormat() const;
+	// short name of the block format for the console output
+	const char* GetFormatName() const;
+
+	// all of the mipmap levels, the largest one first
+	const std::vector<unsigned char>& GetData() const;
+	size_t GetLevelOffset(int level) const;
+	size_t GetLevelSize(int level) const;
+
+	// the DDS file that is used instead of an image file
+	static std::string GetCompressedFilename(const std::string& imageFilename);
+	// number of mipmap levels down to 1x1 for an image size
+	static int GetFullLevelCount(int width, int height);
+	// size of the blocks of one mipmap level of a texture
+	static size_t CalculateLevelSize(GLenum internalFormat, int width, int height, int level);
+	// compress an image file into a DDS file
+	static bool CompressFile(const std::string& inputFilename, const std::string& outputFilename, COMPRESSION_FORMAT format);
+
+private:
+	int m_width;
+	int m_height;
+	int m_levelCount;
+	COMPRESSION_FORMAT m_format;
+	std::vector<unsigned char> m_data;
+	std::vector<size_t> m_levelOffsets;
+
+	// calculate the offsets of the levels and the data size
+	size_t CalculateLevelOffsets();
+	// read and check the header of an open DDS file
+	bool ReadFileHeader(std::istream& file, const std::string& filename);
+};
@@ -0,0 +1,235 @@
+///////////////////////////////////////////////////////////////////////////////
+// deferredshading.cpp
+// ============
+// keep the G-buffer of the deferred path and light it once per pixel
+///////////////////////////////////////////////////////////////////////////////
+
+#include "DeferredShading.h"
+#include "GLStateCache.h"
+
+#include <iostream>
+
+// declare the global variables
+namespace
+{
+	/***********************************************************
+	 *  CreateTarget()
+	 *
+	 *  Create a texture the G-buffer is drawn into, bound to
+	 *  the texture unit the lighting pass reads it from.  The
+	 *  pass reads single texels, so it is never filtered.
+	 ***********************************************************/
+	GLuint CreateTarget(GLuint textureUnit, GLenum internalFormat, int width, int height)
+	{
+		GLuint textureID = 0;
+		glGenTextures(1, &textureID);
+		GLStateCache::ActiveTexture(GL_TEXTURE0 + textureUnit);
+		GLStateCache::BindTexture(GL_TEXTURE_2D, textureID);
+
+		glTexStorage2D(GL_TEXTURE_2D, 1, internalFormat, width, height);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+		GLStateCache::ActiveTexture(GL_TEXTURE0);
+		return textureID;
+	}
+}
+
+/***********************************************************
+ *  DeferredShading()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+DeferredShading::DeferredShading()
+{
+	m_framebufferID = 0;
+	m_albedoTextureID = 0;
+	m_normalTextureID = 0;
+	m_depthTextureID = 0;
+	m_width = 0;
+	m_height = 0;
+	m_previousFramebuffer = 0;
+	m_vertexArrayID = 0;
+}
+
+/***********************************************************
+ *  ~DeferredShading()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+DeferredShading::~DeferredShading()
+{
+	DestroyBuffers();
+
+	if (m_vertexArrayID != 0)
+	{
+		GLStateCache::DeleteVertexArrays(1, &m_vertexArrayID);
+		m_vertexArrayID = 0;
+	}
+}
+
+/***********************************************************
+ *  CreateBuffers()
+ *
+ *  This method is used to create the G-buffer at the passed
+ *  in size.  The base color and material index take 4
+ *  bytes, the normal and the lit flag 4 more, and the depth
+ *  has the format of the window's depth buffer so it can be
+ *  copied there.
+ ***********************************************************/
+bool DeferredShading::CreateBuffers(int width, int height)
+{
+	DestroyBuffers();
+
+	m_albedoTextureID = CreateTarget(ALBEDO_TEXTURE_UNIT, GL_RGBA8, width, height);
+	m_normalTextureID = CreateTarget(NORMAL_TEXTURE_UNIT, GL_RGB10_A2, width, height);
+	m_depthTextureID = CreateTarget(DEPTH_TEXTURE_UNIT, GL_DEPTH24_STENCIL8, width, height);
+
+	glGenFramebuffers(1, &m_framebufferID);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebufferID);
+	glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, m_albedoTextureID, 0);
+	glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, m_normalTextureID, 0);
+	glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, m_depthTextureID, 0);
+	const GLenum drawBuffers[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+	glDrawBuffers(2, drawBuffers);
+
+	bool bComplete = (glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+	glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)m_previousFramebuffer);
+	if (bComplete == false)
+	{
+		std::cout << "ERROR: G-buffer of " << width << "x" << height << " is incomplete" << std::endl;
+		DestroyBuffers();
+		return false;
+	}
+
+	m_width = width;
+	m_height = height;
+	std::cout << "INFO: Created G-buffer of " << width << "x" << height << std::endl;
+	return true;
+}
+
+/***********************************************************
+ *  DestroyBuffers()
+ *
+ *  This method is used to delete the G-buffer.
+ ***********************************************************/
+void DeferredShading::DestroyBuffers()
+{
+	if (m_framebufferID != 0)
+	{
+		glDeleteFramebuffers(1, &m_framebufferID);
+		m_framebufferID = 0;
+	}
+	if (m_albedoTextureID != 0)
+	{
+		GLuint textureIDs[3] = { m_albedoTextureID, m_normalTextureID, m_depthTextureID };
+		GLStateCache::DeleteTextures(3, textureIDs);
+		m_albedoTextureID = 0;
+		m_normalTextureID = 0;
+		m_depthTextureID = 0;
+	}
+	m_width = 0;
+	m_height = 0;
+}
+
+/***********************************************************
+ *  FitViewport()
+ *
+ *  This method is used to create the G-buffer again when
+ *  the viewport is not the size it was created with.  The
+ *  framebuffer bound now is the one it is lit into.
+ ***********************************************************/
+bool DeferredShading::FitViewport()
+{
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &m_previousFramebuffer);
+
+	if ((viewport[2] == m_width) && (viewport[3] == m_height))
+	{
+		return true;
+	}
+	return CreateBuffers(viewport[2], viewport[3]);
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used to create the G-buffer, the vertex
+ *  array of the screen triangle and the lighting variant
+ *  when deferred shading is turned on, so none of them
+ *  lands in a frame.
+ ***********************************************************/
+bool DeferredShading::Initialize(ShaderManager* pShaders)
+{
+	pShaders->PrepareVariants(std::vector<int>(1, ShaderManager::FEATURE_DEFERRED_LIGHTING));
+
+	if (m_vertexArrayID == 0)
+	{
+		glGenVertexArrays(1, &m_vertexArrayID);
+	}
+	return FitViewport();
+}
+
+/***********************************************************
+ *  BeginGeometry()
+ *
+ *  This method is used to bind the G-buffer for drawing the
+ *  opaque objects into, creating it again whenever the
+ *  viewport changed size.  Only the depth is cleared, as
+ *  the lighting pass skips every pixel left at the far
+ *  plane without reading the rest.
+ ***********************************************************/
+bool DeferredShading::BeginGeometry()
+{
+	if (FitViewport() == false)
+	{
+		return false;
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebufferID);
+	GLStateCache::DepthMask(GL_TRUE);
+	glClear(GL_DEPTH_BUFFER_BIT);
+	return true;
+}
+
+/***********************************************************
+ *  LightScene()
+ *
+ *  This method is used to light the G-buffer into the
+ *  framebuffer that was bound before it.  One triangle over
+ *  the screen runs the deferred lighting variant for every
+ *  pixel, without testing depth or blending, and the depth
+ *  of the G-buffer is then copied so later draws are tested
+ *  against the opaque objects.  Both are left as they were.
+ ***********************************************************/
+void DeferredShading::LightScene(ShaderManager* pShaders)
+{
+	bool bDepthTest = GLStateCache::IsEnabled(GL_DEPTH_TEST);
+	bool bBlend = GLStateCache::IsEnabled(GL_BLEND);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)m_previousFramebuffer);
+	GLStateCache::Disable(GL_DEPTH_TEST);
+	GLStateCache::Disable(GL_BLEND);
+
+	GLStateCache::UseProgram(pShaders->GetVariant(ShaderManager::FEATURE_DEFERRED_LIGHTING));
+	GLStateCache::BindVertexArray(m_vertexArrayID);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	GLStateCache::BindVertexArray(0);
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, m_framebufferID);
+	glBlitFramebuffer(0, 0, m_width, m_height, 0, 0, m_width, m_height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+	glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)m_previousFramebuffer);
+
+	if (bDepthTest)
+	{
+		GLStateCache::Enable(GL_DEPTH_TEST);
+	}
+	if (bBlend)
+	{
+		GLStateCache::Enable(GL_BLEND);
+	}
+	pShaders->use();
+}
@@ -0,0 +1,73 @@
+///////////////////////////////////////////////////////////////////////////////
+// deferredshading.h
+// ============
+// keep the G-buffer of the deferred path and light it once per pixel
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+
+#include <GL/glew.h>
+
+/***********************************************************
+ *  DeferredShading
+ *
+ *  This class keeps the G-buffer the deferred path draws the
+ *  opaque objects into - the base color with the material
+ *  index in its alpha, the normal with a flag for lit
+ *  surfaces, and the depth.  Lighting it draws one triangle
+ *  over the screen with the deferred lighting variant, so
+ *  every pixel walks its cluster's lights once, however many
+ *  surfaces were drawn over each other there.  The depth is
+ *  then copied into the framebuffer, so the blended objects
+ *  that the forward path draws afterwards are hidden behind
+ *  the opaque ones.
+ ***********************************************************/
+class DeferredShading
+{
+public:
+	// texture units of the G-buffer, after the shadow maps -
+	// must match the fragment shader
+	static const GLuint ALBEDO_TEXTURE_UNIT = 10;
+	static const GLuint NORMAL_TEXTURE_UNIT = 11;
+	static const GLuint DEPTH_TEXTURE_UNIT = 12;
+
+	// constructor
+	DeferredShading();
+	// destructor
+	~DeferredShading();
+
+	// create the G-buffer at the size of the viewport and
+	// compile the lighting variant, so the first deferred frame
+	// does neither - returns false if the G-buffer could not
+	// be created
+	bool Initialize(ShaderManager* pShaders);
+	// bind the G-buffer, created again if the viewport changed
+	// size, and clear it - returns false if it could not be
+	bool BeginGeometry();
+	// light the G-buffer into the framebuffer that was bound
+	// before BeginGeometry(), and copy its depth there
+	void LightScene(ShaderManager* pShaders);
+
+private:
+	// the G-buffer, the size it was created with, and the
+	// framebuffer that was bound before it
+	GLuint m_framebufferID;
+	GLuint m_albedoTextureID;
+	GLuint m_normalTextureID;
+	GLuint m_depthTextureID;
+	int m_width;
+	int m_height;
+	GLint m_previousFramebuffer;
+	// empty vertex array the screen triangle is drawn with
+	GLuint m_vertexArrayID;
+
+	// create the G-buffer at a size, replacing any old one
+	bool CreateBuffers(int width, int height);
+	// create the G-buffer again when the viewport is not the
+	// size it was created with
+	bool FitViewport();
+	// delete the G-buffer
+	void DestroyBuffers();
+};
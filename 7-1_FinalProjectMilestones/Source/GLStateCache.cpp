@@ -0,0 +1,592 @@
+///////////////////////////////////////////////////////////////////////////////
+// glstatecache.cpp
+// ============
+// remember the bound OpenGL state and skip the calls that change nothing
+///////////////////////////////////////////////////////////////////////////////
+
+#include "GLStateCache.h"
+
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+// declare the global variables
+namespace
+{
+	// the object of a binding that is not known, so the next
+	// call for it is always sent - every binding starts out
+	// this way, since the cache cannot see the state it was
+	// created into
+	const GLuint UNKNOWN_OBJECT = 0xFFFFFFFF;
+	const int UNKNOWN_STATE = -1;
+	// texture units the bindings are remembered for
+	const int MAX_TEXTURE_UNITS = 32;
+	// largest uniform value remembered, a 4x4 matrix
+	const size_t MAX_UNIFORM_SIZE = 64;
+
+	// the buffer targets and texture targets whose bindings are
+	// remembered - the element array buffer is part of the
+	// vertex array, so it is not among them
+	const GLenum BUFFER_TARGETS[] =
+	{
+		GL_ARRAY_BUFFER,
+		GL_COPY_READ_BUFFER,
+		GL_COPY_WRITE_BUFFER,
+		GL_DRAW_INDIRECT_BUFFER,
+		GL_PIXEL_UNPACK_BUFFER,
+		GL_SHADER_STORAGE_BUFFER,
+		GL_UNIFORM_BUFFER
+	};
+	const int BUFFER_TARGET_COUNT = sizeof(BUFFER_TARGETS) / sizeof(BUFFER_TARGETS[0]);
+	const GLenum TEXTURE_TARGETS[] =
+	{
+		GL_TEXTURE_2D,
+		GL_TEXTURE_2D_ARRAY
+	};
+	const int TEXTURE_TARGET_COUNT = sizeof(TEXTURE_TARGETS) / sizeof(TEXTURE_TARGETS[0]);
+	const GLenum CAPABILITIES[] =
+	{
+		GL_BLEND,
+		GL_CULL_FACE,
+		GL_DEPTH_TEST
+	};
+	const int CAPABILITY_COUNT = sizeof(CAPABILITIES) / sizeof(CAPABILITIES[0]);
+
+	// the last value set into one uniform, empty until it is set
+	struct UNIFORM_VALUE
+	{
+		size_t size;
+		unsigned char data[MAX_UNIFORM_SIZE];
+	};
+
+	// everything the cache remembers about the context
+	struct CACHED_STATE
+	{
+		GLuint program;
+		GLuint vertexArray;
+		GLuint buffers[BUFFER_TARGET_COUNT];
+		// the active unit, as an index from GL_TEXTURE0
+		GLuint activeTexture;
+		GLuint textures[MAX_TEXTURE_UNITS][TEXTURE_TARGET_COUNT];
+		// enabled state of each capability, or UNKNOWN_STATE
+		int capabilities[CAPABILITY_COUNT];
+		int depthMask;
+		GLenum blendSourceFactor;
+		GLenum blendDestinationFactor;
+		// the uniform values of every program, by location
+		std::unordered_map<GLuint, std::vector<UNIFORM_VALUE>> uniforms;
+		GLStateCache::STATE_STATS stats;
+	};
+
+	/***********************************************************
+	 *  GetState()
+	 *
+	 *  Get the remembered state, which starts out with every
+	 *  binding unknown.
+	 ***********************************************************/
+	CACHED_STATE& GetState()
+	{
+		static CACHED_STATE* pState = NULL;
+		if (pState == NULL)
+		{
+			pState = new CACHED_STATE();
+			pState->program = UNKNOWN_OBJECT;
+			pState->vertexArray = UNKNOWN_OBJECT;
+			for (int i = 0; i < BUFFER_TARGET_COUNT; i++)
+			{
+				pState->buffers[i] = UNKNOWN_OBJECT;
+			}
+			pState->activeTexture = UNKNOWN_OBJECT;
+			for (int unit = 0; unit < MAX_TEXTURE_UNITS; unit++)
+			{
+				for (int i = 0; i < TEXTURE_TARGET_COUNT; i++)
+				{
+					pState->textures[unit][i] = UNKNOWN_OBJECT;
+				}
+			}
+			for (int i = 0; i < CAPABILITY_COUNT; i++)
+			{
+				pState->capabilities[i] = UNKNOWN_STATE;
+			}
+			pState->depthMask = UNKNOWN_STATE;
+			pState->blendSourceFactor = UNKNOWN_OBJECT;
+			pState->blendDestinationFactor = UNKNOWN_OBJECT;
+			pState->stats = GLStateCache::STATE_STATS();
+		}
+		return *pState;
+	}
+
+	/***********************************************************
+	 *  IsUnchanged()
+	 *
+	 *  Count a state call as skipped when it would not change
+	 *  anything, or as sent when it would.
+	 ***********************************************************/
+	bool IsUnchanged(bool bUnchanged)
+	{
+		CACHED_STATE& state = GetState();
+		if (bUnchanged)
+		{
+			state.stats.elidedCalls++;
+		}
+		else
+		{
+			state.stats.issuedCalls++;
+		}
+		return bUnchanged;
+	}
+
+	/***********************************************************
+	 *  FindBufferBinding()
+	 *
+	 *  Find the remembered buffer of a target, or NULL when the
+	 *  target is not one the cache remembers.
+	 ***********************************************************/
+	GLuint* FindBufferBinding(GLenum target)
+	{
+		for (int i = 0; i < BUFFER_TARGET_COUNT; i++)
+		{
+			if (BUFFER_TARGETS[i] == target)
+			{
+				return &GetState().buffers[i];
+			}
+		}
+		return NULL;
+	}
+
+	/***********************************************************
+	 *  FindTextureBinding()
+	 *
+	 *  Find the remembered texture of a target on the active
+	 *  unit, or NULL when the unit or the target is not one the
+	 *  cache remembers.
+	 ***********************************************************/
+	GLuint* FindTextureBinding(GLenum target)
+	{
+		CACHED_STATE& state = GetState();
+		if (state.activeTexture >= (GLuint)MAX_TEXTURE_UNITS)
+		{
+			return NULL;
+		}
+
+		for (int i = 0; i < TEXTURE_TARGET_COUNT; i++)
+		{
+			if (TEXTURE_TARGETS[i] == target)
+			{
+				return &state.textures[state.activeTexture][i];
+			}
+		}
+		return NULL;
+	}
+
+	/***********************************************************
+	 *  FindCapability()
+	 *
+	 *  Find the remembered state of a capability, or NULL when
+	 *  it is not one the cache remembers.
+	 ***********************************************************/
+	int* FindCapability(GLenum capability)
+	{
+		for (int i = 0; i < CAPABILITY_COUNT; i++)
+		{
+			if (CAPABILITIES[i] == capability)
+			{
+				return &GetState().capabilities[i];
+			}
+		}
+		return NULL;
+	}
+}
+
+/***********************************************************
+ *  UseProgram()
+ *
+ *  This method is used to make a program current, unless it
+ *  already is.
+ ***********************************************************/
+void GLStateCache::UseProgram(GLuint programID)
+{
+	CACHED_STATE& state = GetState();
+	if (IsUnchanged(state.program == programID))
+	{
+		return;
+	}
+
+	glUseProgram(programID);
+	state.program = programID;
+}
+
+/***********************************************************
+ *  BindVertexArray()
+ *
+ *  This method is used to bind a vertex array, unless it
+ *  already is.
+ ***********************************************************/
+void GLStateCache::BindVertexArray(GLuint vertexArrayID)
+{
+	CACHED_STATE& state = GetState();
+	if (IsUnchanged(state.vertexArray == vertexArrayID))
+	{
+		return;
+	}
+
+	glBindVertexArray(vertexArrayID);
+	state.vertexArray = vertexArrayID;
+}
+
+/***********************************************************
+ *  BindBuffer()
+ *
+ *  This method is used to bind a buffer to a target, unless
+ *  it already is.  The element array buffer belongs to the
+ *  bound vertex array, so its binding is always sent.
+ ***********************************************************/
+void GLStateCache::BindBuffer(GLenum target, GLuint bufferID)
+{
+	GLuint* pBinding = FindBufferBinding(target);
+	if (IsUnchanged((pBinding != NULL) && (*pBinding == bufferID)))
+	{
+		return;
+	}
+
+	glBindBuffer(target, bufferID);
+	if (pBinding != NULL)
+	{
+		*pBinding = bufferID;
+	}
+}
+
+/***********************************************************
+ *  BindBufferBase()
+ *
+ *  This method is used to bind a buffer to an indexed binding
+ *  point.  That binds it to the general target as well, which
+ *  the cache takes note of.
+ ***********************************************************/
+void GLStateCache::BindBufferBase(GLenum target, GLuint index, GLuint bufferID)
+{
+	IsUnchanged(false);
+	glBindBufferBase(target, index, bufferID);
+
+	GLuint* pBinding = FindBufferBinding(target);
+	if (pBinding != NULL)
+	{
+		*pBinding = bufferID;
+	}
+}
+
+/***********************************************************
+ *  BindBufferRange()
+ *
+ *  This method is used to bind part of a buffer to an
+ *  indexed binding point, which binds it to the general
+ *  target as well, like BindBufferBase().
+ ***********************************************************/
+void GLStateCache::BindBufferRange(GLenum target, GLuint index, GLuint bufferID, GLintptr offset, GLsizeiptr size)
+{
+	IsUnchanged(false);
+	glBindBufferRange(target, index, bufferID, offset, size);
+
+	GLuint* pBinding = FindBufferBinding(target);
+	if (pBinding != NULL)
+	{
+		*pBinding = bufferID;
+	}
+}
+
+/***********************************************************
+ *  ActiveTexture()
+ *
+ *  This method is used to select the texture unit the next
+ *  texture binding is made on, unless it already is.
+ ***********************************************************/
+void GLStateCache::ActiveTexture(GLenum textureUnit)
+{
+	CACHED_STATE& state = GetState();
+	GLuint unit = (GLuint)(textureUnit - GL_TEXTURE0);
+	if (IsUnchanged(state.activeTexture == unit))
+	{
+		return;
+	}
+
+	glActiveTexture(textureUnit);
+	state.activeTexture = unit;
+}
+
+/***********************************************************
+ *  BindTexture()
+ *
+ *  This method is used to bind a texture to a target of the
+ *  active texture unit, unless it already is.
+ ***********************************************************/
+void GLStateCache::BindTexture(GLenum target, GLuint textureID)
+{
+	GLuint* pBinding = FindTextureBinding(target);
+	if (IsUnchanged((pBinding != NULL) && (*pBinding == textureID)))
+	{
+		return;
+	}
+
+	glBindTexture(target, textureID);
+	if (pBinding != NULL)
+	{
+		*pBinding = textureID;
+	}
+}
+
+/***********************************************************
+ *  Enable()
+ *
+ *  This method is used to enable a capability, unless it
+ *  already is.
+ ***********************************************************/
+void GLStateCache::Enable(GLenum capability)
+{
+	int* pState = FindCapability(capability);
+	if (IsUnchanged((pState != NULL) && (*pState == 1)))
+	{
+		return;
+	}
+
+	glEnable(capability);
+	if (pState != NULL)
+	{
+		*pState = 1;
+	}
+}
+
+/***********************************************************
+ *  Disable()
+ *
+ *  This method is used to disable a capability, unless it
+ *  already is.
+ ***********************************************************/
+void GLStateCache::Disable(GLenum capability)
+{
+	int* pState = FindCapability(capability);
+	if (IsUnchanged((pState != NULL) && (*pState == 0)))
+	{
+		return;
+	}
+
+	glDisable(capability);
+	if (pState != NULL)
+	{
+		*pState = 0;
+	}
+}
+
+/***********************************************************
+ *  IsEnabled()
+ *
+ *  This method is used to check whether a capability is
+ *  enabled.  Only a state the cache does not know yet is
+ *  asked from OpenGL, and then remembered.
+ ***********************************************************/
+bool GLStateCache::IsEnabled(GLenum capability)
+{
+	int* pState = FindCapability(capability);
+	if ((pState != NULL) && (*pState != UNKNOWN_STATE))
+	{
+		return (*pState == 1);
+	}
+
+	bool bEnabled = (glIsEnabled(capability) == GL_TRUE);
+	if (pState != NULL)
+	{
+		*pState = bEnabled ? 1 : 0;
+	}
+	return bEnabled;
+}
+
+/***********************************************************
+ *  DepthMask()
+ *
+ *  This method is used to turn writing into the depth buffer
+ *  on or off, unless it already is.
+ ***********************************************************/
+void GLStateCache::DepthMask(GLboolean bWrite)
+{
+	CACHED_STATE& state = GetState();
+	int depthMask = (bWrite != GL_FALSE) ? 1 : 0;
+	if (IsUnchanged(state.depthMask == depthMask))
+	{
+		return;
+	}
+
+	glDepthMask(bWrite);
+	state.depthMask = depthMask;
+}
+
+/***********************************************************
+ *  BlendFunc()
+ *
+ *  This method is used to set the blend factors, unless they
+ *  already are.
+ ***********************************************************/
+void GLStateCache::BlendFunc(GLenum sourceFactor, GLenum destinationFactor)
+{
+	CACHED_STATE& state = GetState();
+	if (IsUnchanged((state.blendSourceFactor == sourceFactor) &&
+		(state.blendDestinationFactor == destinationFactor)))
+	{
+		return;
+	}
+
+	glBlendFunc(sourceFactor, destinationFactor);
+	state.blendSourceFactor = sourceFactor;
+	state.blendDestinationFactor = destinationFactor;
+}
+
+/***********************************************************
+ *  ChangeUniform()
+ *
+ *  This method is used to compare a uniform value with the
+ *  one last set into the same location of the current
+ *  program, and to remember it.  It returns true when the
+ *  value has to be sent.  An inactive uniform never does,
+ *  and without a known program every value is sent.
+ ***********************************************************/
+bool GLStateCache::ChangeUniform(GLint location, const void* value, size_t size)
+{
+	CACHED_STATE& state = GetState();
+	if (location < 0)
+	{
+		IsUnchanged(true);
+		return false;
+	}
+	if ((state.program == UNKNOWN_OBJECT) || (size > MAX_UNIFORM_SIZE))
+	{
+		IsUnchanged(false);
+		return true;
+	}
+
+	std::vector<UNIFORM_VALUE>& values = state.uniforms[state.program];
+	if ((size_t)location >= values.size())
+	{
+		UNIFORM_VALUE empty;
+		empty.size = 0;
+		values.resize(location + 1, empty);
+	}
+
+	UNIFORM_VALUE& current = values[location];
+	if (IsUnchanged((current.size == size) && (memcmp(current.data, value, size) == 0)))
+	{
+		return false;
+	}
+
+	current.size = size;
+	memcpy(current.data, value, size);
+	return true;
+}
+
+/***********************************************************
+ *  DeleteProgram()
+ *
+ *  This method is used to delete a program along with its
+ *  remembered uniform values.  A current program is only
+ *  deleted once another one is used, so the current program
+ *  becomes unknown.
+ ***********************************************************/
+void GLStateCache::DeleteProgram(GLuint programID)
+{
+	CACHED_STATE& state = GetState();
+	glDeleteProgram(programID);
+
+	state.uniforms.erase(programID);
+	if (state.program == programID)
+	{
+		state.program = UNKNOWN_OBJECT;
+	}
+}
+
+/***********************************************************
+ *  DeleteVertexArrays()
+ *
+ *  This method is used to delete vertex arrays.  Deleting
+ *  the bound one binds 0 in its place.
+ ***********************************************************/
+void GLStateCache::DeleteVertexArrays(GLsizei count, const GLuint* vertexArrayIDs)
+{
+	CACHED_STATE& state = GetState();
+	glDeleteVertexArrays(count, vertexArrayIDs);
+
+	for (GLsizei i = 0; i < count; i++)
+	{
+		if (state.vertexArray == vertexArrayIDs[i])
+		{
+			state.vertexArray = 0;
+		}
+	}
+}
+
+/***********************************************************
+ *  DeleteBuffers()
+ *
+ *  This method is used to delete buffers.  Every target a
+ *  deleted buffer was bound to is bound to 0 in its place.
+ ***********************************************************/
+void GLStateCache::DeleteBuffers(GLsizei count, const GLuint* bufferIDs)
+{
+	CACHED_STATE& state = GetState();
+	glDeleteBuffers(count, bufferIDs);
+
+	for (GLsizei i = 0; i < count; i++)
+	{
+		for (int target = 0; target < BUFFER_TARGET_COUNT; target++)
+		{
+			if (state.buffers[target] == bufferIDs[i])
+			{
+				state.buffers[target] = 0;
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  DeleteTextures()
+ *
+ *  This method is used to delete textures.  Every unit a
+ *  deleted texture was bound to is bound to 0 in its place.
+ ***********************************************************/
+void GLStateCache::DeleteTextures(GLsizei count, const GLuint* textureIDs)
+{
+	CACHED_STATE& state = GetState();
+	glDeleteTextures(count, textureIDs);
+
+	for (GLsizei i = 0; i < count; i++)
+	{
+		for (int unit = 0; unit < MAX_TEXTURE_UNITS; unit++)
+		{
+			for (int target = 0; target < TEXTURE_TARGET_COUNT; target++)
+			{
+				if (state.textures[unit][target] == textureIDs[i])
+				{
+					state.textures[unit][target] = 0;
+				}
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  GetStats()
+ *
+ *  This method is used to get the number of state calls
+ *  sent and skipped since the last reset.
+ ***********************************************************/
+const GLStateCache::STATE_STATS& GLStateCache::GetStats()
+{
+	return GetState().stats;
+}
+
+/***********************************************************
+ *  ResetStats()
+ *
+ *  This method is used to start counting the state calls
+ *  again.
+ ***********************************************************/
+void GLStateCache::ResetStats()
+{
+	GetState().stats = STATE_STATS();
+}
@@ -0,0 +1,74 @@
+///////////////////////////////////////////////////////////////////////////////
+// glstatecache.h
+// ============
+// remember the bound OpenGL state and skip the calls that change nothing
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstddef>
+
+/***********************************************************
+ *  GLStateCache
+ *
+ *  This class stands in front of the OpenGL calls that bind
+ *  objects and switch render state - the program, vertex
+ *  array, buffers, texture units, blending and depth writes
+ *  - and the uniform values of every program.  Each call is
+ *  compared with the value the cache remembers and is only
+ *  sent to OpenGL when it changes something.  There is one
+ *  context, so the cache is static, and every state call in
+ *  the project goes through it, since a call made around it
+ *  would leave it remembering the wrong value.  Deleting an
+ *  object through the cache also forgets its bindings, so a
+ *  new object that reuses its name is bound again.  The
+ *  calls sent and skipped are counted for every frame.
+ ***********************************************************/
+class GLStateCache
+{
+public:
+	// counters since the last reset
+	struct STATE_STATS
+	{
+		// state calls sent to OpenGL, and the ones skipped
+		// because they would not have changed anything
+		int issuedCalls;
+		int elidedCalls;
+	};
+
+	// the binding calls, with the same arguments as OpenGL
+	static void UseProgram(GLuint programID);
+	static void BindVertexArray(GLuint vertexArrayID);
+	static void BindBuffer(GLenum target, GLuint bufferID);
+	static void BindBufferBase(GLenum target, GLuint index, GLuint bufferID);
+	static void BindBufferRange(GLenum target, GLuint index, GLuint bufferID, GLintptr offset, GLsizeiptr size);
+	static void ActiveTexture(GLenum textureUnit);
+	static void BindTexture(GLenum target, GLuint textureID);
+
+	// the render state calls, with the same arguments as OpenGL
+	static void Enable(GLenum capability);
+	static void Disable(GLenum capability);
+	static void DepthMask(GLboolean bWrite);
+	static void BlendFunc(GLenum sourceFactor, GLenum destinationFactor);
+	// check whether a capability is enabled, without asking
+	// OpenGL once the cache knows
+	static bool IsEnabled(GLenum capability);
+
+	// compare a uniform value of the current program with the
+	// one last set, returns true when it changed and has to be
+	// sent to OpenGL
+	static bool ChangeUniform(GLint location, const void* value, size_t size);
+
+	// delete objects and forget where they were bound
+	static void DeleteProgram(GLuint programID);
+	static void DeleteVertexArrays(GLsizei count, const GLuint* vertexArrayIDs);
+	static void DeleteBuffers(GLsizei count, const GLuint* bufferIDs);
+	static void DeleteTextures(GLsizei count, const GLuint* textureIDs);
+
+	// get the counters, and start counting again - normally at
+	// the start of every frame
+	static const STATE_STATS& GetStats();
+	static void ResetStats();
+};
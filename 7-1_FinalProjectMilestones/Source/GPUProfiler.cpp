@@ -0,0 +1,615 @@
+///////////////////////////////////////////////////////////////////////////////
+// gpuprofiler.cpp
+// ============
+// measure the GPU and CPU time spent in named, nested sections of a frame
+///////////////////////////////////////////////////////////////////////////////
+
+#include "GPUProfiler.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+// declaration of the global variables and defines
+namespace
+{
+	// rolling statistics of one scope path
+	struct SCOPE_AVERAGE
+	{
+		std::string path;
+		std::string name;
+		int depth;
+		int samples;
+		double gpuTotalMs;
+		double cpuTotalMs;
+		double gpuMaxMs;
+	};
+
+	// average the scopes of the most recent frames, keeping the
+	// order in which the scopes first appear in a frame
+	std::vector<SCOPE_AVERAGE> AverageScopes(
+		const std::deque<GPUProfiler::FRAME_RESULT>& history,
+		int frameWindow)
+	{
+		std::vector<SCOPE_AVERAGE> averages;
+		size_t firstFrame = 0;
+
+		if ((frameWindow > 0) && (history.size() > (size_t)frameWindow))
+		{
+			firstFrame = history.size() - frameWindow;
+		}
+
+		for (size_t frame = firstFrame; frame < history.size(); frame++)
+		{
+			const std::vector<GPUProfiler::SCOPE_RESULT>& scopes = history[frame].scopes;
+			for (size_t i = 0; i < scopes.size(); i++)
+			{
+				size_t index = 0;
+				while ((index < averages.size()) && (averages[index].path != scopes[i].path))
+				{
+					index++;
+				}
+				if (index == averages.size())
+				{
+					SCOPE_AVERAGE average = { scopes[i].path, scopes[i].name, scopes[i].depth, 0, 0.0, 0.0, 0.0 };
+					averages.push_back(average);
+				}
+
+				averages[index].samples++;
+				averages[index].gpuTotalMs += scopes[i].gpuMs;
+				averages[index].cpuTotalMs += scopes[i].cpuMs;
+				averages[index].gpuMaxMs = std::max(averages[index].gpuMaxMs, scopes[i].gpuMs);
+			}
+		}
+
+		return averages;
+	}
+
+	// escape a scope name for a JSON string
+	std::string EscapeJSON(const std::string& text)
+	{
+		std::string escaped;
+		for (size_t i = 0; i < text.size(); i++)
+		{
+			if ((text[i] == '"') || (text[i] == '\\'))
+			{
+				escaped += '\\';
+			}
+			escaped += text[i];
+		}
+		return escaped;
+	}
+}
+
+/***********************************************************
+ *  Scope()
+ *
+ *  The constructor opens a profiler scope.
+ ***********************************************************/
+GPUProfiler::Scope::Scope(GPUProfiler* pProfiler, const char* name)
+{
+	m_pProfiler = pProfiler;
+	if (NULL != m_pProfiler)
+	{
+		m_pProfiler->BeginScope(name);
+	}
+}
+
+/***********************************************************
+ *  ~Scope()
+ *
+ *  The destructor closes the profiler scope.
+ ***********************************************************/
+GPUProfiler::Scope::~Scope()
+{
+	if (NULL != m_pProfiler)
+	{
+		m_pProfiler->EndScope();
+	}
+}
+
+/***********************************************************
+ *  CPUScope()
+ *
+ *  The constructor opens a CPU only profiler scope.
+ ***********************************************************/
+GPUProfiler::CPUScope::CPUScope(GPUProfiler* pProfiler, const char* name)
+{
+	m_pProfiler = pProfiler;
+	if (NULL != m_pProfiler)
+	{
+		m_pProfiler->BeginCPUScope(name);
+	}
+}
+
+/***********************************************************
+ *  ~CPUScope()
+ *
+ *  The destructor closes the profiler scope.
+ ***********************************************************/
+GPUProfiler::CPUScope::~CPUScope()
+{
+	if (NULL != m_pProfiler)
+	{
+		m_pProfiler->EndScope();
+	}
+}
+
+/***********************************************************
+ *  GPUProfiler()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+GPUProfiler::GPUProfiler()
+{
+	m_bInitialized = false;
+	m_currentSlot = 0;
+	m_frameNumber = 0;
+	m_droppedFrames = 0;
+	m_startTime = std::chrono::steady_clock::now();
+
+	for (int i = 0; i < FRAMES_IN_FLIGHT; i++)
+	{
+		m_frameSlots[i].frameNumber = 0;
+		m_frameSlots[i].bPending = false;
+		for (int j = 0; j < MAX_SCOPES_PER_FRAME * 2; j++)
+		{
+			m_frameSlots[i].queryIDs[j] = 0;
+		}
+	}
+}
+
+/***********************************************************
+ *  ~GPUProfiler()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+GPUProfiler::~GPUProfiler()
+{
+	if (m_bInitialized)
+	{
+		for (int i = 0; i < FRAMES_IN_FLIGHT; i++)
+		{
+			glDeleteQueries(MAX_SCOPES_PER_FRAME * 2, m_frameSlots[i].queryIDs);
+		}
+	}
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used to create the timestamp queries for
+ *  every frame in the ring.  It must be called with a
+ *  current OpenGL context.
+ ***********************************************************/
+bool GPUProfiler::Initialize()
+{
+	if (m_bInitialized)
+	{
+		return true;
+	}
+
+	for (int i = 0; i < FRAMES_IN_FLIGHT; i++)
+	{
+		glGenQueries(MAX_SCOPES_PER_FRAME * 2, m_frameSlots[i].queryIDs);
+		m_frameSlots[i].scopes.reserve(MAX_SCOPES_PER_FRAME);
+	}
+	m_scopeStack.reserve(MAX_SCOPES_PER_FRAME);
+
+	m_bInitialized = (glGetError() == GL_NO_ERROR);
+	if (!m_bInitialized)
+	{
+		std::cout << "GPU profiler could not create timestamp queries" << std::endl;
+	}
+
+	return m_bInitialized;
+}
+
+/***********************************************************
+ *  GetCPUTimeMs()
+ *
+ *  This method is used to get the CPU time in milliseconds
+ *  since the profiler was created.
+ ***********************************************************/
+double GPUProfiler::GetCPUTimeMs() const
+{
+	return std::chrono::duration<double, std::milli>(
+		std::chrono::steady_clock::now() - m_startTime).count();
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used to collect any finished results and
+ *  to start recording the next frame in the ring.
+ ***********************************************************/
+void GPUProfiler::BeginFrame()
+{
+	if (!m_bInitialized)
+	{
+		return;
+	}
+
+	CollectResults();
+
+	m_currentSlot = (m_currentSlot + 1) % FRAMES_IN_FLIGHT;
+	FRAME_SLOT& slot = m_frameSlots[m_currentSlot];
+
+	// the GPU is more than the ring size behind, so the oldest
+	// results are given up rather than waiting for them
+	if (slot.bPending)
+	{
+		m_droppedFrames++;
+	}
+
+	slot.frameNumber = m_frameNumber++;
+	slot.bPending = false;
+	slot.scopes.clear();
+	m_scopeStack.clear();
+
+	BeginScope("frame");
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used to close the frame scope and mark the
+ *  frame's queries as waiting for the GPU.
+ ***********************************************************/
+void GPUProfiler::EndFrame()
+{
+	if (!m_bInitialized)
+	{
+		return;
+	}
+
+	// close the frame scope and anything left open by mistake
+	while (!m_scopeStack.empty())
+	{
+		EndScope();
+	}
+
+	m_frameSlots[m_currentSlot].bPending = true;
+}
+
+/***********************************************************
+ *  BeginScope()
+ *
+ *  This method is used to open a named scope nested in the
+ *  currently open scope.
+ ***********************************************************/
+void GPUProfiler::BeginScope(const char* name)
+{
+	OpenScope(name, true);
+}
+
+/***********************************************************
+ *  BeginCPUScope()
+ *
+ *  This method is used to open a named scope that only
+ *  records the CPU time, so it costs no queries.
+ ***********************************************************/
+void GPUProfiler::BeginCPUScope(const char* name)
+{
+	OpenScope(name, false);
+}
+
+/***********************************************************
+ *  OpenScope()
+ *
+ *  This method is used to open a named scope nested in the
+ *  currently open scope, with or without its GPU queries.
+ ***********************************************************/
+void GPUProfiler::OpenScope(const char* name, bool bGPU)
+{
+	if (!m_bInitialized)
+	{
+		return;
+	}
+
+	FRAME_SLOT& slot = m_frameSlots[m_currentSlot];
+	if (slot.scopes.size() >= MAX_SCOPES_PER_FRAME)
+	{
+		m_scopeStack.push_back(-1);
+		return;
+	}
+
+	PENDING_SCOPE scope;
+	int index = (int)slot.scopes.size();
+	scope.name = name;
+	scope.depth = (int)m_scopeStack.size();
+	scope.beginQueryID = bGPU ? slot.queryIDs[index * 2] : 0;
+	scope.endQueryID = bGPU ? slot.queryIDs[index * 2 + 1] : 0;
+	scope.cpuStartMs = GetCPUTimeMs();
+	scope.cpuEndMs = scope.cpuStartMs;
+
+	if (bGPU)
+	{
+		glQueryCounter(scope.beginQueryID, GL_TIMESTAMP);
+	}
+
+	slot.scopes.push_back(scope);
+	m_scopeStack.push_back(index);
+}
+
+/***********************************************************
+ *  EndScope()
+ *
+ *  This method is used to close the most recently opened
+ *  scope.
+ ***********************************************************/
+void GPUProfiler::EndScope()
+{
+	if ((!m_bInitialized) || m_scopeStack.empty())
+	{
+		return;
+	}
+
+	int index = m_scopeStack.back();
+	m_scopeStack.pop_back();
+	if (index < 0)
+	{
+		return;
+	}
+
+	PENDING_SCOPE& scope = m_frameSlots[m_currentSlot].scopes[index];
+	if (scope.endQueryID != 0)
+	{
+		glQueryCounter(scope.endQueryID, GL_TIMESTAMP);
+	}
+	scope.cpuEndMs = GetCPUTimeMs();
+}
+
+/***********************************************************
+ *  CollectResults()
+ *
+ *  This method is used to read back the pending frames,
+ *  oldest first, for as long as their queries are available.
+ *  Queries complete in order, so the frame's last query
+ *  being available means all of them are.
+ ***********************************************************/
+void GPUProfiler::CollectResults()
+{
+	for (int i = 1; i <= FRAMES_IN_FLIGHT; i++)
+	{
+		FRAME_SLOT& slot = m_frameSlots[(m_currentSlot + i) % FRAMES_IN_FLIGHT];
+		if ((!slot.bPending) || slot.scopes.empty())
+		{
+			continue;
+		}
+
+		// the frame scope is closed last
+		GLint bAvailable = 0;
+		glGetQueryObjectiv(slot.scopes[0].endQueryID, GL_QUERY_RESULT_AVAILABLE, &bAvailable);
+		if (!bAvailable)
+		{
+			break;
+		}
+
+		ResolveFrame(slot);
+		slot.bPending = false;
+	}
+}
+
+/***********************************************************
+ *  ResolveFrame()
+ *
+ *  This method is used to convert the query results of one
+ *  frame into milliseconds relative to the frame start and
+ *  to append them to the frame history.
+ ***********************************************************/
+void GPUProfiler::ResolveFrame(FRAME_SLOT& slot)
+{
+	FRAME_RESULT frame;
+	std::vector<std::string> pathStack;
+	GLuint64 frameBeginTime = 0;
+
+	frame.frameNumber = slot.frameNumber;
+	frame.scopes.resize(slot.scopes.size());
+
+	for (size_t i = 0; i < slot.scopes.size(); i++)
+	{
+		const PENDING_SCOPE& pending = slot.scopes[i];
+		SCOPE_RESULT& result = frame.scopes[i];
+		GLuint64 beginTime = 0;
+		GLuint64 endTime = 0;
+
+		if (pending.beginQueryID != 0)
+		{
+			glGetQueryObjectui64v(pending.beginQueryID, GL_QUERY_RESULT, &beginTime);
+			glGetQueryObjectui64v(pending.endQueryID, GL_QUERY_RESULT, &endTime);
+		}
+		if (i == 0)
+		{
+			frameBeginTime = beginTime;
+		}
+
+		// build the path from the names of the enclosing scopes
+		pathStack.resize(pending.depth);
+		pathStack.push_back(pending.name);
+		result.path.clear();
+		for (size_t j = 0; j < pathStack.size(); j++)
+		{
+			result.path += (j == 0) ? pathStack[j] : "/" + pathStack[j];
+		}
+
+		result.name = pending.name;
+		result.depth = pending.depth;
+		result.bGPU = (pending.beginQueryID != 0);
+		result.gpuStartMs = result.bGPU ? (double)(beginTime - frameBeginTime) / 1000000.0 : 0.0;
+		result.gpuMs = (endTime > beginTime) ? (double)(endTime - beginTime) / 1000000.0 : 0.0;
+		result.cpuStartMs = pending.cpuStartMs;
+		result.cpuMs = pending.cpuEndMs - pending.cpuStartMs;
+	}
+
+	m_history.push_back(frame);
+	while (m_history.size() > HISTORY_FRAMES)
+	{
+		m_history.pop_front();
+	}
+}
+
+/***********************************************************
+ *  FormatTable()
+ *
+ *  This method is used to format the average GPU and CPU
+ *  time of every scope over the last frames as a text table
+ *  with the nested scopes indented under their parents.
+ ***********************************************************/
+std::string GPUProfiler::FormatTable(int frameWindow) const
+{
+	std::vector<SCOPE_AVERAGE> averages = AverageScopes(m_history, frameWindow);
+	std::ostringstream table;
+	int frames = std::min((int)m_history.size(), frameWindow);
+
+	table << std::fixed << std::setprecision(3);
+	table << "---- profiler: average of last " << frames << " frames ("
+		<< m_droppedFrames << " dropped) ----\n";
+	table << std::left << std::setw(28) << "scope"
+		<< std::right << std::setw(10) << "gpu ms"
+		<< std::setw(10) << "max ms"
+		<< std::setw(10) << "cpu ms" << "\n";
+
+	for (size_t i = 0; i < averages.size(); i++)
+	{
+		std::string label = std::string(averages[i].depth * 2, ' ') + averages[i].name;
+		table << std::left << std::setw(28) << label
+			<< std::right << std::setw(10) << averages[i].gpuTotalMs / averages[i].samples
+			<< std::setw(10) << averages[i].gpuMaxMs
+			<< std::setw(10) << averages[i].cpuTotalMs / averages[i].samples << "\n";
+	}
+
+	return table.str();
+}
+
+/***********************************************************
+ *  FormatSummary()
+ *
+ *  This method is used to format the average frame time and
+ *  the most expensive top level scope on a single line.
+ ***********************************************************/
+std::string GPUProfiler::FormatSummary(int frameWindow) const
+{
+	std::vector<SCOPE_AVERAGE> averages = AverageScopes(m_history, frameWindow);
+	std::ostringstream summary;
+
+	if (averages.empty())
+	{
+		return "profiler: waiting for results";
+	}
+
+	// the first scope is always the whole frame
+	int heaviest = -1;
+	for (size_t i = 1; i < averages.size(); i++)
+	{
+		if ((averages[i].depth == 1) &&
+			((heaviest < 0) || (averages[i].gpuTotalMs > averages[heaviest].gpuTotalMs)))
+		{
+			heaviest = (int)i;
+		}
+	}
+
+	summary << std::fixed << std::setprecision(2);
+	summary << "GPU " << averages[0].gpuTotalMs / averages[0].samples << " ms, CPU "
+		<< averages[0].cpuTotalMs / averages[0].samples << " ms";
+	if (heaviest >= 0)
+	{
+		summary << ", heaviest: " << averages[heaviest].name << " "
+			<< averages[heaviest].gpuTotalMs / averages[heaviest].samples << " ms";
+	}
+
+	return summary.str();
+}
+
+/***********************************************************
+ *  ExportCSV()
+ *
+ *  This method is used to write one row per scope of every
+ *  recorded frame to a CSV file.
+ ***********************************************************/
+bool GPUProfiler::ExportCSV(const char* filename) const
+{
+	std::ofstream file(filename);
+	if (!file)
+	{
+		std::cout << "Could not open profiler CSV file:" << filename << std::endl;
+		return false;
+	}
+
+	file << std::fixed << std::setprecision(4);
+	file << "frame,scope,depth,gpu_start_ms,gpu_ms,cpu_start_ms,cpu_ms\n";
+	for (size_t frame = 0; frame < m_history.size(); frame++)
+	{
+		const FRAME_RESULT& result = m_history[frame];
+		for (size_t i = 0; i < result.scopes.size(); i++)
+		{
+			const SCOPE_RESULT& scope = result.scopes[i];
+			file << result.frameNumber << "," << scope.path << "," << scope.depth << ","
+				<< scope.gpuStartMs << "," << scope.gpuMs << ","
+				<< scope.cpuStartMs << "," << scope.cpuMs << "\n";
+		}
+	}
+
+	std::cout << "Wrote profiler CSV:" << filename << std::endl;
+	return true;
+}
+
+/***********************************************************
+ *  ExportChromeTrace()
+ *
+ *  This method is used to write the recorded frames in the
+ *  Chrome trace event format, which can be opened with
+ *  chrome://tracing or Perfetto.  CPU scopes are on thread
+ *  1 and GPU scopes on thread 2, with each frame's GPU
+ *  timeline aligned to the start of its CPU frame scope.
+ *  Scopes that only time the CPU have no GPU event.
+ ***********************************************************/
+bool GPUProfiler::ExportChromeTrace(const char* filename) const
+{
+	std::ofstream file(filename);
+	if (!file)
+	{
+		std::cout << "Could not open profiler trace file:" << filename << std::endl;
+		return false;
+	}
+
+	file << std::fixed << std::setprecision(3);
+	file << "{\"traceEvents\":[\n";
+	file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}},\n";
+	file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}";
+
+	for (size_t frame = 0; frame < m_history.size(); frame++)
+	{
+		const FRAME_RESULT& result = m_history[frame];
+		if (result.scopes.empty())
+		{
+			continue;
+		}
+
+		double frameStartMs = result.scopes[0].cpuStartMs;
+		for (size_t i = 0; i < result.scopes.size(); i++)
+		{
+			const SCOPE_RESULT& scope = result.scopes[i];
+			std::string name = EscapeJSON(scope.name);
+
+			// trace timestamps and durations are in microseconds
+			file << ",\n{\"name\":\"" << name << "\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":"
+				<< scope.cpuStartMs * 1000.0 << ",\"dur\":" << scope.cpuMs * 1000.0
+				<< ",\"args\":{\"frame\":" << result.frameNumber << "}}";
+			if (scope.bGPU == false)
+			{
+				continue;
+			}
+			file << ",\n{\"name\":\"" << name << "\",\"cat\":\"gpu\",\"ph\":\"X\",\"pid\":1,\"tid\":2,\"ts\":"
+				<< (frameStartMs + scope.gpuStartMs) * 1000.0 << ",\"dur\":" << scope.gpuMs * 1000.0
+				<< ",\"args\":{\"frame\":" << result.frameNumber << "}}";
+		}
+	}
+
+	file << "\n]}\n";
+
+	std::cout << "Wrote profiler trace:" << filename << std::endl;
+	return true;
+}
@@ -0,0 +1,150 @@
+///////////////////////////////////////////////////////////////////////////////
+// gpuprofiler.h
+// ============
+// measure the GPU and CPU time spent in named, nested sections of a frame
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <chrono>
+#include <deque>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  GPUProfiler
+ *
+ *  This class records GL_TIMESTAMP queries at the start and
+ *  end of every named scope.  The queries of the last few
+ *  frames are kept in a ring and only read back once the
+ *  GPU reports them as available, so profiling never stalls
+ *  the pipeline.  CPU time is recorded for the same scopes.
+ ***********************************************************/
+class GPUProfiler
+{
+public:
+	// number of frames whose queries can be in flight at once
+	static const int FRAMES_IN_FLIGHT = 4;
+	// number of scopes that can be recorded in one frame
+	static const int MAX_SCOPES_PER_FRAME = 64;
+	// number of resolved frames kept for the table and exports
+	static const int HISTORY_FRAMES = 600;
+
+	// timings of one scope in a resolved frame
+	struct SCOPE_RESULT
+	{
+		std::string name;
+		// names of the enclosing scopes and this one, joined by '/'
+		std::string path;
+		int depth;
+		// false for a scope that only times the CPU
+		bool bGPU;
+		double gpuStartMs;
+		double gpuMs;
+		double cpuStartMs;
+		double cpuMs;
+	};
+
+	// all scope timings of one resolved frame
+	struct FRAME_RESULT
+	{
+		unsigned int frameNumber;
+		std::vector<SCOPE_RESULT> scopes;
+	};
+
+	// helper that opens a scope and closes it when it goes
+	// out of scope - a NULL profiler records nothing
+	class Scope
+	{
+	public:
+		Scope(GPUProfiler* pProfiler, const char* name);
+		~Scope();
+	private:
+		GPUProfiler* m_pProfiler;
+	};
+
+	// the same for a scope that only times the CPU, for work
+	// that sends nothing to the GPU, such as submitting draws
+	class CPUScope
+	{
+	public:
+		CPUScope(GPUProfiler* pProfiler, const char* name);
+		~CPUScope();
+	private:
+		GPUProfiler* m_pProfiler;
+	};
+
+	// constructor
+	GPUProfiler();
+	// destructor
+	~GPUProfiler();
+
+	// create the query objects for the frame ring
+	bool Initialize();
+
+	// mark the start and end of a rendered frame
+	void BeginFrame();
+	void EndFrame();
+
+	// open and close a named scope within the current frame,
+	// the name must stay valid until the frame is resolved
+	void BeginScope(const char* name);
+	void EndScope();
+	// open a scope that records no GPU queries
+	void BeginCPUScope(const char* name);
+
+	// format the rolling averages of every scope as a table
+	std::string FormatTable(int frameWindow) const;
+	// format a one line summary of the frame timings
+	std::string FormatSummary(int frameWindow) const;
+
+	// write the recorded frame history to a file
+	bool ExportCSV(const char* filename) const;
+	bool ExportChromeTrace(const char* filename) const;
+
+private:
+	// a scope that has been recorded but not yet resolved -
+	// the queries are 0 for a scope that only times the CPU
+	struct PENDING_SCOPE
+	{
+		const char* name;
+		int depth;
+		GLuint beginQueryID;
+		GLuint endQueryID;
+		double cpuStartMs;
+		double cpuEndMs;
+	};
+
+	// the queries and scopes of one frame in the ring
+	struct FRAME_SLOT
+	{
+		unsigned int frameNumber;
+		bool bPending;
+		GLuint queryIDs[MAX_SCOPES_PER_FRAME * 2];
+		std::vector<PENDING_SCOPE> scopes;
+	};
+
+	bool m_bInitialized;
+	FRAME_SLOT m_frameSlots[FRAMES_IN_FLIGHT];
+	int m_currentSlot;
+	unsigned int m_frameNumber;
+	// indices of the open scopes, -1 for dropped scopes
+	std::vector<int> m_scopeStack;
+	// frames whose results were overwritten before they resolved
+	unsigned int m_droppedFrames;
+	// resolved frames, oldest first
+	std::deque<FRAME_RESULT> m_history;
+	// reference point for the CPU timings
+	std::chrono::steady_clock::time_point m_startTime;
+
+	// get the CPU time in milliseconds since the profiler started
+	double GetCPUTimeMs() const;
+	// open a scope, with or without its GPU queries
+	void OpenScope(const char* name, bool bGPU);
+	// read back every pending frame whose queries are available
+	void CollectResults();
+	// convert the query results of one frame into a frame result
+	void ResolveFrame(FRAME_SLOT& slot);
+};
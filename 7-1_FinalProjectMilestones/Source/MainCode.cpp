@@ -1,207 +1,850 @@
-#include <iostream>         // error handling and output
-#include <cstdlib>          // EXIT_FAILURE
-
-#include <GL/glew.h>        // GLEW library
-#include "GLFW/glfw3.h"     // GLFW library
-
-// GLM Math Header inclusions
-#include <glm/glm.hpp>
-#include <glm/gtx/transform.hpp>
-#include <glm/gtc/type_ptr.hpp>
-
-#include "SceneManager.h"
-#include "ViewManager.h"
-#include "ShapeMeshes.h"
-#include "ShaderManager.h"
-
-// Namespace for declaring global variables
-namespace
-{
-    // Macro for window title
-    const char* const WINDOW_TITLE = "7-1 Assignment";
-
-    // Main GLFW window
-    GLFWwindow* g_Window = nullptr;
-
-    // Scene manager object for managing the 3D scene prepare and render
-    SceneManager* g_SceneManager = nullptr;
-    // Shader manager object for dynamic interaction with the shader code
-    ShaderManager* g_ShaderManager = nullptr;
-    // View manager object for managing the 3D view setup and projection to 2D
-    ViewManager* g_ViewManager = nullptr;
-
-    // Projection matrix
-    glm::mat4 projection;
-    float fov = 45.0f; // Field of view
-    const int SCR_WIDTH = 1280; // Set your actual width
-    const int SCR_HEIGHT = 720; // Set your actual height
-}
-
-// Function declarations - all functions that are called manually need to be pre-declared at the beginning of the source code.
-bool InitializeGLFW();
-bool InitializeGLEW();
-void processInput(GLFWwindow* window);
-
-/***********************************************************
- *  main(int, char*)
- *
- *  This function gets called after the application has been
- *  launched.
- ***********************************************************/
-int main(int argc, char* argv[])
-{
-    // if GLFW fails initialization, then terminate the application
-    if (InitializeGLFW() == false)
-    {
-        return(EXIT_FAILURE);
-    }
-
-    // try to create a new shader manager object
-    g_ShaderManager = new ShaderManager();
-    // try to create a new view manager object
-    g_ViewManager = new ViewManager(g_ShaderManager);
-
-    // try to create the main display window
-    g_Window = g_ViewManager->CreateDisplayWindow(WINDOW_TITLE);
-
-    // if GLEW fails initialization, then terminate the application
-    if (InitializeGLEW() == false)
-    {
-        return(EXIT_FAILURE);
-    }
-
-    // load the shader code from the external GLSL files
-    g_ShaderManager->LoadShaders(
-        "../../Utilities/shaders/vertexShader.glsl",
-        "../../Utilities/shaders/fragmentShader.glsl");
-    g_ShaderManager->use();
-
-    // try to create a new scene manager object and prepare the 3D scene
-    g_SceneManager = new SceneManager(g_ShaderManager);
-    g_SceneManager->PrepareScene();
-
-    // Initialize the default projection matrix
-    projection = glm::perspective(glm::radians(fov), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-
-    // loop will keep running until the application is closed 
-    // or until an error has occurred
-    while (!glfwWindowShouldClose(g_Window))
-    {
-        // Enable z-depth
-        glEnable(GL_DEPTH_TEST);
-
-        // Clear the frame and z buffers
-        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        // Process input for camera movement and projection changes
-        processInput(g_Window);
-
-        // Set the projection matrix in the shader
-        g_ShaderManager->setMat4Value("projection", projection);
-
-        // Prepare the scene view
-        g_ViewManager->PrepareSceneView();
-
-        // Render the scene
-        g_SceneManager->RenderScene();
-
-        // Swap buffers and poll events
-        glfwSwapBuffers(g_Window);
-        glfwPollEvents();
-    }
-
-    // clear the allocated manager objects from memory
-    if (NULL != g_SceneManager)
-    {
-        delete g_SceneManager;
-        g_SceneManager = NULL;
-    }
-    if (NULL != g_ViewManager)
-    {
-        delete g_ViewManager;
-        g_ViewManager = NULL;
-    }
-    if (NULL != g_ShaderManager)
-    {
-        delete g_ShaderManager;
-        g_ShaderManager = NULL;
-    }
-
-    // Terminates the program successfully
-    exit(EXIT_SUCCESS);
-}
-
-/***********************************************************
- *    InitializeGLFW()
- *
- *  This function is used to initialize the GLFW library.
- ***********************************************************/
-bool InitializeGLFW()
-{
-    // GLFW: initialize and configure library
-    // --------------------------------------
-    glfwInit();
-
-#ifdef __APPLE__
-    // set the version of OpenGL and profile to use
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
-#else
-    // set the version of OpenGL and profile to use
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-#endif
-    // GLFW: end -------------------------------
-
-    return(true);
-}
-
-/***********************************************************
- *    InitializeGLEW()
- *
- *  This function is used to initialize the GLEW library.
- ***********************************************************/
-bool InitializeGLEW()
-{
-    // GLEW: initialize
-    // -----------------------------------------
-    GLenum GLEWInitResult = GLEW_OK;
-
-    // try to initialize the GLEW library
-    GLEWInitResult = glewInit();
-    if (GLEW_OK != GLEWInitResult)
-    {
-        std::cerr << glewGetErrorString(GLEWInitResult) << std::endl;
-        return false;
-    }
-    // GLEW: end -------------------------------
-
-    // Displays a successful OpenGL initialization message
-    std::cout << "INFO: OpenGL Successfully Initialized\n";
-    std::cout << "INFO: OpenGL Version: " << glGetString(GL_VERSION) << "\n" << std::endl;
-
-    return(true);
-}
-
-/***********************************************************
- *  processInput(GLFWwindow* window)
- *
- *  Handle keyboard input for camera movement and projection changes.
- ***********************************************************/
-void processInput(GLFWwindow* window)
-{
-    // Check for perspective view
-    if (glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS) {
-        std::cout << "Switching to Perspective View" << std::endl; // Debugging output
-        projection = glm::perspective(glm::radians(fov), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-    }
-
-    // Check for orthographic view
-    if (glfwGetKey(window, GLFW_KEY_O) == GLFW_PRESS) {
-        std::cout << "Switching to Orthographic View" << std::endl; // Debugging output
-        projection = glm::ortho(-5.0f, 5.0f, -5.0f, 5.0f, 0.1f, 100.0f);
-    }
+#include <iostream>         // error handling and output
+#include <cstdlib>          // EXIT_FAILURE
+#include <cstring>          // strcmp
+#include <chrono>           // startup timing
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>        // GLEW library
+#include "GLFW/glfw3.h"     // GLFW library
+
+// GLM Math Header inclusions
+#include <glm/glm.hpp>
+#include <glm/gtx/transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "SceneManager.h"
+#include "ViewManager.h"
+#include "ShapeMeshes.h"
+#include "ShaderManager.h"
+#include "GLStateCache.h"
+#include "BenchmarkRunner.h"
+#include "GPUProfiler.h"
+#include "CompressedTexture.h"
+#include "AssetPack.h"
+#include "SceneFile.h"
+#include "TransformBatch.h"
+
+// Namespace for declaring global variables
+namespace
+{
+    // Macro for window title
+    const char* const WINDOW_TITLE = "7-1 Assignment";
+
+    // Main GLFW window
+    GLFWwindow* g_Window = nullptr;
+
+    // Scene manager object for managing the 3D scene prepare and render
+    SceneManager* g_SceneManager = nullptr;
+    // Shader manager object for dynamic interaction with the shader code
+    ShaderManager* g_ShaderManager = nullptr;
+    // View manager object for managing the 3D view setup and projection to 2D
+    ViewManager* g_ViewManager = nullptr;
+    // Profiler object for timing the sections of every frame
+    GPUProfiler* g_Profiler = nullptr;
+    // Benchmark object that renders the --bench frames offscreen
+    BenchmarkRunner* g_Benchmark = nullptr;
+
+    // Size of the offscreen framebuffer used by --bench, which
+    // matches the display window created by the view manager
+    const int BENCH_WIDTH = 1000;
+    const int BENCH_HEIGHT = 800;
+
+    // Number of frames averaged in the profiler table and summary
+    const int PROFILER_WINDOW_FRAMES = 120;
+
+    // Shader source files, used when they are not in the asset pack
+    const char* const VERTEX_SHADER_FILE = "shaders/vertexShader.glsl";
+    const char* const FRAGMENT_SHADER_FILE = "shaders/fragmentShader.glsl";
+    // Asset pack loaded at startup when it exists
+    const char* const DEFAULT_ASSET_PACK = "assets.pak";
+    // Scene file loaded at startup when it exists
+    const char* const DEFAULT_SCENE_FILE = "scenes/tabletop.scene";
+    // Directory the linked shader programs are cached in
+    const char* const DEFAULT_SHADER_CACHE = "shadercache";
+
+    // Options read from the command line
+    struct COMMAND_LINE_OPTIONS
+    {
+        bool bBenchmark;
+        BenchmarkRunner::BENCHMARK_SETTINGS bench;
+        bool bProfile;
+        std::string profileOutput;
+        int extraLights;
+        std::vector<std::string> compressTextures;
+        CompressedTexture::COMPRESSION_FORMAT textureFormat;
+        std::string assetPack;
+        bool bAssetPackRequired;
+        std::string buildAssetPack;
+        std::string sceneFile;
+        bool bSceneFileRequired;
+        std::vector<std::string> compileScenes;
+        int checkTransforms;
+        bool bCheckMeshes;
+        bool bCheckVertexFormats;
+        bool bPackedVertices;
+        bool bOcclusionCulling;
+        bool bDetailLevels;
+        bool bShadows;
+        bool bDeferred;
+        std::string shaderCache;
+    };
+}
+
+// Function declarations - all functions that are called manually need to be pre-declared at the beginning of the source code.
+bool InitializeGLFW();
+bool InitializeGLEW();
+bool InitializeGLEWHeadless();
+bool ParseCommandLine(int argc, char* argv[], COMMAND_LINE_OPTIONS& options);
+bool BuildAssetPack(const std::string& filename);
+void RenderFrame();
+void ApplySceneCamera();
+void ReportProfilerResults(bool bPrintTable);
+void processInput(GLFWwindow* window);
+
+/***********************************************************
+ *  main(int, char*)
+ *
+ *  This function gets called after the application has been
+ *  launched.
+ ***********************************************************/
+int main(int argc, char* argv[])
+{
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+    COMMAND_LINE_OPTIONS options;
+
+    // check for the --bench mode and the other options
+    if (ParseCommandLine(argc, argv, options) == false)
+    {
+        return(EXIT_FAILURE);
+    }
+    bool bBenchmark = options.bBenchmark;
+
+    // convert the texture images into DDS files without opening
+    // any window, so they are loaded compressed from now on
+    if (options.compressTextures.empty() == false)
+    {
+        int failedCount = 0;
+        for (size_t i = 0; i < options.compressTextures.size(); i++)
+        {
+            const std::string& filename = options.compressTextures[i];
+            if (CompressedTexture::CompressFile(filename, CompressedTexture::GetCompressedFilename(filename),
+                options.textureFormat) == false)
+            {
+                failedCount++;
+            }
+        }
+        return((failedCount == 0) ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    // compile text scenes into their binary files
+    if (options.compileScenes.empty() == false)
+    {
+        int failedCount = 0;
+        for (size_t i = 0; i < options.compileScenes.size(); i++)
+        {
+            const std::string& filename = options.compileScenes[i];
+            if (SceneFile::Compile(filename, SceneFile::GetCompiledFilename(filename)) == false)
+            {
+                failedCount++;
+            }
+        }
+        return((failedCount == 0) ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    // compare the SIMD transform kernels against GLM
+    if (options.checkTransforms > 0)
+    {
+        std::string report;
+        bool bPassed = TransformBatch::CheckKernels(options.checkTransforms, report);
+        std::cout << report;
+        return(bPassed ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    // measure the vertex cache use of the generated meshes
+    if (options.bCheckMeshes)
+    {
+        std::string report;
+        bool bPassed = ShapeMeshes::CheckMeshes(report);
+        std::cout << report;
+        return(bPassed ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    // measure the error of the packed vertex format
+    if (options.bCheckVertexFormats)
+    {
+        std::string report;
+        bool bPassed = ShapeMeshes::CheckVertexFormats(report);
+        std::cout << report;
+        return(bPassed ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    // bake the shaders, meshes and textures into one file
+    if (options.buildAssetPack.empty() == false)
+    {
+        return(BuildAssetPack(options.buildAssetPack) ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    // in benchmark mode stdout only carries the JSON report, so
+    // route the informational output to stderr instead, until
+    // the report is written
+    std::streambuf* pStdoutBuffer = std::cout.rdbuf();
+    if (bBenchmark)
+    {
+        std::cout.rdbuf(std::cerr.rdbuf());
+    }
+
+    if (bBenchmark)
+    {
+        // render without any display, window or input
+        if ((BenchmarkRunner::CreateHeadlessContext() == false) ||
+            (InitializeGLEWHeadless() == false))
+        {
+            return(EXIT_FAILURE);
+        }
+    }
+    // if GLFW fails initialization, then terminate the application
+    else if (InitializeGLFW() == false)
+    {
+        return(EXIT_FAILURE);
+    }
+
+    // try to create a new shader manager object
+    g_ShaderManager = new ShaderManager();
+    g_ShaderManager->SetProgramCache(options.shaderCache);
+    // try to create a new view manager object
+    g_ViewManager = new ViewManager(g_ShaderManager);
+
+    if (bBenchmark == false)
+    {
+        // try to create the main display window
+        g_Window = g_ViewManager->CreateDisplayWindow(WINDOW_TITLE);
+
+        // if GLEW fails initialization, then terminate the application
+        if (InitializeGLEW() == false)
+        {
+            return(EXIT_FAILURE);
+        }
+    }
+    else
+    {
+        // match the blending state set up with the display window
+        GLStateCache::Enable(GL_BLEND);
+        GLStateCache::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+        // bind the offscreen framebuffer before the scene is
+        // prepared, so the G-buffer is created at its size
+        g_Benchmark = new BenchmarkRunner(options.bench);
+        if (g_Benchmark->Initialize() == false)
+        {
+            return(EXIT_FAILURE);
+        }
+    }
+
+    // map the asset pack, which is only optional when it was not
+    // asked for on the command line
+    AssetPack assetPack;
+    if ((assetPack.Open(options.assetPack) == false) && options.bAssetPackRequired)
+    {
+        return(EXIT_FAILURE);
+    }
+
+    // load the shader code from the pack, or else from the
+    // external GLSL files
+    const char* vertexSource = NULL;
+    const char* fragmentSource = NULL;
+    GLint vertexLength = 0;
+    GLint fragmentLength = 0;
+    if (assetPack.IsOpen() &&
+        assetPack.FindShader(AssetPack::GetEntryName(VERTEX_SHADER_FILE), vertexSource, vertexLength) &&
+        assetPack.FindShader(AssetPack::GetEntryName(FRAGMENT_SHADER_FILE), fragmentSource, fragmentLength))
+    {
+        g_ShaderManager->LoadShaderSources(vertexSource, vertexLength, fragmentSource, fragmentLength);
+    }
+    else
+    {
+        g_ShaderManager->LoadShaders(VERTEX_SHADER_FILE, FRAGMENT_SHADER_FILE);
+    }
+    g_ShaderManager->use();
+
+    // try to create a new scene manager object and prepare the 3D scene
+    g_SceneManager = new SceneManager(g_ShaderManager);
+    g_SceneManager->SetAssetPack(assetPack.IsOpen() ? &assetPack : NULL);
+    g_SceneManager->SetOcclusionCulling(options.bOcclusionCulling);
+    g_SceneManager->SetDetailLevels(options.bDetailLevels);
+    g_SceneManager->SetShadows(options.bShadows);
+    g_SceneManager->SetDeferredShading(options.bDeferred);
+    g_SceneManager->SetVertexFormat(options.bPackedVertices ? ShapeMeshes::VERTEX_PACKED : ShapeMeshes::VERTEX_FULL);
+    g_SceneManager->PrepareScene();
+
+    // everything in the pack has been uploaded, so unmap it
+    g_SceneManager->SetAssetPack(NULL);
+    assetPack.Close();
+    std::cout << "INFO: Startup took "
+        << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count()
+        << " ms" << std::endl;
+    std::cout << "INFO: Mesh vertices take " << g_SceneManager->GetVertexBytes() / 1024 << " KB ("
+        << (options.bPackedVertices ? "packed" : "full") << " format)" << std::endl;
+    g_SceneManager->AddScatteredLights(options.extraLights);
+
+    // draw the objects of the scene file in place of the built
+    // in ones, which is only optional when it was not asked for
+    if (options.bSceneFileRequired || (MappedFile::GetModifiedTime(options.sceneFile) != 0))
+    {
+        if ((g_SceneManager->LoadSceneFile(options.sceneFile) == false) && options.bSceneFileRequired)
+        {
+            return(EXIT_FAILURE);
+        }
+        ApplySceneCamera();
+    }
+
+    // the profiler is always used for the window title, but only
+    // adds its queries to benchmark frames when asked for
+    if ((bBenchmark == false) || options.bProfile)
+    {
+        g_Profiler = new GPUProfiler();
+        g_Profiler->Initialize();
+        g_SceneManager->SetProfiler(g_Profiler);
+    }
+
+    int exitCode = EXIT_SUCCESS;
+
+    if (bBenchmark)
+    {
+        // render the fixed number of frames and report the timings
+        if (g_Benchmark->Run(g_SceneManager, &RenderFrame, pStdoutBuffer) == false)
+        {
+            exitCode = EXIT_FAILURE;
+        }
+    }
+    else
+    {
+        double lastReportTime = glfwGetTime();
+
+        // loop will keep running until the application is closed 
+        // or until an error has occurred
+        while (!glfwWindowShouldClose(g_Window))
+        {
+            // Process input for camera movement and projection changes
+            processInput(g_Window);
+
+            // pick up any edits saved to the scene file
+            if (g_SceneManager->ReloadChangedSceneFile())
+            {
+                ApplySceneCamera();
+            }
+
+            // Render the scene
+            RenderFrame();
+
+            // Swap buffers and poll events
+            glfwSwapBuffers(g_Window);
+            glfwPollEvents();
+
+            // refresh the rolling profiler results once per second
+            if (glfwGetTime() - lastReportTime >= 1.0)
+            {
+                ReportProfilerResults(options.bProfile);
+                lastReportTime = glfwGetTime();
+            }
+        }
+    }
+
+    // write the recorded profiler frames for offline analysis
+    if (options.bProfile && (NULL != g_Profiler))
+    {
+        g_Profiler->ExportCSV((options.profileOutput + ".csv").c_str());
+        g_Profiler->ExportChromeTrace((options.profileOutput + ".json").c_str());
+    }
+
+    // clear the allocated manager objects from memory
+    if (NULL != g_Profiler)
+    {
+        delete g_Profiler;
+        g_Profiler = NULL;
+    }
+    if (NULL != g_SceneManager)
+    {
+        delete g_SceneManager;
+        g_SceneManager = NULL;
+    }
+    if (NULL != g_ViewManager)
+    {
+        delete g_ViewManager;
+        g_ViewManager = NULL;
+    }
+    if (NULL != g_ShaderManager)
+    {
+        delete g_ShaderManager;
+        g_ShaderManager = NULL;
+    }
+    if (NULL != g_Benchmark)
+    {
+        delete g_Benchmark;
+        g_Benchmark = NULL;
+    }
+
+    if (bBenchmark)
+    {
+        BenchmarkRunner::DestroyHeadlessContext();
+    }
+
+    // Terminates the program
+    exit(exitCode);
+}
+
+/***********************************************************
+ *  ParseCommandLine()
+ *
+ *  This function is used to read the command line options.
+ *  Supported options:
+ *    --bench             render headless and print timings
+ *    --frames <count>    number of measured frames (300)
+ *    --warmup <count>    number of unmeasured frames (30)
+ *    --bench-out <file>  write the JSON report to a file
+ *    --profile           print the profiler table every second
+ *                        and export the frames when exiting
+ *    --profile-out <name> base name of the exported CSV and
+ *                        Chrome trace files (profile)
+ *    --lights <count>    add small point lights around the
+ *                        table to measure the lighting cost
+ *    --compress-texture <image> write the image as a BC1/BC3
+ *                        DDS file with all of its mipmaps next
+ *                        to it and exit, can be repeated
+ *    --texture-format <auto|bc1|bc3> block format used by
+ *                        --compress-texture (auto)
+ *    --pack <file>       load the assets from this pack, which
+ *                        must exist (assets.pak if present)
+ *    --build-pack <file> bake the shaders, meshes and textures
+ *                        into a pack file and exit
+ *    --scene <file>      draw the objects of this scene file,
+ *                        which must exist, and reload it when
+ *                        it changes (scenes/tabletop.scene if
+ *                        present)
+ *    --compile-scene <file> compile a text scene into the
+ *                        .bscene file next to it and exit, can
+ *                        be repeated
+ *    --no-occlusion      draw the objects hidden behind the
+ *                        large occluders as well
+ *    --no-lod            draw every object with its full mesh,
+ *                        however small it is on screen
+ *    --no-shadows        light the scene without shadow maps
+ *    --deferred          light the opaque objects once per pixel
+ *                        from a G-buffer, which the G and F keys
+ *                        also switch to and from
+ *    --check-transforms <count> compare the SIMD transform
+ *                        kernels against GLM for a number of
+ *                        random objects, time them and exit
+ *    --check-meshes      report the vertex cache miss ratio of
+ *                        every shape before and after its
+ *                        triangles are reordered, and exit
+ *    --packed-vertices   store the mesh vertices in 16 instead
+ *                        of 32 bytes
+ *    --check-vertex-formats report the error of the packed
+ *                        vertices of every shape against the
+ *                        full ones, and exit
+ *    --shader-cache <dir> keep the linked shader programs in
+ *                        this directory (shadercache)
+ *    --no-shader-cache   compile the shaders on every start
+ ***********************************************************/
+bool ParseCommandLine(int argc, char* argv[], COMMAND_LINE_OPTIONS& options)
+{
+    BenchmarkRunner::BENCHMARK_SETTINGS& settings = options.bench;
+
+    options.bBenchmark = false;
+    options.bProfile = false;
+    options.profileOutput = "profile";
+    options.extraLights = 0;
+    options.compressTextures.clear();
+    options.textureFormat = CompressedTexture::FORMAT_AUTO;
+    options.assetPack = DEFAULT_ASSET_PACK;
+    options.bAssetPackRequired = false;
+    options.buildAssetPack.clear();
+    options.sceneFile = DEFAULT_SCENE_FILE;
+    options.bSceneFileRequired = false;
+    options.compileScenes.clear();
+    options.checkTransforms = 0;
+    options.bCheckMeshes = false;
+    options.bCheckVertexFormats = false;
+    options.bPackedVertices = false;
+    options.bOcclusionCulling = true;
+    options.bDetailLevels = true;
+    options.bShadows = true;
+    options.bDeferred = false;
+    options.shaderCache = DEFAULT_SHADER_CACHE;
+    settings.frameCount = 300;
+    settings.warmupFrames = 30;
+    settings.width = BENCH_WIDTH;
+    settings.height = BENCH_HEIGHT;
+    settings.outputPath.clear();
+
+    for (int i = 1; i < argc; i++)
+    {
+        bool bHasValue = (i + 1 < argc);
+
+        if (strcmp(argv[i], "--bench") == 0)
+        {
+            options.bBenchmark = true;
+        }
+        else if ((strcmp(argv[i], "--frames") == 0) && bHasValue)
+        {
+            settings.frameCount = atoi(argv[++i]);
+        }
+        else if ((strcmp(argv[i], "--warmup") == 0) && bHasValue)
+        {
+            settings.warmupFrames = atoi(argv[++i]);
+        }
+        else if ((strcmp(argv[i], "--bench-out") == 0) && bHasValue)
+        {
+            settings.outputPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--profile") == 0)
+        {
+            options.bProfile = true;
+        }
+        else if ((strcmp(argv[i], "--profile-out") == 0) && bHasValue)
+        {
+            options.bProfile = true;
+            options.profileOutput = argv[++i];
+        }
+        else if ((strcmp(argv[i], "--lights") == 0) && bHasValue)
+        {
+            options.extraLights = atoi(argv[++i]);
+        }
+        else if ((strcmp(argv[i], "--compress-texture") == 0) && bHasValue)
+        {
+            options.compressTextures.push_back(argv[++i]);
+        }
+        else if ((strcmp(argv[i], "--pack") == 0) && bHasValue)
+        {
+            options.assetPack = argv[++i];
+            options.bAssetPackRequired = true;
+        }
+        else if ((strcmp(argv[i], "--build-pack") == 0) && bHasValue)
+        {
+            options.buildAssetPack = argv[++i];
+        }
+        else if ((strcmp(argv[i], "--scene") == 0) && bHasValue)
+        {
+            options.sceneFile = argv[++i];
+            options.bSceneFileRequired = true;
+        }
+        else if ((strcmp(argv[i], "--compile-scene") == 0) && bHasValue)
+        {
+            options.compileScenes.push_back(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--no-occlusion") == 0)
+        {
+            options.bOcclusionCulling = false;
+        }
+        else if (strcmp(argv[i], "--no-lod") == 0)
+        {
+            options.bDetailLevels = false;
+        }
+        else if (strcmp(argv[i], "--no-shadows") == 0)
+        {
+            options.bShadows = false;
+        }
+        else if (strcmp(argv[i], "--deferred") == 0)
+        {
+            options.bDeferred = true;
+        }
+        else if ((strcmp(argv[i], "--check-transforms") == 0) && bHasValue)
+        {
+            options.checkTransforms = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--check-meshes") == 0)
+        {
+            options.bCheckMeshes = true;
+        }
+        else if (strcmp(argv[i], "--check-vertex-formats") == 0)
+        {
+            options.bCheckVertexFormats = true;
+        }
+        else if (strcmp(argv[i], "--packed-vertices") == 0)
+        {
+            options.bPackedVertices = true;
+        }
+        else if ((strcmp(argv[i], "--shader-cache") == 0) && bHasValue)
+        {
+            options.shaderCache = argv[++i];
+        }
+        else if (strcmp(argv[i], "--no-shader-cache") == 0)
+        {
+            options.shaderCache.clear();
+        }
+        else if ((strcmp(argv[i], "--texture-format") == 0) && bHasValue)
+        {
+            const char* format = argv[++i];
+            if (strcmp(format, "auto") == 0)
+            {
+                options.textureFormat = CompressedTexture::FORMAT_AUTO;
+            }
+            else if (strcmp(format, "bc1") == 0)
+            {
+                options.textureFormat = CompressedTexture::FORMAT_BC1;
+            }
+            else if (strcmp(format, "bc3") == 0)
+            {
+                options.textureFormat = CompressedTexture::FORMAT_BC3;
+            }
+            else
+            {
+                std::cerr << "Unknown texture format, use auto, bc1 or bc3: " << format << std::endl;
+                return false;
+            }
+        }
+        else
+        {
+            std::cerr << "Unknown command line option: " << argv[i] << std::endl;
+            return false;
+        }
+    }
+
+    if (options.extraLights < 0)
+    {
+        std::cerr << "The --lights count must not be negative" << std::endl;
+        return false;
+    }
+
+    if ((settings.frameCount <= 0) || (settings.warmupFrames < 0))
+    {
+        std::cerr << "The --frames count must be positive and --warmup must not be negative" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+/***********************************************************
+ *  BuildAssetPack()
+ *
+ *  This function is used to bake the shader sources, the
+ *  meshes of the basic shapes and the scene textures into
+ *  an asset pack.  The textures use their DDS files when
+ *  --compress-texture made them.
+ ***********************************************************/
+bool BuildAssetPack(const std::string& filename)
+{
+    AssetPackWriter writer;
+    bool bSuccess = true;
+
+    bSuccess = writer.AddShaderFile(VERTEX_SHADER_FILE) && bSuccess;
+    bSuccess = writer.AddShaderFile(FRAGMENT_SHADER_FILE) && bSuccess;
+
+    for (int i = 0; i < ShapeMeshes::MESH_COUNT; i++)
+    {
+        ShapeMeshes::MESH_TYPE type = (ShapeMeshes::MESH_TYPE)i;
+        int levelCount = ShapeMeshes::HasLevels(type) ? ShapeMeshes::LOD_COUNT : 1;
+        for (int lod = 0; lod < levelCount; lod++)
+        {
+            ShapeMeshes::MESH_DATA mesh;
+            ShapeMeshes::GenerateMesh(type, lod, mesh);
+            writer.AddMesh(ShapeMeshes::GetMeshLevelName(type, lod), mesh.vertices,
+                ShapeMeshes::FLOATS_PER_VERTEX, mesh.indices);
+        }
+    }
+
+    std::vector<std::string> textureFiles;
+    SceneManager::GetSceneTextureFiles(textureFiles);
+    for (size_t i = 0; i < textureFiles.size(); i++)
+    {
+        bSuccess = writer.AddTextureFile(textureFiles[i]) && bSuccess;
+    }
+
+    return bSuccess && writer.Write(filename);
+}
+
+/***********************************************************
+ *  RenderFrame()
+ *
+ *  This function is used to render one frame of the 3D
+ *  scene into the current framebuffer.
+ ***********************************************************/
+void RenderFrame()
+{
+    if (NULL != g_Profiler)
+    {
+        g_Profiler->BeginFrame();
+    }
+
+    // Enable z-depth
+    GLStateCache::Enable(GL_DEPTH_TEST);
+
+    // Clear the frame and z buffers
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    // the uniform lookup and state call counters cover one
+    // frame at a time
+    g_ShaderManager->ResetUniformLookupCount();
+    GLStateCache::ResetStats();
+
+    // Prepare the scene view
+    {
+        GPUProfiler::Scope viewScope(g_Profiler, "view");
+        g_ViewManager->PrepareSceneView();
+    }
+    g_SceneManager->SetCameraView(g_ViewManager->GetViewMatrix(), g_ViewManager->GetProjectionMatrix());
+
+    // Render the scene
+    g_SceneManager->RenderScene();
+
+    if (NULL != g_Profiler)
+    {
+        g_Profiler->EndFrame();
+    }
+}
+
+/***********************************************************
+ *  ApplySceneCamera()
+ *
+ *  This function is used to move the camera to the camera
+ *  of the scene file when it was loaded or changed.
+ ***********************************************************/
+void ApplySceneCamera()
+{
+    SceneFile::SCENE_CAMERA camera;
+    if (g_SceneManager->GetChangedSceneCamera(camera))
+    {
+        g_ViewManager->SetCamera(camera.position, camera.front, camera.zoom);
+    }
+}
+
+/***********************************************************
+ *  ReportProfilerResults()
+ *
+ *  This function is used to show the rolling profiler
+ *  averages in the window title and, when profiling was
+ *  requested, as a table on the console.
+ ***********************************************************/
+void ReportProfilerResults(bool bPrintTable)
+{
+    if (NULL == g_Profiler)
+    {
+        return;
+    }
+
+    std::string title = std::string(WINDOW_TITLE) + " - " +
+        g_Profiler->FormatSummary(PROFILER_WINDOW_FRAMES);
+    glfwSetWindowTitle(g_Window, title.c_str());
+
+    if (bPrintTable)
+    {
+        std::cout << g_Profiler->FormatTable(PROFILER_WINDOW_FRAMES) << std::endl;
+    }
+}
+
+/***********************************************************
+ *    InitializeGLFW()
+ *
+ *  This function is used to initialize the GLFW library.
+ ***********************************************************/
+bool InitializeGLFW()
+{
+    // GLFW: initialize and configure library
+    // --------------------------------------
+    glfwInit();
+
+#ifdef __APPLE__
+    // set the version of OpenGL and profile to use
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#else
+    // set the version of OpenGL and profile to use
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#endif
+    // GLFW: end -------------------------------
+
+    return(true);
+}
+
+/***********************************************************
+ *    InitializeGLEW()
+ *
+ *  This function is used to initialize the GLEW library.
+ ***********************************************************/
+bool InitializeGLEW()
+{
+    // GLEW: initialize
+    // -----------------------------------------
+    GLenum GLEWInitResult = GLEW_OK;
+
+    // try to initialize the GLEW library
+    GLEWInitResult = glewInit();
+    if (GLEW_OK != GLEWInitResult)
+    {
+        std::cerr << glewGetErrorString(GLEWInitResult) << std::endl;
+        return false;
+    }
+    // GLEW: end -------------------------------
+
+    // Displays a successful OpenGL initialization message
+    std::cout << "INFO: OpenGL Successfully Initialized\n";
+    std::cout << "INFO: OpenGL Version: " << glGetString(GL_VERSION) << "\n" << std::endl;
+
+    return(true);
+}
+
+/***********************************************************
+ *    InitializeGLEWHeadless()
+ *
+ *  This function is used to initialize the GLEW library for
+ *  the headless benchmark context.
+ ***********************************************************/
+bool InitializeGLEWHeadless()
+{
+#ifdef _WIN32
+    // the hidden GLFW window context initializes like the display one
+    return(InitializeGLEW());
+#else
+    // glewInit() also looks for a GLX display, which does not exist
+    // for a surfaceless EGL context, so only load the GL entry points
+    glewExperimental = GL_TRUE;
+    GLenum GLEWInitResult = glewContextInit();
+    if (GLEW_OK != GLEWInitResult)
+    {
+        std::cerr << glewGetErrorString(GLEWInitResult) << std::endl;
+        return false;
+    }
+
+    std::cout << "INFO: OpenGL Successfully Initialized (headless)\n";
+    std::cout << "INFO: OpenGL Version: " << glGetString(GL_VERSION) << "\n";
+    std::cout << "INFO: OpenGL Renderer: " << glGetString(GL_RENDERER) << "\n" << std::endl;
+
+    return(true);
+#endif
+}
+
+/***********************************************************
+ *  processInput(GLFWwindow* window)
+ *
+ *  Handle keyboard input for camera movement and projection changes.
+ ***********************************************************/
+void processInput(GLFWwindow* window)
+{
+    // Check for perspective view
+    if (glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS) {
+        std::cout << "Switching to Perspective View" << std::endl; // Debugging output
+        g_ViewManager->SetOrthographic(false);
+    }
+
+    // Check for orthographic view
+    if (glfwGetKey(window, GLFW_KEY_O) == GLFW_PRESS) {
+        std::cout << "Switching to Orthographic View" << std::endl; // Debugging output
+        g_ViewManager->SetOrthographic(true);
+    }
+
+    // Check for deferred shading, reported once when it changes
+    if ((glfwGetKey(window, GLFW_KEY_G) == GLFW_PRESS) && g_SceneManager->SetDeferredShading(true)) {
+        std::cout << "INFO: Switched to deferred shading" << std::endl;
+    }
+
+    // Check for forward shading
+    if ((glfwGetKey(window, GLFW_KEY_F) == GLFW_PRESS) && g_SceneManager->SetDeferredShading(false)) {
+        std::cout << "INFO: Switched to forward shading" << std::endl;
+    }
 }
\ No newline at end of file
@@ -0,0 +1,190 @@
+///////////////////////////////////////////////////////////////////////////////
+// mappedfile.cpp
+// ============
+// read only view of a whole file mapped into memory
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MappedFile.h"
+
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <direct.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+/***********************************************************
+ *  MappedFile()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+MappedFile::MappedFile()
+{
+	m_pData = NULL;
+	m_size = 0;
+}
+
+/***********************************************************
+ *  ~MappedFile()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+/***********************************************************
+ *  Open()
+ *
+ *  This method is used to map a whole file into memory for
+ *  reading.  Nothing is read yet - the pages are loaded by
+ *  the system as the contents are used.
+ ***********************************************************/
+bool MappedFile::Open(const std::string& filename)
+{
+	Close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	HANDLE mapping = NULL;
+	if (GetFileSizeEx(file, &fileSize) && (fileSize.QuadPart > 0))
+	{
+		mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	}
+	if (mapping != NULL)
+	{
+		m_pData = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		m_size = (m_pData != NULL) ? (size_t)fileSize.QuadPart : 0;
+		// the view keeps the file mapped after the handles are closed
+		CloseHandle(mapping);
+	}
+	CloseHandle(file);
+#else
+	int file = open(filename.c_str(), O_RDONLY);
+	if (file < 0)
+	{
+		return false;
+	}
+
+	struct stat fileStatus;
+	if ((fstat(file, &fileStatus) == 0) && (fileStatus.st_size > 0))
+	{
+		void* pMapped = mmap(NULL, (size_t)fileStatus.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+		if (pMapped != MAP_FAILED)
+		{
+			m_pData = (const unsigned char*)pMapped;
+			m_size = (size_t)fileStatus.st_size;
+			// start reading the whole file in the background
+			madvise(pMapped, m_size, MADV_WILLNEED);
+		}
+	}
+	// the mapping keeps the file open after it is closed
+	close(file);
+#endif
+
+	return m_pData != NULL;
+}
+
+/***********************************************************
+ *  Close()
+ *
+ *  This method is used to unmap the file.
+ ***********************************************************/
+void MappedFile::Close()
+{
+	if (m_pData != NULL)
+	{
+#ifdef _WIN32
+		UnmapViewOfFile(m_pData);
+#else
+		munmap((void*)m_pData, m_size);
+#endif
+	}
+
+	m_pData = NULL;
+	m_size = 0;
+}
+
+/***********************************************************
+ *  IsOpen()
+ *
+ *  This method is used to check whether a file is mapped.
+ ***********************************************************/
+bool MappedFile::IsOpen() const
+{
+	return m_pData != NULL;
+}
+
+/***********************************************************
+ *  GetData()
+ *
+ *  This method is used to get the mapped file contents.
+ ***********************************************************/
+const unsigned char* MappedFile::GetData() const
+{
+	return m_pData;
+}
+
+/***********************************************************
+ *  GetSize()
+ *
+ *  This method is used to get the size of the mapped file.
+ ***********************************************************/
+size_t MappedFile::GetSize() const
+{
+	return m_size;
+}
+
+/***********************************************************
+ *  GetModifiedTime()
+ *
+ *  This method is used to get the time a file was last
+ *  written.  Only changes of the value matter, so it is not
+ *  converted into any particular unit.
+ ***********************************************************/
+long long MappedFile::GetModifiedTime(const std::string& filename)
+{
+	struct stat fileStatus;
+	if (stat(filename.c_str(), &fileStatus) != 0)
+	{
+		return 0;
+	}
+
+	return (long long)fileStatus.st_mtime;
+}
+
+/***********************************************************
+ *  MakeDirectory()
+ *
+ *  This method is used to create a directory for files that
+ *  are written later, such as caches.  A directory that
+ *  already exists is left as it is.
+ ***********************************************************/
+bool MappedFile::MakeDirectory(const std::string& directory)
+{
+	struct stat fileStatus;
+	if (stat(directory.c_str(), &fileStatus) == 0)
+	{
+		return ((fileStatus.st_mode & S_IFDIR) != 0);
+	}
+
+#ifdef _WIN32
+	return (_mkdir(directory.c_str()) == 0);
+#else
+	return (mkdir(directory.c_str(), 0755) == 0);
+#endif
+}
@@ -0,0 +1,53 @@
+///////////////////////////////////////////////////////////////////////////////
+// mappedfile.h
+// ============
+// read only view of a whole file mapped into memory
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+/***********************************************************
+ *  MappedFile
+ *
+ *  This class maps a whole file into memory for reading.
+ *  The pages are only loaded by the system as they are
+ *  used, so the contents can be read in place without
+ *  copying them into a buffer first.
+ ***********************************************************/
+class MappedFile
+{
+public:
+	// constructor
+	MappedFile();
+	// destructor
+	~MappedFile();
+
+	// map a file into memory, returns false if it does not
+	// exist, is empty or could not be mapped
+	bool Open(const std::string& filename);
+	// unmap the file - pointers into it become invalid
+	void Close();
+	bool IsOpen() const;
+
+	// the mapped contents of the file
+	const unsigned char* GetData() const;
+	size_t GetSize() const;
+
+	// the time the file was last written, or 0 if it does not
+	// exist - used to notice that a file has changed
+	static long long GetModifiedTime(const std::string& filename);
+	// create a directory if it does not exist yet, returns
+	// false if it could not be created
+	static bool MakeDirectory(const std::string& directory);
+
+private:
+	const unsigned char* m_pData;
+	size_t m_size;
+
+	// the mapping can not be copied
+	MappedFile(const MappedFile&);
+	MappedFile& operator=(const MappedFile&);
+};
@@ -0,0 +1,292 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshoptimizer.cpp
+// ============
+// reorder the indices and vertices of a mesh for the GPU vertex caches
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+
+// declare the global variables
+namespace
+{
+	// entries of the cache the triangle order is scored for -
+	// a few more than the hardware has, which costs little
+	// when the real cache is smaller
+	const int SCORING_CACHE_SIZE = 32;
+	// how quickly the score of a vertex drops as it moves back
+	// in the cache, and the score of the vertices of the last
+	// triangle, which is lower so the next triangle does not
+	// simply continue a strip
+	const float CACHE_DECAY_POWER = 1.5f;
+	const float LAST_TRIANGLE_SCORE = 0.75f;
+	// boost for vertices with few triangles left, so they are
+	// finished off instead of being left behind
+	const float VALENCE_BOOST_SCALE = 2.0f;
+	const float VALENCE_BOOST_POWER = 0.5f;
+	// index of a vertex that is not used by any triangle
+	const GLuint UNUSED_VERTEX = 0xFFFFFFFF;
+
+	/***********************************************************
+	 *  ScoreVertex()
+	 *
+	 *  Score a vertex by its place in the cache, or -1 when it
+	 *  is not in the cache, and by the number of triangles that
+	 *  still use it.
+	 ***********************************************************/
+	float ScoreVertex(int cachePosition, int remainingTriangles)
+	{
+		// every triangle of the vertex has been added
+		if (remainingTriangles == 0)
+		{
+			return -1.0f;
+		}
+
+		float score = 0.0f;
+		if (cachePosition >= 0)
+		{
+			if (cachePosition < 3)
+			{
+				score = LAST_TRIANGLE_SCORE;
+			}
+			else
+			{
+				float position = (float)(cachePosition - 3) / (float)(SCORING_CACHE_SIZE - 3);
+				score = powf(1.0f - position, CACHE_DECAY_POWER);
+			}
+		}
+
+		score += VALENCE_BOOST_SCALE * powf((float)remainingTriangles, -VALENCE_BOOST_POWER);
+		return score;
+	}
+}
+
+/***********************************************************
+ *  OptimizeVertexCache()
+ *
+ *  This method is used to reorder the triangles of a mesh so
+ *  each one reuses as many of the recently transformed
+ *  vertices as it can.  Every vertex is scored by how
+ *  recently it entered the cache and by how many triangles
+ *  still need it, and the next triangle is the one with the
+ *  highest total among those touching the cache.  Only the
+ *  vertices in the cache change their scores after a
+ *  triangle is added, so this takes time in proportion to
+ *  the size of the mesh.  The winding of every triangle is
+ *  kept.
+ ***********************************************************/
+void MeshOptimizer::OptimizeVertexCache(std::vector<GLuint>& indices, GLuint vertexCount)
+{
+	const int triangleCount = (int)(indices.size() / 3);
+	if (triangleCount == 0)
+	{
+		return;
+	}
+
+	// the triangles of every vertex, stored one vertex after
+	// the other - the ones not added yet come first
+	std::vector<int> remainingTriangles(vertexCount, 0);
+	for (int i = 0; i < triangleCount * 3; i++)
+	{
+		remainingTriangles[indices[i]]++;
+	}
+	std::vector<int> firstTriangle(vertexCount + 1, 0);
+	for (GLuint vertex = 0; vertex < vertexCount; vertex++)
+	{
+		firstTriangle[vertex + 1] = firstTriangle[vertex] + remainingTriangles[vertex];
+	}
+	std::vector<int> vertexTriangles(triangleCount * 3);
+	std::vector<int> filledTriangles(vertexCount, 0);
+	for (int triangle = 0; triangle < triangleCount; triangle++)
+	{
+		for (int corner = 0; corner < 3; corner++)
+		{
+			GLuint vertex = indices[triangle * 3 + corner];
+			vertexTriangles[firstTriangle[vertex] + filledTriangles[vertex]++] = triangle;
+		}
+	}
+
+	std::vector<float> vertexScores(vertexCount);
+	for (GLuint vertex = 0; vertex < vertexCount; vertex++)
+	{
+		vertexScores[vertex] = ScoreVertex(-1, remainingTriangles[vertex]);
+	}
+	std::vector<float> triangleScores(triangleCount);
+	std::vector<char> addedTriangles(triangleCount, 0);
+	for (int triangle = 0; triangle < triangleCount; triangle++)
+	{
+		triangleScores[triangle] = vertexScores[indices[triangle * 3]] +
+			vertexScores[indices[triangle * 3 + 1]] + vertexScores[indices[triangle * 3 + 2]];
+	}
+
+	std::vector<GLuint> cache;
+	std::vector<GLuint> newCache;
+	cache.reserve(SCORING_CACHE_SIZE + 3);
+	newCache.reserve(SCORING_CACHE_SIZE + 3);
+	std::vector<GLuint> ordered;
+	ordered.reserve(triangleCount * 3);
+
+	int bestTriangle = -1;
+	int nextTriangle = 0;
+	for (int added = 0; added < triangleCount; added++)
+	{
+		// no triangle left touches the cache, so start again
+		// from the first one not added yet
+		if (bestTriangle < 0)
+		{
+			while (addedTriangles[nextTriangle])
+			{
+				nextTriangle++;
+			}
+			bestTriangle = nextTriangle;
+		}
+
+		const GLuint* corners = &indices[bestTriangle * 3];
+		addedTriangles[bestTriangle] = 1;
+		newCache.clear();
+		for (int corner = 0; corner < 3; corner++)
+		{
+			GLuint vertex = corners[corner];
+			ordered.push_back(vertex);
+			newCache.push_back(vertex);
+
+			// move the triangle to the end of the vertex's list,
+			// past the ones still to be added
+			int* triangles = &vertexTriangles[firstTriangle[vertex]];
+			int last = --remainingTriangles[vertex];
+			for (int i = 0; i <= last; i++)
+			{
+				if (triangles[i] == bestTriangle)
+				{
+					std::swap(triangles[i], triangles[last]);
+					break;
+				}
+			}
+		}
+
+		// the vertices of the triangle move to the front of the
+		// cache, pushing the others back
+		for (size_t i = 0; i < cache.size(); i++)
+		{
+			GLuint vertex = cache[i];
+			if ((vertex != corners[0]) && (vertex != corners[1]) && (vertex != corners[2]))
+			{
+				newCache.push_back(vertex);
+			}
+		}
+
+		// score the vertices that moved, including the ones that
+		// fell out of the cache, and their triangles with them
+		for (size_t i = 0; i < newCache.size(); i++)
+		{
+			GLuint vertex = newCache[i];
+			int position = (i < (size_t)SCORING_CACHE_SIZE) ? (int)i : -1;
+			float score = ScoreVertex(position, remainingTriangles[vertex]);
+			float change = score - vertexScores[vertex];
+
+			vertexScores[vertex] = score;
+			const int* triangles = &vertexTriangles[firstTriangle[vertex]];
+			for (int j = 0; j < remainingTriangles[vertex]; j++)
+			{
+				triangleScores[triangles[j]] += change;
+			}
+		}
+		if (newCache.size() > (size_t)SCORING_CACHE_SIZE)
+		{
+			newCache.resize(SCORING_CACHE_SIZE);
+		}
+		cache.swap(newCache);
+
+		// the next triangle is the best one using a vertex that
+		// is in the cache
+		bestTriangle = -1;
+		float bestScore = -1.0f;
+		for (size_t i = 0; i < cache.size(); i++)
+		{
+			GLuint vertex = cache[i];
+			const int* triangles = &vertexTriangles[firstTriangle[vertex]];
+			for (int j = 0; j < remainingTriangles[vertex]; j++)
+			{
+				if (triangleScores[triangles[j]] > bestScore)
+				{
+					bestScore = triangleScores[triangles[j]];
+					bestTriangle = triangles[j];
+				}
+			}
+		}
+	}
+
+	// keep any trailing indices that did not make a triangle
+	ordered.insert(ordered.end(), indices.begin() + triangleCount * 3, indices.end());
+	indices.swap(ordered);
+}
+
+/***********************************************************
+ *  OptimizeVertexFetch()
+ *
+ *  This method is used to renumber the vertices of a mesh in
+ *  the order its indices first use them.  Run after the
+ *  triangles were put in cache order, the vertex fetch then
+ *  reads the vertex buffer mostly front to back instead of
+ *  jumping around it.  Vertices that no index uses are left
+ *  out.
+ ***********************************************************/
+void MeshOptimizer::OptimizeVertexFetch(std::vector<GLfloat>& vertices, std::vector<GLuint>& indices,
+	int floatsPerVertex)
+{
+	const size_t vertexCount = vertices.size() / floatsPerVertex;
+	std::vector<GLuint> remap(vertexCount, UNUSED_VERTEX);
+	std::vector<GLfloat> ordered;
+	ordered.reserve(vertices.size());
+
+	GLuint nextVertex = 0;
+	for (size_t i = 0; i < indices.size(); i++)
+	{
+		GLuint& newIndex = remap[indices[i]];
+		if (newIndex == UNUSED_VERTEX)
+		{
+			newIndex = nextVertex++;
+			const GLfloat* vertex = &vertices[indices[i] * floatsPerVertex];
+			ordered.insert(ordered.end(), vertex, vertex + floatsPerVertex);
+		}
+		indices[i] = newIndex;
+	}
+
+	vertices.swap(ordered);
+}
+
+/***********************************************************
+ *  ComputeACMR()
+ *
+ *  This method is used to measure the average cache miss
+ *  ratio of a mesh - the number of vertices that have to be
+ *  transformed for each triangle when the transformed ones
+ *  go through a first in first out cache of the passed in
+ *  size, the way most GPUs keep them.
+ ***********************************************************/
+float MeshOptimizer::ComputeACMR(const std::vector<GLuint>& indices, GLuint vertexCount, int cacheSize)
+{
+	const size_t triangleCount = indices.size() / 3;
+	if (triangleCount == 0)
+	{
+		return 0.0f;
+	}
+
+	// the miss that put each vertex in the cache - a vertex is
+	// still there when fewer than cacheSize misses followed
+	std::vector<int> insertedAt(vertexCount, -cacheSize - 1);
+	int misses = 0;
+	for (size_t i = 0; i < triangleCount * 3; i++)
+	{
+		GLuint vertex = indices[i];
+		if (misses - insertedAt[vertex] > cacheSize)
+		{
+			insertedAt[vertex] = misses;
+			misses++;
+		}
+	}
+
+	return (float)misses / (float)triangleCount;
+}
@@ -0,0 +1,46 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshoptimizer.h
+// ============
+// reorder the indices and vertices of a mesh for the GPU vertex caches
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <vector>
+
+/***********************************************************
+ *  MeshOptimizer
+ *
+ *  This class reorders indexed triangle lists so the GPU
+ *  runs the vertex shader fewer times for them.  The
+ *  triangles are first put in an order that reuses the
+ *  vertices still in the post transform cache, picking the
+ *  next triangle by the score of its vertices the way Tom
+ *  Forsyth's linear speed optimizer does.  The vertices are
+ *  then renumbered in the order the triangles first use
+ *  them, so the vertex fetch reads the buffer from front to
+ *  back.  The average cache miss ratio - the vertices
+ *  transformed per triangle through a simulated cache -
+ *  measures the result, from 0.5 for a perfect grid up to 3
+ *  when nothing is reused.
+ ***********************************************************/
+class MeshOptimizer
+{
+public:
+	// entries of the simulated cache the miss ratio is measured
+	// with, which is in the range of what current GPUs reuse
+	static const int DEFAULT_CACHE_SIZE = 16;
+
+	// reorder the triangles of an indexed triangle list to
+	// reuse the vertices in the post transform cache
+	static void OptimizeVertexCache(std::vector<GLuint>& indices, GLuint vertexCount);
+	// renumber the interleaved vertices in the order the
+	// indices first use them, dropping unused ones
+	static void OptimizeVertexFetch(std::vector<GLfloat>& vertices, std::vector<GLuint>& indices,
+		int floatsPerVertex);
+	// the average number of vertices transformed for each
+	// triangle, through a first in first out cache
+	static float ComputeACMR(const std::vector<GLuint>& indices, GLuint vertexCount, int cacheSize);
+};
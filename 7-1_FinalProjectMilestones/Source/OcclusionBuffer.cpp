@@ -0,0 +1,424 @@
+///////////////////////////////////////////////////////////////////////////////
+// occlusionbuffer.cpp
+// ============
+// small CPU depth buffer for skipping objects hidden behind large occluders
+///////////////////////////////////////////////////////////////////////////////
+
+#include "OcclusionBuffer.h"
+#include "TransformBatch.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <emmintrin.h>
+#include <immintrin.h>
+
+// MSVC compiles AVX2 intrinsics in any function, while GCC and
+// Clang need the functions that use them marked for the target
+#if defined(_MSC_VER)
+#define TARGET_AVX2
+#else
+#define TARGET_AVX2 __attribute__((target("avx2,fma")))
+#endif
+
+// declare the global variables
+namespace
+{
+	// depth of a pixel no occluder was drawn into
+	const float EMPTY_DEPTH = 1.0f;
+	// smallest triangle area in pixels that is drawn
+	const float MIN_TRIANGLE_AREA = 1.0e-4f;
+
+	// the corners of each face of a box, where bit 0, 1 and 2
+	// of a corner select the maximum X, Y and Z
+	const int BOX_FACES[6][4] =
+	{
+		{ 0, 2, 6, 4 }, { 1, 3, 7, 5 },
+		{ 0, 1, 5, 4 }, { 2, 3, 7, 6 },
+		{ 0, 1, 3, 2 }, { 4, 5, 7, 6 }
+	};
+
+	// a triangle ready to be filled - the three edge functions
+	// and the depth as planes over the pixel centers, and the
+	// pixels around it
+	struct TRIANGLE_SETUP
+	{
+		float edgeX[3];
+		float edgeY[3];
+		float edgeOffset[3];
+		float depthX;
+		float depthY;
+		float depthOffset;
+		int minX;
+		int maxX;
+		int minY;
+		int maxY;
+	};
+
+	/***********************************************************
+	 *  FillTriangleSSE()
+	 *
+	 *  Keep the nearer depth in every pixel whose center is
+	 *  inside the triangle, 4 pixels of a row at a time.
+	 ***********************************************************/
+	void FillTriangleSSE(const TRIANGLE_SETUP& t, float* buffer)
+	{
+		const __m128 laneOffsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+		const __m128 zero = _mm_setzero_ps();
+		int startX = t.minX & ~3;
+
+		for (int y = t.minY; y <= t.maxY; y++)
+		{
+			float centerY = (float)y + 0.5f;
+			float* row = buffer + y * OcclusionBuffer::BUFFER_WIDTH;
+			for (int x = startX; x <= t.maxX; x += 4)
+			{
+				__m128 centerX = _mm_add_ps(_mm_set1_ps((float)x), laneOffsets);
+				__m128 inside = _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(centerX, _mm_set1_ps(t.edgeX[0])),
+					_mm_set1_ps(t.edgeY[0] * centerY + t.edgeOffset[0])), zero);
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(centerX, _mm_set1_ps(t.edgeX[1])),
+					_mm_set1_ps(t.edgeY[1] * centerY + t.edgeOffset[1])), zero));
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(centerX, _mm_set1_ps(t.edgeX[2])),
+					_mm_set1_ps(t.edgeY[2] * centerY + t.edgeOffset[2])), zero));
+				if (_mm_movemask_ps(inside) == 0)
+				{
+					continue;
+				}
+
+				__m128 depth = _mm_add_ps(_mm_mul_ps(centerX, _mm_set1_ps(t.depthX)),
+					_mm_set1_ps(t.depthY * centerY + t.depthOffset));
+				__m128 current = _mm_loadu_ps(row + x);
+				__m128 nearer = _mm_min_ps(current, depth);
+				_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearer), _mm_andnot_ps(inside, current)));
+			}
+		}
+	}
+
+	/***********************************************************
+	 *  FillTriangleAVX2()
+	 *
+	 *  Keep the nearer depth in every pixel whose center is
+	 *  inside the triangle, 8 pixels of a row at a time.
+	 ***********************************************************/
+	TARGET_AVX2 void FillTriangleAVX2(const TRIANGLE_SETUP& t, float* buffer)
+	{
+		const __m256 laneOffsets = _mm256_set_ps(7.5f, 6.5f, 5.5f, 4.5f, 3.5f, 2.5f, 1.5f, 0.5f);
+		const __m256 zero = _mm256_setzero_ps();
+		int startX = t.minX & ~7;
+
+		for (int y = t.minY; y <= t.maxY; y++)
+		{
+			float centerY = (float)y + 0.5f;
+			float* row = buffer + y * OcclusionBuffer::BUFFER_WIDTH;
+			for (int x = startX; x <= t.maxX; x += 8)
+			{
+				__m256 centerX = _mm256_add_ps(_mm256_set1_ps((float)x), laneOffsets);
+				__m256 inside = _mm256_cmp_ps(_mm256_fmadd_ps(centerX, _mm256_set1_ps(t.edgeX[0]),
+					_mm256_set1_ps(t.edgeY[0] * centerY + t.edgeOffset[0])), zero, _CMP_GE_OQ);
+				inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_fmadd_ps(centerX, _mm256_set1_ps(t.edgeX[1]),
+					_mm256_set1_ps(t.edgeY[1] * centerY + t.edgeOffset[1])), zero, _CMP_GE_OQ));
+				inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_fmadd_ps(centerX, _mm256_set1_ps(t.edgeX[2]),
+					_mm256_set1_ps(t.edgeY[2] * centerY + t.edgeOffset[2])), zero, _CMP_GE_OQ));
+				if (_mm256_movemask_ps(inside) == 0)
+				{
+					continue;
+				}
+
+				__m256 depth = _mm256_fmadd_ps(centerX, _mm256_set1_ps(t.depthX),
+					_mm256_set1_ps(t.depthY * centerY + t.depthOffset));
+				__m256 current = _mm256_loadu_ps(row + x);
+				_mm256_storeu_ps(row + x, _mm256_blendv_ps(current, _mm256_min_ps(current, depth), inside));
+			}
+		}
+	}
+
+	/***********************************************************
+	 *  IsRectVisibleSSE()
+	 *
+	 *  Check whether any pixel of a rectangle has an occluder
+	 *  depth at or behind the passed in depth, 4 pixels of a
+	 *  row at a time.
+	 ***********************************************************/
+	bool IsRectVisibleSSE(const float* buffer, int minX, int maxX, int minY, int maxY, float nearestDepth)
+	{
+		const __m128i laneIndices = _mm_set_epi32(3, 2, 1, 0);
+		const __m128 depth = _mm_set1_ps(nearestDepth);
+		int startX = minX & ~3;
+
+		for (int y = minY; y <= maxY; y++)
+		{
+			const float* row = buffer + y * OcclusionBuffer::BUFFER_WIDTH;
+			for (int x = startX; x <= maxX; x += 4)
+			{
+				// only the lanes between minX and maxX count
+				__m128i column = _mm_add_epi32(_mm_set1_epi32(x), laneIndices);
+				__m128i inRect = _mm_andnot_si128(
+					_mm_or_si128(_mm_cmplt_epi32(column, _mm_set1_epi32(minX)), _mm_cmpgt_epi32(column, _mm_set1_epi32(maxX))),
+					_mm_set1_epi32(-1));
+				__m128 behind = _mm_cmpge_ps(_mm_loadu_ps(row + x), depth);
+				if (_mm_movemask_ps(_mm_and_ps(behind, _mm_castsi128_ps(inRect))) != 0)
+				{
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	/***********************************************************
+	 *  IsRectVisibleAVX2()
+	 *
+	 *  Check whether any pixel of a rectangle has an occluder
+	 *  depth at or behind the passed in depth, 8 pixels of a
+	 *  row at a time.
+	 ***********************************************************/
+	TARGET_AVX2 bool IsRectVisibleAVX2(const float* buffer, int minX, int maxX, int minY, int maxY, float nearestDepth)
+	{
+		const __m256i laneIndices = _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+		const __m256 depth = _mm256_set1_ps(nearestDepth);
+		int startX = minX & ~7;
+
+		for (int y = minY; y <= maxY; y++)
+		{
+			const float* row = buffer + y * OcclusionBuffer::BUFFER_WIDTH;
+			for (int x = startX; x <= maxX; x += 8)
+			{
+				// only the lanes between minX and maxX count
+				__m256i column = _mm256_add_epi32(_mm256_set1_epi32(x), laneIndices);
+				__m256i outside = _mm256_or_si256(
+					_mm256_cmpgt_epi32(_mm256_set1_epi32(minX), column),
+					_mm256_cmpgt_epi32(column, _mm256_set1_epi32(maxX)));
+				__m256 behind = _mm256_cmp_ps(_mm256_loadu_ps(row + x), depth, _CMP_GE_OQ);
+				if (_mm256_movemask_ps(_mm256_andnot_ps(_mm256_castsi256_ps(outside), behind)) != 0)
+				{
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+}
+
+/***********************************************************
+ *  OcclusionBuffer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+OcclusionBuffer::OcclusionBuffer()
+{
+	m_viewProjection = glm::mat4(1.0f);
+	m_depth.assign(BUFFER_WIDTH * BUFFER_HEIGHT, EMPTY_DEPTH);
+	m_triangleCount = 0;
+	// the same processor check that picks the transform kernels
+	m_bUseAVX2 = TransformBatch::IsKernelSupported(TransformBatch::KERNEL_AVX2);
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used to empty the depth buffer and set
+ *  the view that the following boxes are drawn from.
+ ***********************************************************/
+void OcclusionBuffer::Clear(const glm::mat4& viewProjection)
+{
+	m_viewProjection = viewProjection;
+	std::fill(m_depth.begin(), m_depth.end(), EMPTY_DEPTH);
+	m_triangleCount = 0;
+}
+
+/***********************************************************
+ *  ProjectBox()
+ *
+ *  This method is used to move the corners of a local box
+ *  into buffer pixels.  A box that reaches in front of the
+ *  near plane can not be projected, and is left out.
+ ***********************************************************/
+bool OcclusionBuffer::ProjectBox(const glm::vec3& minimum, const glm::vec3& maximum, const glm::mat4& model,
+	SCREEN_VERTEX corners[8]) const
+{
+	glm::mat4 transform = m_viewProjection * model;
+	for (int i = 0; i < 8; i++)
+	{
+		glm::vec4 corner(
+			(i & 1) ? maximum.x : minimum.x,
+			(i & 2) ? maximum.y : minimum.y,
+			(i & 4) ? maximum.z : minimum.z,
+			1.0f);
+		glm::vec4 clip = transform * corner;
+		if ((clip.w <= 0.0f) || (clip.z < -clip.w))
+		{
+			return false;
+		}
+
+		corners[i].x = (clip.x / clip.w * 0.5f + 0.5f) * (float)BUFFER_WIDTH;
+		corners[i].y = (clip.y / clip.w * 0.5f + 0.5f) * (float)BUFFER_HEIGHT;
+		corners[i].depth = clip.z / clip.w * 0.5f + 0.5f;
+	}
+	return true;
+}
+
+/***********************************************************
+ *  RasterizeBox()
+ *
+ *  This method is used to draw the six faces of a box into
+ *  the depth buffer.  The faces of a flat box have no area
+ *  and are skipped, so a plane only draws its two sides.
+ ***********************************************************/
+void OcclusionBuffer::RasterizeBox(const glm::vec3& minimum, const glm::vec3& maximum, const glm::mat4& model)
+{
+	SCREEN_VERTEX corners[8];
+	if (ProjectBox(minimum, maximum, model, corners) == false)
+	{
+		return;
+	}
+
+	for (int face = 0; face < 6; face++)
+	{
+		const int* quad = BOX_FACES[face];
+		RasterizeTriangle(corners[quad[0]], corners[quad[1]], corners[quad[2]]);
+		RasterizeTriangle(corners[quad[0]], corners[quad[2]], corners[quad[3]]);
+	}
+}
+
+/***********************************************************
+ *  RasterizeTriangle()
+ *
+ *  This method is used to fill the pixels whose centers are
+ *  inside a triangle.  The edges and the depth are set up as
+ *  planes over the pixels, so each pixel only costs a few
+ *  multiply adds, and the rows are filled by the SIMD
+ *  kernels.  Both sides of a triangle are drawn.
+ ***********************************************************/
+void OcclusionBuffer::RasterizeTriangle(const SCREEN_VERTEX& a, const SCREEN_VERTEX& b, const SCREEN_VERTEX& c)
+{
+	float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+	if (std::fabs(area) < MIN_TRIANGLE_AREA)
+	{
+		return;
+	}
+
+	// turn the triangle counter clockwise, so the inside is
+	// where all of the edge functions are positive
+	const SCREEN_VERTEX* vertices[3] = { &a, &b, &c };
+	if (area < 0.0f)
+	{
+		std::swap(vertices[1], vertices[2]);
+		area = -area;
+	}
+
+	TRIANGLE_SETUP setup;
+	for (int edge = 0; edge < 3; edge++)
+	{
+		const SCREEN_VERTEX& from = *vertices[edge];
+		const SCREEN_VERTEX& to = *vertices[(edge + 1) % 3];
+		setup.edgeX[edge] = from.y - to.y;
+		setup.edgeY[edge] = to.x - from.x;
+		setup.edgeOffset[edge] = -setup.edgeX[edge] * from.x - setup.edgeY[edge] * from.y;
+	}
+
+	// the edge opposite a vertex weighs its depth
+	float depthA = vertices[0]->depth / area;
+	float depthB = vertices[1]->depth / area;
+	float depthC = vertices[2]->depth / area;
+	setup.depthX = setup.edgeX[1] * depthA + setup.edgeX[2] * depthB + setup.edgeX[0] * depthC;
+	setup.depthY = setup.edgeY[1] * depthA + setup.edgeY[2] * depthB + setup.edgeY[0] * depthC;
+	setup.depthOffset = setup.edgeOffset[1] * depthA + setup.edgeOffset[2] * depthB + setup.edgeOffset[0] * depthC;
+
+	float minX = std::min(a.x, std::min(b.x, c.x));
+	float maxX = std::max(a.x, std::max(b.x, c.x));
+	float minY = std::min(a.y, std::min(b.y, c.y));
+	float maxY = std::max(a.y, std::max(b.y, c.y));
+	setup.minX = std::max((int)std::floor(minX), 0);
+	setup.maxX = std::min((int)std::ceil(maxX), BUFFER_WIDTH - 1);
+	setup.minY = std::max((int)std::floor(minY), 0);
+	setup.maxY = std::min((int)std::ceil(maxY), BUFFER_HEIGHT - 1);
+	if ((setup.minX > setup.maxX) || (setup.minY > setup.maxY))
+	{
+		return;
+	}
+
+	if (m_bUseAVX2)
+	{
+		FillTriangleAVX2(setup, &m_depth[0]);
+	}
+	else
+	{
+		FillTriangleSSE(setup, &m_depth[0]);
+	}
+	m_triangleCount++;
+}
+
+/***********************************************************
+ *  IsBoxOccluded()
+ *
+ *  This method is used to check whether a box is hidden.
+ *  The rectangle around its projected corners is compared
+ *  with its nearest depth - if every pixel of it has an
+ *  occluder in front of that depth, no part of the box can
+ *  be seen.  Boxes that reach in front of the near plane or
+ *  off the screen are never hidden here.
+ ***********************************************************/
+bool OcclusionBuffer::IsBoxOccluded(const glm::vec3& minimum, const glm::vec3& maximum, const glm::mat4& model) const
+{
+	if (m_triangleCount == 0)
+	{
+		return false;
+	}
+
+	SCREEN_VERTEX corners[8];
+	if (ProjectBox(minimum, maximum, model, corners) == false)
+	{
+		return false;
+	}
+
+	float minX = corners[0].x;
+	float maxX = corners[0].x;
+	float minY = corners[0].y;
+	float maxY = corners[0].y;
+	float nearestDepth = corners[0].depth;
+	for (int i = 1; i < 8; i++)
+	{
+		minX = std::min(minX, corners[i].x);
+		maxX = std::max(maxX, corners[i].x);
+		minY = std::min(minY, corners[i].y);
+		maxY = std::max(maxY, corners[i].y);
+		nearestDepth = std::min(nearestDepth, corners[i].depth);
+	}
+
+	// every pixel the rectangle touches is checked
+	int firstX = std::max((int)std::floor(minX), 0);
+	int lastX = std::min((int)std::ceil(maxX) - 1, BUFFER_WIDTH - 1);
+	int firstY = std::max((int)std::floor(minY), 0);
+	int lastY = std::min((int)std::ceil(maxY) - 1, BUFFER_HEIGHT - 1);
+	if ((firstX > lastX) || (firstY > lastY))
+	{
+		return false;
+	}
+
+	bool bVisible = m_bUseAVX2 ?
+		IsRectVisibleAVX2(&m_depth[0], firstX, lastX, firstY, lastY, nearestDepth) :
+		IsRectVisibleSSE(&m_depth[0], firstX, lastX, firstY, lastY, nearestDepth);
+	return (bVisible == false);
+}
+
+/***********************************************************
+ *  GetTriangleCount()
+ *
+ *  This method is used to get the number of occluder
+ *  triangles drawn since the buffer was cleared.
+ ***********************************************************/
+int OcclusionBuffer::GetTriangleCount() const
+{
+	return m_triangleCount;
+}
+
+/***********************************************************
+ *  GetDepth()
+ *
+ *  This method is used to read the depth of one pixel of
+ *  the buffer, for checking what the occluders covered.
+ ***********************************************************/
+float OcclusionBuffer::GetDepth(int x, int y) const
+{
+	return m_depth[y * BUFFER_WIDTH + x];
+}
@@ -0,0 +1,72 @@
+///////////////////////////////////////////////////////////////////////////////
+// occlusionbuffer.h
+// ============
+// small CPU depth buffer for skipping objects hidden behind large occluders
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// GLM Math Header inclusions
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  OcclusionBuffer
+ *
+ *  This class rasterizes a few large occluders - boxes and
+ *  planes - into a low resolution depth buffer on the CPU,
+ *  and then tests the screen space bounds of other objects
+ *  against it.  An object whose nearest point is behind the
+ *  occluders at every pixel of its bounds is hidden and does
+ *  not need to be drawn.  Rows of 8 pixels are filled and
+ *  tested at once with AVX2 when the processor has it, and
+ *  4 at once with SSE2 otherwise, so no GPU is involved.
+ ***********************************************************/
+class OcclusionBuffer
+{
+public:
+	// size of the depth buffer in pixels - the width is a
+	// multiple of the 8 pixels filled at once
+	static const int BUFFER_WIDTH = 256;
+	static const int BUFFER_HEIGHT = 160;
+
+	// constructor
+	OcclusionBuffer();
+
+	// clear the depth buffer for a new view
+	void Clear(const glm::mat4& viewProjection);
+	// draw the faces of a local box moved by a model matrix - a
+	// box with no depth is drawn as a plane
+	void RasterizeBox(const glm::vec3& minimum, const glm::vec3& maximum, const glm::mat4& model);
+	// check whether a local box moved by a model matrix is
+	// hidden behind everything rasterized so far
+	bool IsBoxOccluded(const glm::vec3& minimum, const glm::vec3& maximum, const glm::mat4& model) const;
+
+	// number of occluder triangles drawn since the last clear
+	int GetTriangleCount() const;
+	// the depth of a pixel, 1 where nothing was drawn
+	float GetDepth(int x, int y) const;
+
+private:
+	// a corner of an occluder in buffer pixels, with its depth
+	// from 0 at the near plane to 1 at the far plane
+	struct SCREEN_VERTEX
+	{
+		float x;
+		float y;
+		float depth;
+	};
+
+	glm::mat4 m_viewProjection;
+	std::vector<float> m_depth;
+	int m_triangleCount;
+	bool m_bUseAVX2;
+
+	// fill the pixels covered by a triangle
+	void RasterizeTriangle(const SCREEN_VERTEX& a, const SCREEN_VERTEX& b, const SCREEN_VERTEX& c);
+	// project the corners of a box, returns false when one of
+	// them is behind the camera
+	bool ProjectBox(const glm::vec3& minimum, const glm::vec3& maximum, const glm::mat4& model,
+		SCREEN_VERTEX corners[8]) const;
+};
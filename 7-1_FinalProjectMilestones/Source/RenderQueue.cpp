@@ -0,0 +1,390 @@
+///////////////////////////////////////////////////////////////////////////////
+// renderqueue.cpp
+// ============
+// collect the draws of a frame and submit them sorted by render state
+///////////////////////////////////////////////////////////////////////////////
+
+#include "RenderQueue.h"
+#include "GLStateCache.h"
+
+#include <algorithm>
+
+// declare the global variables
+namespace
+{
+	// widths of the fields of the sort key - the blend mode is
+	// always on top, and the other fields are ordered from the
+	// most to the least expensive state to change
+	const int BLEND_BITS = 2;
+	const int VARIANT_BITS = 6;
+	const int MESH_BITS = 4;
+	const int LOD_BITS = 2;
+	const int ARRAY_BITS = 4;
+	const int LAYER_BITS = 12;
+	const int MATERIAL_BITS = 8;
+	const int DEPTH_BITS = 24;
+	const int STATE_BITS = VARIANT_BITS + MESH_BITS + LOD_BITS + ARRAY_BITS + LAYER_BITS + MATERIAL_BITS;
+
+	// the blend mode sits in the top bits, and the state and
+	// depth fields swap places for blended draws so that they
+	// are sorted back to front first
+	const int BLEND_SHIFT = 64 - BLEND_BITS;
+	const int UPPER_SHIFT = BLEND_SHIFT - STATE_BITS;
+	const int LOWER_SHIFT = UPPER_SHIFT - DEPTH_BITS;
+
+	// view depth that maps to the largest depth field, farther
+	// draws share the last value
+	const float MAX_SORT_DEPTH = 1000.0f;
+
+	/***********************************************************
+	 *  PackField()
+	 *
+	 *  Clamp a value into a field of the passed in width.
+	 ***********************************************************/
+	uint64_t PackField(int value, int bits)
+	{
+		const int maxValue = (1 << bits) - 1;
+		return (uint64_t)std::min(std::max(value, 0), maxValue);
+	}
+}
+
+/***********************************************************
+ *  RenderQueue()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+RenderQueue::RenderQueue()
+{
+	m_stats = QUEUE_STATS();
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used to remove all of the submitted
+ *  packets, keeping the memory for the next frame.
+ ***********************************************************/
+void RenderQueue::Clear()
+{
+	m_packets.clear();
+}
+
+/***********************************************************
+ *  Submit()
+ *
+ *  This method is used to add a draw to the queue.  Nothing
+ *  is sent to OpenGL until the queue is flushed.
+ ***********************************************************/
+void RenderQueue::Submit(const DRAW_PACKET& packet)
+{
+	m_packets.push_back(packet);
+}
+
+/***********************************************************
+ *  Submit()
+ *
+ *  This method is used to add a list of draws that were
+ *  built ahead of time, copying them in one go.
+ ***********************************************************/
+void RenderQueue::Submit(const std::vector<DRAW_PACKET>& packets)
+{
+	m_packets.insert(m_packets.end(), packets.begin(), packets.end());
+}
+
+/***********************************************************
+ *  SubmitInstances()
+ *
+ *  This method is used to add a copy of a draw for each of
+ *  the passed in model matrices.  The copies sort next to
+ *  each other, so they are drawn together with one call.
+ ***********************************************************/
+void RenderQueue::SubmitInstances(const DRAW_PACKET& packet, const std::vector<glm::mat4>& models)
+{
+	m_packets.reserve(m_packets.size() + models.size());
+	for (size_t i = 0; i < models.size(); i++)
+	{
+		m_packets.push_back(packet);
+		m_packets.back().model = models[i];
+	}
+}
+
+/***********************************************************
+ *  MakeSortKey()
+ *
+ *  This method is used to pack the render state of a draw
+ *  into a 64-bit key.  From the top, opaque keys hold the
+ *  blend mode, the shader variant, the mesh and its level
+ *  of detail, the texture array and layer, the material and
+ *  the view depth.  Blended keys move the view depth,
+ *  inverted, right under the blend mode so they are drawn
+ *  back to front.
+ ***********************************************************/
+uint64_t RenderQueue::MakeSortKey(const DRAW_PACKET& packet, float viewDepth)
+{
+	uint64_t state = PackField(packet.variant, VARIANT_BITS);
+	state = (state << MESH_BITS) | PackField((int)packet.mesh, MESH_BITS);
+	state = (state << LOD_BITS) | PackField(packet.lod, LOD_BITS);
+	// untextured draws take array 0, before every real array
+	state = (state << ARRAY_BITS) | PackField(packet.textureArray + 1, ARRAY_BITS);
+	state = (state << LAYER_BITS) | PackField((packet.textureArray >= 0) ? packet.textureLayer : 0, LAYER_BITS);
+	state = (state << MATERIAL_BITS) | PackField(packet.materialIndex, MATERIAL_BITS);
+
+	const uint64_t maxDepth = ((uint64_t)1 << DEPTH_BITS) - 1;
+	float depthRatio = std::min(std::max(viewDepth / MAX_SORT_DEPTH, 0.0f), 1.0f);
+	uint64_t depth = (uint64_t)(depthRatio * (float)maxDepth);
+
+	uint64_t key = (uint64_t)packet.blendMode << BLEND_SHIFT;
+	if (packet.blendMode == BLEND_ALPHA)
+	{
+		key |= (maxDepth - depth) << (BLEND_SHIFT - DEPTH_BITS);
+		key |= state << (BLEND_SHIFT - DEPTH_BITS - STATE_BITS);
+	}
+	else
+	{
+		key |= state << UPPER_SHIFT;
+		key |= depth << LOWER_SHIFT;
+	}
+
+	return key;
+}
+
+/***********************************************************
+ *  Flush()
+ *
+ *  This method is used to sort the submitted packets by
+ *  their keys and to draw them.  The packets stay in the
+ *  queue until it is cleared.
+ ***********************************************************/
+void RenderQueue::Flush(ShapeMeshes* pMeshes, ShaderManager* pShaders, const glm::mat4& view)
+{
+	Prepare(pMeshes, pShaders, view, 0);
+	Draw(pMeshes, pShaders);
+}
+
+/***********************************************************
+ *  Prepare()
+ *
+ *  This method is used to sort the submitted packets by
+ *  their keys and to upload them.  The sorted packets are
+ *  uploaded as the instance buffer in one go, and each run
+ *  of packets sharing a shader variant, mesh level, texture
+ *  array and blend mode becomes an indirect draw command.
+ *  The shader variants of the batches, with the passed in
+ *  features added to the opaque ones, are then compiled
+ *  together if any are missing, so no draw waits on one.
+ ***********************************************************/
+void RenderQueue::Prepare(ShapeMeshes* pMeshes, ShaderManager* pShaders, const glm::mat4& view, int opaqueFeatures)
+{
+	m_stats = QUEUE_STATS();
+
+	m_sortEntries.resize(m_packets.size());
+	for (size_t i = 0; i < m_packets.size(); i++)
+	{
+		// the depth of the object's origin is close enough for
+		// ordering whole objects
+		float viewDepth = -(view * m_packets[i].model[3]).z;
+		m_sortEntries[i].key = MakeSortKey(m_packets[i], viewDepth);
+		m_sortEntries[i].packetIndex = (uint32_t)i;
+	}
+	std::sort(m_sortEntries.begin(), m_sortEntries.end(), [](const SORT_ENTRY& a, const SORT_ENTRY& b)
+	{
+		return (a.key != b.key) ? (a.key < b.key) : (a.packetIndex < b.packetIndex);
+	});
+
+	m_instances.resize(m_sortEntries.size());
+	for (size_t i = 0; i < m_sortEntries.size(); i++)
+	{
+		const DRAW_PACKET& packet = m_packets[m_sortEntries[i].packetIndex];
+		ShapeMeshes::INSTANCE_DATA& instance = m_instances[i];
+		instance.model = packet.model;
+		instance.color = packet.color;
+		instance.UVscale = packet.UVscale;
+		instance.textureArray = packet.textureArray;
+		instance.textureLayer = packet.textureLayer;
+		instance.materialIndex = packet.materialIndex;
+		pMeshes->GetPositionDecode(packet.mesh, packet.lod, instance);
+	}
+	pMeshes->UploadInstances(m_instances.data(), (int)m_instances.size());
+
+	// every run of packets that share a shader variant, a mesh
+	// level, a texture array and a blend mode becomes one
+	// indirect draw command - the sampler array can only be
+	// indexed by a value that is the same for the whole command
+	m_commands.clear();
+	m_batches.clear();
+	size_t first = 0;
+	while (first < m_sortEntries.size())
+	{
+		const DRAW_PACKET& packet = m_packets[m_sortEntries[first].packetIndex];
+
+		size_t last = first + 1;
+		while (last < m_sortEntries.size())
+		{
+			const DRAW_PACKET& next = m_packets[m_sortEntries[last].packetIndex];
+			if ((next.variant != packet.variant) || (next.mesh != packet.mesh) || (next.lod != packet.lod) ||
+				(next.blendMode != packet.blendMode) || (next.textureArray != packet.textureArray))
+			{
+				break;
+			}
+			last++;
+		}
+
+		// commands with the same variant and blend mode are
+		// drawn together
+		if (m_batches.empty() || (m_batches.back().variant != packet.variant) ||
+			(m_batches.back().blendMode != packet.blendMode))
+		{
+			DRAW_BATCH batch;
+			batch.variant = packet.variant;
+			batch.blendMode = packet.blendMode;
+			batch.firstCommand = (int)m_commands.size();
+			batch.commandCount = 0;
+			m_batches.push_back(batch);
+		}
+
+		ShapeMeshes::DRAW_COMMAND command;
+		pMeshes->GetDrawCommand(packet.mesh, packet.lod, (int)first, (int)(last - first), command);
+		m_commands.push_back(command);
+		m_batches.back().commandCount++;
+		m_stats.instances += (int)(last - first);
+
+		first = last;
+	}
+	m_stats.drawCommands = (int)m_commands.size();
+
+	if (m_commands.empty() == false)
+	{
+		pMeshes->UploadDrawCommands(m_commands.data(), (int)m_commands.size());
+	}
+
+	m_variants.clear();
+	for (size_t i = 0; i < m_batches.size(); i++)
+	{
+		int features = (m_batches[i].blendMode == BLEND_OPAQUE) ? opaqueFeatures : 0;
+		m_variants.push_back(m_batches[i].variant | features);
+	}
+	pShaders->PrepareVariants(m_variants);
+}
+
+/***********************************************************
+ *  Draw()
+ *
+ *  This method is used to draw the prepared packets.  The
+ *  commands of each variant and blend mode are drawn with
+ *  one multi draw call.  They can be drawn again into other
+ *  views, as the view comes from the frame block, until the
+ *  meshes are given the instances of another queue.  The
+ *  shader program is left on the default variant.
+ ***********************************************************/
+void RenderQueue::Draw(ShapeMeshes* pMeshes, ShaderManager* pShaders)
+{
+	DrawBatches(pMeshes, pShaders, -1, 0);
+}
+
+/***********************************************************
+ *  Draw()
+ *
+ *  This method is used to draw the prepared packets of one
+ *  blend mode, with features added to their variants.  The
+ *  deferred path draws the opaque packets into the G-buffer
+ *  this way, and the blended ones after it is lit.
+ ***********************************************************/
+void RenderQueue::Draw(ShapeMeshes* pMeshes, ShaderManager* pShaders, BLEND_MODE blendMode, int addedFeatures)
+{
+	DrawBatches(pMeshes, pShaders, (int)blendMode, addedFeatures);
+}
+
+/***********************************************************
+ *  DrawBatches()
+ *
+ *  This method is used to draw the batches of a blend mode,
+ *  or all of them when the mode is negative.  The vertex
+ *  array is only bound once something is drawn.
+ ***********************************************************/
+void RenderQueue::DrawBatches(ShapeMeshes* pMeshes, ShaderManager* pShaders, int blendMode, int addedFeatures)
+{
+	bool bDrawn = false;
+	int currentVariant = -1;
+	int currentBlendMode = -1;
+
+	for (size_t i = 0; i < m_batches.size(); i++)
+	{
+		if ((blendMode >= 0) && ((int)m_batches[i].blendMode != blendMode))
+		{
+			continue;
+		}
+
+		if (bDrawn == false)
+		{
+			// every mesh is in the same buffers, so the vertex
+			// array is bound once for the whole queue
+			pMeshes->BindMeshes();
+			m_stats.vertexArrayBinds++;
+			bDrawn = true;
+		}
+
+		int variant = m_batches[i].variant | addedFeatures;
+		if (variant != currentVariant)
+		{
+			// Prepare() compiled the variants, so this only binds
+			GLStateCache::UseProgram(pShaders->GetVariant(variant));
+			m_stats.programChanges++;
+			currentVariant = variant;
+		}
+
+		if ((int)m_batches[i].blendMode != currentBlendMode)
+		{
+			if (m_batches[i].blendMode == BLEND_ALPHA)
+			{
+				// blended draws test against the opaque ones but
+				// do not hide each other
+				GLStateCache::Enable(GL_BLEND);
+				GLStateCache::DepthMask(GL_FALSE);
+			}
+			else
+			{
+				GLStateCache::Disable(GL_BLEND);
+				GLStateCache::DepthMask(GL_TRUE);
+			}
+			m_stats.blendChanges++;
+			currentBlendMode = (int)m_batches[i].blendMode;
+		}
+
+		pMeshes->DrawMeshesIndirect(m_batches[i].firstCommand, m_batches[i].commandCount);
+		m_stats.drawCalls++;
+	}
+
+	if (bDrawn == false)
+	{
+		return;
+	}
+
+	GLStateCache::BindVertexArray(0);
+	pShaders->use();
+
+	// leave the blending set up the way the window expects it
+	GLStateCache::Enable(GL_BLEND);
+	GLStateCache::DepthMask(GL_TRUE);
+}
+
+/***********************************************************
+ *  GetPacketCount()
+ *
+ *  This method is used to get the number of packets that
+ *  have been submitted since the queue was cleared.
+ ***********************************************************/
+int RenderQueue::GetPacketCount() const
+{
+	return (int)m_packets.size();
+}
+
+/***********************************************************
+ *  GetStats()
+ *
+ *  This method is used to get the counters of the most
+ *  recent flush.
+ ***********************************************************/
+const RenderQueue::QUEUE_STATS& RenderQueue::GetStats() const
+{
+	return m_stats;
+}
@@ -0,0 +1,152 @@
+///////////////////////////////////////////////////////////////////////////////
+// renderqueue.h
+// ============
+// collect the draws of a frame and submit them sorted by render state
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+#include "ShapeMeshes.h"
+
+#include <GL/glew.h>
+
+// GLM Math Header inclusions
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+/***********************************************************
+ *  RenderQueue
+ *
+ *  This class collects draw packets - the shader variant,
+ *  mesh, texture, material, transform and blend mode of one
+ *  draw - while the scene is walked.  When the queue is
+ *  flushed, the packets are sorted by a 64-bit key that
+ *  packs their render state, so draws sharing a shader
+ *  variant, mesh, texture and material end up next to each
+ *  other.  The sorted packets become the instance buffer of
+ *  the meshes, and every run of packets with the same
+ *  variant, mesh level, texture array and blend mode becomes
+ *  one indirect draw command.  The commands of each variant
+ *  and blend mode are submitted with a single multi draw
+ *  call, so the whole scene costs a handful of draw calls
+ *  however many objects it has.  Opaque draws go first,
+ *  front to back within the same state, and blended draws
+ *  go last, back to front.
+ ***********************************************************/
+class RenderQueue
+{
+public:
+	// how a draw is combined with what is already drawn
+	enum BLEND_MODE
+	{
+		BLEND_OPAQUE = 0,
+		BLEND_ALPHA = 1
+	};
+
+	// everything needed for one draw
+	struct DRAW_PACKET
+	{
+		// features of the shader program variant the draw is
+		// made with, a combination of ShaderManager::PROGRAM_FEATURE
+		int variant;
+		ShapeMeshes::MESH_TYPE mesh;
+		// level of detail of the mesh, 0 for the full mesh
+		int lod;
+		// texture array and layer, or -1 for the color
+		int textureArray;
+		int textureLayer;
+		// color used when there is no texture
+		glm::vec4 color;
+		glm::vec2 UVscale;
+		// index into the material buffer
+		int materialIndex;
+		BLEND_MODE blendMode;
+		glm::mat4 model;
+	};
+
+	// counters for the most recently flushed queue
+	struct QUEUE_STATS
+	{
+		int drawCalls;
+		// indirect commands executed by the draw calls
+		int drawCommands;
+		int instances;
+		// vertex array binds, shader variant and blend changes
+		int vertexArrayBinds;
+		int programChanges;
+		int blendChanges;
+	};
+
+	// constructor
+	RenderQueue();
+
+	// remove all of the submitted packets
+	void Clear();
+	// add a draw to the queue
+	void Submit(const DRAW_PACKET& packet);
+	// add a list of draws to the queue
+	void Submit(const std::vector<DRAW_PACKET>& packets);
+	// add copies of a draw that only differ in their model
+	// matrix, one for each of the passed in matrices
+	void SubmitInstances(const DRAW_PACKET& packet, const std::vector<glm::mat4>& models);
+	// sort the submitted packets and draw them with the shader
+	// variants they need - the view matrix orders the draws by
+	// depth
+	void Flush(ShapeMeshes* pMeshes, ShaderManager* pShaders, const glm::mat4& view);
+	// the two halves of Flush() - sort and upload the packets
+	// and compile the shader variants they are drawn with, the
+	// opaque ones with features added, then draw them, as many
+	// times as needed
+	void Prepare(ShapeMeshes* pMeshes, ShaderManager* pShaders, const glm::mat4& view, int opaqueFeatures);
+	void Draw(ShapeMeshes* pMeshes, ShaderManager* pShaders);
+	// draw only the prepared packets of one blend mode, with
+	// features added to the shader variants they need
+	void Draw(ShapeMeshes* pMeshes, ShaderManager* pShaders, BLEND_MODE blendMode, int addedFeatures);
+
+	// number of packets waiting to be drawn
+	int GetPacketCount() const;
+	// get the counters of the most recent flush
+	const QUEUE_STATS& GetStats() const;
+
+	// pack the render state and view depth of a draw into the
+	// key it is sorted by
+	static uint64_t MakeSortKey(const DRAW_PACKET& packet, float viewDepth);
+
+private:
+	// a packet's key and its place in the packet list - the
+	// place keeps the sort stable between equal keys
+	struct SORT_ENTRY
+	{
+		uint64_t key;
+		uint32_t packetIndex;
+	};
+
+	// commands drawn together with one shader variant and
+	// blend mode
+	struct DRAW_BATCH
+	{
+		int variant;
+		BLEND_MODE blendMode;
+		int firstCommand;
+		int commandCount;
+	};
+
+	std::vector<DRAW_PACKET> m_packets;
+	std::vector<SORT_ENTRY> m_sortEntries;
+	// the sorted packets as mesh instances
+	std::vector<ShapeMeshes::INSTANCE_DATA> m_instances;
+	// the indirect draw commands of the sorted packets, and
+	// the ranges of them that share a variant and blend mode
+	std::vector<ShapeMeshes::DRAW_COMMAND> m_commands;
+	std::vector<DRAW_BATCH> m_batches;
+	// the shader variants the batches are drawn with
+	std::vector<int> m_variants;
+	QUEUE_STATS m_stats;
+
+	// draw the batches of a blend mode, or of every mode for a
+	// negative one
+	void DrawBatches(ShapeMeshes* pMeshes, ShaderManager* pShaders, int blendMode, int addedFeatures);
+};
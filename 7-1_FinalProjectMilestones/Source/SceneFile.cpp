@@ -0,0 +1,598 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenefile.cpp
+// ============
+// compiled scene description with the objects, lights and camera of a scene
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SceneFile.h"
+#include "ShapeMeshes.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <unordered_map>
+
+// declare the global variables
+namespace
+{
+	// extension of the compiled form of a scene
+	const char* const COMPILED_EXTENSION = ".bscene";
+
+	/***********************************************************
+	 *  ReadValues()
+	 *
+	 *  Read a number of floats that follow a keyword.
+	 ***********************************************************/
+	bool ReadValues(std::istream& words, float* values, int count)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			if (!(words >> values[i]))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/***********************************************************
+	 *  ReadTag()
+	 *
+	 *  Read a texture or material tag that follows a keyword
+	 *  into a fixed size, zero filled field.
+	 ***********************************************************/
+	bool ReadTag(std::istream& words, char* tag)
+	{
+		std::string value;
+		if (!(words >> value) || (value.size() >= (size_t)SceneFile::MAX_TAG_LENGTH))
+		{
+			return false;
+		}
+
+		memset(tag, 0, SceneFile::MAX_TAG_LENGTH);
+		memcpy(tag, value.c_str(), value.size());
+		return true;
+	}
+
+	// a keyword of a scene line and what its values set -
+	// either a number of floats, a tag, a name or, for a
+	// keyword without values, a flag
+	struct KEYWORD_VALUE
+	{
+		const char* keyword;
+		float* values;
+		int count;
+		char* tag;
+		std::string* name;
+		uint32_t* flags;
+		uint32_t flag;
+	};
+
+	// objects and groups that can be used as a parent, by name
+	typedef std::unordered_map<std::string, int> OBJECT_NAMES;
+
+	/***********************************************************
+	 *  ReadKeywords()
+	 *
+	 *  Read the keywords that make up the rest of a line, each
+	 *  followed by its values, in any order.  Keywords that
+	 *  are left out keep their defaults.
+	 ***********************************************************/
+	bool ReadKeywords(std::istream& words, const KEYWORD_VALUE* keywords, int keywordCount)
+	{
+		std::string keyword;
+		while (words >> keyword)
+		{
+			int index = 0;
+			while ((index < keywordCount) && (keyword != keywords[index].keyword))
+			{
+				index++;
+			}
+
+			if (index == keywordCount)
+			{
+				return false;
+			}
+
+			bool bValid = false;
+			if (keywords[index].flags != NULL)
+			{
+				*keywords[index].flags |= keywords[index].flag;
+				bValid = true;
+			}
+			else if (keywords[index].tag != NULL)
+			{
+				bValid = ReadTag(words, keywords[index].tag);
+			}
+			else if (keywords[index].name != NULL)
+			{
+				bValid = (bool)(words >> *keywords[index].name);
+			}
+			else
+			{
+				bValid = ReadValues(words, keywords[index].values, keywords[index].count);
+			}
+			if (bValid == false)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/***********************************************************
+	 *  FindMeshType()
+	 *
+	 *  Find the basic shape with the passed in mesh name.
+	 ***********************************************************/
+	bool FindMeshType(const std::string& name, uint32_t& mesh)
+	{
+		for (int i = 0; i < ShapeMeshes::MESH_COUNT; i++)
+		{
+			if (name == ShapeMeshes::GetMeshName((ShapeMeshes::MESH_TYPE)i))
+			{
+				mesh = (uint32_t)i;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/***********************************************************
+	 *  ParseObject()
+	 *
+	 *  Read the rest of an object or group line.  An object
+	 *  starts with its mesh name and a group with its own name,
+	 *  followed by any of the keywords name, parent, position,
+	 *  rotation, scale, uv, color, texture and material with
+	 *  their values, and the flags unlit, alphatest and
+	 *  dynamic.  A named object is added to the names that
+	 *  later objects can use as their parent.
+	 ***********************************************************/
+	bool ParseObject(std::istream& words, bool bGroup, int objectIndex, OBJECT_NAMES& names,
+		SceneFile::SCENE_OBJECT& object)
+	{
+		object = SceneFile::SCENE_OBJECT();
+		object.mesh = SceneFile::NO_MESH;
+		object.parent = -1;
+		object.scale = glm::vec3(1.0f);
+		object.UVscale = glm::vec2(1.0f);
+		object.color = glm::vec4(1.0f);
+
+		std::string name;
+		std::string parentName;
+		std::string firstWord;
+		if (!(words >> firstWord))
+		{
+			return false;
+		}
+		if (bGroup)
+		{
+			name = firstWord;
+		}
+		else if (FindMeshType(firstWord, object.mesh) == false)
+		{
+			return false;
+		}
+
+		const KEYWORD_VALUE keywords[] =
+		{
+			{ "name", NULL, 0, NULL, &name, NULL, 0 },
+			{ "parent", NULL, 0, NULL, &parentName, NULL, 0 },
+			{ "position", &object.position.x, 3, NULL, NULL, NULL, 0 },
+			{ "rotation", &object.rotation.x, 3, NULL, NULL, NULL, 0 },
+			{ "scale", &object.scale.x, 3, NULL, NULL, NULL, 0 },
+			{ "uv", &object.UVscale.x, 2, NULL, NULL, NULL, 0 },
+			{ "color", &object.color.x, 4, NULL, NULL, NULL, 0 },
+			{ "texture", NULL, 0, object.textureTag, NULL, NULL, 0 },
+			{ "material", NULL, 0, object.materialTag, NULL, NULL, 0 },
+			{ "unlit", NULL, 0, NULL, NULL, &object.flags, SceneFile::OBJECT_UNLIT },
+			{ "alphatest", NULL, 0, NULL, NULL, &object.flags, SceneFile::OBJECT_ALPHA_TEST },
+			{ "dynamic", NULL, 0, NULL, NULL, &object.flags, SceneFile::OBJECT_DYNAMIC }
+		};
+		if (ReadKeywords(words, keywords, sizeof(keywords) / sizeof(keywords[0])) == false)
+		{
+			return false;
+		}
+
+		// the parent has to be named before it is used, which
+		// keeps every parent in front of its children
+		if (parentName.empty() == false)
+		{
+			OBJECT_NAMES::const_iterator parent = names.find(parentName);
+			if (parent == names.end())
+			{
+				return false;
+			}
+			object.parent = parent->second;
+		}
+		if (name.empty() == false)
+		{
+			names[name] = objectIndex;
+		}
+
+		return true;
+	}
+
+	/***********************************************************
+	 *  ParseLight()
+	 *
+	 *  Read the rest of a light line - any of the keywords
+	 *  position, range, ambient, diffuse, specular, focal and
+	 *  intensity with their values.
+	 ***********************************************************/
+	bool ParseLight(std::istream& words, ClusteredLights::POINT_LIGHT& light)
+	{
+		light = ClusteredLights::POINT_LIGHT();
+		light.range = 100.0f;
+		light.diffuseColor = glm::vec3(1.0f);
+		light.focalStrength = 32.0f;
+		light.specularIntensity = 1.0f;
+
+		const KEYWORD_VALUE keywords[] =
+		{
+			{ "position", &light.position.x, 3, NULL, NULL, NULL, 0 },
+			{ "range", &light.range, 1, NULL, NULL, NULL, 0 },
+			{ "ambient", &light.ambientColor.x, 3, NULL, NULL, NULL, 0 },
+			{ "diffuse", &light.diffuseColor.x, 3, NULL, NULL, NULL, 0 },
+			{ "specular", &light.specularColor.x, 3, NULL, NULL, NULL, 0 },
+			{ "focal", &light.focalStrength, 1, NULL, NULL, NULL, 0 },
+			{ "intensity", &light.specularIntensity, 1, NULL, NULL, NULL, 0 }
+		};
+		return ReadKeywords(words, keywords, sizeof(keywords) / sizeof(keywords[0])) && (light.range > 0.0f);
+	}
+
+	/***********************************************************
+	 *  ParseCamera()
+	 *
+	 *  Read the rest of a camera line - any of the keywords
+	 *  position, front and zoom with their values.
+	 ***********************************************************/
+	bool ParseCamera(std::istream& words, SceneFile::SCENE_CAMERA& camera)
+	{
+		camera = SceneFile::SCENE_CAMERA();
+		camera.front = glm::vec3(0.0f, 0.0f, -1.0f);
+		camera.zoom = 45.0f;
+
+		const KEYWORD_VALUE keywords[] =
+		{
+			{ "position", &camera.position.x, 3, NULL, NULL, NULL, 0 },
+			{ "front", &camera.front.x, 3, NULL, NULL, NULL, 0 },
+			{ "zoom", &camera.zoom, 1, NULL, NULL, NULL, 0 }
+		};
+		return ReadKeywords(words, keywords, sizeof(keywords) / sizeof(keywords[0]));
+	}
+}
+
+/***********************************************************
+ *  SceneFile()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SceneFile::SceneFile()
+{
+	m_pHeader = NULL;
+	m_pObjects = NULL;
+	m_pLights = NULL;
+}
+
+/***********************************************************
+ *  Open()
+ *
+ *  This method is used to map a compiled scene into memory.
+ *  A text scene is compiled first when its compiled file is
+ *  missing or not newer than the text, and the compiled
+ *  file is mapped in its place.  A compiled file from an
+ *  older version is compiled again from its text.
+ ***********************************************************/
+bool SceneFile::Open(const std::string& filename)
+{
+	Close();
+
+	std::string compiledFilename = GetCompiledFilename(filename);
+	if (compiledFilename != filename)
+	{
+		long long textTime = MappedFile::GetModifiedTime(filename);
+		if (textTime == 0)
+		{
+			std::cout << "Could not find scene file:" << filename << std::endl;
+			return false;
+		}
+
+		// the times only have a resolution of seconds, so a
+		// compiled file from the same second is made again
+		if ((MappedFile::GetModifiedTime(compiledFilename) <= textTime) &&
+			(Compile(filename, compiledFilename) == false))
+		{
+			return false;
+		}
+	}
+
+	if (m_file.Open(compiledFilename) == false)
+	{
+		std::cout << "Could not map scene file:" << compiledFilename << std::endl;
+		return false;
+	}
+
+	if (Validate(compiledFilename) == false)
+	{
+		Close();
+		if ((compiledFilename == filename) || (Compile(filename, compiledFilename) == false) ||
+			(m_file.Open(compiledFilename) == false) || (Validate(compiledFilename) == false))
+		{
+			Close();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/***********************************************************
+ *  Validate()
+ *
+ *  This method is used to check that the mapped file is a
+ *  scene of this version, that its arrays fill the file
+ *  exactly, and that every object uses a known mesh and has
+ *  its parent in front of it.
+ ***********************************************************/
+bool SceneFile::Validate(const std::string& filename)
+{
+	const unsigned char* pData = m_file.GetData();
+	size_t size = m_file.GetSize();
+
+	const SCENE_HEADER* pHeader = (const SCENE_HEADER*)pData;
+	if ((size < sizeof(SCENE_HEADER)) || (pHeader->magic != SCENE_MAGIC) || (pHeader->version != SCENE_VERSION))
+	{
+		std::cout << "Not a valid scene file:" << filename << std::endl;
+		return false;
+	}
+
+	uint64_t expectedSize = sizeof(SCENE_HEADER) +
+		(uint64_t)pHeader->objectCount * sizeof(SCENE_OBJECT) +
+		(uint64_t)pHeader->lightCount * sizeof(ClusteredLights::POINT_LIGHT);
+	if (expectedSize != (uint64_t)size)
+	{
+		std::cout << "Scene file has the wrong size:" << filename << std::endl;
+		return false;
+	}
+
+	const SCENE_OBJECT* pObjects = (const SCENE_OBJECT*)(pData + sizeof(SCENE_HEADER));
+	for (uint32_t i = 0; i < pHeader->objectCount; i++)
+	{
+		if (((pObjects[i].mesh >= (uint32_t)ShapeMeshes::MESH_COUNT) && (pObjects[i].mesh != NO_MESH)) ||
+			(pObjects[i].parent < -1) || (pObjects[i].parent >= (int32_t)i) ||
+			(pObjects[i].textureTag[MAX_TAG_LENGTH - 1] != '\0') ||
+			(pObjects[i].materialTag[MAX_TAG_LENGTH - 1] != '\0'))
+		{
+			std::cout << "Scene file object " << i << " is damaged:" << filename << std::endl;
+			return false;
+		}
+	}
+
+	m_pHeader = pHeader;
+	m_pObjects = pObjects;
+	m_pLights = (const ClusteredLights::POINT_LIGHT*)(pObjects + pHeader->objectCount);
+
+	return true;
+}
+
+/***********************************************************
+ *  Close()
+ *
+ *  This method is used to unmap the scene file.
+ ***********************************************************/
+void SceneFile::Close()
+{
+	m_file.Close();
+
+	m_pHeader = NULL;
+	m_pObjects = NULL;
+	m_pLights = NULL;
+}
+
+/***********************************************************
+ *  IsOpen()
+ *
+ *  This method is used to check whether a scene is mapped.
+ ***********************************************************/
+bool SceneFile::IsOpen() const
+{
+	return m_pHeader != NULL;
+}
+
+/***********************************************************
+ *  GetObjectCount()
+ *
+ *  This method is used to get the number of objects.
+ ***********************************************************/
+int SceneFile::GetObjectCount() const
+{
+	return (m_pHeader != NULL) ? (int)m_pHeader->objectCount : 0;
+}
+
+/***********************************************************
+ *  GetObjects()
+ *
+ *  This method is used to get the object array, read in
+ *  place from the mapped file.
+ ***********************************************************/
+const SceneFile::SCENE_OBJECT* SceneFile::GetObjects() const
+{
+	return m_pObjects;
+}
+
+/***********************************************************
+ *  GetLightCount()
+ *
+ *  This method is used to get the number of lights.
+ ***********************************************************/
+int SceneFile::GetLightCount() const
+{
+	return (m_pHeader != NULL) ? (int)m_pHeader->lightCount : 0;
+}
+
+/***********************************************************
+ *  GetLights()
+ *
+ *  This method is used to get the light array, which has
+ *  the layout of the light buffer of the fragment shader.
+ ***********************************************************/
+const ClusteredLights::POINT_LIGHT* SceneFile::GetLights() const
+{
+	return m_pLights;
+}
+
+/***********************************************************
+ *  HasCamera()
+ *
+ *  This method is used to check whether the scene sets
+ *  where it is viewed from.
+ ***********************************************************/
+bool SceneFile::HasCamera() const
+{
+	return (m_pHeader != NULL) && ((m_pHeader->flags & FLAG_HAS_CAMERA) != 0);
+}
+
+/***********************************************************
+ *  GetCamera()
+ *
+ *  This method is used to get the camera of the scene.
+ ***********************************************************/
+const SceneFile::SCENE_CAMERA& SceneFile::GetCamera() const
+{
+	return m_pHeader->camera;
+}
+
+/***********************************************************
+ *  GetCompiledFilename()
+ *
+ *  This method is used to get the name of the compiled file
+ *  of a text scene, which replaces its extension.
+ ***********************************************************/
+std::string SceneFile::GetCompiledFilename(const std::string& filename)
+{
+	size_t extension = filename.find_last_of('.');
+	size_t folder = filename.find_last_of("/\\");
+	if ((extension == std::string::npos) || ((folder != std::string::npos) && (extension < folder)))
+	{
+		return filename + COMPILED_EXTENSION;
+	}
+
+	if (filename.compare(extension, std::string::npos, COMPILED_EXTENSION) == 0)
+	{
+		return filename;
+	}
+
+	return filename.substr(0, extension) + COMPILED_EXTENSION;
+}
+
+/***********************************************************
+ *  Parse()
+ *
+ *  This method is used to read a text scene.  Every line
+ *  holds one object, group, light or camera, starting with
+ *  that word, and anything after a '#' is a comment.
+ ***********************************************************/
+bool SceneFile::Parse(const std::string& filename, SCENE_HEADER& header,
+	std::vector<SCENE_OBJECT>& objects, std::vector<ClusteredLights::POINT_LIGHT>& lights)
+{
+	std::ifstream file(filename);
+	if (!file)
+	{
+		std::cout << "Could not open scene file:" << filename << std::endl;
+		return false;
+	}
+
+	header = SCENE_HEADER();
+	header.magic = SCENE_MAGIC;
+	header.version = SCENE_VERSION;
+	objects.clear();
+	lights.clear();
+
+	OBJECT_NAMES names;
+	std::string line;
+	int lineNumber = 0;
+	while (std::getline(file, line))
+	{
+		lineNumber++;
+
+		size_t comment = line.find('#');
+		if (comment != std::string::npos)
+		{
+			line.erase(comment);
+		}
+
+		std::istringstream words(line);
+		std::string command;
+		if (!(words >> command))
+		{
+			continue;
+		}
+
+		bool bValid = false;
+		if ((command == "object") || (command == "group"))
+		{
+			SCENE_OBJECT object;
+			bValid = ParseObject(words, command == "group", (int)objects.size(), names, object);
+			objects.push_back(object);
+		}
+		else if (command == "light")
+		{
+			ClusteredLights::POINT_LIGHT light;
+			bValid = ParseLight(words, light);
+			lights.push_back(light);
+		}
+		else if (command == "camera")
+		{
+			bValid = ParseCamera(words, header.camera);
+			header.flags |= FLAG_HAS_CAMERA;
+		}
+
+		if (bValid == false)
+		{
+			std::cout << "Scene file error at " << filename << ":" << lineNumber << ": " << line << std::endl;
+			return false;
+		}
+	}
+
+	header.objectCount = (uint32_t)objects.size();
+	header.lightCount = (uint32_t)lights.size();
+
+	return true;
+}
+
+/***********************************************************
+ *  Compile()
+ *
+ *  This method is used to read a text scene and to write
+ *  its header, objects and lights into a binary scene file.
+ ***********************************************************/
+bool SceneFile::Compile(const std::string& textFilename, const std::string& binaryFilename)
+{
+	SCENE_HEADER header;
+	std::vector<SCENE_OBJECT> objects;
+	std::vector<ClusteredLights::POINT_LIGHT> lights;
+
+	if (Parse(textFilename, header, objects, lights) == false)
+	{
+		return false;
+	}
+
+	std::ofstream file(binaryFilename, std::ios::binary);
+	file.write((const char*)&header, sizeof(header));
+	file.write((const char*)objects.data(), (std::streamsize)(objects.size() * sizeof(SCENE_OBJECT)));
+	file.write((const char*)lights.data(), (std::streamsize)(lights.size() * sizeof(ClusteredLights::POINT_LIGHT)));
+
+	if (!file)
+	{
+		std::cout << "Could not write scene file:" << binaryFilename << std::endl;
+		return false;
+	}
+
+	std::cout << "Compiled scene " << binaryFilename << ": " << objects.size() << " objects, "
+		<< lights.size() << " lights" << std::endl;
+
+	return true;
+}
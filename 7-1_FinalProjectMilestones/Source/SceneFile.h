@@ -0,0 +1,127 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenefile.h
+// ============
+// compiled scene description with the objects, lights and camera of a scene
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "MappedFile.h"
+#include "ClusteredLights.h"
+
+// GLM Math Header inclusions
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  SceneFile
+ *
+ *  This class opens a compiled scene file by mapping it
+ *  into memory.  After a small header the file holds two
+ *  flat arrays - the objects and the lights - which are
+ *  read in place, so even large scenes load without any
+ *  parsing.  Scenes are written as text, one object, group,
+ *  light or camera per line, and compiled into the binary form
+ *  the first time they are opened or whenever the text is
+ *  newer than its compiled file.
+ ***********************************************************/
+class SceneFile
+{
+public:
+	// longest texture or material tag, with its terminator
+	static const int MAX_TAG_LENGTH = 24;
+	// mesh of a group, which only moves the objects under it
+	static const uint32_t NO_MESH = 0xFFFFFFFF;
+	// flags of an object - drawn without the lights, with the
+	// see-through parts of its texture cut out, and expected to
+	// move, so its shadow is drawn every frame
+	static const uint32_t OBJECT_UNLIT = 1;
+	static const uint32_t OBJECT_ALPHA_TEST = 2;
+	static const uint32_t OBJECT_DYNAMIC = 4;
+
+	// where the scene is viewed from
+	struct SCENE_CAMERA
+	{
+		glm::vec3 position;
+		float zoom;
+		glm::vec3 front;
+		uint32_t reserved;
+	};
+
+	// one drawn mesh or group - an empty texture tag draws the
+	// color, and an empty material tag uses the first material.
+	// The transform is relative to the parent, which is an
+	// object in front of this one, or -1 for none
+	struct SCENE_OBJECT
+	{
+		uint32_t mesh;
+		int32_t parent;
+		glm::vec3 position;
+		// degrees around the X, Y and Z axes
+		glm::vec3 rotation;
+		glm::vec3 scale;
+		glm::vec2 UVscale;
+		glm::vec4 color;
+		char textureTag[MAX_TAG_LENGTH];
+		char materialTag[MAX_TAG_LENGTH];
+		uint32_t flags;
+	};
+
+	// constructor
+	SceneFile();
+
+	// map a compiled scene, compiling a text scene into the
+	// file next to it first when that is out of date
+	bool Open(const std::string& filename);
+	// unmap the file - the arrays found in it become invalid
+	void Close();
+	bool IsOpen() const;
+
+	// the flat arrays of the mapped scene
+	int GetObjectCount() const;
+	const SCENE_OBJECT* GetObjects() const;
+	int GetLightCount() const;
+	const ClusteredLights::POINT_LIGHT* GetLights() const;
+	// the camera, when the scene sets one
+	bool HasCamera() const;
+	const SCENE_CAMERA& GetCamera() const;
+
+	// compile a text scene into a binary scene file
+	static bool Compile(const std::string& textFilename, const std::string& binaryFilename);
+	// the compiled file of a text scene, or the file itself
+	// when it is already compiled
+	static std::string GetCompiledFilename(const std::string& filename);
+
+private:
+	// identifies the file and the version of its layout
+	static const uint32_t SCENE_MAGIC = 0x43535343;	// "CSSC"
+	static const uint32_t SCENE_VERSION = 3;
+	static const uint32_t FLAG_HAS_CAMERA = 1;
+
+	// start of the file, followed by the objects and then the
+	// lights
+	struct SCENE_HEADER
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t objectCount;
+		uint32_t lightCount;
+		uint32_t flags;
+		uint32_t reserved[3];
+		SCENE_CAMERA camera;
+	};
+
+	MappedFile m_file;
+	const SCENE_HEADER* m_pHeader;
+	const SCENE_OBJECT* m_pObjects;
+	const ClusteredLights::POINT_LIGHT* m_pLights;
+
+	// check the header and the arrays of the mapped file
+	bool Validate(const std::string& filename);
+	// read the objects, lights and camera of a text scene
+	static bool Parse(const std::string& filename, SCENE_HEADER& header,
+		std::vector<SCENE_OBJECT>& objects, std::vector<ClusteredLights::POINT_LIGHT>& lights);
+};
@@ -1,811 +1,2058 @@
-///////////////////////////////////////////////////////////////////////////////
-// shadermanager.cpp
-// ============
-// manage the loading and rendering of 3D scenes
-//
-//  AUTHOR: Brian Battersby - SNHU Instructor / Computer Science
-//	Created for CS-330-Computational Graphics and Visualization, Nov. 1st, 2023
-///////////////////////////////////////////////////////////////////////////////
-
-#include "SceneManager.h"
-
-#ifndef STB_IMAGE_IMPLEMENTATION
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
-#endif
-
-#include <glm/gtx/transform.hpp>
-
-// declare the global variables
-namespace
-{
-	const char* g_ModelName = "model";
-	const char* g_ColorValueName = "objectColor";
-	const char* g_TextureValueName = "objectTexture";
-	const char* g_UseTextureName = "bUseTexture";
-	const char* g_UseLightingName = "bUseLighting";
-}
-
-/***********************************************************
- *  SceneManager()
- *
- *  The constructor for the class
- ***********************************************************/
-SceneManager::SceneManager(ShaderManager* pShaderManager)
-{
-	m_pShaderManager = pShaderManager;
-	m_basicMeshes = new ShapeMeshes();
-
-	// initialize the texture collection
-	for (int i = 0; i < 16; i++)
-	{
-		m_textureIDs[i].tag = "/0";
-		m_textureIDs[i].ID = -1;
-	}
-	m_loadedTextures = 0;
-}
-
-/***********************************************************
- *  ~SceneManager()
- *
- *  The destructor for the class
- ***********************************************************/
-SceneManager::~SceneManager()
-{
-	// clear the allocated memory
-	m_pShaderManager = NULL;
-	delete m_basicMeshes;
-	m_basicMeshes = NULL;
-	// destroy the created OpenGL textures
-	DestroyGLTextures();
-}
-
-/***********************************************************
- *  CreateGLTexture()
- *
- *  This method is used for loading textures from image files,
- *  configuring the texture mapping parameters in OpenGL,
- *  generating the mipmaps, and loading the read texture into
- *  the next available texture slot in memory.
- ***********************************************************/
-bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
-{
-	int width = 0;
-	int height = 0;
-	int colorChannels = 0;
-	GLuint textureID = 0;
-
-	// indicate to always flip images vertically when loaded
-	stbi_set_flip_vertically_on_load(true);
-
-	// try to parse the image data from the specified image file
-	unsigned char* image = stbi_load(
-		filename,
-		&width,
-		&height,
-		&colorChannels,
-		0);
-
-	// if the image was successfully read from the image file
-	if (image)
-	{
-		std::cout << "Successfully loaded image:" << filename << ", width:" << width << ", height:" << height << ", channels:" << colorChannels << std::endl;
-
-		glGenTextures(1, &textureID);
-		glBindTexture(GL_TEXTURE_2D, textureID);
-
-		// set the texture wrapping parameters
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		// set texture filtering parameters
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-		// if the loaded image is in RGB format
-		if (colorChannels == 3)
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
-		// if the loaded image is in RGBA format - it supports transparency
-		else if (colorChannels == 4)
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
-		else
-		{
-			std::cout << "Not implemented to handle image with " << colorChannels << " channels" << std::endl;
-			return false;
-		}
-
-		// generate the texture mipmaps for mapping textures to lower resolutions
-		glGenerateMipmap(GL_TEXTURE_2D);
-
-		// free the image data from local memory
-		stbi_image_free(image);
-		glBindTexture(GL_TEXTURE_2D, 0); // Unbind the texture
-
-		// register the loaded texture and associate it with the special tag string
-		m_textureIDs[m_loadedTextures].ID = textureID;
-		m_textureIDs[m_loadedTextures].tag = tag;
-		m_loadedTextures++;
-
-		return true;
-	}
-
-	std::cout << "Could not load image:" << filename << std::endl;
-
-	// Error loading the image
-	return false;
-}
-
-/***********************************************************
- *  BindGLTextures()
- *
- *  This method is used for binding the loaded textures to
- *  OpenGL texture memory slots.  There are up to 16 slots.
- ***********************************************************/
-void SceneManager::BindGLTextures()
-{
-	for (int i = 0; i < m_loadedTextures; i++)
-	{
-		// bind textures on corresponding texture units
-		glActiveTexture(GL_TEXTURE0 + i);
-		glBindTexture(GL_TEXTURE_2D, m_textureIDs[i].ID);
-	}
-}
-
-/***********************************************************
- *  DestroyGLTextures()
- *
- *  This method is used for freeing the memory in all the
- *  used texture memory slots.
- ***********************************************************/
-void SceneManager::DestroyGLTextures()
-{
-	for (int i = 0; i < m_loadedTextures; i++)
-	{
-		glGenTextures(1, &m_textureIDs[i].ID);
-	}
-}
-
-/***********************************************************
- *  FindTextureID()
- *
- *  This method is used for getting an ID for the previously
- *  loaded texture bitmap associated with the passed in tag.
- ***********************************************************/
-int SceneManager::FindTextureID(std::string tag)
-{
-	int textureID = -1;
-	int index = 0;
-	bool bFound = false;
-
-	while ((index < m_loadedTextures) && (bFound == false))
-	{
-		if (m_textureIDs[index].tag.compare(tag) == 0)
-		{
-			textureID = m_textureIDs[index].ID;
-			bFound = true;
-		}
-		else
-			index++;
-	}
-
-	return(textureID);
-}
-
-/***********************************************************
- *  FindTextureSlot()
- *
- *  This method is used for getting a slot index for the previously
- *  loaded texture bitmap associated with the passed in tag.
- ***********************************************************/
-int SceneManager::FindTextureSlot(std::string tag)
-{
-	int textureSlot = -1;
-	int index = 0;
-	bool bFound = false;
-
-	while ((index < m_loadedTextures) && (bFound == false))
-	{
-		if (m_textureIDs[index].tag.compare(tag) == 0)
-		{
-			textureSlot = index;
-			bFound = true;
-		}
-		else
-			index++;
-	}
-
-	return(textureSlot);
-}
-
-/***********************************************************
- *  FindMaterial()
- *
- *  This method is used for getting a material from the previously
- *  defined materials list that is associated with the passed in tag.
- ***********************************************************/
-bool SceneManager::FindMaterial(std::string tag, OBJECT_MATERIAL& material)
-{
-	if (m_objectMaterials.size() == 0)
-	{
-		return(false);
-	}
-
-	int index = 0;
-	bool bFound = false;
-	while ((index < m_objectMaterials.size()) && (bFound == false))
-	{
-		if (m_objectMaterials[index].tag.compare(tag) == 0)
-		{
-			bFound = true;
-			material.ambientColor = m_objectMaterials[index].ambientColor;
-			material.ambientStrength = m_objectMaterials[index].ambientStrength;
-			material.diffuseColor = m_objectMaterials[index].diffuseColor;
-			material.specularColor = m_objectMaterials[index].specularColor;
-			material.shininess = m_objectMaterials[index].shininess;
-		}
-		else
-		{
-			index++;
-		}
-	}
-
-	return(true);
-}
-
-/***********************************************************
- *  SetTransformations()
- *
- *  This method is used for setting the transform buffer
- *  using the passed in transformation values.
- ***********************************************************/
-void SceneManager::SetTransformations(
-	glm::vec3 scaleXYZ,
-	float XrotationDegrees,
-	float YrotationDegrees,
-	float ZrotationDegrees,
-	glm::vec3 positionXYZ)
-{
-	// variables for this method
-	glm::mat4 modelView;
-	glm::mat4 scale;
-	glm::mat4 rotationX;
-	glm::mat4 rotationY;
-	glm::mat4 rotationZ;
-	glm::mat4 translation;
-
-	// set the scale value in the transform buffer
-	scale = glm::scale(scaleXYZ);
-	// set the rotation values in the transform buffer
-	rotationX = glm::rotate(glm::radians(XrotationDegrees), glm::vec3(1.0f, 0.0f, 0.0f));
-	rotationY = glm::rotate(glm::radians(YrotationDegrees), glm::vec3(0.0f, 1.0f, 0.0f));
-	rotationZ = glm::rotate(glm::radians(ZrotationDegrees), glm::vec3(0.0f, 0.0f, 1.0f));
-	// set the translation value in the transform buffer
-	translation = glm::translate(positionXYZ);
-
-	modelView = translation * rotationX * rotationY * rotationZ * scale;
-
-	if (NULL != m_pShaderManager)
-	{
-		m_pShaderManager->setMat4Value(g_ModelName, modelView);
-	}
-}
-
-/***********************************************************
- *  SetShaderColor()
- *
- *  This method is used for setting the passed in color
- *  into the shader for the next draw command
- ***********************************************************/
-void SceneManager::SetShaderColor(
-	float redColorValue,
-	float greenColorValue,
-	float blueColorValue,
-	float alphaValue)
-{
-	// variables for this method
-	glm::vec4 currentColor;
-
-	currentColor.r = redColorValue;
-	currentColor.g = greenColorValue;
-	currentColor.b = blueColorValue;
-	currentColor.a = alphaValue;
-
-	if (NULL != m_pShaderManager)
-	{
-		m_pShaderManager->setIntValue(g_UseTextureName, false);
-		m_pShaderManager->setVec4Value(g_ColorValueName, currentColor);
-	}
-}
-
-/***********************************************************
- *  SetShaderTexture()
- *
- *  This method is used for setting the texture data
- *  associated with the passed in ID into the shader.
- ***********************************************************/
-void SceneManager::SetShaderTexture(
-	std::string textureTag)
-{
-	if (NULL != m_pShaderManager)
-	{
-		m_pShaderManager->setIntValue(g_UseTextureName, true);
-
-		int textureID = -1;
-		textureID = FindTextureSlot(textureTag);
-		m_pShaderManager->setSampler2DValue(g_TextureValueName, textureID);
-	}
-}
-
-/***********************************************************
- *  SetTextureUVScale()
- *
- *  This method is used for setting the texture UV scale
- *  values into the shader.
- ***********************************************************/
-void SceneManager::SetTextureUVScale(float u, float v)
-{
-	if (NULL != m_pShaderManager)
-	{
-		m_pShaderManager->setVec2Value("UVscale", glm::vec2(u, v));
-	}
-}
-
-/***********************************************************
- *  SetShaderMaterial()
- *
- *  This method is used for passing the material values
- *  into the shader.
- ***********************************************************/
-void SceneManager::SetShaderMaterial(
-	std::string materialTag)
-{
-	if (m_objectMaterials.size() > 0)
-	{
-		OBJECT_MATERIAL material;
-		bool bReturn = false;
-
-		bReturn = FindMaterial(materialTag, material);
-		if (bReturn == true)
-		{
-			m_pShaderManager->setVec3Value("material.ambientColor", material.ambientColor);
-			m_pShaderManager->setFloatValue("material.ambientStrength", material.ambientStrength);
-			m_pShaderManager->setVec3Value("material.diffuseColor", material.diffuseColor);
-			m_pShaderManager->setVec3Value("material.specularColor", material.specularColor);
-			m_pShaderManager->setFloatValue("material.shininess", material.shininess);
-		}
-	}
-}
-
-/**************************************************************/
-/*** STUDENTS CAN MODIFY the code in the methods BELOW for  ***/
-/*** preparing and rendering their own 3D replicated scenes.***/
-/*** Please refer to the code in the OpenGL sample project  ***/
-/*** for assistance.                                        ***/
-/**************************************************************/
-
- /***********************************************************
-  *  LoadSceneTextures()
-  *
-  *  This method is used for preparing the 3D scene by loading
-  *  the shapes, textures in memory to support the 3D scene
-  *  rendering
-  ***********************************************************/
-  /***********************************************************
-  *  LoadSceneTextures()
-  *
-  *  This method is used for preparing the 3D scene by loading
-  *  the shapes, textures in memory to support the 3D scene
-  *  rendering
-  ***********************************************************/
-
-void SceneManager::LoadSceneTextures()
-{
-	bool bReturn = false;
-
-	bReturn = CreateGLTexture(
-		"../../Utilities/textures/pavers.jpg",
-		"floor");
-
-	bReturn = CreateGLTexture(
-		"../../Utilities/textures/drywall.jpg",
-		"drywall");
-
-	bReturn = CreateGLTexture(
-		"../../Utilities/textures/beads.png",
-		"cylinder");
-
-	bReturn = CreateGLTexture(
-		"../../Utilities/textures/circular-brushed-gold-texture.jpg",
-		"cylinder_top");
-
-	bReturn = CreateGLTexture(
-		"../../Utilities/textures/wood.jpg",
-		"plank");
-
-	bReturn = CreateGLTexture(
-		"../../Utilities/textures/iphonebox.jpg",
-		"box");
-
-	bReturn = CreateGLTexture(
-		"../../Utilities/textures/iphone.png",
-		"iphone");
-
-	bReturn = CreateGLTexture(
-		"../../Utilities/textures/orange.jpg",
-		"ball");
-
-	bReturn = CreateGLTexture(
-		"../../Utilities/textures/cone.jpg",
-		"cone");
-
-	bReturn = CreateGLTexture(
-		"../../Utilities/textures/mint.jpg",
-		"mint");
-
-	bReturn = CreateGLTexture(
-		"../../Utilities/textures/top.png",
-		"top");
-
-	// a?er the texture image data is loaded into memory, the 
-	// loaded textures need to be bound to texture slots - there 
-	// are a total of 16 available slots for scene textures 
-	BindGLTextures();
-}
-
-/***********************************************************
- *  DefineObjectMaterials()
- *
- *  This method is used for configuring the various material
- *  settings for all of the objects within the 3D scene.
- ***********************************************************/
-void SceneManager::DefineObjectMaterials()
-{
-	OBJECT_MATERIAL goldMaterial;
-	goldMaterial.ambientColor = glm::vec3(0.2f, 0.2f, 0.2f);
-	goldMaterial.ambientStrength = 0.3f;
-	goldMaterial.diffuseColor = glm::vec3(0.2f, 0.2f, 0.2f);
-	goldMaterial.specularColor = glm::vec3(0.5f, 0.5f, 0.5f);
-	goldMaterial.shininess = 22.0;
-	goldMaterial.tag = "metal";
-
-	m_objectMaterials.push_back(goldMaterial);
-
-	OBJECT_MATERIAL woodMaterial;
-	woodMaterial.ambientColor = glm::vec3(0.1f, 0.1f, 0.1f);
-	woodMaterial.ambientStrength = 0.2f;
-	woodMaterial.diffuseColor = glm::vec3(0.3f, 0.3f, 0.3f);
-	woodMaterial.specularColor = glm::vec3(0.1f, 0.1f, 0.1f);
-	woodMaterial.shininess = 0.3;
-	woodMaterial.tag = "wood";
-
-	m_objectMaterials.push_back(woodMaterial);
-
-	OBJECT_MATERIAL glassMaterial;
-	glassMaterial.ambientColor = glm::vec3(0.4f, 0.4f, 0.4f);
-	glassMaterial.ambientStrength = 0.3f;
-	glassMaterial.diffuseColor = glm::vec3(0.3f, 0.3f, 0.3f);
-	glassMaterial.specularColor = glm::vec3(0.6f, 0.6f, 0.6f);
-	glassMaterial.shininess = 85.0;
-	glassMaterial.tag = "glass";
-
-	m_objectMaterials.push_back(glassMaterial);
-
-	OBJECT_MATERIAL cheeseMaterial;
-	cheeseMaterial.ambientColor = glm::vec3(0.1f, 0.1f, 0.1f);
-	cheeseMaterial.ambientStrength = 0.2f;
-	cheeseMaterial.diffuseColor = glm::vec3(0.5f, 0.5f, 0.5f);
-	cheeseMaterial.specularColor = glm::vec3(0.1f, 0.1f, 0.1f);
-	cheeseMaterial.shininess = 0.3;
-	cheeseMaterial.tag = "cheese";
-
-	m_objectMaterials.push_back(cheeseMaterial);
-
-	OBJECT_MATERIAL breadMaterial;
-	breadMaterial.ambientColor = glm::vec3(0.2f, 0.2f, 0.2f);
-	breadMaterial.ambientStrength = 0.3f;
-	breadMaterial.diffuseColor = glm::vec3(0.5f, 0.5f, 0.5f);
-	breadMaterial.specularColor = glm::vec3(0.3f, 0.3f, 0.3f);
-	breadMaterial.shininess = 0.5;
-	breadMaterial.tag = "bread";
-
-	m_objectMaterials.push_back(breadMaterial);
-
-	OBJECT_MATERIAL darkBreadMaterial;
-	darkBreadMaterial.ambientColor = glm::vec3(0.2f, 0.2f, 0.2f);
-	darkBreadMaterial.ambientStrength = 0.2f;
-	darkBreadMaterial.diffuseColor = glm::vec3(0.1f, 0.1f, 0.1f);
-	darkBreadMaterial.specularColor = glm::vec3(0.0f, 0.0f, 0.0f);
-	darkBreadMaterial.shininess = 0.0;
-	darkBreadMaterial.tag = "darkbread";
-
-	m_objectMaterials.push_back(darkBreadMaterial);
-
-	OBJECT_MATERIAL backdropMaterial;
-	backdropMaterial.ambientColor = glm::vec3(0.6f, 0.6f, 0.6f);
-	backdropMaterial.ambientStrength = 0.6f;
-	backdropMaterial.diffuseColor = glm::vec3(0.6f, 0.5f, 0.1f);
-	backdropMaterial.specularColor = glm::vec3(0.0f, 0.0f, 0.0f);
-	backdropMaterial.shininess = 0.0;
-	backdropMaterial.tag = "backdrop";
-
-	m_objectMaterials.push_back(backdropMaterial);
-
-	OBJECT_MATERIAL grapeMaterial;
-	grapeMaterial.ambientColor = glm::vec3(0.1f, 0.1f, 0.1f);
-	grapeMaterial.ambientStrength = 0.1f;
-	grapeMaterial.diffuseColor = glm::vec3(0.3f, 0.2f, 0.3f);
-	grapeMaterial.specularColor = glm::vec3(0.4f, 0.2f, 0.2f);
-	grapeMaterial.shininess = 0.5;
-	grapeMaterial.tag = "grape";
-
-	m_objectMaterials.push_back(grapeMaterial);
-}
-
-/***********************************************************
- *  SetupSceneLights()
- *
- *  This method is called to add and configure the light
- *  sources for the 3D scene.  There are up to 4 light sources.
- ***********************************************************/
-void SceneManager::SetupSceneLights()
-{
-	// this line of code is NEEDED for telling the shaders to render 
-	// the 3D scene with custom lighting - to use the default rendered 
-	// lighting then comment out the following line
-	m_pShaderManager->setBoolValue(g_UseLightingName, true);
-
-	// Primary light source (Point light)
-	m_pShaderManager->setVec3Value("lightSources[0].position", -3.0f, 5.0f, 8.0f); // Position adjusted for better lighting
-	m_pShaderManager->setVec3Value("lightSources[0].ambientColor", 0.2f, 0.1f, 0.1f); // Increased ambient light for warmth
-	m_pShaderManager->setVec3Value("lightSources[0].diffuseColor", 0.7f, 0.5f, 0.5f); // Brighter diffuse color
-	m_pShaderManager->setVec3Value("lightSources[0].specularColor", 0.4f, 0.4f, 0.4f); // Higher specular color for shininess
-	m_pShaderManager->setFloatValue("lightSources[0].focalStrength", 32.0f);
-	m_pShaderManager->setFloatValue("lightSources[0].specularIntensity", 6.5f); // Increased intensity for more reflection
-
-	// Secondary light source (Point light)
-	m_pShaderManager->setVec3Value("lightSources[1].position", 3.0f, 5.0f, 8.0f); // Position adjusted to match first light
-	m_pShaderManager->setVec3Value("lightSources[1].ambientColor", 0.1f, 0.1f, 0.1f); // Low ambient for fill
-	m_pShaderManager->setVec3Value("lightSources[1].diffuseColor", 0.6f, 0.6f, 0.6f); // Slightly higher diffuse
-	m_pShaderManager->setVec3Value("lightSources[1].specularColor", 0.3f, 0.3f, 0.3f); // Moderate specular
-	m_pShaderManager->setFloatValue("lightSources[1].focalStrength", 32.0f);
-	m_pShaderManager->setFloatValue("lightSources[1].specularIntensity", 5.4f); // Increased intensity for reflection
-
-	// Tertiary light source (Directional light)
-	m_pShaderManager->setVec3Value("lightSources[2].position", 0.0f, 10.0f, 0.0f); // High above for directional lighting
-	m_pShaderManager->setVec3Value("lightSources[2].ambientColor", 0.3f, 0.3f, 0.3f); // Higher ambient to prevent shadows
-	m_pShaderManager->setVec3Value("lightSources[2].diffuseColor", 1.0f, 1.0f, 1.0f); // Bright white for diffuse
-	m_pShaderManager->setVec3Value("lightSources[2].specularColor", 0.5f, 0.5f, 0.5f); // Increased specular for highlights
-	m_pShaderManager->setFloatValue("lightSources[2].focalStrength", 12.0f);
-	m_pShaderManager->setFloatValue("lightSources[2].specularIntensity", 1.5f); // Increased intensity for stronger reflections
-}
-/***********************************************************
- *  PrepareScene()
- *
- *  This method is used for preparing the 3D scene by loading
- *  the shapes, textures in memory to support the 3D scene
- *  rendering
- ***********************************************************/
-void SceneManager::PrepareScene()
-{
-	// load the texture image files for the textures applied
-	// to objects in the 3D scene
-	LoadSceneTextures();
-	// define the materials that will be used for the objects
-	// in the 3D scene
-	DefineObjectMaterials();
-	// add and defile the light sources for the 3D scene
-	SetupSceneLights();
-
-	m_basicMeshes->LoadBoxMesh();
-	m_basicMeshes->LoadPlaneMesh();
-	m_basicMeshes->LoadCylinderMesh();
-	m_basicMeshes->LoadConeMesh();
-	m_basicMeshes->LoadPrismMesh();
-	m_basicMeshes->LoadPyramid4Mesh();
-	m_basicMeshes->LoadSphereMesh();
-	m_basicMeshes->LoadTaperedCylinderMesh();
-	m_basicMeshes->LoadTorusMesh();
-}
-
-
-/***********************************************************
- *  RenderScene()
- *
- *  This method is used for rendering the 3D scene by
- *  transforming and drawing the basic 3D shapes.
- ***********************************************************/
-void SceneManager::RenderScene()
-{
-	glm::vec3 scaleXYZ;
-	float XrotationDegrees = 0.0f;
-	float YrotationDegrees = 0.0f;
-	float ZrotationDegrees = 0.0f;
-
-	glm::vec3 positionXYZ;
-	glm::mat4 scale;
-	glm::mat4 rotation;
-	glm::mat4 rotation2;
-	glm::mat4 translation;
-	glm::mat4 model;
-	
-	/*** Set needed transformations before drawing the basic mesh ***/
-
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(20.0f, 1.0f, 20.0f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 90.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(0.0f, 15.0f, -8.0f);
-
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
-	// --- Render the backdrop ---
-	SetShaderTexture("drywall");  // Set the texture for the backdrop
-	SetTextureUVScale(1.0f, 1.0f);  // No UV scaling for the backdrop texture
-	SetShaderMaterial("metal");    // Use a default material for the backdrop
-
-	m_basicMeshes->DrawPlaneMesh();
-
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(20.0f, .6f, 8.0f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(0.0f, -1.1f, -0.9f);
-
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
-	//SetShaderColor(1, 1, 1, 1);
-	SetShaderTexture("plank");
-	SetTextureUVScale(1.0, 1.0);
-	SetShaderMaterial("wood");
-
-	// draw the mesh with transformation values - this plane is used for the base
-	m_basicMeshes->DrawBoxMesh();
-
-	// --- Render the iPhone box (cube) --- 
-	SetShaderTexture("iphone");  // White color
-	SetTextureUVScale(1.0f, 1.0f); // No repetition
-	SetShaderTexture("metal"); // Metal texture for the iPhone box
-
-	// Scaling and position for the main iPhone box
-	scaleXYZ = glm::vec3(3.0f, 0.5f, 1.5f);  // Long and flat like a phone box
-	glm::vec3 positionBox(0.0f, -0.5f, 0.0f);  // Placed on the desk
-
-	// Tilt the box a little to the right (rotation around the Y-axis)
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 50.0f;  // Tilt to the right
-	ZrotationDegrees = 0.0f;
-
-	// Apply transformations and render the main box
-	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionBox);
-	m_basicMeshes->DrawBoxMesh();  // Render the box
-
-	// --- Render the skinny box on top of the main box --- 
-	SetShaderTexture("box");  // Use the same texture for the skinny box
-	SetTextureUVScale(1.0f, 1.0f); // No repetition
-	SetShaderTexture("glass"); // Glass texture for the skinny box
-
-	// Define the scale and position for the skinny box
-	scaleXYZ = glm::vec3(3.0f, 0.1f, 1.5f);  // Match the width and depth, but make it thin
-	glm::vec3 positionSkinnyBox = positionBox;  // Start at the main box's position
-
-	// Raise it higher above the main box
-	positionSkinnyBox.y += scaleXYZ.y + 0.12f;  // Adjust this value as needed for positioning
-
-	// Apply transformations for the skinny box
-	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionSkinnyBox);
-
-	// Render the skinny box
-	m_basicMeshes->DrawBoxMesh();
-
-	// --- Render the tapered cylinder (soda can) on top of the iPhone box --- 
-	SetShaderTexture("cone"); // Use the same texture; you can rename it later if needed
-	SetShaderTexture("metal"); // Use metal texture for the cylinder
-
-	scaleXYZ = glm::vec3(0.2f, 0.5f, 0.2f); // Base size (width) smaller
-	glm::vec3 positionCylinder = positionBox;  // Start at the box's position
-
-	// Move the cylinder on top of the box and adjust its position to the left and slightly forward
-	positionCylinder.y += 0.30f;  // Move it on top of the box
-	positionCylinder.x -= 0.50f;  // Move it slightly to the left from the center of the box
-	positionCylinder.z += 0.80f;  // Move it slightly forward
-
-	// Apply the transformations to the tapered cylinder
-	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionCylinder);
-
-	// Render the tapered cylinder
-	m_basicMeshes->DrawCylinderMesh();  // Ensure this function correctly draws a cylinder
-
-	// --- Render the cone on top of the tapered cylinder --- 
-	SetShaderTexture("mint"); // Use the same texture; you can rename it later if needed
-	SetShaderTexture("cheese"); // Cheese texture for the cone
-
-	scaleXYZ = glm::vec3(0.2f, 0.3f, 0.2f); // Adjust values as needed for the cone
-	glm::vec3 positionCone = positionCylinder; // Start at the cylinder's position
-
-	// Move the cone directly on top of the cylinder
-	positionCone.y += 0.50f;  // Move it up to sit on top of the cylinder (adjust as needed)
-
-	// Apply the transformations to the cone
-	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionCone);
-
-	// Render the cone
-	m_basicMeshes->DrawConeMesh();  // Ensure this function correctly draws a cone
-
-	// --- Render the orange (sphere) behind the cone ---  
-	SetShaderTexture("ball"); // Fruit orange color
-	SetShaderTexture("grape"); // Fruit grape color
-	scaleXYZ = glm::vec3(0.5f, 0.5f, 0.60f);   // Make it smaller like an orange
-	glm::vec3 positionOrange = positionBox;  // Start at the box's position
-
-	// Move the orange to the right of the box
-	positionOrange.y += 0.65f;  // Move it on top of the box
-	positionOrange.z -= 0.45f;  // Move it slightly behind the box
-	positionOrange.x += 0.30f;  // Move it to the right from the center of the box 
-
-	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionOrange);
-	m_basicMeshes->DrawSphereMesh();  // Render the orange
-
-	// --- Render the Downy Unstopables bottle (cylinder) to the left of the iPhone box ---  
-	SetShaderTexture("cylinder"); // washer beads texture
-	SetShaderTexture("darkbread"); // Dark bread texture for the bottle
-
-	// Set texture wrapping mode to repeat (only if you want it to repeat along the cylinder)
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT); // Horizontal wrapping
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE); // Vertical clamping to avoid tiling at the top and bottom
-
-	// Adjust texture scaling to make it fit the cylinder smoothly
-	SetTextureUVScale(1.0f, 1.0f); // Set to 1.0f for no repetition and proper wrapping around the cylinder
-
-	// Scaling and position for the cylinder
-	scaleXYZ = glm::vec3(0.5f, 2.5f, 0.4f);   // Larger size for the bottle
-	glm::vec3 positionBottle(-3.0f, -0.8f, 0.0f);  // Move it to the left of the box
-
-	// Apply transformations and render the cylinder
-	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionBottle);
-	m_basicMeshes->DrawCylinderMesh(); // Draw the Downy Unstopables bottle
-
-	// --- Render the tapered cylinder (top) on top of the Downy Unstopables bottle ---  
-	SetShaderTexture("top"); // Use the same texture or a different one for the top
-	SetShaderTexture("darkbread"); // Use the same texture or a different one for the top
-
-	// Adjust texture wrapping for the tapered cylinder (if needed)
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT); // Horizontal wrapping
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE); // Vertical clamping to avoid tiling at the top and bottom
-
-	// Scaling and position for the tapered cylinder (top)
-	scaleXYZ = glm::vec3(0.5f, 0.6f, 0.5f); // Adjust size for the top part (wider at the bottom)
-	glm::vec3 positionTop = positionBottle; // Start at the bottle's position
-
-	// Move the tapered cylinder on top of the bottle
-	positionTop.y += scaleXYZ.y + (scaleXYZ.y / 2.5f); // Move it above the cylinder by half its height
-	positionTop.y += 1.65f; // Additional height adjustment to raise the tapered cylinder higher
-	positionTop.x = positionBottle.x; // Keep it centered with respect to the bottle
-	positionTop.z = positionBottle.z; // Keep the same depth as the bottle
-
-	// Apply transformations and render the tapered cylinder
-	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionTop);
-	m_basicMeshes->DrawTaperedCylinderMesh(); // Ensure you have a function to draw the tapered cylinder
-
-
-}
\ No newline at end of file
+///////////////////////////////////////////////////////////////////////////////
+// shadermanager.cpp
+// ============
+// manage the loading and rendering of 3D scenes
+//
+//  AUTHOR: Brian Battersby - SNHU Instructor / Computer Science
+//	Created for CS-330-Computational Graphics and Visualization, Nov. 1st, 2023
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SceneManager.h"
+#include "GLStateCache.h"
+
+#include <glm/gtx/transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+// declare the global variables
+namespace
+{
+	// size of the material table in the shader - must match
+	// MAX_OBJECT_MATERIALS in the fragment shader
+	const int MAX_OBJECT_MATERIALS = 256;
+	// uniform buffer binding points of the material table and
+	// of the frame values - must match the bindings of the
+	// blocks in the shaders
+	const GLuint MATERIAL_BLOCK_BINDING = 0;
+	const GLuint FRAME_BLOCK_BINDING = 1;
+	// world radius an opaque box or plane needs to be drawn
+	// into the occlusion buffer
+	const float MIN_OCCLUDER_RADIUS = 1.5f;
+	// radius on screen, in pixels, below which an object uses
+	// the next coarser level of detail, and how far past it an
+	// object has to get before its level changes back - this
+	// keeps objects near a boundary from switching every frame
+	const float LOD_SCREEN_RADII[ShapeMeshes::LOD_COUNT - 1] = { 80.0f, 40.0f, 16.0f };
+	const float LOD_HYSTERESIS = 0.15f;
+	// the two lights in front of the table cast shadows all
+	// around them, and the light above it straight down
+	const int CUBE_SHADOW_LIGHTS[] = { 0, 1 };
+	const int OVERHEAD_SHADOW_LIGHT = 2;
+
+	// an image file of the scene and the tag of its texture
+	struct SCENE_TEXTURE
+	{
+		const char* filename;
+		const char* tag;
+	};
+
+	// the textures applied to the objects in the 3D scene
+	const SCENE_TEXTURE SCENE_TEXTURES[] =
+	{
+		{ "../../Utilities/textures/pavers.jpg", "floor" },
+		{ "../../Utilities/textures/drywall.jpg", "drywall" },
+		{ "../../Utilities/textures/beads.png", "cylinder" },
+		{ "../../Utilities/textures/circular-brushed-gold-texture.jpg", "cylinder_top" },
+		{ "../../Utilities/textures/wood.jpg", "plank" },
+		{ "../../Utilities/textures/iphonebox.jpg", "box" },
+		{ "../../Utilities/textures/iphone.png", "iphone" },
+		{ "../../Utilities/textures/orange.jpg", "ball" },
+		{ "../../Utilities/textures/cone.jpg", "cone" },
+		{ "../../Utilities/textures/mint.jpg", "mint" },
+		{ "../../Utilities/textures/top.png", "top" }
+	};
+	const int SCENE_TEXTURE_COUNT = sizeof(SCENE_TEXTURES) / sizeof(SCENE_TEXTURES[0]);
+
+	/***********************************************************
+	 *  ResetDrawPacket()
+	 *
+	 *  Set a draw packet to the state every frame starts from -
+	 *  white, untextured, lit, opaque and using the first
+	 *  material.
+	 ***********************************************************/
+	void ResetDrawPacket(RenderQueue::DRAW_PACKET& packet)
+	{
+		packet.variant = ShaderManager::FEATURE_LIGHTING;
+		packet.mesh = ShapeMeshes::MESH_BOX;
+		packet.lod = 0;
+		packet.textureArray = -1;
+		packet.textureLayer = 0;
+		packet.color = glm::vec4(1.0f);
+		packet.UVscale = glm::vec2(1.0f, 1.0f);
+		packet.materialIndex = 0;
+		packet.blendMode = RenderQueue::BLEND_OPAQUE;
+		packet.model = glm::mat4(1.0f);
+	}
+}
+
+/***********************************************************
+ *  SceneManager()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SceneManager::SceneManager(ShaderManager* pShaderManager)
+{
+	m_pShaderManager = pShaderManager;
+	m_basicMeshes = new ShapeMeshes();
+
+	// initialize the texture collection
+	m_pTextures = new TextureArrays();
+	m_pTextureLoader = new TextureLoader();
+	m_renderStats.drawCalls = 0;
+	m_renderStats.drawCommands = 0;
+	m_renderStats.instances = 0;
+	m_renderStats.stateChanges = 0;
+	m_renderStats.stateCalls = 0;
+	m_renderStats.elidedStateCalls = 0;
+	m_renderStats.uniformLookups = 0;
+	m_renderStats.clusterLights = 0;
+	m_renderStats.transformUpdates = 0;
+	m_renderStats.visibleObjects = 0;
+	m_renderStats.culledObjects = 0;
+	m_renderStats.occludedObjects = 0;
+	m_renderStats.reducedDetailObjects = 0;
+	m_renderStats.shadowUpdates = 0;
+	m_renderStats.shadowCasters = 0;
+	m_pProfiler = NULL;
+	m_pLights = new ClusteredLights();
+	m_viewMatrix = glm::mat4(1.0f);
+	m_projectionMatrix = glm::mat4(1.0f);
+	m_materialBufferID = 0;
+	m_frameBufferID = 0;
+	m_firstDirtyMaterial = MAX_OBJECT_MATERIALS;
+	m_lastDirtyMaterial = -1;
+	ResetDrawPacket(m_drawPacket);
+
+	m_pRenderQueue = new RenderQueue();
+	m_sceneModifiedTime = 0;
+	m_sceneCamera = SceneFile::SCENE_CAMERA();
+	m_bSceneCameraChanged = false;
+	m_scatteredLightCount = 0;
+	m_pSceneTransforms = new TransformHierarchy();
+	m_pSceneBounds = new BoundingVolumeHierarchy();
+	m_bSceneBoundsDirty = false;
+	m_frustum = BoundingVolumeHierarchy::FRUSTUM();
+	m_pOcclusion = new OcclusionBuffer();
+	m_bOcclusionCulling = true;
+	m_viewProjectionMatrix = glm::mat4(1.0f);
+	m_viewportHeight = 1.0f;
+	m_bDetailLevels = true;
+	m_drawLevelCount = 0;
+	m_pShadows = new ShadowMaps();
+	SetShadows(true);
+	m_pDeferred = new DeferredShading();
+	m_bDeferred = false;
+	m_bCollectVariants = false;
+	m_bScenePrepared = false;
+}
+
+/***********************************************************
+ *  ~SceneManager()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+SceneManager::~SceneManager()
+{
+	// clear the allocated memory
+	m_pShaderManager = NULL;
+	delete m_basicMeshes;
+	m_basicMeshes = NULL;
+	// destroy the created OpenGL textures
+	DestroyGLTextures();
+	delete m_pTextures;
+	m_pTextures = NULL;
+	delete m_pTextureLoader;
+	m_pTextureLoader = NULL;
+	delete m_pLights;
+	m_pLights = NULL;
+	delete m_pRenderQueue;
+	m_pRenderQueue = NULL;
+	delete m_pSceneTransforms;
+	m_pSceneTransforms = NULL;
+	delete m_pSceneBounds;
+	m_pSceneBounds = NULL;
+	delete m_pOcclusion;
+	m_pOcclusion = NULL;
+	delete m_pShadows;
+	m_pShadows = NULL;
+	delete m_pDeferred;
+	m_pDeferred = NULL;
+	// destroy the material buffer
+	if (m_materialBufferID != 0)
+	{
+		GLStateCache::DeleteBuffers(1, &m_materialBufferID);
+		m_materialBufferID = 0;
+	}
+	// destroy the frame buffer
+	if (m_frameBufferID != 0)
+	{
+		GLStateCache::DeleteBuffers(1, &m_frameBufferID);
+		m_frameBufferID = 0;
+	}
+}
+
+/***********************************************************
+ *  CreateGLTexture()
+ *
+ *  This method is used for adding a texture image file to
+ *  the list of scene textures.  The files are decoded in
+ *  parallel and uploaded together by BindGLTextures().
+ ***********************************************************/
+bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
+{
+	m_pTextureLoader->AddFile(filename, tag);
+
+	return true;
+}
+
+/***********************************************************
+ *  BindGLTextures()
+ *
+ *  This method is used for loading the added texture files
+ *  into texture arrays and binding every array to its own
+ *  texture unit.  The arrays stay bound, so drawing only
+ *  selects an array and a layer.  The samplers of every
+ *  shader variant are bound to the same units in the shader
+ *  itself.
+ ***********************************************************/
+void SceneManager::BindGLTextures()
+{
+	m_pTextureLoader->LoadTextures(m_pTextures);
+	m_pTextureLoader->PrintTimings();
+	m_pTextures->BindArrays();
+}
+
+/***********************************************************
+ *  DestroyGLTextures()
+ *
+ *  This method is used for freeing the memory in all the
+ *  used texture arrays.
+ ***********************************************************/
+void SceneManager::DestroyGLTextures()
+{
+	m_pTextures->DestroyArrays();
+}
+
+/***********************************************************
+ *  FindMaterialIndex()
+ *
+ *  This method is used for getting the index of the previously
+ *  defined material that is associated with the passed in tag,
+ *  or -1 if there is no such material.
+ ***********************************************************/
+int SceneManager::FindMaterialIndex(const std::string& tag) const
+{
+	std::unordered_map<std::string, int>::const_iterator found = m_materialIndices.find(tag);
+	if (found == m_materialIndices.end())
+	{
+		return(-1);
+	}
+
+	return(found->second);
+}
+
+/***********************************************************
+ *  MarkMaterialsDirty()
+ *
+ *  This method is used for growing the range of materials
+ *  that need to be uploaded before the next draw.
+ ***********************************************************/
+void SceneManager::MarkMaterialsDirty(int firstIndex, int lastIndex)
+{
+	if (firstIndex < m_firstDirtyMaterial)
+	{
+		m_firstDirtyMaterial = firstIndex;
+	}
+	if (lastIndex > m_lastDirtyMaterial)
+	{
+		m_lastDirtyMaterial = lastIndex;
+	}
+}
+
+/***********************************************************
+ *  UploadMaterials()
+ *
+ *  This method is used for copying the changed range of the
+ *  material table into the material uniform buffer.  The
+ *  buffer is created at its full size on the first upload,
+ *  so later uploads never need to reallocate it.
+ ***********************************************************/
+void SceneManager::UploadMaterials()
+{
+	if (m_firstDirtyMaterial > m_lastDirtyMaterial)
+	{
+		return;
+	}
+
+	if (m_materialBufferID == 0)
+	{
+		glGenBuffers(1, &m_materialBufferID);
+		GLStateCache::BindBuffer(GL_UNIFORM_BUFFER, m_materialBufferID);
+		glBufferData(GL_UNIFORM_BUFFER, MAX_OBJECT_MATERIALS * sizeof(GPU_MATERIAL), NULL, GL_DYNAMIC_DRAW);
+		GLStateCache::BindBufferBase(GL_UNIFORM_BUFFER, MATERIAL_BLOCK_BINDING, m_materialBufferID);
+	}
+	else
+	{
+		GLStateCache::BindBuffer(GL_UNIFORM_BUFFER, m_materialBufferID);
+	}
+
+	std::vector<GPU_MATERIAL> gpuMaterials;
+	gpuMaterials.reserve(m_lastDirtyMaterial - m_firstDirtyMaterial + 1);
+	for (int i = m_firstDirtyMaterial; i <= m_lastDirtyMaterial; i++)
+	{
+		const OBJECT_MATERIAL& material = m_objectMaterials[i];
+		GPU_MATERIAL gpuMaterial;
+		gpuMaterial.ambientColor = glm::vec4(material.ambientColor, material.ambientStrength);
+		gpuMaterial.diffuseColor = glm::vec4(material.diffuseColor, 0.0f);
+		gpuMaterial.specularColor = glm::vec4(material.specularColor, material.shininess);
+		gpuMaterials.push_back(gpuMaterial);
+	}
+
+	glBufferSubData(
+		GL_UNIFORM_BUFFER,
+		m_firstDirtyMaterial * sizeof(GPU_MATERIAL),
+		gpuMaterials.size() * sizeof(GPU_MATERIAL),
+		gpuMaterials.data());
+	GLStateCache::BindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	m_firstDirtyMaterial = MAX_OBJECT_MATERIALS;
+	m_lastDirtyMaterial = -1;
+}
+
+/***********************************************************
+ *  UploadFrameUniforms()
+ *
+ *  This method is used for copying the camera and light
+ *  cluster values of the frame into the frame uniform
+ *  buffer.  Every variant of the shader program reads them
+ *  from there, so they are set once however many variants
+ *  the frame draws with.
+ ***********************************************************/
+void SceneManager::UploadFrameUniforms()
+{
+	FRAME_UNIFORMS frame;
+	frame.view = m_viewMatrix;
+	frame.projection = m_projectionMatrix;
+	// the camera sits at the origin of the view space
+	frame.viewPosition = glm::inverse(m_viewMatrix)[3];
+	frame.clusterParameters = m_pLights->GetClusterParameters();
+
+	if (m_frameBufferID == 0)
+	{
+		glGenBuffers(1, &m_frameBufferID);
+		GLStateCache::BindBuffer(GL_UNIFORM_BUFFER, m_frameBufferID);
+		glBufferData(GL_UNIFORM_BUFFER, sizeof(FRAME_UNIFORMS), NULL, GL_DYNAMIC_DRAW);
+		GLStateCache::BindBufferBase(GL_UNIFORM_BUFFER, FRAME_BLOCK_BINDING, m_frameBufferID);
+	}
+	else
+	{
+		GLStateCache::BindBuffer(GL_UNIFORM_BUFFER, m_frameBufferID);
+	}
+
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FRAME_UNIFORMS), &frame);
+	GLStateCache::BindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+/***********************************************************
+ *  UpdateMaterial()
+ *
+ *  This method is used for adding a material to the material
+ *  table, or for replacing the material with the same tag.
+ *  Only the changed entry is uploaded before the next frame.
+ *  The index of the material is returned, or -1 if the
+ *  material table is full.
+ ***********************************************************/
+int SceneManager::UpdateMaterial(const OBJECT_MATERIAL& material)
+{
+	int index = FindMaterialIndex(material.tag);
+	if (index >= 0)
+	{
+		m_objectMaterials[index] = material;
+	}
+	else
+	{
+		if ((int)m_objectMaterials.size() >= MAX_OBJECT_MATERIALS)
+		{
+			std::cout << "Too many object materials, could not add:" << material.tag << std::endl;
+			return(-1);
+		}
+
+		index = (int)m_objectMaterials.size();
+		m_objectMaterials.push_back(material);
+		m_materialIndices[material.tag] = index;
+	}
+
+	MarkMaterialsDirty(index, index);
+
+	return(index);
+}
+
+/***********************************************************
+ *  SetTransformations()
+ *
+ *  This method is used for setting the model matrix of the
+ *  next draw using the passed in transformation values.
+ ***********************************************************/
+void SceneManager::SetTransformations(
+	glm::vec3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	glm::vec3 positionXYZ)
+{
+	m_drawPacket.model = TransformHierarchy::ComposeMatrix(
+		scaleXYZ,
+		glm::vec3(XrotationDegrees, YrotationDegrees, ZrotationDegrees),
+		positionXYZ);
+}
+
+/***********************************************************
+ *  SetShaderColor()
+ *
+ *  This method is used for setting the passed in color
+ *  into the next draw command.  A color that is not fully
+ *  opaque is blended, after all of the opaque draws.
+ ***********************************************************/
+void SceneManager::SetShaderColor(
+	float redColorValue,
+	float greenColorValue,
+	float blueColorValue,
+	float alphaValue)
+{
+	// variables for this method
+	glm::vec4 currentColor;
+
+	currentColor.r = redColorValue;
+	currentColor.g = greenColorValue;
+	currentColor.b = blueColorValue;
+	currentColor.a = alphaValue;
+
+	m_drawPacket.variant &= ~ShaderManager::FEATURE_TEXTURE;
+	m_drawPacket.textureArray = -1;
+	m_drawPacket.color = currentColor;
+	m_drawPacket.blendMode = (alphaValue < 1.0f) ? RenderQueue::BLEND_ALPHA : RenderQueue::BLEND_OPAQUE;
+}
+
+/***********************************************************
+ *  SetShaderTexture()
+ *
+ *  This method is used for selecting the texture array and
+ *  layer of the texture associated with the passed in tag
+ *  for the next draw.  Textured draws are always opaque.
+ ***********************************************************/
+void SceneManager::SetShaderTexture(
+	std::string textureTag)
+{
+	TextureArrays::TEXTURE_LAYER location;
+
+	// an unknown tag keeps the current texture
+	if (m_pTextures->FindTexture(textureTag, location) == true)
+	{
+		m_drawPacket.variant |= ShaderManager::FEATURE_TEXTURE;
+		m_drawPacket.textureArray = location.arrayIndex;
+		m_drawPacket.textureLayer = location.layer;
+		m_drawPacket.blendMode = RenderQueue::BLEND_OPAQUE;
+	}
+}
+
+/***********************************************************
+ *  SetTextureUVScale()
+ *
+ *  This method is used for setting the texture UV scale
+ *  values of the next draw.
+ ***********************************************************/
+void SceneManager::SetTextureUVScale(float u, float v)
+{
+	m_drawPacket.UVscale = glm::vec2(u, v);
+}
+
+/***********************************************************
+ *  SetShaderMaterial()
+ *
+ *  This method is used for selecting the material used for
+ *  the next draw command.  The material values are already
+ *  in the material buffer, so only the index is passed into
+ *  the shader.  An unknown tag keeps the current material.
+ ***********************************************************/
+void SceneManager::SetShaderMaterial(
+	const std::string& materialTag)
+{
+	int materialIndex = FindMaterialIndex(materialTag);
+	if (materialIndex >= 0)
+	{
+		SetShaderMaterial(materialIndex);
+	}
+}
+
+void SceneManager::SetShaderMaterial(
+	int materialIndex)
+{
+	m_drawPacket.materialIndex = materialIndex;
+}
+
+/***********************************************************
+ *  SetShaderLighting()
+ *
+ *  This method is used for choosing whether the next draw
+ *  is lit by the scene lights, or shows its plain color or
+ *  texture.  Each choice is drawn with its own variant of
+ *  the shader program.
+ ***********************************************************/
+void SceneManager::SetShaderLighting(
+	bool bLighting)
+{
+	if (bLighting)
+	{
+		m_drawPacket.variant |= ShaderManager::FEATURE_LIGHTING;
+	}
+	else
+	{
+		m_drawPacket.variant &= ~ShaderManager::FEATURE_LIGHTING;
+	}
+}
+
+/***********************************************************
+ *  SetShaderAlphaTest()
+ *
+ *  This method is used for choosing whether the parts of
+ *  the next draw that are mostly see-through are cut out.
+ *  The rest stays opaque, so the draw still writes depth and
+ *  needs no sorting.
+ ***********************************************************/
+void SceneManager::SetShaderAlphaTest(
+	bool bAlphaTest)
+{
+	if (bAlphaTest)
+	{
+		m_drawPacket.variant |= ShaderManager::FEATURE_ALPHA_TEST;
+	}
+	else
+	{
+		m_drawPacket.variant &= ~ShaderManager::FEATURE_ALPHA_TEST;
+	}
+}
+
+/***********************************************************
+ *  SubmitDraw()
+ *
+ *  This method is used for adding a draw of the passed in
+ *  mesh, with the transform, texture, material and color set
+ *  so far, to the render queue.  The state is kept, so the
+ *  next draw only needs to set what differs.  A draw outside
+ *  of the view frustum, or hidden behind the occluders drawn
+ *  before it, is counted and skipped, and the others use the
+ *  level of detail that fits their size on screen.
+ ***********************************************************/
+void SceneManager::SubmitDraw(
+	ShapeMeshes::MESH_TYPE mesh)
+{
+	if (m_bCollectVariants)
+	{
+		AddPacketVariants(m_drawPacket);
+		return;
+	}
+
+	int& level = NextDrawLevel();
+
+	m_drawPacket.mesh = mesh;
+	// the shadow may fall into the view even when the object
+	// is outside of it, so every draw casts one
+	if (m_bShadows)
+	{
+		m_staticCasters.push_back(m_drawPacket);
+	}
+	if (IsPacketVisible(mesh, m_drawPacket.model) == false)
+	{
+		m_renderStats.culledObjects++;
+		return;
+	}
+
+	if (IsOccluder(m_drawPacket))
+	{
+		RasterizeOccluder(mesh, m_drawPacket.model);
+	}
+	else if (IsPacketOccluded(mesh, m_drawPacket.model))
+	{
+		m_renderStats.occludedObjects++;
+		return;
+	}
+
+	level = SelectDetailLevel(mesh, m_drawPacket.model, level);
+	if (level > 0)
+	{
+		m_renderStats.reducedDetailObjects++;
+	}
+
+	m_drawPacket.lod = level;
+	m_renderStats.visibleObjects++;
+	m_pRenderQueue->Submit(m_drawPacket);
+	m_drawPacket.lod = 0;
+}
+
+/***********************************************************
+ *  SubmitInstances()
+ *
+ *  This method is used for adding a copy of the next draw of
+ *  the passed in mesh for every passed in model matrix.  The
+ *  copies share the texture, material and color set so far,
+ *  and are drawn together with one instanced draw call for
+ *  each level of detail they use.  Only the copies inside
+ *  the view frustum and not hidden behind the occluders are
+ *  added.
+ ***********************************************************/
+void SceneManager::SubmitInstances(
+	ShapeMeshes::MESH_TYPE mesh,
+	const std::vector<glm::mat4>& transforms)
+{
+	if (m_bCollectVariants)
+	{
+		AddPacketVariants(m_drawPacket);
+		return;
+	}
+
+	m_drawPacket.mesh = mesh;
+
+	for (int lod = 0; lod < ShapeMeshes::LOD_COUNT; lod++)
+	{
+		m_levelTransforms[lod].clear();
+	}
+	for (size_t i = 0; i < transforms.size(); i++)
+	{
+		if (m_bShadows)
+		{
+			m_staticCasters.push_back(m_drawPacket);
+			m_staticCasters.back().model = transforms[i];
+		}
+
+		int& level = NextDrawLevel();
+		if (IsPacketVisible(mesh, transforms[i]) == false)
+		{
+			m_renderStats.culledObjects++;
+		}
+		else if (IsPacketOccluded(mesh, transforms[i]))
+		{
+			m_renderStats.occludedObjects++;
+		}
+		else
+		{
+			level = SelectDetailLevel(mesh, transforms[i], level);
+			m_levelTransforms[level].push_back(transforms[i]);
+		}
+	}
+
+	for (int lod = 0; lod < ShapeMeshes::LOD_COUNT; lod++)
+	{
+		m_renderStats.visibleObjects += (int)m_levelTransforms[lod].size();
+		if (lod > 0)
+		{
+			m_renderStats.reducedDetailObjects += (int)m_levelTransforms[lod].size();
+		}
+
+		m_drawPacket.lod = lod;
+		m_pRenderQueue->SubmitInstances(m_drawPacket, m_levelTransforms[lod]);
+	}
+	m_drawPacket.lod = 0;
+}
+
+/**************************************************************/
+/*** STUDENTS CAN MODIFY the code in the methods BELOW for  ***/
+/*** preparing and rendering their own 3D replicated scenes.***/
+/*** Please refer to the code in the OpenGL sample project  ***/
+/*** for assistance.                                        ***/
+/**************************************************************/
+
+ /***********************************************************
+  *  LoadSceneTextures()
+  *
+  *  This method is used for preparing the 3D scene by loading
+  *  the shapes, textures in memory to support the 3D scene
+  *  rendering
+  ***********************************************************/
+  /***********************************************************
+  *  LoadSceneTextures()
+  *
+  *  This method is used for preparing the 3D scene by loading
+  *  the shapes, textures in memory to support the 3D scene
+  *  rendering
+  ***********************************************************/
+
+void SceneManager::LoadSceneTextures()
+{
+	for (int i = 0; i < SCENE_TEXTURE_COUNT; i++)
+	{
+		CreateGLTexture(SCENE_TEXTURES[i].filename, SCENE_TEXTURES[i].tag);
+	}
+
+	// after the texture files are added, they are decoded in
+	// parallel and packed into texture arrays that are bound
+	// to texture units - there is no limit on the number of
+	// scene textures 
+	BindGLTextures();
+}
+
+/***********************************************************
+ *  DefineObjectMaterials()
+ *
+ *  This method is used for configuring the various material
+ *  settings for all of the objects within the 3D scene.
+ ***********************************************************/
+void SceneManager::DefineObjectMaterials()
+{
+	OBJECT_MATERIAL goldMaterial;
+	goldMaterial.ambientColor = glm::vec3(0.2f, 0.2f, 0.2f);
+	goldMaterial.ambientStrength = 0.3f;
+	goldMaterial.diffuseColor = glm::vec3(0.2f, 0.2f, 0.2f);
+	goldMaterial.specularColor = glm::vec3(0.5f, 0.5f, 0.5f);
+	goldMaterial.shininess = 22.0;
+	goldMaterial.tag = "metal";
+
+	UpdateMaterial(goldMaterial);
+
+	OBJECT_MATERIAL woodMaterial;
+	woodMaterial.ambientColor = glm::vec3(0.1f, 0.1f, 0.1f);
+	woodMaterial.ambientStrength = 0.2f;
+	woodMaterial.diffuseColor = glm::vec3(0.3f, 0.3f, 0.3f);
+	woodMaterial.specularColor = glm::vec3(0.1f, 0.1f, 0.1f);
+	woodMaterial.shininess = 0.3;
+	woodMaterial.tag = "wood";
+
+	UpdateMaterial(woodMaterial);
+
+	OBJECT_MATERIAL glassMaterial;
+	glassMaterial.ambientColor = glm::vec3(0.4f, 0.4f, 0.4f);
+	glassMaterial.ambientStrength = 0.3f;
+	glassMaterial.diffuseColor = glm::vec3(0.3f, 0.3f, 0.3f);
+	glassMaterial.specularColor = glm::vec3(0.6f, 0.6f, 0.6f);
+	glassMaterial.shininess = 85.0;
+	glassMaterial.tag = "glass";
+
+	UpdateMaterial(glassMaterial);
+
+	OBJECT_MATERIAL cheeseMaterial;
+	cheeseMaterial.ambientColor = glm::vec3(0.1f, 0.1f, 0.1f);
+	cheeseMaterial.ambientStrength = 0.2f;
+	cheeseMaterial.diffuseColor = glm::vec3(0.5f, 0.5f, 0.5f);
+	cheeseMaterial.specularColor = glm::vec3(0.1f, 0.1f, 0.1f);
+	cheeseMaterial.shininess = 0.3;
+	cheeseMaterial.tag = "cheese";
+
+	UpdateMaterial(cheeseMaterial);
+
+	OBJECT_MATERIAL breadMaterial;
+	breadMaterial.ambientColor = glm::vec3(0.2f, 0.2f, 0.2f);
+	breadMaterial.ambientStrength = 0.3f;
+	breadMaterial.diffuseColor = glm::vec3(0.5f, 0.5f, 0.5f);
+	breadMaterial.specularColor = glm::vec3(0.3f, 0.3f, 0.3f);
+	breadMaterial.shininess = 0.5;
+	breadMaterial.tag = "bread";
+
+	UpdateMaterial(breadMaterial);
+
+	OBJECT_MATERIAL darkBreadMaterial;
+	darkBreadMaterial.ambientColor = glm::vec3(0.2f, 0.2f, 0.2f);
+	darkBreadMaterial.ambientStrength = 0.2f;
+	darkBreadMaterial.diffuseColor = glm::vec3(0.1f, 0.1f, 0.1f);
+	darkBreadMaterial.specularColor = glm::vec3(0.0f, 0.0f, 0.0f);
+	darkBreadMaterial.shininess = 0.0;
+	darkBreadMaterial.tag = "darkbread";
+
+	UpdateMaterial(darkBreadMaterial);
+
+	OBJECT_MATERIAL backdropMaterial;
+	backdropMaterial.ambientColor = glm::vec3(0.6f, 0.6f, 0.6f);
+	backdropMaterial.ambientStrength = 0.6f;
+	backdropMaterial.diffuseColor = glm::vec3(0.6f, 0.5f, 0.1f);
+	backdropMaterial.specularColor = glm::vec3(0.0f, 0.0f, 0.0f);
+	backdropMaterial.shininess = 0.0;
+	backdropMaterial.tag = "backdrop";
+
+	UpdateMaterial(backdropMaterial);
+
+	OBJECT_MATERIAL grapeMaterial;
+	grapeMaterial.ambientColor = glm::vec3(0.1f, 0.1f, 0.1f);
+	grapeMaterial.ambientStrength = 0.1f;
+	grapeMaterial.diffuseColor = glm::vec3(0.3f, 0.2f, 0.3f);
+	grapeMaterial.specularColor = glm::vec3(0.4f, 0.2f, 0.2f);
+	grapeMaterial.shininess = 0.5;
+	grapeMaterial.tag = "grape";
+
+	UpdateMaterial(grapeMaterial);
+
+	// the whole table is uploaded once here, rather than the
+	// material values being set for every draw
+	UploadMaterials();
+}
+
+/***********************************************************
+ *  SetupSceneLights()
+ *
+ *  This method is called to add and configure the light
+ *  sources for the 3D scene.  The lights are kept in a
+ *  shader storage buffer, so there is no fixed limit on
+ *  their number - each fragment is only lit by the lights
+ *  whose range reaches its cluster.
+ ***********************************************************/
+void SceneManager::SetupSceneLights()
+{
+	ClusteredLights::POINT_LIGHT light = {};
+
+	m_pLights->Initialize();
+	m_pLights->ClearLights();
+
+	// the scene lights reach past the whole table, so they
+	// light the scene the same as lights without a range
+	light.range = 100.0f;
+
+	// Primary light source (Point light)
+	light.position = glm::vec3(-3.0f, 5.0f, 8.0f); // Position adjusted for better lighting
+	light.ambientColor = glm::vec3(0.2f, 0.1f, 0.1f); // Increased ambient light for warmth
+	light.diffuseColor = glm::vec3(0.7f, 0.5f, 0.5f); // Brighter diffuse color
+	light.specularColor = glm::vec3(0.4f, 0.4f, 0.4f); // Higher specular color for shininess
+	light.focalStrength = 32.0f;
+	light.specularIntensity = 6.5f; // Increased intensity for more reflection
+	m_pLights->AddLight(light);
+
+	// Secondary light source (Point light)
+	light.position = glm::vec3(3.0f, 5.0f, 8.0f); // Position adjusted to match first light
+	light.ambientColor = glm::vec3(0.1f, 0.1f, 0.1f); // Low ambient for fill
+	light.diffuseColor = glm::vec3(0.6f, 0.6f, 0.6f); // Slightly higher diffuse
+	light.specularColor = glm::vec3(0.3f, 0.3f, 0.3f); // Moderate specular
+	light.focalStrength = 32.0f;
+	light.specularIntensity = 5.4f; // Increased intensity for reflection
+	m_pLights->AddLight(light);
+
+	// Tertiary light source (Directional light)
+	light.position = glm::vec3(0.0f, 10.0f, 0.0f); // High above for directional lighting
+	light.ambientColor = glm::vec3(0.3f, 0.3f, 0.3f); // Higher ambient to prevent shadows
+	light.diffuseColor = glm::vec3(1.0f, 1.0f, 1.0f); // Bright white for diffuse
+	light.specularColor = glm::vec3(0.5f, 0.5f, 0.5f); // Increased specular for highlights
+	light.focalStrength = 12.0f;
+	light.specularIntensity = 1.5f; // Increased intensity for stronger reflections
+	m_pLights->AddLight(light);
+}
+
+/***********************************************************
+ *  AddScatteredLights()
+ *
+ *  This method is used to add a number of small colored
+ *  point lights spread over the table top.  The positions
+ *  come from a fixed seed, so every run gets the same
+ *  lights and the timings can be compared.
+ ***********************************************************/
+void SceneManager::AddScatteredLights(int count)
+{
+	ClusteredLights::POINT_LIGHT light = {};
+	unsigned int seed = 12345;
+
+	// remembered so the lights can be added again when the
+	// scene file changes its lights
+	m_scatteredLightCount = count;
+
+	for (int i = 0; i < count; i++)
+	{
+		float values[7];
+		for (int j = 0; j < 7; j++)
+		{
+			seed = seed * 1664525u + 1013904223u;
+			values[j] = (float)(seed >> 8) / (float)(1 << 24);
+		}
+
+		light.position = glm::vec3(
+			-9.0f + values[0] * 18.0f,
+			-0.6f + values[1] * 3.0f,
+			-4.5f + values[2] * 7.0f);
+		light.range = 1.0f + values[3] * 1.5f;
+		light.diffuseColor = glm::vec3(values[4], values[5], values[6]);
+		light.ambientColor = light.diffuseColor * 0.05f;
+		light.specularColor = light.diffuseColor * 0.5f;
+		light.focalStrength = 16.0f;
+		light.specularIntensity = 1.0f;
+		m_pLights->AddLight(light);
+	}
+}
+
+/***********************************************************
+ *  PrepareScene()
+ *
+ *  This method is used for preparing the 3D scene by loading
+ *  the shapes, textures in memory to support the 3D scene
+ *  rendering
+ ***********************************************************/
+void SceneManager::PrepareScene()
+{
+	// load the texture image files for the textures applied
+	// to objects in the 3D scene
+	LoadSceneTextures();
+	// define the materials that will be used for the objects
+	// in the 3D scene
+	DefineObjectMaterials();
+	// add and defile the light sources for the 3D scene
+	SetupSceneLights();
+	m_pShadows->Initialize();
+
+	m_basicMeshes->LoadBoxMesh();
+	m_basicMeshes->LoadPlaneMesh();
+	m_basicMeshes->LoadCylinderMesh();
+	m_basicMeshes->LoadConeMesh();
+	m_basicMeshes->LoadPrismMesh();
+	m_basicMeshes->LoadPyramid4Mesh();
+	m_basicMeshes->LoadSphereMesh();
+	m_basicMeshes->LoadTaperedCylinderMesh();
+	m_basicMeshes->LoadTorusMesh();
+
+	m_bScenePrepared = true;
+	PrepareShaderVariants();
+}
+
+
+/***********************************************************
+ *  RenderScene()
+ *
+ *  This method is used for rendering the 3D scene by
+ *  transforming and drawing the basic 3D shapes.
+ ***********************************************************/
+void SceneManager::RenderScene()
+{
+	GPUProfiler::Scope sceneScope(m_pProfiler, "scene");
+
+	// upload any materials changed since the last frame
+	UploadMaterials();
+
+	// bin the lights into the clusters of this frame's view
+	{
+		GPUProfiler::Scope lightScope(m_pProfiler, "light clusters");
+
+		GLint viewport[4];
+		glGetIntegerv(GL_VIEWPORT, viewport);
+		m_pLights->Update(m_viewMatrix, m_projectionMatrix, viewport[2], viewport[3]);
+		m_viewportHeight = (float)viewport[3];
+		UploadFrameUniforms();
+		m_renderStats.clusterLights = m_pLights->GetAssignedLightCount();
+	}
+
+	// collect the draws of every object - an object that does
+	// not set its own texture or material keeps the one of the
+	// object submitted before it
+	{
+		GPUProfiler::Scope submitScope(m_pProfiler, "submit");
+
+		m_pRenderQueue->Clear();
+		m_staticCasters.clear();
+		m_dynamicCasters.clear();
+		ResetDrawPacket(m_drawPacket);
+
+		// the frustum of this frame's view, whichever projection
+		// it uses, decides which objects are drawn
+		m_viewProjectionMatrix = m_projectionMatrix * m_viewMatrix;
+		m_frustum = BoundingVolumeHierarchy::ExtractFrustum(m_viewProjectionMatrix);
+		m_pOcclusion->Clear(m_viewProjectionMatrix);
+		m_renderStats.visibleObjects = 0;
+		m_renderStats.culledObjects = 0;
+		m_renderStats.occludedObjects = 0;
+		m_renderStats.reducedDetailObjects = 0;
+		m_drawLevelCount = 0;
+
+		if (m_sceneFilename.empty())
+		{
+			RenderBackdrop();
+			RenderTable();
+			RenderPhoneBox();
+			RenderWineBottle();
+			RenderGrapes();
+		}
+		else
+		{
+			// the draws of the scene file objects are only made
+			// again when the file changes, and their matrices
+			// when an object or one of its parents moved
+			UpdateSceneTransforms();
+			SubmitVisibleScenePackets();
+		}
+	}
+
+	// draw the shadows of whatever moved into the shadow maps
+	{
+		GPUProfiler::Scope shadowScope(m_pProfiler, "shadows");
+		UpdateShadows();
+	}
+
+	// draw them sorted by their render state
+	{
+		GPUProfiler::Scope queueScope(m_pProfiler, "render queue");
+
+		if (m_bDeferred && (m_pDeferred->BeginGeometry() == false))
+		{
+			std::cout << "ERROR: deferred shading is not available, using forward shading" << std::endl;
+			m_bDeferred = false;
+		}
+
+		if (m_bDeferred)
+		{
+			// the opaque objects only fill the G-buffer, which is
+			// lit once per pixel, and the blended ones are lit as
+			// they are drawn over it
+			m_pRenderQueue->Prepare(m_basicMeshes, m_pShaderManager, m_viewMatrix, ShaderManager::FEATURE_GBUFFER);
+			m_pRenderQueue->Draw(m_basicMeshes, m_pShaderManager, RenderQueue::BLEND_OPAQUE, ShaderManager::FEATURE_GBUFFER);
+			{
+				GPUProfiler::Scope lightingScope(m_pProfiler, "deferred lighting");
+				m_pDeferred->LightScene(m_pShaderManager);
+			}
+			m_pRenderQueue->Draw(m_basicMeshes, m_pShaderManager, RenderQueue::BLEND_ALPHA, 0);
+		}
+		else
+		{
+			m_pRenderQueue->Flush(m_basicMeshes, m_pShaderManager, m_viewMatrix);
+		}
+
+		const RenderQueue::QUEUE_STATS& queueStats = m_pRenderQueue->GetStats();
+		m_renderStats.drawCalls = queueStats.drawCalls;
+		m_renderStats.drawCommands = queueStats.drawCommands;
+		m_renderStats.instances = queueStats.instances;
+		m_renderStats.stateChanges = queueStats.vertexArrayBinds + queueStats.programChanges + queueStats.blendChanges;
+	}
+
+	// any name lookups counted since the start of the frame
+	// mean a string uniform path is still being used per frame
+	m_renderStats.uniformLookups = m_pShaderManager->GetUniformLookupCount();
+
+	// the state calls counted since the start of the frame
+	const GLStateCache::STATE_STATS& stateStats = GLStateCache::GetStats();
+	m_renderStats.stateCalls = stateStats.issuedCalls;
+	m_renderStats.elidedStateCalls = stateStats.elidedCalls;
+}
+
+/***********************************************************
+ *  LoadSceneFile()
+ *
+ *  This method is used to load the objects, lights and
+ *  camera of a scene file.  The objects are drawn in place
+ *  of the built in ones, and the lights replace the ones
+ *  from SetupSceneLights() when the file has any.
+ ***********************************************************/
+bool SceneManager::LoadSceneFile(const std::string& filename)
+{
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	SceneFile sceneFile;
+
+	// read the time first, so a change made while the file is
+	// loading is picked up by the next check
+	long long modifiedTime = MappedFile::GetModifiedTime(filename);
+	if (sceneFile.Open(filename) == false)
+	{
+		return false;
+	}
+
+	int changedCount = ApplySceneFile(sceneFile);
+	m_sceneFilename = filename;
+	m_sceneModifiedTime = modifiedTime;
+	PrepareShaderVariants();
+
+	std::cout << "Loaded scene " << filename << ": " << sceneFile.GetObjectCount() << " objects ("
+		<< changedCount << " changed), " << sceneFile.GetLightCount() << " lights in "
+		<< std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count()
+		<< " ms" << std::endl;
+
+	// the mapping is closed here - everything needed was copied
+	// out of it, so the file can be written again while the
+	// scene is shown
+	return true;
+}
+
+/***********************************************************
+ *  ReloadChangedSceneFile()
+ *
+ *  This method is used to check whether the loaded scene
+ *  file was written since it was loaded, and to load it
+ *  again if it was.  Only the objects that differ from the
+ *  loaded ones have their draws made again.  A file that
+ *  fails to load leaves the scene as it was.
+ ***********************************************************/
+bool SceneManager::ReloadChangedSceneFile()
+{
+	if (m_sceneFilename.empty())
+	{
+		return false;
+	}
+
+	long long modifiedTime = MappedFile::GetModifiedTime(m_sceneFilename);
+	if ((modifiedTime == 0) || (modifiedTime == m_sceneModifiedTime))
+	{
+		return false;
+	}
+
+	// a broken file is only reported once, not on every check
+	m_sceneModifiedTime = modifiedTime;
+
+	return LoadSceneFile(m_sceneFilename);
+}
+
+/***********************************************************
+ *  GetChangedSceneCamera()
+ *
+ *  This method is used to get the camera of the scene file
+ *  after it was loaded or changed, so that moving the camera
+ *  around is not undone by reloads that leave it alone.
+ ***********************************************************/
+bool SceneManager::GetChangedSceneCamera(SceneFile::SCENE_CAMERA& camera)
+{
+	if (m_bSceneCameraChanged == false)
+	{
+		return false;
+	}
+
+	camera = m_sceneCamera;
+	m_bSceneCameraChanged = false;
+	return true;
+}
+
+/***********************************************************
+ *  ApplySceneFile()
+ *
+ *  This method is used to compare a mapped scene file with
+ *  the loaded one, object by object.  Only the objects that
+ *  changed have their transforms and draws set again, and
+ *  the lights are only replaced when any of them changed.
+ *  When an object moved to another parent, or was removed,
+ *  the whole tree is built again.  Returns the number of
+ *  objects that changed.
+ ***********************************************************/
+int SceneManager::ApplySceneFile(const SceneFile& sceneFile)
+{
+	int objectCount = sceneFile.GetObjectCount();
+	const SceneFile::SCENE_OBJECT* pObjects = sceneFile.GetObjects();
+	int keptCount = std::min((int)m_sceneObjects.size(), objectCount);
+	int changedCount = 0;
+
+	bool bRebuild = (objectCount < (int)m_sceneObjects.size());
+	for (int i = 0; (i < keptCount) && (bRebuild == false); i++)
+	{
+		bRebuild = (pObjects[i].parent != m_sceneObjects[i].parent) ||
+			((pObjects[i].mesh == SceneFile::NO_MESH) != (m_sceneObjects[i].mesh == SceneFile::NO_MESH));
+	}
+	if (bRebuild)
+	{
+		m_sceneObjects.clear();
+		m_scenePackets.clear();
+		m_sceneObjectPackets.clear();
+		m_pSceneTransforms->Clear();
+		keptCount = 0;
+	}
+
+	m_sceneObjects.resize(objectCount);
+	for (int i = 0; i < objectCount; i++)
+	{
+		const SceneFile::SCENE_OBJECT& object = pObjects[i];
+		if ((i < keptCount) && (memcmp(&m_sceneObjects[i], &object, sizeof(SceneFile::SCENE_OBJECT)) == 0))
+		{
+			continue;
+		}
+
+		// new objects get a node and, unless they are a group, a
+		// draw - the parents are always in front of them
+		if (i >= keptCount)
+		{
+			m_pSceneTransforms->AddNode(object.parent);
+			if (object.mesh == SceneFile::NO_MESH)
+			{
+				m_sceneObjectPackets.push_back(-1);
+			}
+			else
+			{
+				m_sceneObjectPackets.push_back((int)m_scenePackets.size());
+				m_scenePackets.push_back(RenderQueue::DRAW_PACKET());
+			}
+		}
+
+		// the world matrices are brought up to date before the
+		// next frame is drawn, and only for the changed nodes
+		m_sceneObjects[i] = object;
+		m_pSceneTransforms->SetLocalTransform(i, object.scale, object.rotation, object.position);
+		if (m_sceneObjectPackets[i] >= 0)
+		{
+			ResolveSceneObject(object, m_scenePackets[m_sceneObjectPackets[i]]);
+		}
+		changedCount++;
+	}
+	if (changedCount > 0)
+	{
+		m_bSceneBoundsDirty = true;
+	}
+
+	int lightCount = sceneFile.GetLightCount();
+	const ClusteredLights::POINT_LIGHT* pLights = sceneFile.GetLights();
+	bool bLightsChanged = (lightCount != (int)m_sceneLights.size()) ||
+		((lightCount > 0) && (memcmp(m_sceneLights.data(), pLights, lightCount * sizeof(ClusteredLights::POINT_LIGHT)) != 0));
+	if (bLightsChanged)
+	{
+		m_sceneLights.assign(pLights, pLights + lightCount);
+
+		// a scene without lights goes back to the built in ones
+		if (m_sceneLights.empty())
+		{
+			SetupSceneLights();
+		}
+		else
+		{
+			m_pLights->ClearLights();
+			for (int i = 0; i < lightCount; i++)
+			{
+				m_pLights->AddLight(m_sceneLights[i]);
+			}
+		}
+		AddScatteredLights(m_scatteredLightCount);
+	}
+
+	if (sceneFile.HasCamera() &&
+		(m_sceneFilename.empty() || (memcmp(&m_sceneCamera, &sceneFile.GetCamera(), sizeof(SceneFile::SCENE_CAMERA)) != 0)))
+	{
+		m_sceneCamera = sceneFile.GetCamera();
+		m_bSceneCameraChanged = true;
+	}
+
+	return changedCount;
+}
+
+/***********************************************************
+ *  ResolveSceneObject()
+ *
+ *  This method is used to make the draw of a scene file
+ *  object, going through the same Set methods as the built
+ *  in objects so the texture, material and blending are
+ *  chosen the same way.  Unknown tags are left at the
+ *  defaults.  The model matrix is kept, since it comes from
+ *  the transform tree, and so is the level of detail picked
+ *  for the last frame.
+ ***********************************************************/
+void SceneManager::ResolveSceneObject(const SceneFile::SCENE_OBJECT& object, RenderQueue::DRAW_PACKET& packet)
+{
+	ResetDrawPacket(m_drawPacket);
+
+	SetShaderColor(object.color.r, object.color.g, object.color.b, object.color.a);
+	if (object.textureTag[0] != '\0')
+	{
+		SetShaderTexture(object.textureTag);
+	}
+	SetTextureUVScale(object.UVscale.x, object.UVscale.y);
+	if (object.materialTag[0] != '\0')
+	{
+		SetShaderMaterial(object.materialTag);
+	}
+	SetShaderLighting((object.flags & SceneFile::OBJECT_UNLIT) == 0);
+	SetShaderAlphaTest((object.flags & SceneFile::OBJECT_ALPHA_TEST) != 0);
+	m_drawPacket.mesh = (ShapeMeshes::MESH_TYPE)object.mesh;
+	m_drawPacket.model = packet.model;
+	m_drawPacket.lod = packet.lod;
+
+	packet = m_drawPacket;
+	m_drawPacket.lod = 0;
+}
+
+/***********************************************************
+ *  UpdateSceneTransforms()
+ *
+ *  This method is used to recompute the world matrices of
+ *  the scene objects that moved, along with everything
+ *  parented to them, and to copy them into their draws.
+ *  When nothing moved this does no matrix math at all.
+ ***********************************************************/
+void SceneManager::UpdateSceneTransforms()
+{
+	m_renderStats.transformUpdates = m_pSceneTransforms->Update();
+
+	const std::vector<int>& changedNodes = m_pSceneTransforms->GetChangedNodes();
+	for (size_t i = 0; i < changedNodes.size(); i++)
+	{
+		int packetIndex = m_sceneObjectPackets[changedNodes[i]];
+		if (packetIndex >= 0)
+		{
+			m_scenePackets[packetIndex].model = m_pSceneTransforms->GetWorldMatrix(changedNodes[i]);
+			if (m_bSceneBoundsDirty == false)
+			{
+				m_pSceneBounds->SetBounds(packetIndex, GetPacketBounds(m_scenePackets[packetIndex]));
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  GetPacketBounds()
+ *
+ *  This method is used to get the world space box around
+ *  the mesh of a draw, from the local box of the mesh.
+ ***********************************************************/
+BoundingVolumeHierarchy::BOUNDING_BOX SceneManager::GetPacketBounds(const RenderQueue::DRAW_PACKET& packet) const
+{
+	const ShapeMeshes::MESH_BOUNDS& bounds = m_basicMeshes->GetMeshBounds(packet.mesh);
+	return BoundingVolumeHierarchy::TransformBounds(bounds.minimum, bounds.maximum, packet.model);
+}
+
+/***********************************************************
+ *  IsPacketVisible()
+ *
+ *  This method is used to check whether a mesh drawn with a
+ *  model matrix is inside the view frustum.  The sphere of
+ *  the mesh is grown by the largest scale of the matrix,
+ *  which is cheaper than moving its box for draws that are
+ *  made again every frame.
+ ***********************************************************/
+bool SceneManager::IsPacketVisible(ShapeMeshes::MESH_TYPE mesh, const glm::mat4& model) const
+{
+	const ShapeMeshes::MESH_BOUNDS& bounds = m_basicMeshes->GetMeshBounds(mesh);
+	float scale = std::max(glm::length(glm::vec3(model[0])),
+		std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+	glm::vec3 center = glm::vec3(model * glm::vec4(bounds.center, 1.0f));
+
+	return BoundingVolumeHierarchy::IsSphereVisible(m_frustum, center, bounds.radius * scale);
+}
+
+/***********************************************************
+ *  SubmitVisibleScenePackets()
+ *
+ *  This method is used to add the scene file draws that are
+ *  inside the view frustum to the render queue, each with
+ *  the level of detail that fits its size on screen.  The
+ *  tree over their bounds is built again after the scene
+ *  file changed, and only refit when objects moved.
+ ***********************************************************/
+void SceneManager::SubmitVisibleScenePackets()
+{
+	if (m_bSceneBoundsDirty)
+	{
+		std::vector<BoundingVolumeHierarchy::BOUNDING_BOX> bounds(m_scenePackets.size());
+		for (size_t i = 0; i < m_scenePackets.size(); i++)
+		{
+			bounds[i] = GetPacketBounds(m_scenePackets[i]);
+		}
+		m_pSceneBounds->Build(bounds);
+		m_bSceneBoundsDirty = false;
+	}
+
+	m_pSceneBounds->Cull(m_frustum, m_visiblePackets);
+	m_renderStats.culledObjects = (int)(m_scenePackets.size() - m_visiblePackets.size());
+
+	// draw all of the occluders first, so every other draw is
+	// tested against the whole occlusion buffer
+	for (size_t i = 0; i < m_visiblePackets.size(); i++)
+	{
+		const RenderQueue::DRAW_PACKET& packet = m_scenePackets[m_visiblePackets[i]];
+		if (IsOccluder(packet))
+		{
+			RasterizeOccluder(packet.mesh, packet.model);
+		}
+	}
+
+	for (size_t i = 0; i < m_visiblePackets.size(); i++)
+	{
+		RenderQueue::DRAW_PACKET& packet = m_scenePackets[m_visiblePackets[i]];
+		if ((IsOccluder(packet) == false) && IsPacketOccluded(packet.mesh, packet.model))
+		{
+			m_renderStats.occludedObjects++;
+			continue;
+		}
+
+		packet.lod = SelectDetailLevel(packet.mesh, packet.model, packet.lod);
+		if (packet.lod > 0)
+		{
+			m_renderStats.reducedDetailObjects++;
+		}
+
+		m_pRenderQueue->Submit(packet);
+		m_renderStats.visibleObjects++;
+	}
+}
+
+/***********************************************************
+ *  IsOccluder()
+ *
+ *  This method is used to check whether a draw is drawn into
+ *  the occlusion buffer.  Only opaque boxes and planes are,
+ *  since their bounds are their exact shape, and only when
+ *  they are large enough to hide other objects.  Alpha
+ *  tested draws have holes, so they never are.
+ ***********************************************************/
+bool SceneManager::IsOccluder(const RenderQueue::DRAW_PACKET& packet) const
+{
+	if ((m_bOcclusionCulling == false) || (packet.blendMode != RenderQueue::BLEND_OPAQUE) ||
+		((packet.variant & ShaderManager::FEATURE_ALPHA_TEST) != 0) ||
+		((packet.mesh != ShapeMeshes::MESH_BOX) && (packet.mesh != ShapeMeshes::MESH_PLANE)))
+	{
+		return false;
+	}
+
+	const ShapeMeshes::MESH_BOUNDS& bounds = m_basicMeshes->GetMeshBounds(packet.mesh);
+	float scale = std::max(glm::length(glm::vec3(packet.model[0])),
+		std::max(glm::length(glm::vec3(packet.model[1])), glm::length(glm::vec3(packet.model[2]))));
+	return (bounds.radius * scale >= MIN_OCCLUDER_RADIUS);
+}
+
+/***********************************************************
+ *  RasterizeOccluder()
+ *
+ *  This method is used to draw the box of an occluder into
+ *  the occlusion buffer.
+ ***********************************************************/
+void SceneManager::RasterizeOccluder(ShapeMeshes::MESH_TYPE mesh, const glm::mat4& model)
+{
+	const ShapeMeshes::MESH_BOUNDS& bounds = m_basicMeshes->GetMeshBounds(mesh);
+	m_pOcclusion->RasterizeBox(bounds.minimum, bounds.maximum, model);
+}
+
+/***********************************************************
+ *  IsPacketOccluded()
+ *
+ *  This method is used to check whether the box of a mesh
+ *  drawn with a model matrix is hidden behind the occluders.
+ ***********************************************************/
+bool SceneManager::IsPacketOccluded(ShapeMeshes::MESH_TYPE mesh, const glm::mat4& model) const
+{
+	if (m_bOcclusionCulling == false)
+	{
+		return false;
+	}
+
+	const ShapeMeshes::MESH_BOUNDS& bounds = m_basicMeshes->GetMeshBounds(mesh);
+	return m_pOcclusion->IsBoxOccluded(bounds.minimum, bounds.maximum, model);
+}
+
+/***********************************************************
+ *  SetOcclusionCulling()
+ *
+ *  This method is used to turn the occlusion culling on or
+ *  off, for comparing the cost of both.
+ ***********************************************************/
+void SceneManager::SetOcclusionCulling(bool bEnabled)
+{
+	m_bOcclusionCulling = bEnabled;
+}
+
+/***********************************************************
+ *  SelectDetailLevel()
+ *
+ *  This method is used to pick the level of detail a mesh
+ *  drawn with a model matrix should use.  The sphere of the
+ *  mesh is measured in pixels on screen, which works for
+ *  both projections since the clip w is 1 for orthographic
+ *  ones.  The level only changes once the size is clearly
+ *  past a boundary, so objects near one do not pop between
+ *  two levels as the camera moves.
+ ***********************************************************/
+int SceneManager::SelectDetailLevel(ShapeMeshes::MESH_TYPE mesh, const glm::mat4& model, int currentLevel) const
+{
+	if ((m_bDetailLevels == false) || (ShapeMeshes::HasLevels(mesh) == false))
+	{
+		return 0;
+	}
+
+	const ShapeMeshes::MESH_BOUNDS& bounds = m_basicMeshes->GetMeshBounds(mesh);
+	float scale = std::max(glm::length(glm::vec3(model[0])),
+		std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+	glm::vec4 center = m_viewProjectionMatrix * (model * glm::vec4(bounds.center, 1.0f));
+
+	// the center is behind the camera, so the visible part of
+	// the object is right in front of it
+	if (center.w <= 0.0f)
+	{
+		return 0;
+	}
+	float screenRadius = bounds.radius * scale * m_projectionMatrix[1][1] / center.w * m_viewportHeight * 0.5f;
+
+	// the levels the object would move to if it were getting
+	// smaller, and if it were getting larger
+	int coarserLevel = 0;
+	int finerLevel = 0;
+	for (int i = 0; i < ShapeMeshes::LOD_COUNT - 1; i++)
+	{
+		if (screenRadius < LOD_SCREEN_RADII[i] * (1.0f - LOD_HYSTERESIS))
+		{
+			coarserLevel = i + 1;
+		}
+		if (screenRadius < LOD_SCREEN_RADII[i] * (1.0f + LOD_HYSTERESIS))
+		{
+			finerLevel = i + 1;
+		}
+	}
+
+	return std::min(std::max(currentLevel, coarserLevel), finerLevel);
+}
+
+/***********************************************************
+ *  NextDrawLevel()
+ *
+ *  This method is used to get the level of detail the next
+ *  built in draw used in the last frame.  The built in
+ *  objects are submitted in the same order every frame, so
+ *  the order identifies them.
+ ***********************************************************/
+int& SceneManager::NextDrawLevel()
+{
+	if (m_drawLevelCount >= (int)m_drawLevels.size())
+	{
+		m_drawLevels.push_back(0);
+	}
+	return m_drawLevels[m_drawLevelCount++];
+}
+
+/***********************************************************
+ *  SetDetailLevels()
+ *
+ *  This method is used to turn the coarser levels of detail
+ *  on or off, for comparing the cost of both.
+ ***********************************************************/
+void SceneManager::SetDetailLevels(bool bEnabled)
+{
+	m_bDetailLevels = bEnabled;
+}
+
+/***********************************************************
+ *  SetShadows()
+ *
+ *  This method is used to turn the shadows of the main
+ *  lights on or off.  Without them no caster is collected
+ *  and no shadow map is drawn or read.
+ ***********************************************************/
+void SceneManager::SetShadows(bool bEnabled)
+{
+	m_bShadows = bEnabled;
+
+	std::vector<int> cubeLights;
+	int overheadLight = ShadowMaps::NO_LIGHT;
+	if (bEnabled)
+	{
+		cubeLights.assign(CUBE_SHADOW_LIGHTS, CUBE_SHADOW_LIGHTS + sizeof(CUBE_SHADOW_LIGHTS) / sizeof(CUBE_SHADOW_LIGHTS[0]));
+		overheadLight = OVERHEAD_SHADOW_LIGHT;
+	}
+	m_pShadows->SetShadowLights(cubeLights, overheadLight);
+}
+
+/***********************************************************
+ *  SetDeferredShading()
+ *
+ *  This method is used to choose between the two ways of
+ *  lighting the opaque objects - as they are drawn, or once
+ *  per pixel after they are all drawn into the G-buffer.
+ *  The blended objects are lit as they are drawn either way.
+ *  The G-buffer and the shader variants of the new path are
+ *  made here rather than in its first frame.  Returns true
+ *  when the choice changed.
+ ***********************************************************/
+bool SceneManager::SetDeferredShading(bool bEnabled)
+{
+	if (m_bDeferred == bEnabled)
+	{
+		return false;
+	}
+
+	if (bEnabled && (m_pDeferred->Initialize(m_pShaderManager) == false))
+	{
+		std::cout << "ERROR: deferred shading is not available, using forward shading" << std::endl;
+		return false;
+	}
+
+	m_bDeferred = bEnabled;
+	if (m_bScenePrepared)
+	{
+		PrepareShaderVariants();
+	}
+	return true;
+}
+
+/***********************************************************
+ *  CollectSceneCasters()
+ *
+ *  This method is used to add the draw of every scene file
+ *  object to the shadow casters, whether it is in view or
+ *  not.  Objects flagged as dynamic are drawn into the
+ *  shadow maps every frame, and the others are cached.
+ ***********************************************************/
+void SceneManager::CollectSceneCasters()
+{
+	for (size_t i = 0; i < m_sceneObjects.size(); i++)
+	{
+		int packetIndex = m_sceneObjectPackets[i];
+		if (packetIndex < 0)
+		{
+			continue;
+		}
+
+		if (m_sceneObjects[i].flags & SceneFile::OBJECT_DYNAMIC)
+		{
+			m_dynamicCasters.push_back(m_scenePackets[packetIndex]);
+		}
+		else
+		{
+			m_staticCasters.push_back(m_scenePackets[packetIndex]);
+		}
+	}
+}
+
+/***********************************************************
+ *  UpdateShadows()
+ *
+ *  This method is used to bring the shadow maps up to date
+ *  with the casters of the frame.  The built in objects
+ *  never move, so they are all static casters.  Drawing the
+ *  maps binds the light views in place of the camera, which
+ *  is bound again afterwards.
+ ***********************************************************/
+void SceneManager::UpdateShadows()
+{
+	if (m_bShadows && (m_sceneFilename.empty() == false))
+	{
+		CollectSceneCasters();
+	}
+
+	m_pShadows->Update(m_basicMeshes, m_pShaderManager, m_pLights, m_staticCasters, m_dynamicCasters);
+
+	const ShadowMaps::SHADOW_STATS& shadowStats = m_pShadows->GetStats();
+	m_renderStats.shadowUpdates = shadowStats.staticUpdates;
+	m_renderStats.shadowCasters = shadowStats.dynamicCasters;
+	if ((shadowStats.staticUpdates > 0) || (shadowStats.dynamicCasters > 0))
+	{
+		GLStateCache::BindBufferBase(GL_UNIFORM_BUFFER, FRAME_BLOCK_BINDING, m_frameBufferID);
+	}
+}
+
+/***********************************************************
+ *  PrepareShaderVariants()
+ *
+ *  This method is used to compile the shader variants the
+ *  objects of the scene are drawn with, in one batch, so
+ *  that no frame waits for a compile.  The built in objects
+ *  are walked with their draws turned into variants, and
+ *  the scene file objects already have their draws.
+ ***********************************************************/
+void SceneManager::PrepareShaderVariants()
+{
+	m_sceneVariants.clear();
+
+	if (m_sceneFilename.empty())
+	{
+		m_bCollectVariants = true;
+		ResetDrawPacket(m_drawPacket);
+		RenderBackdrop();
+		RenderTable();
+		RenderPhoneBox();
+		RenderWineBottle();
+		RenderGrapes();
+		m_bCollectVariants = false;
+	}
+	else
+	{
+		for (size_t i = 0; i < m_scenePackets.size(); i++)
+		{
+			AddPacketVariants(m_scenePackets[i]);
+		}
+	}
+
+	m_pShaderManager->PrepareVariants(m_sceneVariants);
+}
+
+/***********************************************************
+ *  AddPacketVariants()
+ *
+ *  This method is used to add the shader variants a draw is
+ *  made with to the ones of the scene - the variant that
+ *  lights it or fills the G-buffer with it, and the one
+ *  that draws it into the shadow maps.
+ ***********************************************************/
+void SceneManager::AddPacketVariants(const RenderQueue::DRAW_PACKET& packet)
+{
+	bool bOpaque = (packet.blendMode == RenderQueue::BLEND_OPAQUE);
+
+	int variants[2];
+	int variantCount = 0;
+	variants[variantCount++] = (m_bDeferred && bOpaque) ? (packet.variant | ShaderManager::FEATURE_GBUFFER) : packet.variant;
+	if (m_bShadows && bOpaque)
+	{
+		variants[variantCount++] = ShadowMaps::GetCasterVariant(packet.variant);
+	}
+
+	for (int i = 0; i < variantCount; i++)
+	{
+		if (std::find(m_sceneVariants.begin(), m_sceneVariants.end(), variants[i]) == m_sceneVariants.end())
+		{
+			m_sceneVariants.push_back(variants[i]);
+		}
+	}
+}
+
+/***********************************************************
+ *  RenderBackdrop()
+ *
+ *  This method is used for rendering the wall plane behind
+ *  the table.
+ ***********************************************************/
+void SceneManager::RenderBackdrop()
+{
+	GPUProfiler::CPUScope scope(m_pProfiler, "backdrop");
+
+	glm::vec3 scaleXYZ;
+	float XrotationDegrees = 0.0f;
+	float YrotationDegrees = 0.0f;
+	float ZrotationDegrees = 0.0f;
+	glm::vec3 positionXYZ;
+
+	/*** Set needed transformations before drawing the basic mesh ***/
+
+	// set the XYZ scale for the mesh
+	scaleXYZ = glm::vec3(20.0f, 1.0f, 20.0f);
+
+	// set the XYZ rotation for the mesh
+	XrotationDegrees = 90.0f;
+	YrotationDegrees = 0.0f;
+	ZrotationDegrees = 0.0f;
+
+	// set the XYZ position for the mesh
+	positionXYZ = glm::vec3(0.0f, 15.0f, -8.0f);
+
+	// set the transformations into memory to be used on the drawn meshes
+	SetTransformations(
+		scaleXYZ,
+		XrotationDegrees,
+		YrotationDegrees,
+		ZrotationDegrees,
+		positionXYZ);
+
+	// --- Render the backdrop ---
+	SetShaderTexture("drywall");  // Set the texture for the backdrop
+	SetTextureUVScale(1.0f, 1.0f);  // No UV scaling for the backdrop texture
+	SetShaderMaterial("metal");    // Use a default material for the backdrop
+
+	SubmitDraw(ShapeMeshes::MESH_PLANE);
+}
+
+/***********************************************************
+ *  RenderTable()
+ *
+ *  This method is used for rendering the wooden table top
+ *  that all the other objects are placed on.
+ ***********************************************************/
+void SceneManager::RenderTable()
+{
+	GPUProfiler::CPUScope scope(m_pProfiler, "table");
+
+	glm::vec3 scaleXYZ;
+	float XrotationDegrees = 0.0f;
+	float YrotationDegrees = 0.0f;
+	float ZrotationDegrees = 0.0f;
+	glm::vec3 positionXYZ;
+
+	// set the XYZ scale for the mesh
+	scaleXYZ = glm::vec3(20.0f, .6f, 8.0f);
+
+	// set the XYZ rotation for the mesh
+	XrotationDegrees = 0.0f;
+	YrotationDegrees = 0.0f;
+	ZrotationDegrees = 0.0f;
+
+	// set the XYZ position for the mesh
+	positionXYZ = glm::vec3(0.0f, -1.1f, -0.9f);
+
+	// set the transformations into memory to be used on the drawn meshes
+	SetTransformations(
+		scaleXYZ,
+		XrotationDegrees,
+		YrotationDegrees,
+		ZrotationDegrees,
+		positionXYZ);
+
+	//SetShaderColor(1, 1, 1, 1);
+	SetShaderTexture("plank");
+	SetTextureUVScale(1.0, 1.0);
+	SetShaderMaterial("wood");
+
+	// draw the mesh with transformation values - this plane is used for the base
+	SubmitDraw(ShapeMeshes::MESH_BOX);
+}
+
+/***********************************************************
+ *  RenderPhoneBox()
+ *
+ *  This method is used for rendering the iPhone box and the
+ *  objects stacked on and around it - the lid, the soda can
+ *  with its cone, and the orange.
+ ***********************************************************/
+void SceneManager::RenderPhoneBox()
+{
+	GPUProfiler::CPUScope scope(m_pProfiler, "phone box");
+
+	glm::vec3 scaleXYZ;
+	float XrotationDegrees = 0.0f;
+	float YrotationDegrees = 0.0f;
+	float ZrotationDegrees = 0.0f;
+
+	// --- Render the iPhone box (cube) --- 
+	SetShaderTexture("iphone");  // White color
+	SetTextureUVScale(1.0f, 1.0f); // No repetition
+	SetShaderMaterial("metal"); // Metal material for the iPhone box
+
+	// Scaling and position for the main iPhone box
+	scaleXYZ = glm::vec3(3.0f, 0.5f, 1.5f);  // Long and flat like a phone box
+	glm::vec3 positionBox(0.0f, -0.5f, 0.0f);  // Placed on the desk
+
+	// Tilt the box a little to the right (rotation around the Y-axis)
+	XrotationDegrees = 0.0f;
+	YrotationDegrees = 50.0f;  // Tilt to the right
+	ZrotationDegrees = 0.0f;
+
+	// Apply transformations and render the main box
+	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionBox);
+	SubmitDraw(ShapeMeshes::MESH_BOX);  // Render the box
+
+	// --- Render the skinny box on top of the main box --- 
+	SetShaderTexture("box");  // Use the same texture for the skinny box
+	SetTextureUVScale(1.0f, 1.0f); // No repetition
+	SetShaderMaterial("glass"); // Glass material for the skinny box
+
+	// Define the scale and position for the skinny box
+	scaleXYZ = glm::vec3(3.0f, 0.1f, 1.5f);  // Match the width and depth, but make it thin
+	glm::vec3 positionSkinnyBox = positionBox;  // Start at the main box's position
+
+	// Raise it higher above the main box
+	positionSkinnyBox.y += scaleXYZ.y + 0.12f;  // Adjust this value as needed for positioning
+
+	// Apply transformations for the skinny box
+	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionSkinnyBox);
+
+	// Render the skinny box
+	SubmitDraw(ShapeMeshes::MESH_BOX);
+
+	// --- Render the tapered cylinder (soda can) on top of the iPhone box --- 
+	SetShaderTexture("cone"); // Use the same texture; you can rename it later if needed
+	SetShaderMaterial("metal"); // Use metal material for the cylinder
+
+	scaleXYZ = glm::vec3(0.2f, 0.5f, 0.2f); // Base size (width) smaller
+	glm::vec3 positionCylinder = positionBox;  // Start at the box's position
+
+	// Move the cylinder on top of the box and adjust its position to the left and slightly forward
+	positionCylinder.y += 0.30f;  // Move it on top of the box
+	positionCylinder.x -= 0.50f;  // Move it slightly to the left from the center of the box
+	positionCylinder.z += 0.80f;  // Move it slightly forward
+
+	// Apply the transformations to the tapered cylinder
+	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionCylinder);
+
+	// Render the tapered cylinder
+	SubmitDraw(ShapeMeshes::MESH_CYLINDER);  // Ensure this function correctly draws a cylinder
+
+	// --- Render the cone on top of the tapered cylinder --- 
+	SetShaderTexture("mint"); // Use the same texture; you can rename it later if needed
+	SetShaderMaterial("cheese"); // Cheese material for the cone
+
+	scaleXYZ = glm::vec3(0.2f, 0.3f, 0.2f); // Adjust values as needed for the cone
+	glm::vec3 positionCone = positionCylinder; // Start at the cylinder's position
+
+	// Move the cone directly on top of the cylinder
+	positionCone.y += 0.50f;  // Move it up to sit on top of the cylinder (adjust as needed)
+
+	// Apply the transformations to the cone
+	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionCone);
+
+	// Render the cone
+	SubmitDraw(ShapeMeshes::MESH_CONE);  // Ensure this function correctly draws a cone
+
+	// --- Render the orange (sphere) behind the cone ---  
+	SetShaderTexture("ball"); // Fruit orange color
+	SetShaderMaterial("grape"); // Fruit grape material
+	scaleXYZ = glm::vec3(0.5f, 0.5f, 0.60f);   // Make it smaller like an orange
+	glm::vec3 positionOrange = positionBox;  // Start at the box's position
+
+	// Move the orange to the right of the box
+	positionOrange.y += 0.65f;  // Move it on top of the box
+	positionOrange.z -= 0.45f;  // Move it slightly behind the box
+	positionOrange.x += 0.30f;  // Move it to the right from the center of the box 
+
+	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionOrange);
+	SubmitDraw(ShapeMeshes::MESH_SPHERE);  // Render the orange
+}
+
+/***********************************************************
+ *  RenderWineBottle()
+ *
+ *  This method is used for rendering the Downy Unstopables
+ *  bottle and its cap to the left of the iPhone box.
+ ***********************************************************/
+void SceneManager::RenderWineBottle()
+{
+	GPUProfiler::CPUScope scope(m_pProfiler, "bottle");
+
+	glm::vec3 scaleXYZ;
+	// the bottle shares the Y rotation of the iPhone box
+	float XrotationDegrees = 0.0f;
+	float YrotationDegrees = 50.0f;
+	float ZrotationDegrees = 0.0f;
+
+	// --- Render the Downy Unstopables bottle (cylinder) to the left of the iPhone box ---  
+	SetShaderTexture("cylinder"); // washer beads texture
+	SetShaderMaterial("darkbread"); // Dark bread material for the bottle
+
+	// Adjust texture scaling to make it fit the cylinder smoothly
+	SetTextureUVScale(1.0f, 1.0f); // Set to 1.0f for no repetition and proper wrapping around the cylinder
+
+	// Scaling and position for the cylinder
+	scaleXYZ = glm::vec3(0.5f, 2.5f, 0.4f);   // Larger size for the bottle
+	glm::vec3 positionBottle(-3.0f, -0.8f, 0.0f);  // Move it to the left of the box
+
+	// Apply transformations and render the cylinder
+	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionBottle);
+	SubmitDraw(ShapeMeshes::MESH_CYLINDER); // Draw the Downy Unstopables bottle
+
+	// --- Render the tapered cylinder (top) on top of the Downy Unstopables bottle ---  
+	SetShaderTexture("top"); // Use the same texture or a different one for the top
+	SetShaderMaterial("darkbread"); // Use the same material or a different one for the top
+
+	// Scaling and position for the tapered cylinder (top)
+	scaleXYZ = glm::vec3(0.5f, 0.6f, 0.5f); // Adjust size for the top part (wider at the bottom)
+	glm::vec3 positionTop = positionBottle; // Start at the bottle's position
+
+	// Move the tapered cylinder on top of the bottle
+	positionTop.y += scaleXYZ.y + (scaleXYZ.y / 2.5f); // Move it above the cylinder by half its height
+	positionTop.y += 1.65f; // Additional height adjustment to raise the tapered cylinder higher
+	positionTop.x = positionBottle.x; // Keep it centered with respect to the bottle
+	positionTop.z = positionBottle.z; // Keep the same depth as the bottle
+
+	// Apply transformations and render the tapered cylinder
+	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionTop);
+	SubmitDraw(ShapeMeshes::MESH_TAPERED_CYLINDER); // Ensure you have a function to draw the tapered cylinder
+}
+
+/***********************************************************
+ *  RenderGrapes()
+ *
+ *  This method is used for rendering a bunch of grapes on
+ *  the table to the right of the iPhone box.  Every grape is
+ *  the same sphere, so the whole bunch is one instanced draw.
+ ***********************************************************/
+void SceneManager::RenderGrapes()
+{
+	GPUProfiler::CPUScope scope(m_pProfiler, "grapes");
+
+	// the bunch never moves, so its transforms are only built
+	// the first time it is rendered
+	if (m_grapeTransforms.empty())
+	{
+		const float grapeRadius = 0.12f;
+		// center of the bottom ring, resting on the table top
+		const glm::vec3 bunchBase(2.6f, -0.8f + grapeRadius, 0.9f);
+
+		// rings of grapes, narrowing towards the top of the bunch
+		const int ringCount = 5;
+		for (int ring = 0; ring < ringCount; ring++)
+		{
+			float ringRadius = 0.42f - ring * 0.09f;
+			int grapeCount = (int)(2.0f * glm::pi<float>() * ringRadius / (1.8f * grapeRadius));
+			if (grapeCount < 1)
+			{
+				grapeCount = 1;
+			}
+
+			for (int i = 0; i < grapeCount; i++)
+			{
+				// every other ring is turned by half a grape so the
+				// grapes sit in the gaps of the ring below
+				float angle = 2.0f * glm::pi<float>() * (i + 0.5f * (ring % 2)) / grapeCount;
+				glm::vec3 positionGrape = bunchBase + glm::vec3(
+					ringRadius * cosf(angle),
+					ring * 1.4f * grapeRadius,
+					ringRadius * sinf(angle));
+
+				m_grapeTransforms.push_back(glm::translate(positionGrape) * glm::scale(glm::vec3(grapeRadius)));
+			}
+		}
+	}
+
+	SetShaderColor(0.35f, 0.1f, 0.35f, 1.0f); // Dark purple grapes
+	SetTextureUVScale(1.0f, 1.0f);
+	SetShaderMaterial("grape");
+
+	SubmitInstances(ShapeMeshes::MESH_SPHERE, m_grapeTransforms);
+}
+
+/***********************************************************
+ *  SetProfiler()
+ *
+ *  This method is used for setting the profiler that times
+ *  the rendering of each object, or NULL for no profiling.
+ ***********************************************************/
+void SceneManager::SetProfiler(GPUProfiler* pProfiler)
+{
+	m_pProfiler = pProfiler;
+}
+
+/***********************************************************
+ *  SetAssetPack()
+ *
+ *  This method is used for setting the asset pack that the
+ *  meshes and textures are loaded from before the files, or
+ *  NULL to only use the files.  It must be called before
+ *  PrepareScene() and stay open until it returns.
+ ***********************************************************/
+void SceneManager::SetAssetPack(const AssetPack* pAssetPack)
+{
+	m_basicMeshes->SetAssetPack(pAssetPack);
+	m_pTextureLoader->SetAssetPack(pAssetPack);
+}
+
+/***********************************************************
+ *  SetVertexFormat()
+ *
+ *  This method is used for choosing how the vertices of the
+ *  meshes are stored.  It must be called before
+ *  PrepareScene() loads them.
+ ***********************************************************/
+void SceneManager::SetVertexFormat(ShapeMeshes::VERTEX_FORMAT format)
+{
+	m_basicMeshes->SetVertexFormat(format);
+}
+
+/***********************************************************
+ *  GetVertexBytes()
+ *
+ *  This method is used for getting the bytes of vertex
+ *  buffer the loaded meshes use.
+ ***********************************************************/
+GLsizeiptr SceneManager::GetVertexBytes() const
+{
+	return m_basicMeshes->GetVertexBytes();
+}
+
+/***********************************************************
+ *  GetSceneTextureFiles()
+ *
+ *  This method is used for getting the image files of all
+ *  the scene textures, so they can be packed offline.
+ ***********************************************************/
+void SceneManager::GetSceneTextureFiles(std::vector<std::string>& filenames)
+{
+	filenames.clear();
+	for (int i = 0; i < SCENE_TEXTURE_COUNT; i++)
+	{
+		filenames.push_back(SCENE_TEXTURES[i].filename);
+	}
+}
+
+/***********************************************************
+ *  SetCameraView()
+ *
+ *  This method is used for setting the view and projection
+ *  matrices of the next rendered frame, which the lights
+ *  are binned against.
+ ***********************************************************/
+void SceneManager::SetCameraView(const glm::mat4& view, const glm::mat4& projection)
+{
+	m_viewMatrix = view;
+	m_projectionMatrix = projection;
+}
+
+/***********************************************************
+ *  GetRenderStats()
+ *
+ *  This method is used for getting the counters collected
+ *  while rendering the most recent frame.
+ ***********************************************************/
+const SceneManager::RENDER_STATS& SceneManager::GetRenderStats() const
+{
+	return(m_renderStats);
+}
@@ -1,125 +1,376 @@
-///////////////////////////////////////////////////////////////////////////////
-// shadermanager.h
-// ============
-// manage the loading and rendering of 3D scenes
-//
-//  AUTHOR: Brian Battersby - SNHU Instructor / Computer Science
-//	Created for CS-330-Computational Graphics and Visualization, Nov. 1st, 2023
-///////////////////////////////////////////////////////////////////////////////
-
-#pragma once
-
-#include "ShaderManager.h"
-#include "ShapeMeshes.h"
-
-#include <string>
-#include <vector>
-
-/***********************************************************
- *  SceneManager
- *
- *  This class contains the code for preparing and rendering
- *  3D scenes, including the shader settings.
- ***********************************************************/
-class SceneManager
-{
-public:
-	// constructor
-	SceneManager(ShaderManager* pShaderManager);
-	// destructor
-	~SceneManager();
-
-	// properties for loaded texture access
-	struct TEXTURE_INFO
-	{
-		std::string tag;
-		uint32_t ID;
-	};
-
-	// properties for object materials
-	struct OBJECT_MATERIAL
-	{
-		float ambientStrength;
-		glm::vec3 ambientColor;
-		glm::vec3 diffuseColor;
-		glm::vec3 specularColor;
-		float shininess;
-		std::string tag;
-	};
-
-private:
-	// pointer to shader manager object
-	ShaderManager* m_pShaderManager;
-	// pointer to basic shapes object
-	ShapeMeshes* m_basicMeshes;
-	// total number of loaded textures
-	int m_loadedTextures;
-	// loaded textures info
-	TEXTURE_INFO m_textureIDs[16];
-	// defined object materials
-	std::vector<OBJECT_MATERIAL> m_objectMaterials;
-
-	// load texture images and convert to OpenGL texture data
-	bool CreateGLTexture(const char* filename, std::string tag);
-	// bind loaded OpenGL textures to slots in memory
-	void BindGLTextures();
-	// free the loaded OpenGL textures
-	void DestroyGLTextures();
-	// find a loaded texture by tag
-	int FindTextureID(std::string tag);
-	int FindTextureSlot(std::string tag);
-	// find a defined material by tag
-	bool FindMaterial(std::string tag, OBJECT_MATERIAL& material);
-
-	// set the transformation values 
-	// into the transform buffer
-	void SetTransformations(
-		glm::vec3 scaleXYZ,
-		float XrotationDegrees,
-		float YrotationDegrees,
-		float ZrotationDegrees,
-		glm::vec3 positionXYZ);
-
-	// set the color values into the shader
-	void SetShaderColor(
-		float redColorValue,
-		float greenColorValue,
-		float blueColorValue,
-		float alphaValue);
-
-	// set the texture data into the shader
-	void SetShaderTexture(
-		std::string textureTag);
-
-	// set the UV scale for the texture mapping
-	void SetTextureUVScale(
-		float u, float v);
-
-	// set the object material into the shader
-	void SetShaderMaterial(
-		std::string materialTag);
-
-public:
-
-	// prepare the 3D scene for rendering
-	void PrepareScene();
-	// render the objects in the 3D scene
-	void RenderScene();
-
-	// load all of the needed textures before rendering
-	void LoadSceneTextures();
-	// define all the object materials before rendering
-	void DefineObjectMaterials();
-	// add and define the light sources before rendering
-	void SetupSceneLights();
-
-	// methods for rendering the various objects in the 3D scene
-	void RenderTable();
-	void RenderBackdrop();
-	void RenderCheeseWheel();
-	void RenderBreadLoaf();
-	void RenderWineGlass();
-	void RenderWineBottle();
-	void RenderGrapes();
-	void RenderPlateAndKnife();
+///////////////////////////////////////////////////////////////////////////////
+// shadermanager.h
+// ============
+// manage the loading and rendering of 3D scenes
+//
+//  AUTHOR: Brian Battersby - SNHU Instructor / Computer Science
+//	Created for CS-330-Computational Graphics and Visualization, Nov. 1st, 2023
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+#include "ShapeMeshes.h"
+#include "GPUProfiler.h"
+#include "ClusteredLights.h"
+#include "TextureArrays.h"
+#include "TextureLoader.h"
+#include "AssetPack.h"
+#include "RenderQueue.h"
+#include "SceneFile.h"
+#include "TransformHierarchy.h"
+#include "BoundingVolumeHierarchy.h"
+#include "OcclusionBuffer.h"
+#include "ShadowMaps.h"
+#include "DeferredShading.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/***********************************************************
+ *  SceneManager
+ *
+ *  This class contains the code for preparing and rendering
+ *  3D scenes, including the shader settings.
+ ***********************************************************/
+class SceneManager
+{
+public:
+	// constructor
+	SceneManager(ShaderManager* pShaderManager);
+	// destructor
+	~SceneManager();
+
+	// properties for object materials
+	struct OBJECT_MATERIAL
+	{
+		float ambientStrength;
+		glm::vec3 ambientColor;
+		glm::vec3 diffuseColor;
+		glm::vec3 specularColor;
+		float shininess;
+		std::string tag;
+	};
+
+	// layout of one material in the std140 material block of
+	// the fragment shader - the scalars are packed into the
+	// fourth component of the colors
+	struct GPU_MATERIAL
+	{
+		glm::vec4 ambientColor;		// rgb + ambientStrength
+		glm::vec4 diffuseColor;		// rgb + unused
+		glm::vec4 specularColor;	// rgb + shininess
+	};
+
+	// layout of the std140 frame block that every variant of
+	// the shader program reads the values of the frame from
+	struct FRAME_UNIFORMS
+	{
+		glm::mat4 view;
+		glm::mat4 projection;
+		glm::vec4 viewPosition;			// xyz + unused
+		glm::vec4 clusterParameters;
+	};
+
+	// counters collected while rendering one frame
+	struct RENDER_STATS
+	{
+		int drawCalls;
+		// indirect commands executed by the draw calls, and the
+		// meshes they drew
+		int drawCommands;
+		int instances;
+		// vertex array, shader variant and blend changes sent by
+		// the render queue
+		int stateChanges;
+		// OpenGL state calls sent and skipped by the state cache
+		int stateCalls;
+		int elidedStateCalls;
+		int uniformLookups;
+		// light references in all the light cluster lists
+		int clusterLights;
+		// scene object world matrices recomputed this frame
+		int transformUpdates;
+		// objects inside and outside of the view frustum
+		int visibleObjects;
+		int culledObjects;
+		// objects inside the frustum hidden behind the occluders
+		int occludedObjects;
+		// drawn objects using a coarser level of detail
+		int reducedDetailObjects;
+		// 1 when the cached shadows of the static objects were
+		// drawn again, and the dynamic objects drawn into the
+		// shadow maps
+		int shadowUpdates;
+		int shadowCasters;
+	};
+
+private:
+	// pointer to shader manager object
+	ShaderManager* m_pShaderManager;
+	// pointer to basic shapes object
+	ShapeMeshes* m_basicMeshes;
+	// pointer to the optional profiler object
+	GPUProfiler* m_pProfiler;
+	// loaded textures, packed into texture arrays
+	TextureArrays* m_pTextures;
+	// loader that decodes the texture files in parallel
+	TextureLoader* m_pTextureLoader;
+	// defined object materials
+	std::vector<OBJECT_MATERIAL> m_objectMaterials;
+	// index of every defined material by its tag
+	std::unordered_map<std::string, int> m_materialIndices;
+	// uniform buffer holding the whole material table
+	GLuint m_materialBufferID;
+	// uniform buffer holding the values of the frame
+	GLuint m_frameBufferID;
+	// range of materials changed since the last upload, the
+	// first index is larger than the last when nothing changed
+	int m_firstDirtyMaterial;
+	int m_lastDirtyMaterial;
+	// counters for the most recently rendered frame
+	RENDER_STATS m_renderStats;
+	// point lights of the scene, binned per frame
+	ClusteredLights* m_pLights;
+	// camera matrices of the frame being rendered
+	glm::mat4 m_viewMatrix;
+	glm::mat4 m_projectionMatrix;
+	// queue the draws of a frame are sorted and submitted by
+	RenderQueue* m_pRenderQueue;
+	// the draw being built by the Set methods below, copied
+	// into the queue by SubmitDraw()
+	RenderQueue::DRAW_PACKET m_drawPacket;
+
+	// model matrices of the grapes in the cluster, built once
+	// since the cluster never moves
+	std::vector<glm::mat4> m_grapeTransforms;
+
+	// the loaded scene file and when it was last changed
+	std::string m_sceneFilename;
+	long long m_sceneModifiedTime;
+	// copies of the objects and lights of the scene file, kept
+	// to find what changed when it is loaded again
+	std::vector<SceneFile::SCENE_OBJECT> m_sceneObjects;
+	std::vector<ClusteredLights::POINT_LIGHT> m_sceneLights;
+	// the transforms of the scene objects, one node for each
+	TransformHierarchy* m_pSceneTransforms;
+	// the draws made from the scene objects, and the draw of
+	// every object, or -1 for groups that draw nothing
+	std::vector<RenderQueue::DRAW_PACKET> m_scenePackets;
+	std::vector<int> m_sceneObjectPackets;
+	// the camera of the scene file, and whether it changed
+	// since it was last taken
+	SceneFile::SCENE_CAMERA m_sceneCamera;
+	bool m_bSceneCameraChanged;
+	// number of lights added by AddScatteredLights()
+	int m_scatteredLightCount;
+	// tree over the world bounds of the scene file draws, which
+	// is built again when the draws were added or changed
+	BoundingVolumeHierarchy* m_pSceneBounds;
+	bool m_bSceneBoundsDirty;
+	std::vector<int> m_visiblePackets;
+	// view frustum of the frame being rendered
+	BoundingVolumeHierarchy::FRUSTUM m_frustum;
+	// depth buffer the large occluders of a frame are drawn
+	// into on the CPU, and whether it is used
+	OcclusionBuffer* m_pOcclusion;
+	bool m_bOcclusionCulling;
+	// view projection and viewport height of the frame being
+	// rendered, for measuring objects on screen
+	glm::mat4 m_viewProjectionMatrix;
+	float m_viewportHeight;
+	// whether small objects use coarser levels of detail, and
+	// the level every built in draw used in the last frame, in
+	// the order they are submitted
+	bool m_bDetailLevels;
+	std::vector<int> m_drawLevels;
+	int m_drawLevelCount;
+	// the model matrices of the built in instances that are
+	// inside the view frustum, split by level of detail
+	std::vector<glm::mat4> m_levelTransforms[ShapeMeshes::LOD_COUNT];
+	// shadow maps of the lights, whether they are used, and the
+	// draws of the frame that cast shadows - every one, inside
+	// the view or not, split by whether it is expected to move
+	ShadowMaps* m_pShadows;
+	bool m_bShadows;
+	std::vector<RenderQueue::DRAW_PACKET> m_staticCasters;
+	std::vector<RenderQueue::DRAW_PACKET> m_dynamicCasters;
+	// G-buffer of the deferred path, and whether the opaque
+	// objects are drawn with it instead of lit as they are drawn
+	DeferredShading* m_pDeferred;
+	bool m_bDeferred;
+	// the shader variants the scene is drawn with, and whether
+	// the built in objects only add theirs instead of a draw
+	std::vector<int> m_sceneVariants;
+	bool m_bCollectVariants;
+	// whether PrepareScene() was called, so the objects can be
+	// walked for their variants
+	bool m_bScenePrepared;
+
+	// add a texture image file to be loaded with the others
+	bool CreateGLTexture(const char* filename, std::string tag);
+	// load the added textures into arrays and bind them to
+	// texture units
+	void BindGLTextures();
+	// free the loaded OpenGL textures
+	void DestroyGLTextures();
+	// find the index of a defined material by tag
+	int FindMaterialIndex(const std::string& tag) const;
+	// mark a range of materials as changed
+	void MarkMaterialsDirty(int firstIndex, int lastIndex);
+	// upload the changed materials into the material buffer
+	void UploadMaterials();
+	// upload the camera and light cluster values of the frame
+	// into the frame buffer
+	void UploadFrameUniforms();
+	// copy the objects, lights and camera of a mapped scene
+	// file that differ from the loaded ones, and return the
+	// number of changed objects
+	int ApplySceneFile(const SceneFile& sceneFile);
+	// make the draw of one object of a scene file
+	void ResolveSceneObject(const SceneFile::SCENE_OBJECT& object, RenderQueue::DRAW_PACKET& packet);
+	// bring the world matrices of moved scene objects and
+	// their children up to date in their draws
+	void UpdateSceneTransforms();
+	// the world space box around the mesh of a draw
+	BoundingVolumeHierarchy::BOUNDING_BOX GetPacketBounds(const RenderQueue::DRAW_PACKET& packet) const;
+	// check whether the mesh of a draw is inside the frustum
+	bool IsPacketVisible(ShapeMeshes::MESH_TYPE mesh, const glm::mat4& model) const;
+	// add the scene file draws inside the frustum to the queue
+	void SubmitVisibleScenePackets();
+	// check whether a draw is large enough to hide others
+	bool IsOccluder(const RenderQueue::DRAW_PACKET& packet) const;
+	// draw an occluder into the occlusion buffer, or check
+	// whether a draw is hidden behind the ones drawn so far
+	void RasterizeOccluder(ShapeMeshes::MESH_TYPE mesh, const glm::mat4& model);
+	bool IsPacketOccluded(ShapeMeshes::MESH_TYPE mesh, const glm::mat4& model) const;
+	// pick the level of detail of a mesh from its size on
+	// screen, starting from the level it used last frame
+	int SelectDetailLevel(ShapeMeshes::MESH_TYPE mesh, const glm::mat4& model, int currentLevel) const;
+	// the level the next built in draw used last frame, to be
+	// replaced with the level it uses in this one
+	int& NextDrawLevel();
+	// add the scene file draws to the shadow casters
+	void CollectSceneCasters();
+	// bring the shadow maps up to date with the casters
+	void UpdateShadows();
+	// compile the shader variants of every object, in every
+	// pass that is turned on, before a frame needs them
+	void PrepareShaderVariants();
+	// add the variants a draw is made with to the scene's
+	void AddPacketVariants(const RenderQueue::DRAW_PACKET& packet);
+
+	// set the transformation values 
+	// into the next draw
+	void SetTransformations(
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ);
+
+	// set the color values into the next draw
+	void SetShaderColor(
+		float redColorValue,
+		float greenColorValue,
+		float blueColorValue,
+		float alphaValue);
+
+	// set the texture into the next draw
+	void SetShaderTexture(
+		std::string textureTag);
+
+	// set the UV scale for the texture mapping
+	void SetTextureUVScale(
+		float u, float v);
+
+	// select the object material of the next draw
+	void SetShaderMaterial(
+		const std::string& materialTag);
+	void SetShaderMaterial(
+		int materialIndex);
+
+	// light the next draw, or draw its plain color or texture
+	void SetShaderLighting(
+		bool bLighting);
+	// cut out the see-through parts of the next draw
+	void SetShaderAlphaTest(
+		bool bAlphaTest);
+
+	// add the next draw of a mesh to the render queue
+	void SubmitDraw(
+		ShapeMeshes::MESH_TYPE mesh);
+	// add a copy of the next draw of a mesh for every passed
+	// in model matrix - they are drawn with one instanced call
+	void SubmitInstances(
+		ShapeMeshes::MESH_TYPE mesh,
+		const std::vector<glm::mat4>& transforms);
+
+public:
+
+	// prepare the 3D scene for rendering
+	void PrepareScene();
+	// render the objects in the 3D scene
+	void RenderScene();
+	// get the counters for the most recently rendered frame
+	const RENDER_STATS& GetRenderStats() const;
+	// set the profiler used for timing the rendered objects
+	void SetProfiler(GPUProfiler* pProfiler);
+	// skip the objects hidden behind the large occluders
+	void SetOcclusionCulling(bool bEnabled);
+	// draw small objects with coarser levels of detail
+	void SetDetailLevels(bool bEnabled);
+	// let the main lights cast shadows
+	void SetShadows(bool bEnabled);
+	// light the opaque objects once per pixel from a G-buffer,
+	// or as they are drawn - returns true when that changed
+	bool SetDeferredShading(bool bEnabled);
+	// set the camera matrices used for the next rendered frame
+	void SetCameraView(const glm::mat4& view, const glm::mat4& projection);
+	// load the meshes and textures from an asset pack when it
+	// has them - call before PrepareScene()
+	void SetAssetPack(const AssetPack* pAssetPack);
+	// choose how the mesh vertices are stored - must be called
+	// before PrepareScene()
+	void SetVertexFormat(ShapeMeshes::VERTEX_FORMAT format);
+	// bytes of vertex buffer used by the loaded meshes
+	GLsizeiptr GetVertexBytes() const;
+	// get the image files of the scene textures for packing
+	static void GetSceneTextureFiles(std::vector<std::string>& filenames);
+
+	// load all of the needed textures before rendering
+	void LoadSceneTextures();
+	// define all the object materials before rendering
+	void DefineObjectMaterials();
+	// add a material, or replace the one with the same tag -
+	// only the changed entry is uploaded before the next frame
+	int UpdateMaterial(const OBJECT_MATERIAL& material);
+	// add and define the light sources before rendering
+	void SetupSceneLights();
+	// add small colored point lights around the table, used
+	// for measuring how the lighting scales
+	void AddScatteredLights(int count);
+
+	// load the objects, lights and camera of a scene file and
+	// draw them in place of the built in objects - call after
+	// PrepareScene()
+	bool LoadSceneFile(const std::string& filename);
+	// load the scene file again if it changed since it was
+	// loaded, returns true when it was reloaded
+	bool ReloadChangedSceneFile();
+	// get the camera of the scene file, only returns true the
+	// first time after it was loaded or changed
+	bool GetChangedSceneCamera(SceneFile::SCENE_CAMERA& camera);
+
+	// methods for rendering the various objects in the 3D scene
+	void RenderTable();
+	void RenderBackdrop();
+	void RenderCheeseWheel();
+	void RenderBreadLoaf();
+	void RenderWineGlass();
+	void RenderWineBottle();
+	void RenderGrapes();
+	void RenderPlateAndKnife();
+	void RenderPhoneBox();
 };
\ No newline at end of file
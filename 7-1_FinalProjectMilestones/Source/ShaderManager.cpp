@@ -0,0 +1,916 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadermanager.cpp
+// ============
+// load the shader programs and manage the values of their uniforms
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ShaderManager.h"
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+// declare the global variables
+namespace
+{
+	// 64-bit FNV-1a constants for the program cache keys
+	const uint64_t FNV_OFFSET_BASIS = 0xCBF29CE484222325ULL;
+	const uint64_t FNV_PRIME = 0x100000001B3ULL;
+
+	// identifies a program cache file, and the version of its
+	// layout
+	const uint32_t PROGRAM_CACHE_MAGIC = 0x42505343;	// "CSPB"
+	const uint32_t PROGRAM_CACHE_VERSION = 1;
+
+	// the start of a program cache file, followed by the
+	// driver's program binary
+	struct PROGRAM_CACHE_HEADER
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint64_t key;
+		uint32_t binaryFormat;
+		uint32_t binaryLength;
+	};
+}
+
+/***********************************************************
+ *  ShaderManager()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ShaderManager::ShaderManager()
+{
+	m_programID = 0;
+	m_uniformLookups = 0;
+	m_loadStats = LOAD_STATS();
+	for (int i = 0; i < VARIANT_COUNT; i++)
+	{
+		m_variants[i] = 0;
+	}
+}
+
+/***********************************************************
+ *  ~ShaderManager()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ShaderManager::~ShaderManager()
+{
+	DeleteVariants();
+}
+
+/***********************************************************
+ *  ReadShaderFile()
+ *
+ *  This method is used to read the full text of a shader
+ *  source file.
+ ***********************************************************/
+bool ShaderManager::ReadShaderFile(const char* filename, std::string& source)
+{
+	std::ifstream file(filename);
+	if (!file)
+	{
+		std::cout << "ERROR: could not open shader file:" << filename << std::endl;
+		return false;
+	}
+
+	std::stringstream buffer;
+	buffer << file.rdbuf();
+	source = buffer.str();
+
+	return true;
+}
+
+/***********************************************************
+ *  CompileShader()
+ *
+ *  This method is used to start compiling one shader stage.
+ *  The defines go right after the #version line, which has
+ *  to stay first.  The status is not asked for here, so a
+ *  driver with parallel shader compilation keeps compiling
+ *  in the background while the next stages are handed to it.
+ ***********************************************************/
+GLuint ShaderManager::CompileShader(GLenum shaderType, const char* source, GLint length, const std::string& defines)
+{
+	GLuint shaderID = glCreateShader(shaderType);
+
+	// split the source after the #version line, if it has one -
+	// only comments can come before it
+	GLint versionLength = 0;
+	for (GLint lineStart = 0; lineStart < length; )
+	{
+		const char* lineEnd = (const char*)memchr(source + lineStart, '\n', length - lineStart);
+		GLint nextLine = (lineEnd != NULL) ? (GLint)(lineEnd - source + 1) : length;
+		if ((length - lineStart >= 8) && (strncmp(source + lineStart, "#version", 8) == 0))
+		{
+			versionLength = nextLine;
+			break;
+		}
+		lineStart = nextLine;
+	}
+
+	const GLchar* parts[3] = { source, defines.c_str(), source + versionLength };
+	GLint lengths[3] = { versionLength, (GLint)defines.size(), length - versionLength };
+	glShaderSource(shaderID, 3, parts, lengths);
+	glCompileShader(shaderID);
+
+	return shaderID;
+}
+
+/***********************************************************
+ *  CheckShader()
+ *
+ *  This method is used to check that a shader stage was
+ *  compiled, and to display the compiler output if not.
+ ***********************************************************/
+bool ShaderManager::CheckShader(GLuint shaderID, const char* stageName)
+{
+	GLint bSuccess = GL_FALSE;
+	glGetShaderiv(shaderID, GL_COMPILE_STATUS, &bSuccess);
+	if (bSuccess == GL_FALSE)
+	{
+		GLint logLength = 0;
+		glGetShaderiv(shaderID, GL_INFO_LOG_LENGTH, &logLength);
+		std::vector<char> log(logLength + 1, '\0');
+		glGetShaderInfoLog(shaderID, logLength, NULL, log.data());
+		std::cout << "ERROR: shader compilation failed:" << stageName << "\n" << log.data() << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+/***********************************************************
+ *  LoadShaders()
+ *
+ *  This method is used to load, compile and link the vertex
+ *  and fragment shader files into the shader program, and to
+ *  resolve the locations of all its active uniforms.
+ ***********************************************************/
+GLuint ShaderManager::LoadShaders(const char* vertexShaderFile, const char* fragmentShaderFile)
+{
+	std::string vertexSource;
+	std::string fragmentSource;
+
+	if ((ReadShaderFile(vertexShaderFile, vertexSource) == false) ||
+		(ReadShaderFile(fragmentShaderFile, fragmentSource) == false))
+	{
+		return 0;
+	}
+
+	return LoadShaderSources(vertexSource.c_str(), (GLint)vertexSource.size(),
+		fragmentSource.c_str(), (GLint)fragmentSource.size());
+}
+
+/***********************************************************
+ *  LoadShaderSources()
+ *
+ *  This method is used to compile and link shader code that
+ *  is already in memory, such as the sources mapped from the
+ *  asset pack, which are not null terminated.  The sources
+ *  are copied for compiling the variants later on, and the
+ *  default variant becomes the shader program, replacing
+ *  the current one and all of its variants.
+ ***********************************************************/
+GLuint ShaderManager::LoadShaderSources(
+	const char* vertexSource, GLint vertexLength,
+	const char* fragmentSource, GLint fragmentLength)
+{
+	DeleteVariants();
+	m_vertexSource.assign(vertexSource, vertexLength);
+	m_fragmentSource.assign(fragmentSource, fragmentLength);
+
+	std::vector<PROGRAM_SOURCES> sources(1);
+	GetVariantSources(DEFAULT_FEATURES, sources[0]);
+
+	std::vector<GLuint> programs;
+	if (LoadPrograms(sources, programs) == false)
+	{
+		return 0;
+	}
+
+	m_variants[DEFAULT_FEATURES] = programs[0];
+	SetProgram(programs[0]);
+	return m_programID;
+}
+
+/***********************************************************
+ *  LoadPrograms()
+ *
+ *  This method is used to load a list of shader programs.
+ *  Programs found in the cache are loaded from their driver
+ *  binaries without compiling anything.  The stages of all
+ *  of the others are handed to the driver before any result
+ *  is asked for, and each program is linked as soon as both
+ *  of its stages are done, so a driver that compiles in
+ *  parallel works on all of them at once.  Every program
+ *  that was compiled is then saved into the cache.
+ ***********************************************************/
+bool ShaderManager::LoadPrograms(const std::vector<PROGRAM_SOURCES>& sources, std::vector<GLuint>& programs)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	m_loadStats = LOAD_STATS();
+	programs.assign(sources.size(), 0);
+
+	// the driver is part of the key, since a binary only loads
+	// into the driver that made it
+	std::string driver;
+	driver += (const char*)glGetString(GL_VENDOR);
+	driver += (const char*)glGetString(GL_RENDERER);
+	driver += (const char*)glGetString(GL_VERSION);
+
+	std::vector<uint64_t> keys(sources.size());
+	for (size_t i = 0; i < sources.size(); i++)
+	{
+		keys[i] = HashProgram(sources[i], driver);
+		programs[i] = LoadCachedProgram(keys[i]);
+		if (programs[i] != 0)
+		{
+			m_loadStats.cachedPrograms++;
+		}
+	}
+
+	// a program that is still being compiled - the stages are
+	// 0 once it has been linked
+	struct PENDING_PROGRAM
+	{
+		size_t index;
+		GLuint vertexShaderID;
+		GLuint fragmentShaderID;
+	};
+	std::vector<PENDING_PROGRAM> pending;
+
+	bool bParallel = GLEW_KHR_parallel_shader_compile;
+	if (bParallel && (sources.size() > (size_t)m_loadStats.cachedPrograms))
+	{
+		// let the driver use as many threads as it wants
+		glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+	}
+
+	for (size_t i = 0; i < sources.size(); i++)
+	{
+		if (programs[i] == 0)
+		{
+			PENDING_PROGRAM program;
+			program.index = i;
+			program.vertexShaderID = CompileShader(GL_VERTEX_SHADER, sources[i].vertexSource,
+				sources[i].vertexLength, sources[i].defines);
+			program.fragmentShaderID = CompileShader(GL_FRAGMENT_SHADER, sources[i].fragmentSource,
+				sources[i].fragmentLength, sources[i].defines);
+			pending.push_back(program);
+		}
+	}
+
+	// link the programs in the order their stages finish - when
+	// the driver compiles on the calling thread they are simply
+	// linked in order
+	size_t linkedCount = 0;
+	while (linkedCount < pending.size())
+	{
+		for (size_t i = 0; i < pending.size(); i++)
+		{
+			PENDING_PROGRAM& program = pending[i];
+			if (program.vertexShaderID == 0)
+			{
+				continue;
+			}
+
+			if (bParallel)
+			{
+				GLint bVertexDone = GL_FALSE;
+				GLint bFragmentDone = GL_FALSE;
+				glGetShaderiv(program.vertexShaderID, GL_COMPLETION_STATUS_KHR, &bVertexDone);
+				glGetShaderiv(program.fragmentShaderID, GL_COMPLETION_STATUS_KHR, &bFragmentDone);
+				if ((bVertexDone == GL_FALSE) || (bFragmentDone == GL_FALSE))
+				{
+					continue;
+				}
+			}
+
+			programs[program.index] = LinkProgram(program.vertexShaderID, program.fragmentShaderID);
+			program.vertexShaderID = 0;
+			program.fragmentShaderID = 0;
+			linkedCount++;
+		}
+
+		if (linkedCount < pending.size())
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	// the links also run in the background, so their results
+	// are only asked for once all of them were started
+	for (size_t i = 0; i < pending.size(); i++)
+	{
+		GLuint& programID = programs[pending[i].index];
+		if ((programID != 0) && (CheckProgram(programID) == false))
+		{
+			GLStateCache::DeleteProgram(programID);
+			programID = 0;
+		}
+
+		if (programID != 0)
+		{
+			SaveCachedProgram(keys[pending[i].index], programID);
+			m_loadStats.compiledPrograms++;
+		}
+		else
+		{
+			m_loadStats.failedPrograms++;
+		}
+	}
+
+	m_loadStats.milliseconds = std::chrono::duration<double, std::milli>(
+		std::chrono::steady_clock::now() - start).count();
+	std::cout << "INFO: Loaded " << sources.size() << " shader programs in " << m_loadStats.milliseconds
+		<< " ms - " << m_loadStats.cachedPrograms << " from the cache, " << m_loadStats.compiledPrograms
+		<< " compiled" << std::endl;
+
+	return (m_loadStats.failedPrograms == 0);
+}
+
+/***********************************************************
+ *  LinkProgram()
+ *
+ *  This method is used to start linking the compiled vertex
+ *  and fragment shaders into a program.  The shader objects
+ *  are deleted either way, and 0 is returned when either of
+ *  them did not compile.
+ ***********************************************************/
+GLuint ShaderManager::LinkProgram(GLuint vertexShaderID, GLuint fragmentShaderID)
+{
+	bool bVertexCompiled = CheckShader(vertexShaderID, "vertex shader");
+	bool bFragmentCompiled = CheckShader(fragmentShaderID, "fragment shader");
+	if ((bVertexCompiled == false) || (bFragmentCompiled == false))
+	{
+		glDeleteShader(vertexShaderID);
+		glDeleteShader(fragmentShaderID);
+		return 0;
+	}
+
+	GLuint programID = glCreateProgram();
+	if (m_cacheDirectory.empty() == false)
+	{
+		glProgramParameteri(programID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
+	glAttachShader(programID, vertexShaderID);
+	glAttachShader(programID, fragmentShaderID);
+	glLinkProgram(programID);
+
+	// the shader objects are no longer needed once linked
+	glDetachShader(programID, vertexShaderID);
+	glDetachShader(programID, fragmentShaderID);
+	glDeleteShader(vertexShaderID);
+	glDeleteShader(fragmentShaderID);
+
+	return programID;
+}
+
+/***********************************************************
+ *  CheckProgram()
+ *
+ *  This method is used to check that a program was linked,
+ *  and to display the linker output if not.
+ ***********************************************************/
+bool ShaderManager::CheckProgram(GLuint programID)
+{
+	GLint bSuccess = GL_FALSE;
+	glGetProgramiv(programID, GL_LINK_STATUS, &bSuccess);
+	if (bSuccess == GL_FALSE)
+	{
+		GLint logLength = 0;
+		glGetProgramiv(programID, GL_INFO_LOG_LENGTH, &logLength);
+		std::vector<char> log(logLength + 1, '\0');
+		glGetProgramInfoLog(programID, logLength, NULL, log.data());
+		std::cout << "ERROR: shader program linking failed\n" << log.data() << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+/***********************************************************
+ *  SetProgram()
+ *
+ *  This method is used to make a loaded program the shader
+ *  program and to resolve the locations of all its active
+ *  uniforms.
+ ***********************************************************/
+void ShaderManager::SetProgram(GLuint programID)
+{
+	m_programID = programID;
+
+	ResolveUniforms();
+}
+
+/***********************************************************
+ *  GetVariant()
+ *
+ *  This method is used to get the variant of the shader
+ *  program compiled for a combination of features.  After
+ *  the first call for a combination this is a table lookup.
+ *  A variant that was not prepared ahead of time is
+ *  compiled on its own by the first call.
+ ***********************************************************/
+GLuint ShaderManager::GetVariant(int features)
+{
+	features &= (VARIANT_COUNT - 1);
+	if (m_variants[features] == 0)
+	{
+		PrepareVariants(std::vector<int>(1, features));
+	}
+	return m_variants[features];
+}
+
+/***********************************************************
+ *  PrepareVariants()
+ *
+ *  This method is used to compile the variants of a list of
+ *  feature combinations that are not in the table yet, or
+ *  to load them from the program cache.  They are all given
+ *  to LoadPrograms() together, so a driver that compiles in
+ *  parallel works on all of them at once.  A variant that
+ *  fails to compile uses the shader program in its place so
+ *  it is only tried once.
+ ***********************************************************/
+void ShaderManager::PrepareVariants(const std::vector<int>& features)
+{
+	if (m_programID == 0)
+	{
+		return;
+	}
+
+	std::vector<int> missing;
+	for (size_t i = 0; i < features.size(); i++)
+	{
+		int variant = features[i] & (VARIANT_COUNT - 1);
+		if ((m_variants[variant] == 0) &&
+			(std::find(missing.begin(), missing.end(), variant) == missing.end()))
+		{
+			missing.push_back(variant);
+		}
+	}
+	if (missing.empty())
+	{
+		return;
+	}
+
+	std::vector<PROGRAM_SOURCES> sources(missing.size());
+	for (size_t i = 0; i < missing.size(); i++)
+	{
+		GetVariantSources(missing[i], sources[i]);
+	}
+
+	std::vector<GLuint> programs;
+	LoadPrograms(sources, programs);
+	for (size_t i = 0; i < missing.size(); i++)
+	{
+		if (programs[i] == 0)
+		{
+			std::cout << "ERROR: shader variant failed, using the shader program in its place:" << sources[i].defines << std::endl;
+			programs[i] = m_programID;
+		}
+		m_variants[missing[i]] = programs[i];
+	}
+}
+
+/***********************************************************
+ *  GetVariantCount()
+ *
+ *  This method is used to get the number of variants of the
+ *  shader program that have been compiled so far.
+ ***********************************************************/
+int ShaderManager::GetVariantCount() const
+{
+	int count = 0;
+	for (int i = 0; i < VARIANT_COUNT; i++)
+	{
+		if ((m_variants[i] != 0) && ((m_variants[i] != m_programID) || (i == DEFAULT_FEATURES)))
+		{
+			count++;
+		}
+	}
+	return count;
+}
+
+/***********************************************************
+ *  GetVariantSources()
+ *
+ *  This method is used to get the sources of a variant of
+ *  the loaded shader program, with a #define line for every
+ *  feature it is compiled with.
+ ***********************************************************/
+void ShaderManager::GetVariantSources(int features, PROGRAM_SOURCES& sources) const
+{
+	sources.vertexSource = m_vertexSource.c_str();
+	sources.vertexLength = (GLint)m_vertexSource.size();
+	sources.fragmentSource = m_fragmentSource.c_str();
+	sources.fragmentLength = (GLint)m_fragmentSource.size();
+
+	sources.defines.clear();
+	if (features & FEATURE_TEXTURE)
+	{
+		sources.defines += "#define USE_TEXTURE\n";
+	}
+	if (features & FEATURE_LIGHTING)
+	{
+		sources.defines += "#define USE_LIGHTING\n";
+	}
+	if (features & FEATURE_ALPHA_TEST)
+	{
+		sources.defines += "#define USE_ALPHA_TEST\n";
+	}
+	if (features & FEATURE_SHADOW_DEPTH)
+	{
+		sources.defines += "#define USE_SHADOW_DEPTH\n";
+	}
+	if (features & FEATURE_GBUFFER)
+	{
+		sources.defines += "#define USE_GBUFFER\n";
+	}
+	if (features & FEATURE_DEFERRED_LIGHTING)
+	{
+		sources.defines += "#define USE_DEFERRED_LIGHTING\n";
+	}
+}
+
+/***********************************************************
+ *  DeleteVariants()
+ *
+ *  This method is used to delete every compiled variant,
+ *  the shader program included.  A failed variant shares
+ *  the shader program, so it is only deleted once.
+ ***********************************************************/
+void ShaderManager::DeleteVariants()
+{
+	for (int i = 0; i < VARIANT_COUNT; i++)
+	{
+		if ((m_variants[i] != 0) && (m_variants[i] != m_programID))
+		{
+			GLStateCache::DeleteProgram(m_variants[i]);
+		}
+		m_variants[i] = 0;
+	}
+
+	if (m_programID != 0)
+	{
+		GLStateCache::DeleteProgram(m_programID);
+		m_programID = 0;
+	}
+	m_uniformLocations.clear();
+}
+
+/***********************************************************
+ *  SetProgramCache()
+ *
+ *  This method is used to set the directory the program
+ *  binaries are kept in, which is created when the first
+ *  one is saved.  An empty name turns the cache off.
+ ***********************************************************/
+void ShaderManager::SetProgramCache(const std::string& directory)
+{
+	m_cacheDirectory = directory;
+}
+
+/***********************************************************
+ *  GetLoadStats()
+ *
+ *  This method is used to get the counters of the most
+ *  recent LoadPrograms() call.
+ ***********************************************************/
+const ShaderManager::LOAD_STATS& ShaderManager::GetLoadStats() const
+{
+	return m_loadStats;
+}
+
+/***********************************************************
+ *  HashProgram()
+ *
+ *  This method is used to make the cache key of a program,
+ *  a 64-bit FNV-1a hash of its sources, its defines and the
+ *  driver.  Changing any of them gives a new key, so a stale
+ *  binary is never found.
+ ***********************************************************/
+uint64_t ShaderManager::HashProgram(const PROGRAM_SOURCES& sources, const std::string& driver)
+{
+	const char* parts[4] = { sources.vertexSource, sources.fragmentSource, sources.defines.c_str(), driver.c_str() };
+	const size_t lengths[4] = { (size_t)sources.vertexLength, (size_t)sources.fragmentLength,
+		sources.defines.size(), driver.size() };
+
+	uint64_t hash = FNV_OFFSET_BASIS;
+	for (int part = 0; part < 4; part++)
+	{
+		for (size_t i = 0; i < lengths[part]; i++)
+		{
+			hash = (hash ^ (unsigned char)parts[part][i]) * FNV_PRIME;
+		}
+		// keep the parts apart, so text moving from one to the
+		// next changes the key
+		hash = (hash ^ 0xFF) * FNV_PRIME;
+	}
+
+	return hash;
+}
+
+/***********************************************************
+ *  GetCacheFilename()
+ *
+ *  This method is used to get the name of the file a program
+ *  binary is kept in.
+ ***********************************************************/
+std::string ShaderManager::GetCacheFilename(uint64_t key) const
+{
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+	return m_cacheDirectory + "/" + name;
+}
+
+/***********************************************************
+ *  LoadCachedProgram()
+ *
+ *  This method is used to load a program from its cached
+ *  binary.  The driver can still refuse a binary made by
+ *  the same driver name, after an update for example, in
+ *  which case the program is compiled again and the new
+ *  binary replaces the stale one.
+ ***********************************************************/
+GLuint ShaderManager::LoadCachedProgram(uint64_t key)
+{
+	if (m_cacheDirectory.empty())
+	{
+		return 0;
+	}
+
+	MappedFile file;
+	if (file.Open(GetCacheFilename(key)) == false)
+	{
+		return 0;
+	}
+
+	PROGRAM_CACHE_HEADER header;
+	if (file.GetSize() < sizeof(header))
+	{
+		return 0;
+	}
+	memcpy(&header, file.GetData(), sizeof(header));
+	if ((header.magic != PROGRAM_CACHE_MAGIC) || (header.version != PROGRAM_CACHE_VERSION) ||
+		(header.key != key) || (header.binaryLength != file.GetSize() - sizeof(header)))
+	{
+		return 0;
+	}
+
+	GLuint programID = glCreateProgram();
+	glProgramBinary(programID, (GLenum)header.binaryFormat, file.GetData() + sizeof(header), (GLsizei)header.binaryLength);
+
+	GLint bSuccess = GL_FALSE;
+	glGetProgramiv(programID, GL_LINK_STATUS, &bSuccess);
+	if (bSuccess == GL_FALSE)
+	{
+		std::cout << "INFO: cached shader program is stale and will be compiled again" << std::endl;
+		GLStateCache::DeleteProgram(programID);
+		return 0;
+	}
+
+	return programID;
+}
+
+/***********************************************************
+ *  SaveCachedProgram()
+ *
+ *  This method is used to write the binary of a linked
+ *  program into the cache, when the driver can give one.
+ ***********************************************************/
+void ShaderManager::SaveCachedProgram(uint64_t key, GLuint programID)
+{
+	if (m_cacheDirectory.empty())
+	{
+		return;
+	}
+
+	GLint formatCount = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+	GLint binaryLength = 0;
+	glGetProgramiv(programID, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+	if ((formatCount <= 0) || (binaryLength <= 0))
+	{
+		return;
+	}
+
+	std::vector<unsigned char> binary(binaryLength);
+	GLenum binaryFormat = 0;
+	glGetProgramBinary(programID, binaryLength, &binaryLength, &binaryFormat, binary.data());
+
+	PROGRAM_CACHE_HEADER header;
+	header.magic = PROGRAM_CACHE_MAGIC;
+	header.version = PROGRAM_CACHE_VERSION;
+	header.key = key;
+	header.binaryFormat = (uint32_t)binaryFormat;
+	header.binaryLength = (uint32_t)binaryLength;
+
+	if (MappedFile::MakeDirectory(m_cacheDirectory) == false)
+	{
+		std::cout << "ERROR: could not create shader cache directory:" << m_cacheDirectory << std::endl;
+		return;
+	}
+
+	std::string filename = GetCacheFilename(key);
+	std::ofstream file(filename, std::ios::binary);
+	file.write((const char*)&header, sizeof(header));
+	file.write((const char*)binary.data(), binaryLength);
+	if (!file)
+	{
+		std::cout << "ERROR: could not write shader cache file:" << filename << std::endl;
+	}
+}
+
+/***********************************************************
+ *  ResolveUniforms()
+ *
+ *  This method is used to fill the uniform table with the
+ *  location of every active uniform in the program.  Arrays
+ *  of basic types are reported once as "name[0]", so every
+ *  element is added, along with the plain array name.
+ ***********************************************************/
+void ShaderManager::ResolveUniforms()
+{
+	GLint uniformCount = 0;
+	GLint maxNameLength = 0;
+
+	m_uniformLocations.clear();
+
+	glGetProgramiv(m_programID, GL_ACTIVE_UNIFORMS, &uniformCount);
+	glGetProgramiv(m_programID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+	std::vector<char> nameBuffer(maxNameLength + 1, '\0');
+	for (GLint i = 0; i < uniformCount; i++)
+	{
+		GLsizei nameLength = 0;
+		GLint arraySize = 0;
+		GLenum type = 0;
+
+		glGetActiveUniform(m_programID, (GLuint)i, maxNameLength, &nameLength, &arraySize, &type, nameBuffer.data());
+		std::string name(nameBuffer.data(), nameLength);
+
+		GLint location = glGetUniformLocation(m_programID, name.c_str());
+		if (location < 0)
+		{
+			// uniforms inside uniform blocks have no location
+			continue;
+		}
+		m_uniformLocations[name] = location;
+
+		size_t bracket = name.rfind("[0]");
+		if ((bracket != std::string::npos) && (bracket + 3 == name.size()))
+		{
+			std::string baseName = name.substr(0, bracket);
+			m_uniformLocations[baseName] = location;
+			for (GLint element = 1; element < arraySize; element++)
+			{
+				std::string elementName = baseName + "[" + std::to_string(element) + "]";
+				m_uniformLocations[elementName] = glGetUniformLocation(m_programID, elementName.c_str());
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  FindUniformLocation()
+ *
+ *  This method is used to look up a uniform location in the
+ *  uniform table.  Inactive uniforms return -1, which the
+ *  glUniform functions silently ignore.
+ ***********************************************************/
+GLint ShaderManager::FindUniformLocation(const std::string& name)
+{
+	m_uniformLookups++;
+
+	std::unordered_map<std::string, GLint>::const_iterator found = m_uniformLocations.find(name);
+	if (found == m_uniformLocations.end())
+	{
+		return -1;
+	}
+
+	return found->second;
+}
+
+/***********************************************************
+ *  use()
+ *
+ *  This method is used to make the shader program current.
+ ***********************************************************/
+void ShaderManager::use()
+{
+	GLStateCache::UseProgram(m_programID);
+}
+
+/***********************************************************
+ *  GetProgramID()
+ *
+ *  This method is used to get the ID of the shader program.
+ ***********************************************************/
+GLuint ShaderManager::GetProgramID() const
+{
+	return m_programID;
+}
+
+/***********************************************************
+ *  SetUniformBlockBinding()
+ *
+ *  This method is used to connect a uniform block of the
+ *  program to the buffer bound at the passed in binding
+ *  point with glBindBufferBase().
+ ***********************************************************/
+bool ShaderManager::SetUniformBlockBinding(const char* blockName, GLuint binding)
+{
+	GLuint blockIndex = glGetUniformBlockIndex(m_programID, blockName);
+	if (blockIndex == GL_INVALID_INDEX)
+	{
+		std::cout << "ERROR: uniform block not found in shader program:" << blockName << std::endl;
+		return false;
+	}
+
+	glUniformBlockBinding(m_programID, blockIndex, binding);
+	return true;
+}
+
+/***********************************************************
+ *  GetUniformLookupCount()
+ *
+ *  This method is used to get the number of uniform name
+ *  lookups since the counter was last reset.
+ ***********************************************************/
+int ShaderManager::GetUniformLookupCount() const
+{
+	return m_uniformLookups;
+}
+
+/***********************************************************
+ *  ResetUniformLookupCount()
+ *
+ *  This method is used to reset the uniform lookup counter,
+ *  normally at the start of every frame.
+ ***********************************************************/
+void ShaderManager::ResetUniformLookupCount()
+{
+	m_uniformLookups = 0;
+}
+
+/***********************************************************
+ *  set*Value()
+ *
+ *  These methods are used to set uniform values by name.
+ *  They go through the typed handles, so values that did
+ *  not change are not sent again.
+ ***********************************************************/
+void ShaderManager::setBoolValue(const std::string& name, bool value)
+{
+	ShaderUniform<bool>(FindUniformLocation(name)).Set(value);
+}
+
+void ShaderManager::setIntValue(const std::string& name, int value)
+{
+	ShaderUniform<int>(FindUniformLocation(name)).Set(value);
+}
+
+void ShaderManager::setFloatValue(const std::string& name, float value)
+{
+	ShaderUniform<float>(FindUniformLocation(name)).Set(value);
+}
+
+void ShaderManager::setSampler2DValue(const std::string& name, int value)
+{
+	ShaderUniform<int>(FindUniformLocation(name)).Set(value);
+}
+
+void ShaderManager::setVec2Value(const std::string& name, const glm::vec2& value)
+{
+	ShaderUniform<glm::vec2>(FindUniformLocation(name)).Set(value);
+}
+
+void ShaderManager::setVec3Value(const std::string& name, const glm::vec3& value)
+{
+	ShaderUniform<glm::vec3>(FindUniformLocation(name)).Set(value);
+}
+
+void ShaderManager::setVec3Value(const std::string& name, float x, float y, float z)
+{
+	ShaderUniform<glm::vec3>(FindUniformLocation(name)).Set(glm::vec3(x, y, z));
+}
+
+void ShaderManager::setVec4Value(const std::string& name, const glm::vec4& value)
+{
+	ShaderUniform<glm::vec4>(FindUniformLocation(name)).Set(value);
+}
+
+void ShaderManager::setMat4Value(const std::string& name, const glm::mat4& value)
+{
+	ShaderUniform<glm::mat4>(FindUniformLocation(name)).Set(value);
+}
@@ -0,0 +1,286 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadermanager.h
+// ============
+// load the shader programs and manage the values of their uniforms
+//
+// This project's copy replaces the shared Utilities version so the uniform
+// locations can be resolved once after loading instead of on every call.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "GLStateCache.h"
+
+#include <GL/glew.h>
+
+// GLM Math Header inclusions
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/***********************************************************
+ *  ShaderUniform
+ *
+ *  A typed handle to a uniform of the current shader
+ *  program.  The location is resolved once by name through
+ *  the ShaderManager, after which setting the value never
+ *  touches the name again.
+ ***********************************************************/
+template<typename T>
+class ShaderUniform
+{
+public:
+	ShaderUniform() : m_location(-1) {}
+	explicit ShaderUniform(GLint location) : m_location(location) {}
+
+	// check whether the uniform is active in the program
+	bool IsValid() const { return m_location >= 0; }
+	// get the resolved uniform location
+	GLint GetLocation() const { return m_location; }
+
+	// set the value into the currently used program
+	void Set(const T& value) const;
+
+private:
+	GLint m_location;
+};
+
+// the values go through the state cache, so a value that is
+// already in the program is not sent again
+template<> inline void ShaderUniform<int>::Set(const int& value) const
+{
+	if (GLStateCache::ChangeUniform(m_location, &value, sizeof(value)))
+	{
+		glUniform1i(m_location, value);
+	}
+}
+template<> inline void ShaderUniform<bool>::Set(const bool& value) const { ShaderUniform<int>(m_location).Set((int)value); }
+template<> inline void ShaderUniform<float>::Set(const float& value) const
+{
+	if (GLStateCache::ChangeUniform(m_location, &value, sizeof(value)))
+	{
+		glUniform1f(m_location, value);
+	}
+}
+template<> inline void ShaderUniform<glm::ivec2>::Set(const glm::ivec2& value) const
+{
+	if (GLStateCache::ChangeUniform(m_location, &value, sizeof(value)))
+	{
+		glUniform2i(m_location, value.x, value.y);
+	}
+}
+template<> inline void ShaderUniform<glm::vec2>::Set(const glm::vec2& value) const
+{
+	if (GLStateCache::ChangeUniform(m_location, &value, sizeof(value)))
+	{
+		glUniform2fv(m_location, 1, glm::value_ptr(value));
+	}
+}
+template<> inline void ShaderUniform<glm::vec3>::Set(const glm::vec3& value) const
+{
+	if (GLStateCache::ChangeUniform(m_location, &value, sizeof(value)))
+	{
+		glUniform3fv(m_location, 1, glm::value_ptr(value));
+	}
+}
+template<> inline void ShaderUniform<glm::vec4>::Set(const glm::vec4& value) const
+{
+	if (GLStateCache::ChangeUniform(m_location, &value, sizeof(value)))
+	{
+		glUniform4fv(m_location, 1, glm::value_ptr(value));
+	}
+}
+template<> inline void ShaderUniform<glm::mat4>::Set(const glm::mat4& value) const
+{
+	if (GLStateCache::ChangeUniform(m_location, &value, sizeof(value)))
+	{
+		glUniformMatrix4fv(m_location, 1, GL_FALSE, glm::value_ptr(value));
+	}
+}
+
+/***********************************************************
+ *  ShaderManager
+ *
+ *  This class contains the code for loading the shader
+ *  program and for setting its uniform values.  Linked
+ *  programs are saved as driver binaries in a cache
+ *  directory, under a hash of their sources, defines and
+ *  the driver, so later launches load them without
+ *  compiling anything.  The programs missing from the cache
+ *  are compiled together, letting a driver with parallel
+ *  shader compilation work on all of them at once.
+ *
+ *  The shader sources are kept after loading, so variants
+ *  of the program can be compiled from them with #define
+ *  lines for the features a draw uses - a texture, the
+ *  lighting and the alpha test - instead of branching on
+ *  them in every fragment.  Each variant is compiled the
+ *  first time it is asked for and kept in a table indexed
+ *  by its features - the variants a frame needs are asked
+ *  for together before it draws, so they compile at once.
+ *  The variants read the values of the
+ *  frame from uniform blocks and bind their samplers in the
+ *  shader, so they share no uniforms of their own.
+ ***********************************************************/
+class ShaderManager
+{
+public:
+	// the sources of one shader program - the text does not
+	// need to be null terminated - and the defines added to
+	// both stages after their #version line
+	struct PROGRAM_SOURCES
+	{
+		const char* vertexSource;
+		GLint vertexLength;
+		const char* fragmentSource;
+		GLint fragmentLength;
+		std::string defines;
+	};
+
+	// the features a variant of the program is compiled with,
+	// combined into its index in the variant table
+	enum PROGRAM_FEATURE
+	{
+		FEATURE_TEXTURE = 1,
+		FEATURE_LIGHTING = 2,
+		FEATURE_ALPHA_TEST = 4,
+		// writes the distance from a light into a shadow map
+		// instead of a color
+		FEATURE_SHADOW_DEPTH = 8,
+		// writes the surface into the G-buffer of the deferred
+		// path instead of lighting it
+		FEATURE_GBUFFER = 16,
+		// lights the G-buffer with a triangle that covers the
+		// screen, in place of drawing the meshes
+		FEATURE_DEFERRED_LIGHTING = 32
+	};
+	static const int VARIANT_COUNT = 64;
+	// the variant loaded as the shader program
+	static const int DEFAULT_FEATURES = FEATURE_TEXTURE | FEATURE_LIGHTING;
+
+	// counters of the most recent LoadPrograms() call
+	struct LOAD_STATS
+	{
+		int cachedPrograms;
+		int compiledPrograms;
+		int failedPrograms;
+		double milliseconds;
+	};
+
+	// constructor
+	ShaderManager();
+	// destructor
+	~ShaderManager();
+
+	// load, compile and link the shader code from the GLSL files
+	GLuint LoadShaders(const char* vertexShaderFile, const char* fragmentShaderFile);
+	// compile and link shader code that is already in memory -
+	// the lengths allow the text to be used without copying it
+	GLuint LoadShaderSources(
+		const char* vertexSource, GLint vertexLength,
+		const char* fragmentSource, GLint fragmentLength);
+	// load a list of programs at once, from the cache or by
+	// compiling the missing ones in parallel - a program that
+	// fails is 0, and then false is returned
+	bool LoadPrograms(const std::vector<PROGRAM_SOURCES>& sources, std::vector<GLuint>& programs);
+	// keep the linked programs in a directory, or an empty name
+	// to always compile them
+	void SetProgramCache(const std::string& directory);
+	// get the counters of the most recent load
+	const LOAD_STATS& GetLoadStats() const;
+	// make the loaded shader program the current one
+	void use();
+	// get the OpenGL ID of the loaded shader program
+	GLuint GetProgramID() const;
+	// get the variant of the program with a combination of
+	// features, compiling it the first time it is asked for
+	GLuint GetVariant(int features);
+	// compile every variant of a list that is not compiled yet
+	// in one go, so the driver can work on all of them at once
+	void PrepareVariants(const std::vector<int>& features);
+	// number of variants compiled so far
+	int GetVariantCount() const;
+
+	// get a typed handle for a uniform - call once and keep the
+	// handle, since this is a name lookup
+	template<typename T>
+	ShaderUniform<T> GetUniform(const std::string& name)
+	{
+		return ShaderUniform<T>(FindUniformLocation(name));
+	}
+
+	// bind a uniform block of the program to a buffer binding
+	// point, returns false if the block is not active
+	bool SetUniformBlockBinding(const char* blockName, GLuint binding);
+
+	// number of uniform name lookups since the last reset, used
+	// to make sure no lookups are left in the per-frame code
+	int GetUniformLookupCount() const;
+	void ResetUniformLookupCount();
+
+	// set uniform values by name - each call is a name lookup,
+	// so these are meant for one time setup only, and only set
+	// the values of the loaded shader program
+	void setBoolValue(const std::string& name, bool value);
+	void setIntValue(const std::string& name, int value);
+	void setFloatValue(const std::string& name, float value);
+	void setSampler2DValue(const std::string& name, int value);
+	void setVec2Value(const std::string& name, const glm::vec2& value);
+	void setVec3Value(const std::string& name, const glm::vec3& value);
+	void setVec3Value(const std::string& name, float x, float y, float z);
+	void setVec4Value(const std::string& name, const glm::vec4& value);
+	void setMat4Value(const std::string& name, const glm::mat4& value);
+
+private:
+	// ID of the linked shader program
+	GLuint m_programID;
+	// locations of all the active uniforms in the program
+	std::unordered_map<std::string, GLint> m_uniformLocations;
+	// number of name lookups since the last reset
+	int m_uniformLookups;
+	// directory of the program binary cache, empty when off
+	std::string m_cacheDirectory;
+	LOAD_STATS m_loadStats;
+	// the loaded sources the variants are compiled from, and
+	// the variants compiled so far - 0 when not asked for yet
+	std::string m_vertexSource;
+	std::string m_fragmentSource;
+	GLuint m_variants[VARIANT_COUNT];
+
+	// read the contents of a shader source file
+	bool ReadShaderFile(const char* filename, std::string& source);
+	// start compiling one shader stage - the result is checked
+	// when the program is linked
+	GLuint CompileShader(GLenum shaderType, const char* source, GLint length, const std::string& defines);
+	// check that a shader stage compiled and report any errors
+	bool CheckShader(GLuint shaderID, const char* stageName);
+	// start linking compiled shader stages into a program, or
+	// return 0 if either of them failed
+	GLuint LinkProgram(GLuint vertexShaderID, GLuint fragmentShaderID);
+	// check that a program linked and report any errors
+	bool CheckProgram(GLuint programID);
+	// make a loaded program the current shader program
+	void SetProgram(GLuint programID);
+	// delete every compiled variant
+	void DeleteVariants();
+	// the sources of a variant of the loaded program
+	void GetVariantSources(int features, PROGRAM_SOURCES& sources) const;
+	// the key of a program in the cache
+	static uint64_t HashProgram(const PROGRAM_SOURCES& sources, const std::string& driver);
+	// load a program from the cache, or return 0 if it is
+	// missing or was made by a different driver
+	GLuint LoadCachedProgram(uint64_t key);
+	// save the binary of a linked program into the cache
+	void SaveCachedProgram(uint64_t key, GLuint programID);
+	// name of the cache file of a program
+	std::string GetCacheFilename(uint64_t key) const;
+	// fill the uniform table with every active uniform
+	void ResolveUniforms();
+	// look up the location of a uniform by name
+	GLint FindUniformLocation(const std::string& name);
+};
@@ -0,0 +1,527 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadowmaps.cpp
+// ============
+// draw and cache the shadow maps of the shadow casting lights
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ShadowMaps.h"
+#include "GLStateCache.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+// declare the global variables
+namespace
+{
+	// closest distance to a light that is drawn into its maps
+	const float SHADOW_NEAR_PLANE = 0.05f;
+	// how wide the overhead map looks down, in degrees
+	const float OVERHEAD_FIELD_OF_VIEW = 120.0f;
+	// distance, in world units, and offset along the normal,
+	// per unit of distance from the light, that a surface is
+	// moved towards the light before it is compared with the
+	// maps - this keeps it from shadowing itself
+	const float SHADOW_DISTANCE_BIAS = 0.02f;
+	const float SHADOW_NORMAL_OFFSET = 0.004f;
+
+	// the direction and up vector of every cube map face, in
+	// the order of the layers, +x -x +y -y +z -z
+	const glm::vec3 CUBE_FACE_DIRECTIONS[6] =
+	{
+		glm::vec3(1.0f, 0.0f, 0.0f),
+		glm::vec3(-1.0f, 0.0f, 0.0f),
+		glm::vec3(0.0f, 1.0f, 0.0f),
+		glm::vec3(0.0f, -1.0f, 0.0f),
+		glm::vec3(0.0f, 0.0f, 1.0f),
+		glm::vec3(0.0f, 0.0f, -1.0f)
+	};
+	const glm::vec3 CUBE_FACE_UPS[6] =
+	{
+		glm::vec3(0.0f, -1.0f, 0.0f),
+		glm::vec3(0.0f, -1.0f, 0.0f),
+		glm::vec3(0.0f, 0.0f, 1.0f),
+		glm::vec3(0.0f, 0.0f, -1.0f),
+		glm::vec3(0.0f, -1.0f, 0.0f),
+		glm::vec3(0.0f, -1.0f, 0.0f)
+	};
+
+	/***********************************************************
+	 *  CreateDepthTexture()
+	 *
+	 *  Create a depth texture that is compared against when it
+	 *  is sampled, either an array with the passed in number
+	 *  of layers or a single map.
+	 ***********************************************************/
+	GLuint CreateDepthTexture(GLenum target, int size, int layerCount)
+	{
+		GLuint textureID = 0;
+		glGenTextures(1, &textureID);
+		GLStateCache::BindTexture(target, textureID);
+
+		if (target == GL_TEXTURE_2D_ARRAY)
+		{
+			glTexStorage3D(target, 1, GL_DEPTH_COMPONENT24, size, size, layerCount);
+		}
+		else
+		{
+			glTexStorage2D(target, 1, GL_DEPTH_COMPONENT24, size, size);
+		}
+
+		// the linear filter blends four comparisons, which
+		// softens the edges of the shadows
+		glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(target, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+		glTexParameteri(target, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+
+		GLStateCache::BindTexture(target, 0);
+		return textureID;
+	}
+}
+
+/***********************************************************
+ *  ShadowMaps()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ShadowMaps::ShadowMaps()
+{
+	for (int i = 0; i < MAX_CUBE_SHADOWS; i++)
+	{
+		m_cubeLights[i] = NO_LIGHT;
+		m_cubeLightPositions[i] = glm::vec4(0.0f);
+	}
+	m_overheadLight = NO_LIGHT;
+	m_overheadLightPosition = glm::vec4(0.0f);
+	m_bViewsValid = false;
+	m_uniforms = SHADOW_UNIFORMS();
+	m_uniforms.cubeLights = glm::ivec4(NO_LIGHT);
+	m_uniforms.overheadLight = glm::ivec4(NO_LIGHT);
+	m_bStaticValid = false;
+	m_bHadDynamicCasters = false;
+	m_staticCubeMapID = 0;
+	m_staticOverheadMapID = 0;
+	m_cubeMapID = 0;
+	m_overheadMapID = 0;
+	m_framebufferID = 0;
+	m_viewBufferID = 0;
+	m_viewStride = 0;
+	m_uniformBufferID = 0;
+	m_pQueue = new RenderQueue();
+	m_stats = SHADOW_STATS();
+}
+
+/***********************************************************
+ *  ~ShadowMaps()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ShadowMaps::~ShadowMaps()
+{
+	delete m_pQueue;
+	m_pQueue = NULL;
+
+	if (m_cubeMapID != 0)
+	{
+		GLuint textureIDs[4] = { m_staticCubeMapID, m_staticOverheadMapID, m_cubeMapID, m_overheadMapID };
+		GLStateCache::DeleteTextures(4, textureIDs);
+		m_staticCubeMapID = 0;
+		m_staticOverheadMapID = 0;
+		m_cubeMapID = 0;
+		m_overheadMapID = 0;
+	}
+	if (m_uniformBufferID != 0)
+	{
+		GLuint bufferIDs[2] = { m_viewBufferID, m_uniformBufferID };
+		GLStateCache::DeleteBuffers(2, bufferIDs);
+		glDeleteFramebuffers(1, &m_framebufferID);
+		m_viewBufferID = 0;
+		m_uniformBufferID = 0;
+		m_framebufferID = 0;
+	}
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used to create the buffer of the light
+ *  views, the shadow block, the framebuffer the maps are
+ *  drawn through and the maps.  The shadow block starts out
+ *  without any shadow casting lights.
+ ***********************************************************/
+bool ShadowMaps::Initialize()
+{
+	if (m_uniformBufferID != 0)
+	{
+		return true;
+	}
+
+	// every view starts at an offset the uniform buffer
+	// binding accepts
+	GLint alignment = 1;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	alignment = std::max(alignment, 1);
+	m_viewStride = (((GLint)sizeof(SHADOW_VIEW) + alignment - 1) / alignment) * alignment;
+
+	GLuint bufferIDs[2];
+	glGenBuffers(2, bufferIDs);
+	m_viewBufferID = bufferIDs[0];
+	m_uniformBufferID = bufferIDs[1];
+
+	GLStateCache::BindBuffer(GL_UNIFORM_BUFFER, m_viewBufferID);
+	glBufferData(GL_UNIFORM_BUFFER, (GLsizeiptr)m_viewStride * VIEW_COUNT, NULL, GL_DYNAMIC_DRAW);
+
+	GLStateCache::BindBuffer(GL_UNIFORM_BUFFER, m_uniformBufferID);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(SHADOW_UNIFORMS), &m_uniforms, GL_DYNAMIC_DRAW);
+	GLStateCache::BindBufferBase(GL_UNIFORM_BUFFER, SHADOW_BLOCK_BINDING, m_uniformBufferID);
+	GLStateCache::BindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	// the maps are drawn into with depth only
+	GLint previousFramebuffer = 0;
+	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFramebuffer);
+	glGenFramebuffers(1, &m_framebufferID);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebufferID);
+	glDrawBuffer(GL_NONE);
+	glReadBuffer(GL_NONE);
+	glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)previousFramebuffer);
+
+	CreateMaps();
+
+	return true;
+}
+
+/***********************************************************
+ *  CreateMaps()
+ *
+ *  This method is used to create the maps the static casters
+ *  are cached in, and the maps the fragment shader reads,
+ *  which stay bound to their texture units.  The faces of
+ *  the cube maps are the layers of one texture array.
+ ***********************************************************/
+void ShadowMaps::CreateMaps()
+{
+	// the maps are created on their own texture unit so the
+	// texture arrays stay bound to theirs
+	GLStateCache::ActiveTexture(GL_TEXTURE0 + CUBE_TEXTURE_UNIT);
+	m_staticCubeMapID = CreateDepthTexture(GL_TEXTURE_2D_ARRAY, CUBE_MAP_SIZE, MAX_CUBE_SHADOWS * 6);
+	m_staticOverheadMapID = CreateDepthTexture(GL_TEXTURE_2D, OVERHEAD_MAP_SIZE, 1);
+	m_cubeMapID = CreateDepthTexture(GL_TEXTURE_2D_ARRAY, CUBE_MAP_SIZE, MAX_CUBE_SHADOWS * 6);
+	m_overheadMapID = CreateDepthTexture(GL_TEXTURE_2D, OVERHEAD_MAP_SIZE, 1);
+
+	GLStateCache::BindTexture(GL_TEXTURE_2D_ARRAY, m_cubeMapID);
+	GLStateCache::ActiveTexture(GL_TEXTURE0 + OVERHEAD_TEXTURE_UNIT);
+	GLStateCache::BindTexture(GL_TEXTURE_2D, m_overheadMapID);
+	GLStateCache::ActiveTexture(GL_TEXTURE0);
+
+	m_bStaticValid = false;
+
+	std::cout << "INFO: Created shadow maps - " << MAX_CUBE_SHADOWS << " cube maps of " << CUBE_MAP_SIZE
+		<< " and an overhead map of " << OVERHEAD_MAP_SIZE << std::endl;
+}
+
+/***********************************************************
+ *  SetShadowLights()
+ *
+ *  This method is used to choose the lights that cast
+ *  shadows.  Lights past the number of cube maps, and
+ *  indices past the lights of the scene, cast none.  The
+ *  maps are drawn again on the next update when the choice
+ *  changed.
+ ***********************************************************/
+void ShadowMaps::SetShadowLights(const std::vector<int>& cubeLights, int overheadLight)
+{
+	for (int i = 0; i < MAX_CUBE_SHADOWS; i++)
+	{
+		m_cubeLights[i] = (i < (int)cubeLights.size()) ? cubeLights[i] : NO_LIGHT;
+	}
+	m_overheadLight = overheadLight;
+}
+
+/***********************************************************
+ *  UpdateViews()
+ *
+ *  This method is used to build the views of the shadow
+ *  casting lights - six faces looking out from each point
+ *  light and one looking down from the overhead light - and
+ *  to upload them along with the shadow block.  Nothing is
+ *  uploaded while the lights stay where they were.  Returns
+ *  true when the views changed.
+ ***********************************************************/
+bool ShadowMaps::UpdateViews(const ClusteredLights* pLights)
+{
+	int lightCount = pLights->GetLightCount();
+
+	SHADOW_UNIFORMS uniforms = {};
+	uniforms.cubeLights = glm::ivec4(NO_LIGHT);
+	uniforms.overheadLight = glm::ivec4(NO_LIGHT);
+	uniforms.bias = glm::vec4(SHADOW_DISTANCE_BIAS, SHADOW_NORMAL_OFFSET, 0.0f, 0.0f);
+
+	glm::vec4 cubeLightPositions[MAX_CUBE_SHADOWS];
+	for (int i = 0; i < MAX_CUBE_SHADOWS; i++)
+	{
+		cubeLightPositions[i] = glm::vec4(0.0f);
+		if ((m_cubeLights[i] >= 0) && (m_cubeLights[i] < lightCount))
+		{
+			const ClusteredLights::POINT_LIGHT& light = pLights->GetLight(m_cubeLights[i]);
+			uniforms.cubeLights[i] = m_cubeLights[i];
+			cubeLightPositions[i] = glm::vec4(light.position, light.range);
+		}
+	}
+	glm::vec4 overheadLightPosition = glm::vec4(0.0f);
+	if ((m_overheadLight >= 0) && (m_overheadLight < lightCount))
+	{
+		const ClusteredLights::POINT_LIGHT& light = pLights->GetLight(m_overheadLight);
+		uniforms.overheadLight.x = m_overheadLight;
+		overheadLightPosition = glm::vec4(light.position, light.range);
+	}
+
+	bool bChanged = (m_bViewsValid == false) ||
+		(memcmp(cubeLightPositions, m_cubeLightPositions, sizeof(cubeLightPositions)) != 0) ||
+		(overheadLightPosition != m_overheadLightPosition);
+	for (int i = 0; i < MAX_CUBE_SHADOWS; i++)
+	{
+		bChanged = bChanged || (uniforms.cubeLights[i] != m_uniforms.cubeLights[i]);
+	}
+	bChanged = bChanged || (uniforms.overheadLight.x != m_uniforms.overheadLight.x);
+	if (bChanged == false)
+	{
+		return false;
+	}
+
+	std::vector<unsigned char> viewData((size_t)m_viewStride * VIEW_COUNT, 0);
+	for (int i = 0; i < MAX_CUBE_SHADOWS; i++)
+	{
+		glm::vec3 position = glm::vec3(cubeLightPositions[i]);
+		float range = std::max(cubeLightPositions[i].w, SHADOW_NEAR_PLANE * 2.0f);
+		for (int face = 0; face < 6; face++)
+		{
+			SHADOW_VIEW* pView = (SHADOW_VIEW*)&viewData[(size_t)m_viewStride * (i * 6 + face)];
+			pView->view = glm::lookAt(position, position + CUBE_FACE_DIRECTIONS[face], CUBE_FACE_UPS[face]);
+			pView->projection = glm::perspective(glm::radians(90.0f), 1.0f, SHADOW_NEAR_PLANE, range);
+			pView->lightPosition = glm::vec4(position, range);
+			pView->unused = glm::vec4(0.0f);
+			uniforms.cubeMatrices[i * 6 + face] = pView->projection * pView->view;
+		}
+	}
+	{
+		glm::vec3 position = glm::vec3(overheadLightPosition);
+		float range = std::max(overheadLightPosition.w, SHADOW_NEAR_PLANE * 2.0f);
+		SHADOW_VIEW* pView = (SHADOW_VIEW*)&viewData[(size_t)m_viewStride * OVERHEAD_VIEW];
+		pView->view = glm::lookAt(position, position + glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f));
+		pView->projection = glm::perspective(glm::radians(OVERHEAD_FIELD_OF_VIEW), 1.0f, SHADOW_NEAR_PLANE, range);
+		pView->lightPosition = glm::vec4(position, range);
+		pView->unused = glm::vec4(0.0f);
+		uniforms.overheadMatrix = pView->projection * pView->view;
+	}
+
+	GLStateCache::BindBuffer(GL_UNIFORM_BUFFER, m_viewBufferID);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, (GLsizeiptr)viewData.size(), viewData.data());
+	GLStateCache::BindBuffer(GL_UNIFORM_BUFFER, m_uniformBufferID);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(SHADOW_UNIFORMS), &uniforms);
+	GLStateCache::BindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	memcpy(m_cubeLightPositions, cubeLightPositions, sizeof(cubeLightPositions));
+	m_overheadLightPosition = overheadLightPosition;
+	m_uniforms = uniforms;
+	m_bViewsValid = true;
+	return true;
+}
+
+/***********************************************************
+ *  IsSameCasters()
+ *
+ *  This method is used to check whether the static casters
+ *  are the ones the cached maps were drawn with.  Only the
+ *  values that change the shadow are compared.
+ ***********************************************************/
+bool ShadowMaps::IsSameCasters(const std::vector<RenderQueue::DRAW_PACKET>& casters) const
+{
+	if (casters.size() != m_staticCasters.size())
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i < casters.size(); i++)
+	{
+		const RenderQueue::DRAW_PACKET& a = casters[i];
+		const RenderQueue::DRAW_PACKET& b = m_staticCasters[i];
+		if ((a.mesh != b.mesh) || (a.variant != b.variant) || (a.blendMode != b.blendMode) ||
+			(a.textureArray != b.textureArray) || (a.textureLayer != b.textureLayer) ||
+			(a.UVscale != b.UVscale) || (a.model != b.model))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+/***********************************************************
+ *  DrawCasters()
+ *
+ *  This method is used to draw casters into every view of
+ *  the shadow casting lights.  The casters are sorted and
+ *  uploaded once and drawn again for each view, with the
+ *  depth variant of the shader program.  Blended casters
+ *  are see-through, so they cast no shadow, and alpha
+ *  tested ones keep their texture to cut out their holes.
+ ***********************************************************/
+void ShadowMaps::DrawCasters(ShapeMeshes* pMeshes, ShaderManager* pShaders,
+	const std::vector<RenderQueue::DRAW_PACKET>& casters, GLuint cubeMapID, GLuint overheadMapID, bool bClear)
+{
+	m_pQueue->Clear();
+	for (size_t i = 0; i < casters.size(); i++)
+	{
+		if (casters[i].blendMode == RenderQueue::BLEND_ALPHA)
+		{
+			continue;
+		}
+
+		RenderQueue::DRAW_PACKET packet = casters[i];
+		packet.variant = GetCasterVariant(packet.variant);
+		packet.lod = 0;
+		m_pQueue->Submit(packet);
+	}
+	m_pQueue->Prepare(pMeshes, pShaders, glm::mat4(1.0f), 0);
+
+	glViewport(0, 0, CUBE_MAP_SIZE, CUBE_MAP_SIZE);
+	for (int i = 0; i < MAX_CUBE_SHADOWS; i++)
+	{
+		if (m_uniforms.cubeLights[i] == NO_LIGHT)
+		{
+			continue;
+		}
+
+		for (int face = 0; face < 6; face++)
+		{
+			glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, cubeMapID, 0, i * 6 + face);
+			GLStateCache::BindBufferRange(GL_UNIFORM_BUFFER, FRAME_BLOCK_BINDING, m_viewBufferID,
+				(GLintptr)m_viewStride * (i * 6 + face), sizeof(SHADOW_VIEW));
+			if (bClear)
+			{
+				glClear(GL_DEPTH_BUFFER_BIT);
+			}
+			m_pQueue->Draw(pMeshes, pShaders);
+		}
+	}
+
+	if (m_uniforms.overheadLight.x != NO_LIGHT)
+	{
+		glViewport(0, 0, OVERHEAD_MAP_SIZE, OVERHEAD_MAP_SIZE);
+		glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, overheadMapID, 0);
+		GLStateCache::BindBufferRange(GL_UNIFORM_BUFFER, FRAME_BLOCK_BINDING, m_viewBufferID,
+			(GLintptr)m_viewStride * OVERHEAD_VIEW, sizeof(SHADOW_VIEW));
+		if (bClear)
+		{
+			glClear(GL_DEPTH_BUFFER_BIT);
+		}
+		m_pQueue->Draw(pMeshes, pShaders);
+	}
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used to bring the shadow maps up to date.
+ *  The static casters are only drawn again when they, or
+ *  the shadow casting lights, changed since the cached maps
+ *  were drawn.  The cached maps are then copied into the
+ *  maps the fragment shader reads and the dynamic casters
+ *  are drawn over them.  While nothing changes and there
+ *  are no dynamic casters, nothing is drawn or copied.  The
+ *  frame block is left bound to a light view.
+ ***********************************************************/
+void ShadowMaps::Update(ShapeMeshes* pMeshes, ShaderManager* pShaders, const ClusteredLights* pLights,
+	const std::vector<RenderQueue::DRAW_PACKET>& staticCasters,
+	const std::vector<RenderQueue::DRAW_PACKET>& dynamicCasters)
+{
+	m_stats = SHADOW_STATS();
+	if (m_uniformBufferID == 0)
+	{
+		return;
+	}
+
+	bool bLightsChanged = UpdateViews(pLights);
+	bool bShadowLights = (m_uniforms.overheadLight.x != NO_LIGHT);
+	for (int i = 0; i < MAX_CUBE_SHADOWS; i++)
+	{
+		bShadowLights = bShadowLights || (m_uniforms.cubeLights[i] != NO_LIGHT);
+	}
+	if (bShadowLights == false)
+	{
+		return;
+	}
+
+	bool bDrawStatic = bLightsChanged || (m_bStaticValid == false) || (IsSameCasters(staticCasters) == false);
+	bool bDynamicCasters = (dynamicCasters.empty() == false);
+	if ((bDrawStatic == false) && (bDynamicCasters == false) && (m_bHadDynamicCasters == false))
+	{
+		return;
+	}
+
+	GLint previousFramebuffer = 0;
+	GLint previousViewport[4];
+	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFramebuffer);
+	glGetIntegerv(GL_VIEWPORT, previousViewport);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebufferID);
+	GLStateCache::Enable(GL_DEPTH_TEST);
+	GLStateCache::DepthMask(GL_TRUE);
+
+	if (bDrawStatic)
+	{
+		DrawCasters(pMeshes, pShaders, staticCasters, m_staticCubeMapID, m_staticOverheadMapID, true);
+		m_staticCasters = staticCasters;
+		m_bStaticValid = true;
+		m_stats.staticUpdates = 1;
+	}
+
+	// the read maps start from the static shadows, which also
+	// clears away the dynamic casters of the last frame
+	glCopyImageSubData(m_staticCubeMapID, GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0,
+		m_cubeMapID, GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0, CUBE_MAP_SIZE, CUBE_MAP_SIZE, MAX_CUBE_SHADOWS * 6);
+	glCopyImageSubData(m_staticOverheadMapID, GL_TEXTURE_2D, 0, 0, 0, 0,
+		m_overheadMapID, GL_TEXTURE_2D, 0, 0, 0, 0, OVERHEAD_MAP_SIZE, OVERHEAD_MAP_SIZE, 1);
+
+	if (bDynamicCasters)
+	{
+		DrawCasters(pMeshes, pShaders, dynamicCasters, m_cubeMapID, m_overheadMapID, false);
+		m_stats.dynamicCasters = (int)dynamicCasters.size();
+	}
+	m_bHadDynamicCasters = bDynamicCasters;
+
+	glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)previousFramebuffer);
+	glViewport(previousViewport[0], previousViewport[1], previousViewport[2], previousViewport[3]);
+}
+
+/***********************************************************
+ *  GetStats()
+ *
+ *  This method is used to get the counters of the most
+ *  recent update.
+ ***********************************************************/
+const ShadowMaps::SHADOW_STATS& ShadowMaps::GetStats() const
+{
+	return m_stats;
+}
+
+/***********************************************************
+ *  GetCasterVariant()
+ *
+ *  This method is used to get the shader variant a caster
+ *  is drawn into the maps with - the depth variant, which
+ *  keeps the texture of alpha tested casters to cut out
+ *  their holes.
+ ***********************************************************/
+int ShadowMaps::GetCasterVariant(int variant)
+{
+	int features = ShaderManager::FEATURE_SHADOW_DEPTH;
+	if (variant & ShaderManager::FEATURE_ALPHA_TEST)
+	{
+		features |= variant & (ShaderManager::FEATURE_ALPHA_TEST | ShaderManager::FEATURE_TEXTURE);
+	}
+	return features;
+}
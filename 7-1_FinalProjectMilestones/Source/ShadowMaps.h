@@ -0,0 +1,169 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadowmaps.h
+// ============
+// draw and cache the shadow maps of the shadow casting lights
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ClusteredLights.h"
+#include "RenderQueue.h"
+#include "ShaderManager.h"
+#include "ShapeMeshes.h"
+
+#include <GL/glew.h>
+
+// GLM Math Header inclusions
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  ShadowMaps
+ *
+ *  This class keeps a depth cube map for each shadow casting
+ *  point light, and one map looking straight down for the
+ *  light above the scene.  The maps store the distance from
+ *  the light to the nearest caster over the light's range.
+ *  The static casters are drawn into maps of their own only
+ *  when they or the lights moved, and copied into the maps
+ *  the fragment shader reads.  Only the dynamic casters are
+ *  drawn over that copy every frame, so a scene that holds
+ *  still costs nothing but the lookups.
+ ***********************************************************/
+class ShadowMaps
+{
+public:
+	// number of cube maps, and the size of their faces and of
+	// the overhead map - the count must match MAX_CUBE_SHADOWS
+	// in the fragment shader
+	static const int MAX_CUBE_SHADOWS = 2;
+	static const int CUBE_MAP_SIZE = 512;
+	static const int OVERHEAD_MAP_SIZE = 1024;
+
+	// texture units of the maps, after the texture arrays, and
+	// the uniform buffer bindings of the shadow block and of
+	// the frame block the views are drawn with - must match
+	// the fragment shader
+	static const GLuint CUBE_TEXTURE_UNIT = 8;
+	static const GLuint OVERHEAD_TEXTURE_UNIT = 9;
+	static const GLuint SHADOW_BLOCK_BINDING = 2;
+	static const GLuint FRAME_BLOCK_BINDING = 1;
+
+	// light index of a map that no light uses
+	static const int NO_LIGHT = -1;
+
+	// counters for the most recent update
+	struct SHADOW_STATS
+	{
+		// 1 when the static casters were drawn again
+		int staticUpdates;
+		// dynamic casters drawn over the static shadows
+		int dynamicCasters;
+	};
+
+	// constructor
+	ShadowMaps();
+	// destructor
+	~ShadowMaps();
+
+	// create the maps, the uniform buffers and the framebuffer,
+	// so no frame has to create them
+	bool Initialize();
+
+	// choose the lights that cast shadows, by their index in
+	// the light buffer - the point lights get a cube map, and
+	// the overhead light a map looking straight down
+	void SetShadowLights(const std::vector<int>& cubeLights, int overheadLight);
+
+	// bring the maps up to date with the lights and casters -
+	// the static casters are compared with the ones the cached
+	// maps were drawn with, and the dynamic ones are drawn over
+	// them.  Leaves the frame block binding to the caller
+	void Update(ShapeMeshes* pMeshes, ShaderManager* pShaders, const ClusteredLights* pLights,
+		const std::vector<RenderQueue::DRAW_PACKET>& staticCasters,
+		const std::vector<RenderQueue::DRAW_PACKET>& dynamicCasters);
+
+	// get the counters of the most recent update
+	const SHADOW_STATS& GetStats() const;
+
+	// the shader variant a caster drawn with the passed in
+	// variant is drawn into the maps with
+	static int GetCasterVariant(int variant);
+
+private:
+	// number of views drawn - six faces for every cube map and
+	// the overhead map after them
+	static const int VIEW_COUNT = MAX_CUBE_SHADOWS * 6 + 1;
+	static const int OVERHEAD_VIEW = MAX_CUBE_SHADOWS * 6;
+
+	// one view of a light, laid out like the std140 frame block
+	// so the scene shaders draw it - the light position and
+	// range take the place of the camera position
+	struct SHADOW_VIEW
+	{
+		glm::mat4 view;
+		glm::mat4 projection;
+		glm::vec4 lightPosition;		// xyz + range
+		glm::vec4 unused;
+	};
+
+	// layout of the std140 shadow block of the fragment shader,
+	// with the view and projection of every cube map face
+	struct SHADOW_UNIFORMS
+	{
+		glm::ivec4 cubeLights;
+		glm::ivec4 overheadLight;		// x + unused
+		glm::mat4 overheadMatrix;
+		glm::vec4 bias;					// distance, normal offset
+		glm::mat4 cubeMatrices[MAX_CUBE_SHADOWS * 6];
+	};
+
+	// the lights chosen to cast shadows, and the position and
+	// range of each when its views were last built
+	int m_cubeLights[MAX_CUBE_SHADOWS];
+	int m_overheadLight;
+	glm::vec4 m_cubeLightPositions[MAX_CUBE_SHADOWS];
+	glm::vec4 m_overheadLightPosition;
+	bool m_bViewsValid;
+	// the shadow block as it was last uploaded
+	SHADOW_UNIFORMS m_uniforms;
+
+	// the static casters the cached maps were drawn with, and
+	// whether dynamic casters were drawn into the last frame
+	std::vector<RenderQueue::DRAW_PACKET> m_staticCasters;
+	bool m_bStaticValid;
+	bool m_bHadDynamicCasters;
+
+	// maps holding only the static casters, and the maps the
+	// fragment shader reads - the cube map faces are layers of
+	// a texture array, cube map i taking layers i*6 to i*6+5
+	GLuint m_staticCubeMapID;
+	GLuint m_staticOverheadMapID;
+	GLuint m_cubeMapID;
+	GLuint m_overheadMapID;
+	GLuint m_framebufferID;
+	// the views, each at an offset the uniform buffer binding
+	// accepts, and the shadow block
+	GLuint m_viewBufferID;
+	GLint m_viewStride;
+	GLuint m_uniformBufferID;
+
+	// queue the casters are sorted and drawn with
+	RenderQueue* m_pQueue;
+	SHADOW_STATS m_stats;
+
+	// create the static and the read maps
+	void CreateMaps();
+	// build the views of the shadow casting lights and upload
+	// them with the shadow block, returns true when a light
+	// moved or changed since they were last built
+	bool UpdateViews(const ClusteredLights* pLights);
+	// check whether the static casters are the ones the maps
+	// were drawn with
+	bool IsSameCasters(const std::vector<RenderQueue::DRAW_PACKET>& casters) const;
+	// draw casters into every view of the passed in maps,
+	// clearing them first or drawing over what is there
+	void DrawCasters(ShapeMeshes* pMeshes, ShaderManager* pShaders,
+		const std::vector<RenderQueue::DRAW_PACKET>& casters, GLuint cubeMapID, GLuint overheadMapID, bool bClear);
+};
@@ -0,0 +1,1326 @@
+///////////////////////////////////////////////////////////////////////////////
+// shapemeshes.cpp
+// ============
+// create and draw the meshes of the basic 3D shapes
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ShapeMeshes.h"
+#include "GLStateCache.h"
+#include "AssetPack.h"
+#include "MeshOptimizer.h"
+
+// GLM Math Header inclusions
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+// declare the global variables
+namespace
+{
+	// the detail of every level, from the full mesh down
+	const ShapeMeshes::SHAPE_DETAIL LEVEL_DETAILS[ShapeMeshes::LOD_COUNT] =
+	{
+		{ 36, 18, 18 },
+		{ 24, 12, 12 },
+		{ 16, 8, 8 },
+		{ 10, 6, 6 }
+	};
+	// radius of the torus ring and of its tube
+	const float TORUS_RADIUS = 1.0f;
+	const float TORUS_TUBE_RADIUS = 0.2f;
+	const float PI = 3.14159265358979f;
+
+	// vertex array bindings of the mesh vertices and of the
+	// per instance values
+	const GLuint VERTEX_BINDING = 0;
+	const GLuint INSTANCE_BINDING = 1;
+	// room in the shared buffers when they are first created,
+	// enough for all of the basic shapes
+	const GLsizei INITIAL_VERTEX_CAPACITY = 16384;
+	const GLsizei INITIAL_INDEX_CAPACITY = 65536;
+	// largest value of the normalized 16-bit positions and of
+	// the normalized 10-bit normals
+	const float POSITION_STEPS = 32767.0f;
+	const float NORMAL_STEPS = 511.0f;
+	// largest error of the packed vertices that still draws
+	// like the full ones - the position relative to the mesh
+	// radius, the normal in degrees and the texture coordinate
+	const float MAX_POSITION_ERROR = 1.0e-4f;
+	const float MAX_NORMAL_ERROR = 0.25f;
+	const float MAX_TEXTURE_ERROR = 1.0e-3f;
+
+	const char* const MESH_NAMES[ShapeMeshes::MESH_COUNT] =
+	{
+		"box",
+		"plane",
+		"cylinder",
+		"cone",
+		"prism",
+		"pyramid4",
+		"sphere",
+		"tapered_cylinder",
+		"torus"
+	};
+
+	/***********************************************************
+	 *  FloatToHalf()
+	 *
+	 *  Round a float to the nearest half float, the values too
+	 *  small for a normal half becoming subnormal ones.
+	 ***********************************************************/
+	GLushort FloatToHalf(float value)
+	{
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		uint32_t sign = (bits >> 16) & 0x8000;
+		int exponent = (int)((bits >> 23) & 0xFF) - 127 + 15;
+		uint32_t mantissa = bits & 0x7FFFFF;
+
+		if (exponent >= 31)
+		{
+			return (GLushort)(sign | 0x7C00);
+		}
+		if (exponent <= 0)
+		{
+			if (exponent < -10)
+			{
+				return (GLushort)sign;
+			}
+			mantissa |= 0x800000;
+			int shift = 14 - exponent;
+			uint32_t half = mantissa >> shift;
+			uint32_t rest = mantissa & ((1u << shift) - 1);
+			uint32_t halfway = 1u << (shift - 1);
+			if ((rest > halfway) || ((rest == halfway) && (half & 1)))
+			{
+				half++;
+			}
+			return (GLushort)(sign | half);
+		}
+
+		// rounding up can carry into the exponent, which is
+		// still the nearest half
+		uint32_t half = sign | ((uint32_t)exponent << 10) | (mantissa >> 13);
+		uint32_t rest = mantissa & 0x1FFF;
+		if ((rest > 0x1000) || ((rest == 0x1000) && (half & 1)))
+		{
+			half++;
+		}
+		return (GLushort)half;
+	}
+
+	/***********************************************************
+	 *  HalfToFloat()
+	 *
+	 *  Turn a half float back into a float.
+	 ***********************************************************/
+	float HalfToFloat(GLushort half)
+	{
+		int exponent = (half >> 10) & 0x1F;
+		int mantissa = half & 0x3FF;
+		float value = (exponent == 0) ? ldexpf((float)mantissa, -24) : ldexpf((float)(mantissa + 1024), exponent - 25);
+		return (half & 0x8000) ? -value : value;
+	}
+
+	/***********************************************************
+	 *  PackNormal()
+	 *
+	 *  Pack a normal into the signed 10-bit x, y and z fields
+	 *  of GL_INT_2_10_10_10_REV.
+	 ***********************************************************/
+	GLuint PackNormal(const glm::vec3& normal)
+	{
+		GLuint packed = 0;
+		for (int i = 0; i < 3; i++)
+		{
+			int value = (int)roundf(std::min(std::max(normal[i], -1.0f), 1.0f) * NORMAL_STEPS);
+			packed |= ((GLuint)value & 0x3FF) << (10 * i);
+		}
+		return packed;
+	}
+
+	/***********************************************************
+	 *  UnpackNormal()
+	 *
+	 *  Read a packed normal back the way OpenGL normalizes it.
+	 ***********************************************************/
+	glm::vec3 UnpackNormal(GLuint packed)
+	{
+		glm::vec3 normal;
+		for (int i = 0; i < 3; i++)
+		{
+			int value = (int)((packed >> (10 * i)) & 0x3FF);
+			value = (value >= 512) ? value - 1024 : value;
+			normal[i] = std::max((float)value / NORMAL_STEPS, -1.0f);
+		}
+		return normal;
+	}
+
+	/***********************************************************
+	 *  AddVertex()
+	 *
+	 *  Add an interleaved vertex to a mesh and return its index.
+	 ***********************************************************/
+	GLuint AddVertex(ShapeMeshes::MESH_DATA& mesh, const glm::vec3& position, const glm::vec3& normal, const glm::vec2& uv)
+	{
+		GLuint index = (GLuint)(mesh.vertices.size() / ShapeMeshes::FLOATS_PER_VERTEX);
+		const GLfloat vertex[ShapeMeshes::FLOATS_PER_VERTEX] =
+		{
+			position.x, position.y, position.z,
+			normal.x, normal.y, normal.z,
+			uv.x, uv.y
+		};
+		mesh.vertices.insert(mesh.vertices.end(), vertex, vertex + ShapeMeshes::FLOATS_PER_VERTEX);
+		return index;
+	}
+
+	/***********************************************************
+	 *  AddTriangle()
+	 *
+	 *  Add a triangle of existing vertices, listed counter
+	 *  clockwise as seen from the front.
+	 ***********************************************************/
+	void AddTriangle(ShapeMeshes::MESH_DATA& mesh, GLuint a, GLuint b, GLuint c)
+	{
+		mesh.indices.push_back(a);
+		mesh.indices.push_back(b);
+		mesh.indices.push_back(c);
+	}
+
+	/***********************************************************
+	 *  AddFlatTriangle()
+	 *
+	 *  Add a triangle with its own vertices and a flat normal.
+	 ***********************************************************/
+	void AddFlatTriangle(ShapeMeshes::MESH_DATA& mesh, const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2)
+	{
+		glm::vec3 normal = glm::normalize(glm::cross(p1 - p0, p2 - p0));
+		GLuint a = AddVertex(mesh, p0, normal, glm::vec2(0.0f, 0.0f));
+		GLuint b = AddVertex(mesh, p1, normal, glm::vec2(1.0f, 0.0f));
+		GLuint c = AddVertex(mesh, p2, normal, glm::vec2(0.5f, 1.0f));
+		AddTriangle(mesh, a, b, c);
+	}
+
+	/***********************************************************
+	 *  AddFlatQuad()
+	 *
+	 *  Add a quad with its own vertices and a flat normal, the
+	 *  corners listed counter clockwise as seen from the front.
+	 ***********************************************************/
+	void AddFlatQuad(ShapeMeshes::MESH_DATA& mesh,
+		const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3)
+	{
+		glm::vec3 normal = glm::normalize(glm::cross(p1 - p0, p3 - p0));
+		GLuint a = AddVertex(mesh, p0, normal, glm::vec2(0.0f, 0.0f));
+		GLuint b = AddVertex(mesh, p1, normal, glm::vec2(1.0f, 0.0f));
+		GLuint c = AddVertex(mesh, p2, normal, glm::vec2(1.0f, 1.0f));
+		GLuint d = AddVertex(mesh, p3, normal, glm::vec2(0.0f, 1.0f));
+		AddTriangle(mesh, a, b, c);
+		AddTriangle(mesh, a, c, d);
+	}
+
+	/***********************************************************
+	 *  AddFace()
+	 *
+	 *  Add a rectangle around a center point, spanned by two
+	 *  half extent vectors whose cross product faces out.
+	 ***********************************************************/
+	void AddFace(ShapeMeshes::MESH_DATA& mesh, const glm::vec3& center, const glm::vec3& right, const glm::vec3& up)
+	{
+		AddFlatQuad(mesh, center - right - up, center + right - up, center + right + up, center - right + up);
+	}
+
+	/***********************************************************
+	 *  RingPoint()
+	 *
+	 *  Get the direction of one of a number of segments around
+	 *  the Y axis.  The angle turns from +X towards -Z, which
+	 *  keeps the side triangles counter clockwise as seen from
+	 *  outside.
+	 ***********************************************************/
+	glm::vec3 RingPoint(int segment, int segmentCount)
+	{
+		float angle = 2.0f * PI * segment / segmentCount;
+		return glm::vec3(cosf(angle), 0.0f, -sinf(angle));
+	}
+
+	/***********************************************************
+	 *  AddCap()
+	 *
+	 *  Add a round cap at a height, facing up or down.
+	 ***********************************************************/
+	void AddCap(ShapeMeshes::MESH_DATA& mesh, const ShapeMeshes::SHAPE_DETAIL& detail, float radius, float height, bool bFacingUp)
+	{
+		glm::vec3 normal(0.0f, bFacingUp ? 1.0f : -1.0f, 0.0f);
+		GLuint center = AddVertex(mesh, glm::vec3(0.0f, height, 0.0f), normal, glm::vec2(0.5f, 0.5f));
+		GLuint first = 0;
+
+		for (int i = 0; i <= detail.segments; i++)
+		{
+			glm::vec3 direction = RingPoint(i, detail.segments);
+			GLuint index = AddVertex(mesh, direction * radius + glm::vec3(0.0f, height, 0.0f), normal,
+				glm::vec2(0.5f + 0.5f * direction.x, 0.5f - 0.5f * direction.z));
+			first = (i == 0) ? index : first;
+		}
+
+		for (int i = 0; i < detail.segments; i++)
+		{
+			if (bFacingUp)
+			{
+				AddTriangle(mesh, center, first + i, first + i + 1);
+			}
+			else
+			{
+				AddTriangle(mesh, center, first + i + 1, first + i);
+			}
+		}
+	}
+
+	/***********************************************************
+	 *  AddTube()
+	 *
+	 *  Add the side of a tube from y = 0 to y = 1, with
+	 *  different bottom and top radii for the tapered shapes.
+	 *  A top radius of zero makes a cone.
+	 ***********************************************************/
+	void AddTube(ShapeMeshes::MESH_DATA& mesh, const ShapeMeshes::SHAPE_DETAIL& detail, float bottomRadius, float topRadius)
+	{
+		// the normals lean up by the slope of the side
+		float slope = bottomRadius - topRadius;
+		GLuint first = 0;
+
+		for (int i = 0; i <= detail.segments; i++)
+		{
+			glm::vec3 direction = RingPoint(i, detail.segments);
+			glm::vec3 normal = glm::normalize(direction + glm::vec3(0.0f, slope, 0.0f));
+			float u = (float)i / detail.segments;
+
+			GLuint bottom = AddVertex(mesh, direction * bottomRadius, normal, glm::vec2(u, 0.0f));
+			AddVertex(mesh, direction * topRadius + glm::vec3(0.0f, 1.0f, 0.0f), normal, glm::vec2(u, 1.0f));
+			first = (i == 0) ? bottom : first;
+		}
+
+		for (int i = 0; i < detail.segments; i++)
+		{
+			GLuint bottom0 = first + i * 2;
+			GLuint top0 = bottom0 + 1;
+			GLuint bottom1 = bottom0 + 2;
+			GLuint top1 = bottom0 + 3;
+
+			AddTriangle(mesh, bottom0, bottom1, top1);
+			// the top edge of a cone is a point
+			if (topRadius > 0.0f)
+			{
+				AddTriangle(mesh, bottom0, top1, top0);
+			}
+		}
+	}
+
+	/***********************************************************
+	 *  AddSphere()
+	 *
+	 *  Add a sphere of radius 1 around the origin, made of
+	 *  rings from the bottom pole to the top pole.
+	 ***********************************************************/
+	void AddSphere(ShapeMeshes::MESH_DATA& mesh, const ShapeMeshes::SHAPE_DETAIL& detail)
+	{
+		const int ringVertices = detail.segments + 1;
+
+		for (int stack = 0; stack <= detail.rings; stack++)
+		{
+			float latitude = PI * stack / detail.rings - 0.5f * PI;
+			for (int i = 0; i <= detail.segments; i++)
+			{
+				glm::vec3 position = RingPoint(i, detail.segments) * cosf(latitude) + glm::vec3(0.0f, sinf(latitude), 0.0f);
+				AddVertex(mesh, position, position,
+					glm::vec2((float)i / detail.segments, (float)stack / detail.rings));
+			}
+		}
+
+		for (int stack = 0; stack < detail.rings; stack++)
+		{
+			for (int i = 0; i < detail.segments; i++)
+			{
+				GLuint bottom0 = stack * ringVertices + i;
+				GLuint bottom1 = bottom0 + 1;
+				GLuint top0 = bottom0 + ringVertices;
+				GLuint top1 = top0 + 1;
+
+				// skip the triangles that collapse at the poles
+				if (stack > 0)
+				{
+					AddTriangle(mesh, bottom0, bottom1, top1);
+				}
+				if (stack < detail.rings - 1)
+				{
+					AddTriangle(mesh, bottom0, top1, top0);
+				}
+			}
+		}
+	}
+
+	/***********************************************************
+	 *  AddTorus()
+	 *
+	 *  Add a torus lying in the XZ plane around the origin.
+	 ***********************************************************/
+	void AddTorus(ShapeMeshes::MESH_DATA& mesh, const ShapeMeshes::SHAPE_DETAIL& detail)
+	{
+		const int tubeVertices = detail.tubeSegments + 1;
+
+		for (int i = 0; i <= detail.segments; i++)
+		{
+			glm::vec3 direction = RingPoint(i, detail.segments);
+			for (int j = 0; j <= detail.tubeSegments; j++)
+			{
+				float angle = 2.0f * PI * j / detail.tubeSegments;
+				glm::vec3 normal = direction * cosf(angle) + glm::vec3(0.0f, sinf(angle), 0.0f);
+				AddVertex(mesh, direction * TORUS_RADIUS + normal * TORUS_TUBE_RADIUS, normal,
+					glm::vec2((float)i / detail.segments, (float)j / detail.tubeSegments));
+			}
+		}
+
+		for (int i = 0; i < detail.segments; i++)
+		{
+			for (int j = 0; j < detail.tubeSegments; j++)
+			{
+				GLuint a = i * tubeVertices + j;
+				GLuint b = a + tubeVertices;
+				AddTriangle(mesh, a, b, b + 1);
+				AddTriangle(mesh, a, b + 1, a + 1);
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  ShapeMeshes()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ShapeMeshes::ShapeMeshes()
+{
+	m_pAssetPack = NULL;
+	m_vertexFormat = VERTEX_FULL;
+	for (int i = 0; i < MESH_COUNT; i++)
+	{
+		for (int lod = 0; lod < LOD_COUNT; lod++)
+		{
+			m_meshes[i][lod].firstIndex = 0;
+			m_meshes[i][lod].indexCount = 0;
+			m_meshes[i][lod].baseVertex = 0;
+			m_meshes[i][lod].positionScale = glm::vec4(1.0f, 1.0f, 1.0f, 0.0f);
+			m_meshes[i][lod].positionOffset = glm::vec4(0.0f);
+		}
+		m_bounds[i].minimum = glm::vec3(0.0f);
+		m_bounds[i].maximum = glm::vec3(0.0f);
+		m_bounds[i].center = glm::vec3(0.0f);
+		m_bounds[i].radius = 0.0f;
+	}
+	m_vertexArrayID = 0;
+	m_vertexBufferID = 0;
+	m_indexBufferID = 0;
+	m_vertexCount = 0;
+	m_vertexCapacity = 0;
+	m_indexCount = 0;
+	m_indexCapacity = 0;
+	m_instanceBufferID = 0;
+	m_instanceCapacity = 0;
+	m_commandBufferID = 0;
+	m_commandCapacity = 0;
+}
+
+/***********************************************************
+ *  ~ShapeMeshes()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ShapeMeshes::~ShapeMeshes()
+{
+	if (m_vertexArrayID != 0)
+	{
+		GLStateCache::DeleteVertexArrays(1, &m_vertexArrayID);
+		GLStateCache::DeleteBuffers(1, &m_vertexBufferID);
+		GLStateCache::DeleteBuffers(1, &m_indexBufferID);
+		GLStateCache::DeleteBuffers(1, &m_instanceBufferID);
+		GLStateCache::DeleteBuffers(1, &m_commandBufferID);
+		m_vertexArrayID = 0;
+	}
+}
+
+/***********************************************************
+ *  SetAssetPack()
+ *
+ *  This method is used to set the asset pack the meshes are
+ *  taken from.  Shapes missing from the pack are generated.
+ ***********************************************************/
+void ShapeMeshes::SetAssetPack(const AssetPack* pAssetPack)
+{
+	m_pAssetPack = pAssetPack;
+}
+
+/***********************************************************
+ *  SetVertexFormat()
+ *
+ *  This method is used to choose how the vertices of the
+ *  meshes are stored.  The vertex array is laid out for one
+ *  format, so it can only be changed before the first mesh
+ *  is loaded.
+ ***********************************************************/
+bool ShapeMeshes::SetVertexFormat(VERTEX_FORMAT format)
+{
+	if (m_vertexArrayID != 0)
+	{
+		std::cout << "ERROR: the vertex format cannot change after the meshes are loaded" << std::endl;
+		return(false);
+	}
+
+	m_vertexFormat = format;
+	return(true);
+}
+
+/***********************************************************
+ *  GetVertexFormat()
+ *
+ *  This method is used to get how the vertices are stored.
+ ***********************************************************/
+ShapeMeshes::VERTEX_FORMAT ShapeMeshes::GetVertexFormat() const
+{
+	return m_vertexFormat;
+}
+
+/***********************************************************
+ *  GetVertexBytes()
+ *
+ *  This method is used to get the bytes of vertex buffer
+ *  the loaded meshes use.
+ ***********************************************************/
+GLsizeiptr ShapeMeshes::GetVertexBytes() const
+{
+	return (GLsizeiptr)m_vertexCount * GetVertexSize();
+}
+
+/***********************************************************
+ *  GetVertexSize()
+ *
+ *  This method is used to get the size of one vertex in the
+ *  chosen format.
+ ***********************************************************/
+GLsizei ShapeMeshes::GetVertexSize() const
+{
+	return (m_vertexFormat == VERTEX_PACKED) ? (GLsizei)sizeof(PACKED_VERTEX) : FLOATS_PER_VERTEX * sizeof(GLfloat);
+}
+
+/***********************************************************
+ *  GetMeshName()
+ *
+ *  This method is used to get the name of a shape's mesh.
+ ***********************************************************/
+const char* ShapeMeshes::GetMeshName(MESH_TYPE type)
+{
+	return MESH_NAMES[type];
+}
+
+/***********************************************************
+ *  GetMeshLevelName()
+ *
+ *  This method is used to get the name a level of a shape's
+ *  mesh is stored under in the asset pack.  The full mesh
+ *  keeps the name of the shape.
+ ***********************************************************/
+std::string ShapeMeshes::GetMeshLevelName(MESH_TYPE type, int lod)
+{
+	if (lod == 0)
+	{
+		return MESH_NAMES[type];
+	}
+	return std::string(MESH_NAMES[type]) + "_lod" + std::to_string(lod);
+}
+
+/***********************************************************
+ *  HasLevels()
+ *
+ *  This method is used to check whether a shape is built
+ *  with fewer segments at the coarser levels of detail -
+ *  only the shapes with round sides are.
+ ***********************************************************/
+bool ShapeMeshes::HasLevels(MESH_TYPE type)
+{
+	switch (type)
+	{
+	case MESH_CYLINDER:
+	case MESH_CONE:
+	case MESH_SPHERE:
+	case MESH_TAPERED_CYLINDER:
+	case MESH_TORUS:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/***********************************************************
+ *  GenerateMesh()
+ *
+ *  This method is used to generate the vertices and indices
+ *  of a shape at a level of detail.  Only the round shapes
+ *  have fewer segments at the coarser levels.
+ ***********************************************************/
+void ShapeMeshes::GenerateMesh(MESH_TYPE type, int lod, MESH_DATA& mesh)
+{
+	GenerateShape(type, LEVEL_DETAILS[std::min(std::max(lod, 0), LOD_COUNT - 1)], mesh);
+}
+
+/***********************************************************
+ *  GenerateShape()
+ *
+ *  This method is used to generate the vertices and indices
+ *  of a shape with any number of segments and rings.  The
+ *  triangles are put in vertex cache order and the vertices
+ *  in the order the triangles use them, so the GPU runs the
+ *  vertex shader as few times as it can for every draw.
+ ***********************************************************/
+void ShapeMeshes::GenerateShape(MESH_TYPE type, const SHAPE_DETAIL& detail, MESH_DATA& mesh)
+{
+	// fewer segments than this do not make a closed shape
+	SHAPE_DETAIL validDetail;
+	validDetail.segments = std::max(detail.segments, 3);
+	validDetail.rings = std::max(detail.rings, 2);
+	validDetail.tubeSegments = std::max(detail.tubeSegments, 3);
+
+	BuildShape(type, validDetail, mesh);
+
+	// a coarse grid can already fit the cache better in the
+	// order it was built, so the new order is only kept when
+	// it transforms fewer vertices
+	GLuint vertexCount = (GLuint)(mesh.vertices.size() / FLOATS_PER_VERTEX);
+	std::vector<GLuint> ordered = mesh.indices;
+	MeshOptimizer::OptimizeVertexCache(ordered, vertexCount);
+	if (MeshOptimizer::ComputeACMR(ordered, vertexCount, MeshOptimizer::DEFAULT_CACHE_SIZE) <
+		MeshOptimizer::ComputeACMR(mesh.indices, vertexCount, MeshOptimizer::DEFAULT_CACHE_SIZE))
+	{
+		mesh.indices.swap(ordered);
+	}
+	MeshOptimizer::OptimizeVertexFetch(mesh.vertices, mesh.indices, FLOATS_PER_VERTEX);
+}
+
+/***********************************************************
+ *  CheckMeshes()
+ *
+ *  This method is used to measure the average cache miss
+ *  ratio of every level of every shape, in the order the
+ *  triangles are built and after they were reordered.  The
+ *  check fails when reordering made any of them worse.
+ ***********************************************************/
+bool ShapeMeshes::CheckMeshes(std::string& report)
+{
+	std::ostringstream output;
+	output << std::fixed << std::setprecision(3);
+	output << "mesh                    triangles  vertices  ACMR built  ACMR ordered\n";
+
+	bool bPassed = true;
+	for (int i = 0; i < MESH_COUNT; i++)
+	{
+		MESH_TYPE type = (MESH_TYPE)i;
+		int levelCount = HasLevels(type) ? LOD_COUNT : 1;
+		for (int lod = 0; lod < levelCount; lod++)
+		{
+			MESH_DATA built;
+			BuildShape(type, LEVEL_DETAILS[lod], built);
+			GLuint builtVertices = (GLuint)(built.vertices.size() / FLOATS_PER_VERTEX);
+			float builtRatio = MeshOptimizer::ComputeACMR(built.indices, builtVertices,
+				MeshOptimizer::DEFAULT_CACHE_SIZE);
+
+			MESH_DATA ordered;
+			GenerateMesh(type, lod, ordered);
+			GLuint orderedVertices = (GLuint)(ordered.vertices.size() / FLOATS_PER_VERTEX);
+			float orderedRatio = MeshOptimizer::ComputeACMR(ordered.indices, orderedVertices,
+				MeshOptimizer::DEFAULT_CACHE_SIZE);
+
+			bool bMeshPassed = (orderedRatio <= builtRatio) && (ordered.indices.size() == built.indices.size());
+			bPassed = bPassed && bMeshPassed;
+			output << std::left << std::setw(24) << GetMeshLevelName(type, lod) << std::right
+				<< std::setw(9) << ordered.indices.size() / 3 << std::setw(10) << orderedVertices
+				<< std::setw(12) << builtRatio << std::setw(14) << orderedRatio
+				<< (bMeshPassed ? "" : " FAILED") << "\n";
+		}
+	}
+
+	report = output.str();
+	return(bPassed);
+}
+
+/***********************************************************
+ *  PackVertices()
+ *
+ *  This method is used to pack interleaved mesh vertices.
+ *  The positions are stored relative to the box around the
+ *  mesh, so the 16 bits cover just the space the mesh takes,
+ *  and the scale and offset turn them back.  A flat side of
+ *  the box keeps a tiny scale so nothing divides by zero.
+ ***********************************************************/
+void ShapeMeshes::PackVertices(const GLfloat* vertices, GLsizei vertexCount, std::vector<PACKED_VERTEX>& packed,
+	glm::vec3& positionScale, glm::vec3& positionOffset)
+{
+	MESH_BOUNDS bounds;
+	ComputeBounds(vertices, vertexCount, bounds);
+	positionOffset = bounds.center;
+	positionScale = glm::max((bounds.maximum - bounds.minimum) * 0.5f, glm::vec3(1.0e-6f));
+
+	packed.resize(vertexCount);
+	for (GLsizei i = 0; i < vertexCount; i++)
+	{
+		const GLfloat* vertex = vertices + i * FLOATS_PER_VERTEX;
+		PACKED_VERTEX& packedVertex = packed[i];
+		for (int axis = 0; axis < 3; axis++)
+		{
+			float value = (vertex[axis] - positionOffset[axis]) / positionScale[axis];
+			value = std::min(std::max(value, -1.0f), 1.0f);
+			packedVertex.position[axis] = (GLshort)roundf(value * POSITION_STEPS);
+		}
+		packedVertex.position[3] = 0;
+		packedVertex.normal = PackNormal(glm::vec3(vertex[3], vertex[4], vertex[5]));
+		packedVertex.textureCoordinate[0] = FloatToHalf(vertex[6]);
+		packedVertex.textureCoordinate[1] = FloatToHalf(vertex[7]);
+	}
+}
+
+/***********************************************************
+ *  UnpackVertex()
+ *
+ *  This method is used to turn a packed vertex back into
+ *  interleaved floats, with the same rules OpenGL uses for
+ *  reading the normalized and half float values.
+ ***********************************************************/
+void ShapeMeshes::UnpackVertex(const PACKED_VERTEX& packed, const glm::vec3& positionScale,
+	const glm::vec3& positionOffset, GLfloat vertex[FLOATS_PER_VERTEX])
+{
+	for (int axis = 0; axis < 3; axis++)
+	{
+		float value = std::max((float)packed.position[axis] / POSITION_STEPS, -1.0f);
+		vertex[axis] = value * positionScale[axis] + positionOffset[axis];
+	}
+	glm::vec3 normal = UnpackNormal(packed.normal);
+	vertex[3] = normal.x;
+	vertex[4] = normal.y;
+	vertex[5] = normal.z;
+	vertex[6] = HalfToFloat(packed.textureCoordinate[0]);
+	vertex[7] = HalfToFloat(packed.textureCoordinate[1]);
+}
+
+/***********************************************************
+ *  CheckVertexFormats()
+ *
+ *  This method is used to pack every level of every shape
+ *  and compare the unpacked vertices with the full ones.
+ *  The position error is relative to the radius of the
+ *  mesh, so it is the share of the object's size on screen
+ *  a vertex can move, and the normal error is the angle the
+ *  lighting sees, after the normal is normalized again.
+ ***********************************************************/
+bool ShapeMeshes::CheckVertexFormats(std::string& report)
+{
+	std::ostringstream output;
+	output << "mesh                    full bytes  packed bytes  position error  normal degrees  UV error\n";
+
+	bool bPassed = true;
+	size_t fullBytes = 0;
+	size_t packedBytes = 0;
+	for (int i = 0; i < MESH_COUNT; i++)
+	{
+		MESH_TYPE type = (MESH_TYPE)i;
+		int levelCount = HasLevels(type) ? LOD_COUNT : 1;
+		for (int lod = 0; lod < levelCount; lod++)
+		{
+			MESH_DATA mesh;
+			GenerateMesh(type, lod, mesh);
+			GLsizei vertexCount = (GLsizei)(mesh.vertices.size() / FLOATS_PER_VERTEX);
+
+			MESH_BOUNDS bounds;
+			ComputeBounds(mesh.vertices.data(), vertexCount, bounds);
+			std::vector<PACKED_VERTEX> packed;
+			glm::vec3 positionScale;
+			glm::vec3 positionOffset;
+			PackVertices(mesh.vertices.data(), vertexCount, packed, positionScale, positionOffset);
+
+			float positionError = 0.0f;
+			float normalError = 0.0f;
+			float textureError = 0.0f;
+			for (GLsizei v = 0; v < vertexCount; v++)
+			{
+				const GLfloat* full = &mesh.vertices[v * FLOATS_PER_VERTEX];
+				GLfloat unpacked[FLOATS_PER_VERTEX];
+				UnpackVertex(packed[v], positionScale, positionOffset, unpacked);
+
+				glm::vec3 fullPosition(full[0], full[1], full[2]);
+				glm::vec3 unpackedPosition(unpacked[0], unpacked[1], unpacked[2]);
+				positionError = std::max(positionError,
+					glm::length(unpackedPosition - fullPosition) / std::max(bounds.radius, 1.0e-6f));
+
+				glm::vec3 fullNormal = glm::normalize(glm::vec3(full[3], full[4], full[5]));
+				glm::vec3 unpackedNormal = glm::normalize(glm::vec3(unpacked[3], unpacked[4], unpacked[5]));
+				float cosine = std::min(std::max(glm::dot(fullNormal, unpackedNormal), -1.0f), 1.0f);
+				normalError = std::max(normalError, acosf(cosine) * 180.0f / PI);
+
+				textureError = std::max(textureError,
+					std::max(fabsf(unpacked[6] - full[6]), fabsf(unpacked[7] - full[7])));
+			}
+
+			bool bMeshPassed = (positionError <= MAX_POSITION_ERROR) && (normalError <= MAX_NORMAL_ERROR) &&
+				(textureError <= MAX_TEXTURE_ERROR);
+			bPassed = bPassed && bMeshPassed;
+			fullBytes += mesh.vertices.size() * sizeof(GLfloat);
+			packedBytes += packed.size() * sizeof(PACKED_VERTEX);
+			output << std::left << std::setw(24) << GetMeshLevelName(type, lod) << std::right
+				<< std::setw(10) << mesh.vertices.size() * sizeof(GLfloat)
+				<< std::setw(14) << packed.size() * sizeof(PACKED_VERTEX)
+				<< std::scientific << std::setprecision(2) << std::setw(16) << positionError
+				<< std::fixed << std::setprecision(3) << std::setw(16) << normalError
+				<< std::scientific << std::setprecision(2) << std::setw(10) << textureError
+				<< std::defaultfloat << (bMeshPassed ? "" : " FAILED") << "\n";
+		}
+	}
+	output << "total                   " << std::setw(10) << fullBytes << std::setw(14) << packedBytes
+		<< "  (" << std::fixed << std::setprecision(1) << 100.0 * packedBytes / std::max(fullBytes, (size_t)1)
+		<< "% of the full size)\n";
+
+	report = output.str();
+	return(bPassed);
+}
+
+/***********************************************************
+ *  BuildShape()
+ *
+ *  This method is used to build the vertices and indices of
+ *  a shape, in the order they are generated.  The shapes fit
+ *  in a unit box: the box, prism and pyramid are centered on
+ *  the origin, the plane spans -1 to 1, and the round shapes
+ *  have a radius of 1, standing from y = 0 to y = 1 apart
+ *  from the sphere and torus, which are centered.
+ ***********************************************************/
+void ShapeMeshes::BuildShape(MESH_TYPE type, const SHAPE_DETAIL& detail, MESH_DATA& mesh)
+{
+	mesh.vertices.clear();
+	mesh.indices.clear();
+
+	switch (type)
+	{
+	case MESH_BOX:
+		AddFace(mesh, glm::vec3(0.0f, 0.0f, 0.5f), glm::vec3(0.5f, 0.0f, 0.0f), glm::vec3(0.0f, 0.5f, 0.0f));
+		AddFace(mesh, glm::vec3(0.0f, 0.0f, -0.5f), glm::vec3(-0.5f, 0.0f, 0.0f), glm::vec3(0.0f, 0.5f, 0.0f));
+		AddFace(mesh, glm::vec3(0.5f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, -0.5f), glm::vec3(0.0f, 0.5f, 0.0f));
+		AddFace(mesh, glm::vec3(-0.5f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 0.5f), glm::vec3(0.0f, 0.5f, 0.0f));
+		AddFace(mesh, glm::vec3(0.0f, 0.5f, 0.0f), glm::vec3(0.5f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, -0.5f));
+		AddFace(mesh, glm::vec3(0.0f, -0.5f, 0.0f), glm::vec3(0.5f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 0.5f));
+		break;
+
+	case MESH_PLANE:
+		AddFace(mesh, glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f));
+		break;
+
+	case MESH_CYLINDER:
+		AddTube(mesh, detail, 1.0f, 1.0f);
+		AddCap(mesh, detail, 1.0f, 1.0f, true);
+		AddCap(mesh, detail, 1.0f, 0.0f, false);
+		break;
+
+	case MESH_CONE:
+		AddTube(mesh, detail, 1.0f, 0.0f);
+		AddCap(mesh, detail, 1.0f, 0.0f, false);
+		break;
+
+	case MESH_PRISM:
+		AddFlatTriangle(mesh, glm::vec3(-0.5f, -0.5f, 0.5f), glm::vec3(0.5f, -0.5f, 0.5f), glm::vec3(0.0f, 0.5f, 0.5f));
+		AddFlatTriangle(mesh, glm::vec3(0.5f, -0.5f, -0.5f), glm::vec3(-0.5f, -0.5f, -0.5f), glm::vec3(0.0f, 0.5f, -0.5f));
+		AddFlatQuad(mesh, glm::vec3(0.5f, -0.5f, 0.5f), glm::vec3(0.5f, -0.5f, -0.5f),
+			glm::vec3(0.0f, 0.5f, -0.5f), glm::vec3(0.0f, 0.5f, 0.5f));
+		AddFlatQuad(mesh, glm::vec3(-0.5f, -0.5f, -0.5f), glm::vec3(-0.5f, -0.5f, 0.5f),
+			glm::vec3(0.0f, 0.5f, 0.5f), glm::vec3(0.0f, 0.5f, -0.5f));
+		AddFace(mesh, glm::vec3(0.0f, -0.5f, 0.0f), glm::vec3(0.5f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 0.5f));
+		break;
+
+	case MESH_PYRAMID4:
+		AddFlatTriangle(mesh, glm::vec3(-0.5f, -0.5f, 0.5f), glm::vec3(0.5f, -0.5f, 0.5f), glm::vec3(0.0f, 0.5f, 0.0f));
+		AddFlatTriangle(mesh, glm::vec3(0.5f, -0.5f, 0.5f), glm::vec3(0.5f, -0.5f, -0.5f), glm::vec3(0.0f, 0.5f, 0.0f));
+		AddFlatTriangle(mesh, glm::vec3(0.5f, -0.5f, -0.5f), glm::vec3(-0.5f, -0.5f, -0.5f), glm::vec3(0.0f, 0.5f, 0.0f));
+		AddFlatTriangle(mesh, glm::vec3(-0.5f, -0.5f, -0.5f), glm::vec3(-0.5f, -0.5f, 0.5f), glm::vec3(0.0f, 0.5f, 0.0f));
+		AddFace(mesh, glm::vec3(0.0f, -0.5f, 0.0f), glm::vec3(0.5f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 0.5f));
+		break;
+
+	case MESH_SPHERE:
+		AddSphere(mesh, detail);
+		break;
+
+	case MESH_TAPERED_CYLINDER:
+		AddTube(mesh, detail, 1.0f, 0.5f);
+		AddCap(mesh, detail, 0.5f, 1.0f, true);
+		AddCap(mesh, detail, 1.0f, 0.0f, false);
+		break;
+
+	case MESH_TORUS:
+		AddTorus(mesh, detail);
+		break;
+
+	default:
+		break;
+	}
+}
+
+/***********************************************************
+ *  CreateBuffers()
+ *
+ *  This method is used to create the vertex array shared by
+ *  every mesh, with empty vertex, index and command buffers
+ *  and an instance buffer holding a single untransformed
+ *  white instance.  The vertex array reads the vertices and
+ *  the instances through two buffer bindings, so a buffer
+ *  can be replaced without describing the attributes again.
+ ***********************************************************/
+void ShapeMeshes::CreateBuffers()
+{
+	INSTANCE_DATA instance;
+	instance.model = glm::mat4(1.0f);
+	instance.color = glm::vec4(1.0f);
+	instance.UVscale = glm::vec2(1.0f, 1.0f);
+	instance.textureArray = -1;
+	instance.textureLayer = 0;
+	instance.materialIndex = 0;
+	instance.positionScale = glm::vec4(1.0f, 1.0f, 1.0f, 0.0f);
+	instance.positionOffset = glm::vec4(0.0f);
+
+	GLuint buffers[4];
+	glGenBuffers(4, buffers);
+	m_vertexBufferID = buffers[0];
+	m_indexBufferID = buffers[1];
+	m_instanceBufferID = buffers[2];
+	m_commandBufferID = buffers[3];
+
+	GLStateCache::BindBuffer(GL_ARRAY_BUFFER, m_instanceBufferID);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(INSTANCE_DATA), &instance, GL_STREAM_DRAW);
+	GLStateCache::BindBuffer(GL_ARRAY_BUFFER, 0);
+	m_instanceCapacity = 1;
+
+	glGenVertexArrays(1, &m_vertexArrayID);
+	GLStateCache::BindVertexArray(m_vertexArrayID);
+	GLStateCache::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBufferID);
+
+	// position, normal and texture coordinate - the packed
+	// values are normalized or widened to floats as they are
+	// read, so the vertex shader is the same for both formats
+	if (m_vertexFormat == VERTEX_PACKED)
+	{
+		glVertexAttribFormat(0, 3, GL_SHORT, GL_TRUE, (GLuint)offsetof(PACKED_VERTEX, position));
+		glVertexAttribFormat(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, (GLuint)offsetof(PACKED_VERTEX, normal));
+		glVertexAttribFormat(2, 2, GL_HALF_FLOAT, GL_FALSE, (GLuint)offsetof(PACKED_VERTEX, textureCoordinate));
+	}
+	else
+	{
+		glVertexAttribFormat(0, 3, GL_FLOAT, GL_FALSE, 0);
+		glVertexAttribFormat(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat));
+		glVertexAttribFormat(2, 2, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat));
+	}
+	for (GLuint location = 0; location < FIRST_INSTANCE_ATTRIBUTE; location++)
+	{
+		glVertexAttribBinding(location, VERTEX_BINDING);
+		glEnableVertexAttribArray(location);
+	}
+
+	// model matrix columns, color, UV scale, the texture and
+	// material indices and then the position scale and offset,
+	// advancing once per instance
+	GLuint location = FIRST_INSTANCE_ATTRIBUTE;
+	for (int column = 0; column < 4; column++)
+	{
+		glVertexAttribFormat(location++, 4, GL_FLOAT, GL_FALSE,
+			(GLuint)(offsetof(INSTANCE_DATA, model) + column * sizeof(glm::vec4)));
+	}
+	glVertexAttribFormat(location++, 4, GL_FLOAT, GL_FALSE, (GLuint)offsetof(INSTANCE_DATA, color));
+	glVertexAttribFormat(location++, 2, GL_FLOAT, GL_FALSE, (GLuint)offsetof(INSTANCE_DATA, UVscale));
+	glVertexAttribIFormat(location++, 3, GL_INT, (GLuint)offsetof(INSTANCE_DATA, textureArray));
+	glVertexAttribFormat(location++, 4, GL_FLOAT, GL_FALSE, (GLuint)offsetof(INSTANCE_DATA, positionScale));
+	glVertexAttribFormat(location++, 4, GL_FLOAT, GL_FALSE, (GLuint)offsetof(INSTANCE_DATA, positionOffset));
+	for (GLuint instanceLocation = FIRST_INSTANCE_ATTRIBUTE; instanceLocation < location; instanceLocation++)
+	{
+		glVertexAttribBinding(instanceLocation, INSTANCE_BINDING);
+		glEnableVertexAttribArray(instanceLocation);
+	}
+
+	glBindVertexBuffer(INSTANCE_BINDING, m_instanceBufferID, 0, sizeof(INSTANCE_DATA));
+	glVertexBindingDivisor(INSTANCE_BINDING, 1);
+
+	GLStateCache::BindVertexArray(0);
+}
+
+/***********************************************************
+ *  GrowBuffer()
+ *
+ *  This method is used to replace a buffer with a larger
+ *  one, copying over the part that is already used.
+ ***********************************************************/
+void ShapeMeshes::GrowBuffer(GLuint& bufferID, GLsizeiptr usedBytes, GLsizeiptr newBytes)
+{
+	GLuint newBufferID = 0;
+	glGenBuffers(1, &newBufferID);
+	GLStateCache::BindBuffer(GL_COPY_WRITE_BUFFER, newBufferID);
+	glBufferData(GL_COPY_WRITE_BUFFER, newBytes, NULL, GL_STATIC_DRAW);
+
+	if (usedBytes > 0)
+	{
+		GLStateCache::BindBuffer(GL_COPY_READ_BUFFER, bufferID);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, usedBytes);
+		GLStateCache::BindBuffer(GL_COPY_READ_BUFFER, 0);
+	}
+	GLStateCache::BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	GLStateCache::DeleteBuffers(1, &bufferID);
+	bufferID = newBufferID;
+}
+
+/***********************************************************
+ *  UploadInstances()
+ *
+ *  This method is used to replace the per instance values
+ *  that the meshes are drawn with.  The buffer storage is
+ *  orphaned, so the upload does not wait for draws that
+ *  still read the previous values, and only grows when more
+ *  instances are uploaded than ever before.
+ ***********************************************************/
+void ShapeMeshes::UploadInstances(const INSTANCE_DATA* instances, int instanceCount)
+{
+	if (m_vertexArrayID == 0)
+	{
+		CreateBuffers();
+	}
+	if (instanceCount <= 0)
+	{
+		return;
+	}
+
+	if (instanceCount > m_instanceCapacity)
+	{
+		m_instanceCapacity = std::max(instanceCount, m_instanceCapacity * 2);
+	}
+
+	GLStateCache::BindBuffer(GL_ARRAY_BUFFER, m_instanceBufferID);
+	glBufferData(GL_ARRAY_BUFFER, m_instanceCapacity * sizeof(INSTANCE_DATA), NULL, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, instanceCount * sizeof(INSTANCE_DATA), instances);
+	GLStateCache::BindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+/***********************************************************
+ *  UploadDrawCommands()
+ *
+ *  This method is used to replace the indirect draw commands
+ *  in the command buffer, which is orphaned and grown the
+ *  same way as the instance buffer.
+ ***********************************************************/
+void ShapeMeshes::UploadDrawCommands(const DRAW_COMMAND* commands, int commandCount)
+{
+	if (m_vertexArrayID == 0)
+	{
+		CreateBuffers();
+	}
+	if (commandCount <= 0)
+	{
+		return;
+	}
+
+	if (commandCount > m_commandCapacity)
+	{
+		m_commandCapacity = std::max(commandCount, m_commandCapacity * 2);
+	}
+
+	GLStateCache::BindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBufferID);
+	glBufferData(GL_DRAW_INDIRECT_BUFFER, m_commandCapacity * sizeof(DRAW_COMMAND), NULL, GL_STREAM_DRAW);
+	glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, commandCount * sizeof(DRAW_COMMAND), commands);
+	GLStateCache::BindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+/***********************************************************
+ *  BindMeshes()
+ *
+ *  This method is used to bind the vertex array shared by
+ *  every mesh.  It stays bound until another one is bound,
+ *  so unbind it before changing any element array buffer.
+ ***********************************************************/
+void ShapeMeshes::BindMeshes()
+{
+	GLStateCache::BindVertexArray(m_vertexArrayID);
+}
+
+/***********************************************************
+ *  DrawMeshInstanced()
+ *
+ *  This method is used to draw a range of the uploaded
+ *  instances of a mesh with a single draw call.  The meshes
+ *  must be bound.  The base instance moves the instance
+ *  attributes to the start of the range.
+ ***********************************************************/
+void ShapeMeshes::DrawMeshInstanced(MESH_TYPE type, int lod, int firstInstance, int instanceCount)
+{
+	const MESH_RANGE& mesh = m_meshes[type][lod];
+	if ((mesh.indexCount == 0) || (instanceCount <= 0))
+	{
+		return;
+	}
+
+	glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, mesh.indexCount, GL_UNSIGNED_INT,
+		(void*)(mesh.firstIndex * sizeof(GLuint)), instanceCount, mesh.baseVertex, (GLuint)firstInstance);
+}
+
+/***********************************************************
+ *  GetDrawCommand()
+ *
+ *  This method is used to fill in the indirect draw command
+ *  for a range of the uploaded instances of one level of a
+ *  mesh.  A mesh that is not loaded gets a command that
+ *  draws nothing.
+ ***********************************************************/
+void ShapeMeshes::GetDrawCommand(MESH_TYPE type, int lod, int firstInstance, int instanceCount, DRAW_COMMAND& command) const
+{
+	const MESH_RANGE& mesh = m_meshes[type][lod];
+	command.count = (GLuint)mesh.indexCount;
+	command.instanceCount = (GLuint)instanceCount;
+	command.firstIndex = mesh.firstIndex;
+	command.baseVertex = mesh.baseVertex;
+	command.baseInstance = (GLuint)firstInstance;
+}
+
+/***********************************************************
+ *  GetPositionDecode()
+ *
+ *  This method is used to fill in the scale and offset the
+ *  vertex shader turns the stored positions of one level of
+ *  a mesh back into its own space with.
+ ***********************************************************/
+void ShapeMeshes::GetPositionDecode(MESH_TYPE type, int lod, INSTANCE_DATA& instance) const
+{
+	const MESH_RANGE& mesh = m_meshes[type][lod];
+	instance.positionScale = mesh.positionScale;
+	instance.positionOffset = mesh.positionOffset;
+}
+
+/***********************************************************
+ *  DrawMeshesIndirect()
+ *
+ *  This method is used to draw a range of the uploaded
+ *  commands with one glMultiDrawElementsIndirect call.  The
+ *  meshes must be bound.
+ ***********************************************************/
+void ShapeMeshes::DrawMeshesIndirect(int firstCommand, int commandCount)
+{
+	if (commandCount <= 0)
+	{
+		return;
+	}
+
+	GLStateCache::BindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBufferID);
+	glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+		(void*)(firstCommand * sizeof(DRAW_COMMAND)), commandCount, 0);
+	GLStateCache::BindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+/***********************************************************
+ *  UploadMesh()
+ *
+ *  This method is used to add the vertices and indices of a
+ *  mesh to the end of the shared buffers, growing them when
+ *  they are full.  The indices stay relative to the mesh,
+ *  and the base vertex moves them to where it was placed.
+ *  The vertices are packed first when the packed format was
+ *  chosen.
+ ***********************************************************/
+void ShapeMeshes::UploadMesh(MESH_TYPE type, int lod, const GLfloat* vertices, GLsizei vertexCount,
+	const GLuint* indices, GLsizei indexCount)
+{
+	const GLsizei vertexSize = GetVertexSize();
+
+	MESH_RANGE& mesh = m_meshes[type][lod];
+	const void* vertexData = vertices;
+	std::vector<PACKED_VERTEX> packed;
+	if (m_vertexFormat == VERTEX_PACKED)
+	{
+		glm::vec3 positionScale;
+		glm::vec3 positionOffset;
+		PackVertices(vertices, vertexCount, packed, positionScale, positionOffset);
+		mesh.positionScale = glm::vec4(positionScale, 0.0f);
+		mesh.positionOffset = glm::vec4(positionOffset, 0.0f);
+		vertexData = packed.data();
+	}
+
+	if (m_vertexArrayID == 0)
+	{
+		CreateBuffers();
+	}
+
+	if (m_vertexCount + vertexCount > m_vertexCapacity)
+	{
+		GLsizei capacity = std::max(m_vertexCount + vertexCount, std::max(m_vertexCapacity * 2, INITIAL_VERTEX_CAPACITY));
+		GrowBuffer(m_vertexBufferID, (GLsizeiptr)m_vertexCount * vertexSize, (GLsizeiptr)capacity * vertexSize);
+		m_vertexCapacity = capacity;
+
+		GLStateCache::BindVertexArray(m_vertexArrayID);
+		glBindVertexBuffer(VERTEX_BINDING, m_vertexBufferID, 0, vertexSize);
+		GLStateCache::BindVertexArray(0);
+	}
+	if (m_indexCount + indexCount > m_indexCapacity)
+	{
+		GLsizei capacity = std::max(m_indexCount + indexCount, std::max(m_indexCapacity * 2, INITIAL_INDEX_CAPACITY));
+		GrowBuffer(m_indexBufferID, (GLsizeiptr)m_indexCount * sizeof(GLuint), (GLsizeiptr)capacity * sizeof(GLuint));
+		m_indexCapacity = capacity;
+
+		GLStateCache::BindVertexArray(m_vertexArrayID);
+		GLStateCache::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBufferID);
+		GLStateCache::BindVertexArray(0);
+	}
+
+	GLStateCache::BindBuffer(GL_ARRAY_BUFFER, m_vertexBufferID);
+	glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)m_vertexCount * vertexSize, (GLsizeiptr)vertexCount * vertexSize, vertexData);
+	GLStateCache::BindBuffer(GL_ARRAY_BUFFER, 0);
+	// the index buffer is only bound through the vertex array,
+	// so it is filled through the copy binding
+	GLStateCache::BindBuffer(GL_COPY_WRITE_BUFFER, m_indexBufferID);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, (GLintptr)m_indexCount * sizeof(GLuint), (GLsizeiptr)indexCount * sizeof(GLuint), indices);
+	GLStateCache::BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	mesh.firstIndex = (GLuint)m_indexCount;
+	mesh.indexCount = indexCount;
+	mesh.baseVertex = (GLint)m_vertexCount;
+	// every level covers the same space as the full mesh
+	if (lod == 0)
+	{
+		ComputeBounds(vertices, vertexCount, m_bounds[type]);
+	}
+
+	m_vertexCount += vertexCount;
+	m_indexCount += indexCount;
+}
+
+/***********************************************************
+ *  LoadMesh()
+ *
+ *  This method is used to add the buffers of every level of
+ *  a shape to the shared buffers.  A level baked into the
+ *  asset pack is uploaded straight from the mapped file,
+ *  otherwise it is generated.  Shapes without coarser levels
+ *  draw their full mesh at every level.
+ ***********************************************************/
+void ShapeMeshes::LoadMesh(MESH_TYPE type)
+{
+	if (m_meshes[type][0].indexCount != 0)
+	{
+		return;
+	}
+
+	const int levelCount = HasLevels(type) ? LOD_COUNT : 1;
+	for (int lod = 0; lod < levelCount; lod++)
+	{
+		AssetPack::MESH_VIEW packed;
+		if ((m_pAssetPack != NULL) && m_pAssetPack->FindMesh(GetMeshLevelName(type, lod), packed) &&
+			(packed.floatsPerVertex == FLOATS_PER_VERTEX))
+		{
+			UploadMesh(type, lod, packed.vertices, (GLsizei)packed.vertexCount, packed.indices, (GLsizei)packed.indexCount);
+			continue;
+		}
+
+		MESH_DATA mesh;
+		GenerateMesh(type, lod, mesh);
+		UploadMesh(type, lod, mesh.vertices.data(), (GLsizei)(mesh.vertices.size() / FLOATS_PER_VERTEX),
+			mesh.indices.data(), (GLsizei)mesh.indices.size());
+	}
+
+	for (int lod = levelCount; lod < LOD_COUNT; lod++)
+	{
+		m_meshes[type][lod] = m_meshes[type][0];
+	}
+}
+
+/***********************************************************
+ *  GetMeshBounds()
+ *
+ *  This method is used to get the box and sphere around the
+ *  vertices of a loaded mesh, in its own space.
+ ***********************************************************/
+const ShapeMeshes::MESH_BOUNDS& ShapeMeshes::GetMeshBounds(MESH_TYPE type) const
+{
+	return m_bounds[type];
+}
+
+/***********************************************************
+ *  ComputeBounds()
+ *
+ *  This method is used to measure the box around the vertex
+ *  positions of a mesh, and the sphere around the center of
+ *  that box which holds every vertex.
+ ***********************************************************/
+void ShapeMeshes::ComputeBounds(const GLfloat* vertices, GLsizei vertexCount, MESH_BOUNDS& bounds)
+{
+	bounds.minimum = glm::vec3(0.0f);
+	bounds.maximum = glm::vec3(0.0f);
+	bounds.center = glm::vec3(0.0f);
+	bounds.radius = 0.0f;
+	if (vertexCount <= 0)
+	{
+		return;
+	}
+
+	bounds.minimum = glm::vec3(vertices[0], vertices[1], vertices[2]);
+	bounds.maximum = bounds.minimum;
+	for (GLsizei i = 1; i < vertexCount; i++)
+	{
+		const GLfloat* position = vertices + i * FLOATS_PER_VERTEX;
+		glm::vec3 point(position[0], position[1], position[2]);
+		bounds.minimum = glm::min(bounds.minimum, point);
+		bounds.maximum = glm::max(bounds.maximum, point);
+	}
+
+	bounds.center = (bounds.minimum + bounds.maximum) * 0.5f;
+	float radiusSquared = 0.0f;
+	for (GLsizei i = 0; i < vertexCount; i++)
+	{
+		const GLfloat* position = vertices + i * FLOATS_PER_VERTEX;
+		glm::vec3 offset = glm::vec3(position[0], position[1], position[2]) - bounds.center;
+		radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+	}
+	bounds.radius = std::sqrt(radiusSquared);
+}
+
+/***********************************************************
+ *  DrawMesh()
+ *
+ *  This method is used to draw a loaded mesh once, with the
+ *  values of the first uploaded instance.
+ ***********************************************************/
+void ShapeMeshes::DrawMesh(MESH_TYPE type)
+{
+	BindMeshes();
+	DrawMeshInstanced(type, 0, 0, 1);
+	GLStateCache::BindVertexArray(0);
+}
+
+void ShapeMeshes::LoadBoxMesh() { LoadMesh(MESH_BOX); }
+void ShapeMeshes::LoadPlaneMesh() { LoadMesh(MESH_PLANE); }
+void ShapeMeshes::LoadCylinderMesh() { LoadMesh(MESH_CYLINDER); }
+void ShapeMeshes::LoadConeMesh() { LoadMesh(MESH_CONE); }
+void ShapeMeshes::LoadPrismMesh() { LoadMesh(MESH_PRISM); }
+void ShapeMeshes::LoadPyramid4Mesh() { LoadMesh(MESH_PYRAMID4); }
+void ShapeMeshes::LoadSphereMesh() { LoadMesh(MESH_SPHERE); }
+void ShapeMeshes::LoadTaperedCylinderMesh() { LoadMesh(MESH_TAPERED_CYLINDER); }
+void ShapeMeshes::LoadTorusMesh() { LoadMesh(MESH_TORUS); }
+
+void ShapeMeshes::DrawBoxMesh() { DrawMesh(MESH_BOX); }
+void ShapeMeshes::DrawPlaneMesh() { DrawMesh(MESH_PLANE); }
+void ShapeMeshes::DrawCylinderMesh() { DrawMesh(MESH_CYLINDER); }
+void ShapeMeshes::DrawConeMesh() { DrawMesh(MESH_CONE); }
+void ShapeMeshes::DrawPrismMesh() { DrawMesh(MESH_PRISM); }
+void ShapeMeshes::DrawPyramid4Mesh() { DrawMesh(MESH_PYRAMID4); }
+void ShapeMeshes::DrawSphereMesh() { DrawMesh(MESH_SPHERE); }
+void ShapeMeshes::DrawTaperedCylinderMesh() { DrawMesh(MESH_TAPERED_CYLINDER); }
+void ShapeMeshes::DrawTorusMesh() { DrawMesh(MESH_TORUS); }
@@ -0,0 +1,295 @@
+///////////////////////////////////////////////////////////////////////////////
+// shapemeshes.h
+// ============
+// create and draw the meshes of the basic 3D shapes
+//
+// This project's copy replaces the shared 3DShapes version so the meshes
+// can be generated without OpenGL and baked into the asset pack.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+// GLM Math Header inclusions
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+class AssetPack;
+
+/***********************************************************
+ *  ShapeMeshes
+ *
+ *  This class creates the meshes of the basic 3D shapes and
+ *  draws them.  Every shape is an indexed triangle list with
+ *  interleaved position, normal and texture coordinate
+ *  vertices, generated on the CPU or taken pre-built from
+ *  the asset pack.  All of the meshes are stored in one
+ *  vertex buffer and one index buffer behind a single vertex
+ *  array, and read their transform, color and material from
+ *  a shared instance buffer, so any mix of meshes and copies
+ *  can be drawn with one indirect call.  The round shapes
+ *  are also built at coarser levels of detail, for objects
+ *  that only cover a few pixels, and the triangles of every
+ *  mesh are ordered to reuse the transformed vertices.  The
+ *  vertices can be packed into half the space, with the
+ *  instances carrying the scale that unpacks the positions
+ *  of their mesh.
+ ***********************************************************/
+class ShapeMeshes
+{
+public:
+	// floats in one vertex - position, normal and texture
+	// coordinate, matching the vertex shader inputs
+	static const int FLOATS_PER_VERTEX = 8;
+	// levels of detail of every mesh, level 0 being the full
+	// mesh - shapes without round sides use it at every level
+	static const int LOD_COUNT = 4;
+
+	// the basic shapes
+	enum MESH_TYPE
+	{
+		MESH_BOX,
+		MESH_PLANE,
+		MESH_CYLINDER,
+		MESH_CONE,
+		MESH_PRISM,
+		MESH_PYRAMID4,
+		MESH_SPHERE,
+		MESH_TAPERED_CYLINDER,
+		MESH_TORUS,
+		MESH_COUNT
+	};
+
+	// the tessellation of the round shapes - the segments
+	// around the Y axis, the rings from the bottom to the top
+	// of the sphere and the segments around the tube of the
+	// torus
+	struct SHAPE_DETAIL
+	{
+		int segments;
+		int rings;
+		int tubeSegments;
+	};
+
+	// how the mesh vertices are stored in the vertex buffer
+	enum VERTEX_FORMAT
+	{
+		// 32 bytes of float position, normal and texture
+		// coordinate, as the meshes are generated
+		VERTEX_FULL,
+		// 16 bytes - the position as 16-bit values inside the
+		// bounds of its mesh, the normal as 10-bit values and
+		// the texture coordinate as half floats
+		VERTEX_PACKED
+	};
+
+	// one vertex of the packed format, laid out the way the
+	// vertex array reads it
+	struct PACKED_VERTEX
+	{
+		// normalized from -1 to 1 across the mesh bounds, with
+		// the fourth value unused
+		GLshort position[4];
+		// normalized x, y and z in GL_INT_2_10_10_10_REV
+		GLuint normal;
+		// half floats
+		GLushort textureCoordinate[2];
+	};
+
+	// the vertices and indices of a generated mesh
+	struct MESH_DATA
+	{
+		std::vector<GLfloat> vertices;
+		std::vector<GLuint> indices;
+	};
+
+	// the values of one drawn copy of a mesh, read by the
+	// instance attributes of the vertex shader
+	struct INSTANCE_DATA
+	{
+		glm::mat4 model;
+		// color used when there is no texture
+		glm::vec4 color;
+		glm::vec2 UVscale;
+		// texture array and layer, or -1 for the color
+		GLint textureArray;
+		GLint textureLayer;
+		// index into the material buffer
+		GLint materialIndex;
+		// scale and offset that turn the stored positions of
+		// the mesh into its own space - the identity for full
+		// vertices
+		glm::vec4 positionScale;
+		glm::vec4 positionOffset;
+	};
+
+	// the space taken by the vertices of a mesh, as a box and
+	// as the sphere around the center of the box
+	struct MESH_BOUNDS
+	{
+		glm::vec3 minimum;
+		glm::vec3 maximum;
+		glm::vec3 center;
+		float radius;
+	};
+
+	// first vertex attribute location of the instance values -
+	// must match the vertex shader
+	static const GLuint FIRST_INSTANCE_ATTRIBUTE = 3;
+
+	// one draw of glMultiDrawElementsIndirect, laid out the way
+	// OpenGL reads it from the command buffer
+	struct DRAW_COMMAND
+	{
+		GLuint count;
+		GLuint instanceCount;
+		GLuint firstIndex;
+		GLint baseVertex;
+		GLuint baseInstance;
+	};
+
+	// constructor
+	ShapeMeshes();
+	// destructor
+	~ShapeMeshes();
+
+	// use the meshes baked into an asset pack when it has them
+	void SetAssetPack(const AssetPack* pAssetPack);
+	// choose how the vertices are stored - must be called
+	// before the first mesh is loaded
+	bool SetVertexFormat(VERTEX_FORMAT format);
+	VERTEX_FORMAT GetVertexFormat() const;
+	// bytes of vertex buffer used by the loaded meshes
+	GLsizeiptr GetVertexBytes() const;
+
+	// create the mesh of each shape
+	void LoadBoxMesh();
+	void LoadPlaneMesh();
+	void LoadCylinderMesh();
+	void LoadConeMesh();
+	void LoadPrismMesh();
+	void LoadPyramid4Mesh();
+	void LoadSphereMesh();
+	void LoadTaperedCylinderMesh();
+	void LoadTorusMesh();
+
+	// draw the mesh of each shape, using the first uploaded
+	// instance
+	void DrawBoxMesh();
+	void DrawPlaneMesh();
+	void DrawCylinderMesh();
+	void DrawConeMesh();
+	void DrawPrismMesh();
+	void DrawPyramid4Mesh();
+	void DrawSphereMesh();
+	void DrawTaperedCylinderMesh();
+	void DrawTorusMesh();
+
+	// replace the contents of the instance buffer
+	void UploadInstances(const INSTANCE_DATA* instances, int instanceCount);
+	// bind the vertex array shared by every mesh, for the
+	// instanced and indirect draws below
+	void BindMeshes();
+	// draw a range of the uploaded instances of a mesh with
+	// one call
+	void DrawMeshInstanced(MESH_TYPE type, int lod, int firstInstance, int instanceCount);
+
+	// fill in the indirect draw command for a range of the
+	// uploaded instances of a mesh at a level of detail
+	void GetDrawCommand(MESH_TYPE type, int lod, int firstInstance, int instanceCount, DRAW_COMMAND& command) const;
+	// fill in the position scale and offset of an instance of
+	// a mesh at a level of detail
+	void GetPositionDecode(MESH_TYPE type, int lod, INSTANCE_DATA& instance) const;
+	// replace the contents of the indirect command buffer
+	void UploadDrawCommands(const DRAW_COMMAND* commands, int commandCount);
+	// draw a range of the uploaded commands with one call
+	void DrawMeshesIndirect(int firstCommand, int commandCount);
+
+	// get the local bounds of a loaded mesh
+	const MESH_BOUNDS& GetMeshBounds(MESH_TYPE type) const;
+
+	// generate the vertices and indices of a shape at a level
+	// of detail - does not use OpenGL, so it also serves the
+	// asset packer
+	static void GenerateMesh(MESH_TYPE type, int lod, MESH_DATA& mesh);
+	// generate the vertices and indices of a shape with any
+	// tessellation, ordered for the GPU vertex caches
+	static void GenerateShape(MESH_TYPE type, const SHAPE_DETAIL& detail, MESH_DATA& mesh);
+	// check whether a shape has coarser levels of detail
+	static bool HasLevels(MESH_TYPE type);
+	// name of a shape's mesh in scene files and the asset pack
+	static const char* GetMeshName(MESH_TYPE type);
+	// name of one level of a shape's mesh in the asset pack
+	static std::string GetMeshLevelName(MESH_TYPE type, int lod);
+	// measure the bounds of interleaved mesh vertices
+	static void ComputeBounds(const GLfloat* vertices, GLsizei vertexCount, MESH_BOUNDS& bounds);
+	// measure the vertex cache use of every level of every
+	// shape before and after ordering, returns false if the
+	// ordering made any of them worse
+	static bool CheckMeshes(std::string& report);
+	// pack interleaved mesh vertices, and get the scale and
+	// offset that turn the packed positions back
+	static void PackVertices(const GLfloat* vertices, GLsizei vertexCount, std::vector<PACKED_VERTEX>& packed,
+		glm::vec3& positionScale, glm::vec3& positionOffset);
+	// turn a packed vertex back into interleaved floats, the
+	// way the vertex shader reads it
+	static void UnpackVertex(const PACKED_VERTEX& packed, const glm::vec3& positionScale,
+		const glm::vec3& positionOffset, GLfloat vertex[FLOATS_PER_VERTEX]);
+	// measure the error of the packed vertices of every level
+	// of every shape, returns false if any is too large to draw
+	static bool CheckVertexFormats(std::string& report);
+
+private:
+	// where a loaded mesh lives in the shared buffers
+	struct MESH_RANGE
+	{
+		GLuint firstIndex;
+		GLsizei indexCount;
+		GLint baseVertex;
+		// turns the stored positions into the mesh's own space
+		glm::vec4 positionScale;
+		glm::vec4 positionOffset;
+	};
+
+	MESH_RANGE m_meshes[MESH_COUNT][LOD_COUNT];
+	MESH_BOUNDS m_bounds[MESH_COUNT];
+	const AssetPack* m_pAssetPack;
+	VERTEX_FORMAT m_vertexFormat;
+	// vertex array and buffers shared by every mesh, with the
+	// number of vertices and indices used and allocated
+	GLuint m_vertexArrayID;
+	GLuint m_vertexBufferID;
+	GLuint m_indexBufferID;
+	GLsizei m_vertexCount;
+	GLsizei m_vertexCapacity;
+	GLsizei m_indexCount;
+	GLsizei m_indexCapacity;
+	// per instance values shared by every mesh, and the number
+	// of instances it has room for
+	GLuint m_instanceBufferID;
+	int m_instanceCapacity;
+	// indirect draw commands, and the number it has room for
+	GLuint m_commandBufferID;
+	int m_commandCapacity;
+
+	// build the vertices and indices of a shape in the order
+	// they are generated
+	static void BuildShape(MESH_TYPE type, const SHAPE_DETAIL& detail, MESH_DATA& mesh);
+	// size of one vertex in the chosen format
+	GLsizei GetVertexSize() const;
+	// create the shared vertex array and buffers
+	void CreateBuffers();
+	// make a buffer larger, keeping its used contents
+	static void GrowBuffer(GLuint& bufferID, GLsizeiptr usedBytes, GLsizeiptr newBytes);
+	// create the buffers of a shape from the pack or generated
+	void LoadMesh(MESH_TYPE type);
+	// add the vertices and indices of a mesh to the shared
+	// buffers
+	void UploadMesh(MESH_TYPE type, int lod, const GLfloat* vertices, GLsizei vertexCount,
+		const GLuint* indices, GLsizei indexCount);
+	// draw a loaded mesh
+	void DrawMesh(MESH_TYPE type);
+};
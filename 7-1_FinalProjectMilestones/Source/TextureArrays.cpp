@@ -0,0 +1,504 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturearrays.cpp
+// ============
+// pack the scene textures into a few 2D texture arrays
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureArrays.h"
+#include "GLStateCache.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+// declare the global variables
+namespace
+{
+	const int BYTES_PER_PIXEL = 4;
+
+	/***********************************************************
+	 *  NextPowerOfTwo()
+	 *
+	 *  Get the smallest power of two that is not less than the
+	 *  passed in value.
+	 ***********************************************************/
+	int NextPowerOfTwo(int value)
+	{
+		int power = 1;
+		while (power < value)
+		{
+			power <<= 1;
+		}
+		return power;
+	}
+}
+
+/***********************************************************
+ *  TextureArrays()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TextureArrays::TextureArrays()
+{
+	m_maxTextureSize = 0;
+	m_maxLayers = 0;
+}
+
+/***********************************************************
+ *  ~TextureArrays()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+TextureArrays::~TextureArrays()
+{
+	DestroyArrays();
+}
+
+/***********************************************************
+ *  ReserveTexture()
+ *
+ *  This method is used to reserve a layer for an image of
+ *  the passed in size.  The returned index is used to upload
+ *  the pixels once the arrays are created.
+ ***********************************************************/
+int TextureArrays::ReserveTexture(const std::string& tag, int width, int height)
+{
+	if ((width <= 0) || (height <= 0))
+	{
+		std::cout << "Invalid texture image:" << tag << std::endl;
+		return -1;
+	}
+
+	return AddTexture(tag, width, height, GL_RGBA8);
+}
+
+/***********************************************************
+ *  ReserveCompressedTexture()
+ *
+ *  This method is used to reserve a layer for a compressed
+ *  texture.  The blocks cannot be resized, so the texture
+ *  needs an array of exactly its size and format, and all of
+ *  the mipmap levels of that array.
+ ***********************************************************/
+int TextureArrays::ReserveCompressedTexture(const std::string& tag, int width, int height, GLenum internalFormat, int levelCount)
+{
+	if ((width <= 0) || (height <= 0))
+	{
+		std::cout << "Invalid texture image:" << tag << std::endl;
+		return -1;
+	}
+
+	int fullLevelCount = (int)log2f((float)((width > height) ? width : height)) + 1;
+	if (levelCount != fullLevelCount)
+	{
+		return -1;
+	}
+
+	return AddTexture(tag, width, height, internalFormat);
+}
+
+/***********************************************************
+ *  AddTexture()
+ *
+ *  This method is used to place a reserved texture in an
+ *  array, so the arrays are known before they are created.
+ ***********************************************************/
+int TextureArrays::AddTexture(const std::string& tag, int width, int height, GLenum internalFormat)
+{
+	if (m_maxTextureSize == 0)
+	{
+		glGetIntegerv(GL_MAX_TEXTURE_SIZE, &m_maxTextureSize);
+		glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &m_maxLayers);
+	}
+
+	int arrayIndex = ChooseArray(width, height, internalFormat);
+	if (arrayIndex < 0)
+	{
+		return -1;
+	}
+	if (m_arrays[arrayIndex].layers >= m_maxLayers)
+	{
+		std::cout << "Too many textures of the same size, could not add:" << tag << std::endl;
+		return -1;
+	}
+
+	RESERVED_TEXTURE texture;
+	texture.tag = tag;
+	texture.width = width;
+	texture.height = height;
+	texture.location.arrayIndex = arrayIndex;
+	texture.location.layer = m_arrays[arrayIndex].layers++;
+	m_textures.push_back(texture);
+	m_textureLayers[tag] = texture.location;
+
+	return (int)m_textures.size() - 1;
+}
+
+/***********************************************************
+ *  ResizeImage()
+ *
+ *  This method is used to resample an RGBA image to a new
+ *  size with bilinear filtering.  It does not use OpenGL, so
+ *  it can be called from any thread.
+ ***********************************************************/
+void TextureArrays::ResizeImage(
+	const unsigned char* source, int sourceWidth, int sourceHeight,
+	std::vector<unsigned char>& destination, int width, int height)
+{
+	destination.resize((size_t)width * height * BYTES_PER_PIXEL);
+
+	for (int y = 0; y < height; y++)
+	{
+		float sourceY = ((y + 0.5f) * sourceHeight / height) - 0.5f;
+		int y0 = (int)floorf(sourceY);
+		float fractionY = sourceY - y0;
+		int y1 = (y0 + 1 < sourceHeight) ? y0 + 1 : sourceHeight - 1;
+		y0 = (y0 < 0) ? 0 : y0;
+
+		for (int x = 0; x < width; x++)
+		{
+			float sourceX = ((x + 0.5f) * sourceWidth / width) - 0.5f;
+			int x0 = (int)floorf(sourceX);
+			float fractionX = sourceX - x0;
+			int x1 = (x0 + 1 < sourceWidth) ? x0 + 1 : sourceWidth - 1;
+			x0 = (x0 < 0) ? 0 : x0;
+
+			const unsigned char* p00 = source + ((size_t)y0 * sourceWidth + x0) * BYTES_PER_PIXEL;
+			const unsigned char* p10 = source + ((size_t)y0 * sourceWidth + x1) * BYTES_PER_PIXEL;
+			const unsigned char* p01 = source + ((size_t)y1 * sourceWidth + x0) * BYTES_PER_PIXEL;
+			const unsigned char* p11 = source + ((size_t)y1 * sourceWidth + x1) * BYTES_PER_PIXEL;
+			unsigned char* output = &destination[((size_t)y * width + x) * BYTES_PER_PIXEL];
+
+			for (int channel = 0; channel < BYTES_PER_PIXEL; channel++)
+			{
+				float top = p00[channel] + (p10[channel] - p00[channel]) * fractionX;
+				float bottom = p01[channel] + (p11[channel] - p01[channel]) * fractionX;
+				output[channel] = (unsigned char)(top + (bottom - top) * fractionY + 0.5f);
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  ResizeToPowerOfTwo()
+ *
+ *  This method is used to resample an RGBA image up to the
+ *  next powers of two, which is the size of the array an
+ *  uncompressed image is placed in.
+ ***********************************************************/
+void TextureArrays::ResizeToPowerOfTwo(std::vector<unsigned char>& pixels, int& width, int& height)
+{
+	int newWidth = NextPowerOfTwo(width);
+	int newHeight = NextPowerOfTwo(height);
+
+	if ((newWidth != width) || (newHeight != height))
+	{
+		std::vector<unsigned char> resized;
+		ResizeImage(pixels.data(), width, height, resized, newWidth, newHeight);
+		pixels.swap(resized);
+		width = newWidth;
+		height = newHeight;
+	}
+}
+
+/***********************************************************
+ *  ChooseArray()
+ *
+ *  This method is used to choose the array for an image.
+ *  The size is rounded up to a power of two and an array of
+ *  that size and format is used or added.  When all of the
+ *  arrays are used, an uncompressed image goes into the
+ *  uncompressed array closest in size and is resized to fit,
+ *  while a compressed texture gets no array at all.
+ ***********************************************************/
+int TextureArrays::ChooseArray(int width, int height, GLenum internalFormat)
+{
+	bool bCompressed = (internalFormat != GL_RGBA8);
+	int arrayWidth = NextPowerOfTwo(width);
+	int arrayHeight = NextPowerOfTwo(height);
+
+	if (bCompressed)
+	{
+		if ((arrayWidth != width) || (arrayHeight != height) ||
+			(width > m_maxTextureSize) || (height > m_maxTextureSize))
+		{
+			return -1;
+		}
+	}
+	arrayWidth = (arrayWidth > m_maxTextureSize) ? m_maxTextureSize : arrayWidth;
+	arrayHeight = (arrayHeight > m_maxTextureSize) ? m_maxTextureSize : arrayHeight;
+
+	for (int i = 0; i < (int)m_arrays.size(); i++)
+	{
+		if ((m_arrays[i].width == arrayWidth) && (m_arrays[i].height == arrayHeight) &&
+			(m_arrays[i].internalFormat == internalFormat))
+		{
+			return i;
+		}
+	}
+
+	if ((int)m_arrays.size() < MAX_TEXTURE_ARRAYS)
+	{
+		ARRAY_INFO info;
+		info.textureID = 0;
+		info.width = arrayWidth;
+		info.height = arrayHeight;
+		info.internalFormat = internalFormat;
+		info.layers = 0;
+		m_arrays.push_back(info);
+		return (int)m_arrays.size() - 1;
+	}
+
+	if (bCompressed)
+	{
+		return -1;
+	}
+
+	int closestArray = -1;
+	float closestDifference = INFINITY;
+	for (int i = 0; i < (int)m_arrays.size(); i++)
+	{
+		if (m_arrays[i].internalFormat != GL_RGBA8)
+		{
+			continue;
+		}
+
+		float difference =
+			fabsf(log2f((float)m_arrays[i].width / arrayWidth)) +
+			fabsf(log2f((float)m_arrays[i].height / arrayHeight));
+		if (difference < closestDifference)
+		{
+			closestDifference = difference;
+			closestArray = i;
+		}
+	}
+
+	return closestArray;
+}
+
+/***********************************************************
+ *  CreateArrays()
+ *
+ *  This method is used to create the storage of the arrays
+ *  the reserved textures were placed in.  The pixels are
+ *  uploaded afterwards with UploadTexture(), or with
+ *  UploadCompressedLevel() for the compressed arrays.
+ ***********************************************************/
+bool TextureArrays::CreateArrays()
+{
+	for (int arrayIndex = 0; arrayIndex < (int)m_arrays.size(); arrayIndex++)
+	{
+		ARRAY_INFO& info = m_arrays[arrayIndex];
+		if (info.textureID != 0)
+		{
+			continue;
+		}
+
+		int levels = (int)log2f((float)((info.width > info.height) ? info.width : info.height)) + 1;
+
+		glGenTextures(1, &info.textureID);
+		GLStateCache::BindTexture(GL_TEXTURE_2D_ARRAY, info.textureID);
+		glTexStorage3D(GL_TEXTURE_2D_ARRAY, levels, info.internalFormat, info.width, info.height, info.layers);
+
+		// set the texture wrapping parameters
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		// set texture filtering parameters, sampling the mipmaps
+		// when the textures are minified
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+		// size of the storage with all of the mipmap levels
+		size_t bytes = 0;
+		for (int level = 0; level < levels; level++)
+		{
+			int width = (info.width >> level) > 0 ? (info.width >> level) : 1;
+			int height = (info.height >> level) > 0 ? (info.height >> level) : 1;
+			if (info.internalFormat == GL_RGBA8)
+			{
+				bytes += (size_t)width * height * BYTES_PER_PIXEL;
+			}
+			else
+			{
+				size_t blockBytes = (info.internalFormat == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT) ? 16 : 8;
+				bytes += (size_t)((width + 3) / 4) * ((height + 3) / 4) * blockBytes;
+			}
+		}
+		bytes *= info.layers;
+
+		std::cout << "Created texture array " << arrayIndex << ": " << info.width << "x" << info.height
+			<< ((info.internalFormat == GL_RGBA8) ? " RGBA8" :
+				((info.internalFormat == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT) ? " BC3" : " BC1"))
+			<< ", layers:" << info.layers << ", " << bytes / 1024 << " KB" << std::endl;
+	}
+
+	GLStateCache::BindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+	return true;
+}
+
+/***********************************************************
+ *  GetLayerSize()
+ *
+ *  This method is used to get the size of the array layer
+ *  of a reserved texture, or zero if it has no layer.
+ ***********************************************************/
+void TextureArrays::GetLayerSize(int textureIndex, int& width, int& height) const
+{
+	width = 0;
+	height = 0;
+
+	if ((textureIndex < 0) || (textureIndex >= (int)m_textures.size()))
+	{
+		return;
+	}
+
+	int arrayIndex = m_textures[textureIndex].location.arrayIndex;
+	if (arrayIndex >= 0)
+	{
+		width = m_arrays[arrayIndex].width;
+		height = m_arrays[arrayIndex].height;
+	}
+}
+
+/***********************************************************
+ *  UploadTexture()
+ *
+ *  This method is used to copy the pixels of a reserved
+ *  texture into its array layer.  The pixels must already
+ *  have the size returned by GetLayerSize().
+ ***********************************************************/
+void TextureArrays::UploadTexture(int textureIndex, const void* pixels) const
+{
+	if ((textureIndex < 0) || (textureIndex >= (int)m_textures.size()))
+	{
+		return;
+	}
+
+	const TEXTURE_LAYER& location = m_textures[textureIndex].location;
+	if (location.arrayIndex < 0)
+	{
+		return;
+	}
+
+	const ARRAY_INFO& info = m_arrays[location.arrayIndex];
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	GLStateCache::BindTexture(GL_TEXTURE_2D_ARRAY, info.textureID);
+	glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, location.layer, info.width, info.height, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+	GLStateCache::BindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+/***********************************************************
+ *  UploadCompressedLevel()
+ *
+ *  This method is used to copy the blocks of one mipmap
+ *  level of a compressed texture into its array layer.
+ ***********************************************************/
+void TextureArrays::UploadCompressedLevel(int textureIndex, int level, const void* data, GLsizei size) const
+{
+	if ((textureIndex < 0) || (textureIndex >= (int)m_textures.size()))
+	{
+		return;
+	}
+
+	const TEXTURE_LAYER& location = m_textures[textureIndex].location;
+	if (location.arrayIndex < 0)
+	{
+		return;
+	}
+
+	const ARRAY_INFO& info = m_arrays[location.arrayIndex];
+	int width = (info.width >> level) > 0 ? (info.width >> level) : 1;
+	int height = (info.height >> level) > 0 ? (info.height >> level) : 1;
+
+	GLStateCache::BindTexture(GL_TEXTURE_2D_ARRAY, info.textureID);
+	glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, location.layer, width, height, 1, info.internalFormat, size, data);
+	GLStateCache::BindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+/***********************************************************
+ *  FinishArrays()
+ *
+ *  This method is used to generate the mipmaps of every
+ *  uncompressed array once all of its layers have been
+ *  uploaded.  The compressed arrays already have theirs.
+ ***********************************************************/
+void TextureArrays::FinishArrays() const
+{
+	for (int i = 0; i < (int)m_arrays.size(); i++)
+	{
+		if (m_arrays[i].internalFormat != GL_RGBA8)
+		{
+			continue;
+		}
+
+		GLStateCache::BindTexture(GL_TEXTURE_2D_ARRAY, m_arrays[i].textureID);
+		// generate the texture mipmaps for mapping textures to lower resolutions
+		glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+	}
+	GLStateCache::BindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+/***********************************************************
+ *  BindArrays()
+ *
+ *  This method is used to bind every texture array to its
+ *  own texture unit.
+ ***********************************************************/
+void TextureArrays::BindArrays() const
+{
+	for (int i = 0; i < (int)m_arrays.size(); i++)
+	{
+		GLStateCache::ActiveTexture(GL_TEXTURE0 + FIRST_TEXTURE_UNIT + i);
+		GLStateCache::BindTexture(GL_TEXTURE_2D_ARRAY, m_arrays[i].textureID);
+	}
+	GLStateCache::ActiveTexture(GL_TEXTURE0);
+}
+
+/***********************************************************
+ *  DestroyArrays()
+ *
+ *  This method is used to delete all of the texture arrays
+ *  and to forget the textures reserved in them.
+ ***********************************************************/
+void TextureArrays::DestroyArrays()
+{
+	for (int i = 0; i < (int)m_arrays.size(); i++)
+	{
+		if (m_arrays[i].textureID != 0)
+		{
+			GLStateCache::DeleteTextures(1, &m_arrays[i].textureID);
+		}
+	}
+	m_arrays.clear();
+	m_textures.clear();
+	m_textureLayers.clear();
+}
+
+/***********************************************************
+ *  FindTexture()
+ *
+ *  This method is used to find the array and layer of the
+ *  texture associated with the passed in tag.
+ ***********************************************************/
+bool TextureArrays::FindTexture(const std::string& tag, TEXTURE_LAYER& location) const
+{
+	std::unordered_map<std::string, TEXTURE_LAYER>::const_iterator found = m_textureLayers.find(tag);
+	if (found == m_textureLayers.end())
+	{
+		return false;
+	}
+
+	location = found->second;
+	return true;
+}
+
+/***********************************************************
+ *  GetArrayCount()
+ *
+ *  This method is used to get the number of texture arrays.
+ ***********************************************************/
+int TextureArrays::GetArrayCount() const
+{
+	return (int)m_arrays.size();
+}
@@ -0,0 +1,121 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturearrays.h
+// ============
+// pack the scene textures into a few 2D texture arrays
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/***********************************************************
+ *  TextureArrays
+ *
+ *  This class packs the scene textures into
+ *  GL_TEXTURE_2D_ARRAY objects, one for every texture size.
+ *  Sizes are rounded up to powers of two so that the
+ *  textures share as few arrays as possible.  Each array
+ *  stays bound to its own texture unit, so a draw only
+ *  selects an array and a layer instead of binding textures.
+ *
+ *  Every texture is reserved with its image size first, so
+ *  the arrays can be created before any image is decoded,
+ *  and the layers can then be uploaded in any order.
+ *  Compressed textures go into arrays of their own block
+ *  format, with the mipmap levels uploaded from the file.
+ ***********************************************************/
+class TextureArrays
+{
+public:
+	// number of arrays, and the texture units they use - must
+	// match MAX_TEXTURE_ARRAYS in the fragment shader
+	static const int MAX_TEXTURE_ARRAYS = 8;
+	static const int FIRST_TEXTURE_UNIT = 0;
+
+	// where a texture is stored in the arrays
+	struct TEXTURE_LAYER
+	{
+		int arrayIndex;
+		int layer;
+	};
+
+	// constructor
+	TextureArrays();
+	// destructor
+	~TextureArrays();
+
+	// reserve a layer for an image of the passed in size and
+	// return the index used to upload it, or -1 if it has none
+	int ReserveTexture(const std::string& tag, int width, int height);
+	// reserve a layer for a compressed texture with a full
+	// mipmap chain - returns -1 if no array can take it, so the
+	// image can be loaded uncompressed instead
+	int ReserveCompressedTexture(const std::string& tag, int width, int height, GLenum internalFormat, int levelCount);
+	// create the arrays for all of the reserved textures
+	bool CreateArrays();
+	// get the size a reserved texture has in its array - the
+	// uploaded pixels must be resized to it
+	void GetLayerSize(int textureIndex, int& width, int& height) const;
+	// upload the RGBA pixels of a reserved texture - when a
+	// pixel unpack buffer is bound, pixels is an offset into it
+	void UploadTexture(int textureIndex, const void* pixels) const;
+	// upload one mipmap level of a compressed texture, where
+	// data is also an offset into a bound pixel unpack buffer
+	void UploadCompressedLevel(int textureIndex, int level, const void* data, GLsizei size) const;
+	// generate the mipmaps of the uncompressed arrays once all
+	// of the layers are uploaded
+	void FinishArrays() const;
+	// bind every texture array to its texture unit
+	void BindArrays() const;
+	// delete the texture arrays
+	void DestroyArrays();
+
+	// find where the texture with the passed in tag is stored
+	bool FindTexture(const std::string& tag, TEXTURE_LAYER& location) const;
+	// number of texture arrays that were created
+	int GetArrayCount() const;
+
+	// resample an RGBA image to a new size with bilinear filtering
+	static void ResizeImage(
+		const unsigned char* source, int sourceWidth, int sourceHeight,
+		std::vector<unsigned char>& destination, int width, int height);
+	// resample an RGBA image up to the next powers of two, the
+	// size it has in its array
+	static void ResizeToPowerOfTwo(std::vector<unsigned char>& pixels, int& width, int& height);
+
+private:
+	// a reserved texture and its place in the arrays
+	struct RESERVED_TEXTURE
+	{
+		std::string tag;
+		int width;
+		int height;
+		TEXTURE_LAYER location;
+	};
+
+	// the size, format and layers of one texture array
+	struct ARRAY_INFO
+	{
+		GLuint textureID;
+		int width;
+		int height;
+		GLenum internalFormat;
+		int layers;
+	};
+
+	std::vector<RESERVED_TEXTURE> m_textures;
+	std::vector<ARRAY_INFO> m_arrays;
+	std::unordered_map<std::string, TEXTURE_LAYER> m_textureLayers;
+	GLint m_maxTextureSize;
+	GLint m_maxLayers;
+
+	// choose the array an image of the passed in size and
+	// format goes into, or -1 if none can take it
+	int ChooseArray(int width, int height, GLenum internalFormat);
+	// place a texture in an array and return its index
+	int AddTexture(const std::string& tag, int width, int height, GLenum internalFormat);
+};
@@ -0,0 +1,586 @@
+///////////////////////////////////////////////////////////////////////////////
+// textureloader.cpp
+// ============
+// decode texture images on worker threads and stream them to the GPU
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureLoader.h"
+#include "GLStateCache.h"
+
+#ifndef STB_IMAGE_IMPLEMENTATION
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+// declare the global variables
+namespace
+{
+	const int BYTES_PER_PIXEL = 4;
+
+	/***********************************************************
+	 *  ElapsedMilliseconds()
+	 *
+	 *  Get the time between two clock readings in milliseconds.
+	 ***********************************************************/
+	double ElapsedMilliseconds(
+		std::chrono::steady_clock::time_point start,
+		std::chrono::steady_clock::time_point end)
+	{
+		return std::chrono::duration<double, std::milli>(end - start).count();
+	}
+}
+
+/***********************************************************
+ *  TextureLoader()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TextureLoader::TextureLoader()
+{
+	m_totalMs = 0.0;
+	m_pAssetPack = NULL;
+	for (int i = 0; i < UPLOAD_BUFFER_COUNT; i++)
+	{
+		m_uploadBufferIDs[i] = 0;
+	}
+}
+
+/***********************************************************
+ *  ~TextureLoader()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+TextureLoader::~TextureLoader()
+{
+	if (m_uploadBufferIDs[0] != 0)
+	{
+		GLStateCache::DeleteBuffers(UPLOAD_BUFFER_COUNT, m_uploadBufferIDs);
+	}
+}
+
+/***********************************************************
+ *  SetAssetPack()
+ *
+ *  This method is used to set the asset pack that is looked
+ *  in before the image files.  It must stay open until the
+ *  textures are loaded.
+ ***********************************************************/
+void TextureLoader::SetAssetPack(const AssetPack* pAssetPack)
+{
+	m_pAssetPack = pAssetPack;
+}
+
+/***********************************************************
+ *  AddFile()
+ *
+ *  This method is used to add an image file to the list of
+ *  files loaded by the next call to LoadTextures().
+ ***********************************************************/
+void TextureLoader::AddFile(const char* filename, const std::string& tag)
+{
+	LOAD_JOB job;
+	job.filename = filename;
+	job.tag = tag;
+	job.textureIndex = -1;
+	job.layerWidth = 0;
+	job.layerHeight = 0;
+	job.bPacked = false;
+	m_jobs.push_back(job);
+}
+
+/***********************************************************
+ *  ReservePackedJob()
+ *
+ *  This method is used to reserve an array layer for a job
+ *  whose texture is in the asset pack.  Compressed textures
+ *  are only used when the GPU can sample them.
+ ***********************************************************/
+bool TextureLoader::ReservePackedJob(int jobIndex, TextureArrays* pTextureArrays, bool bUseCompressed)
+{
+	LOAD_JOB& job = m_jobs[jobIndex];
+	LOAD_TIMING& timing = m_timings[jobIndex];
+
+	if ((m_pAssetPack == NULL) ||
+		(m_pAssetPack->FindTexture(AssetPack::GetEntryName(job.filename), job.packed) == false))
+	{
+		return false;
+	}
+
+	if (job.packed.internalFormat == GL_RGBA8)
+	{
+		job.textureIndex = pTextureArrays->ReserveTexture(job.tag, job.packed.width, job.packed.height);
+	}
+	else if (bUseCompressed)
+	{
+		job.textureIndex = pTextureArrays->ReserveCompressedTexture(job.tag, job.packed.width, job.packed.height,
+			job.packed.internalFormat, job.packed.levelCount);
+	}
+	else
+	{
+		return false;
+	}
+
+	if (job.textureIndex < 0)
+	{
+		return false;
+	}
+
+	job.bPacked = true;
+	timing.format = (job.packed.internalFormat == GL_RGBA8) ? "RGBA8" :
+		((job.packed.internalFormat == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT) ? "BC3" : "BC1");
+	timing.filename = "pack:" + AssetPack::GetEntryName(job.filename);
+	timing.width = (int)job.packed.width;
+	timing.height = (int)job.packed.height;
+	timing.channels = 4;
+
+	return true;
+}
+
+/***********************************************************
+ *  ReserveCompressedJob()
+ *
+ *  This method is used to reserve a compressed array layer
+ *  for a job when a DDS file of its image exists and the
+ *  arrays have room for its size and block format.
+ ***********************************************************/
+bool TextureLoader::ReserveCompressedJob(int jobIndex, TextureArrays* pTextureArrays)
+{
+	LOAD_JOB& job = m_jobs[jobIndex];
+	LOAD_TIMING& timing = m_timings[jobIndex];
+	std::string filename = CompressedTexture::GetCompressedFilename(job.filename);
+
+	CompressedTexture header;
+	if (header.ReadHeader(filename) == false)
+	{
+		return false;
+	}
+
+	job.textureIndex = pTextureArrays->ReserveCompressedTexture(
+		job.tag, header.GetWidth(), header.GetHeight(), header.GetInternalFormat(), header.GetLevelCount());
+	if (job.textureIndex < 0)
+	{
+		std::cout << "No texture array for compressed texture, loading the image instead:" << filename << std::endl;
+		return false;
+	}
+
+	job.compressedFilename = filename;
+	timing.filename = filename;
+	timing.width = header.GetWidth();
+	timing.height = header.GetHeight();
+	timing.channels = (header.GetInternalFormat() == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT) ? 4 : 3;
+	timing.format = header.GetFormatName();
+
+	return true;
+}
+
+/***********************************************************
+ *  DecodeJob()
+ *
+ *  This method is used to decode the image of one job into
+ *  RGBA pixels, flip it vertically for OpenGL and resize it
+ *  to its array layer.  A compressed job only reads its DDS
+ *  file.  It is called on the worker threads, so it only
+ *  touches the data of its own job.
+ ***********************************************************/
+void TextureLoader::DecodeJob(int jobIndex)
+{
+	LOAD_JOB& job = m_jobs[jobIndex];
+	LOAD_TIMING& timing = m_timings[jobIndex];
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	if (job.compressedFilename.empty() == false)
+	{
+		timing.bLoaded = job.compressed.Read(job.compressedFilename);
+		timing.decodeMs = ElapsedMilliseconds(start, std::chrono::steady_clock::now());
+		return;
+	}
+
+	if (job.bPacked)
+	{
+		// a packed texture only needs work if it did not get an
+		// array of its own size
+		if ((job.packed.internalFormat == GL_RGBA8) &&
+			(((int)job.packed.width != job.layerWidth) || ((int)job.packed.height != job.layerHeight)))
+		{
+			TextureArrays::ResizeImage(job.packed.data, job.packed.width, job.packed.height,
+				job.pixels, job.layerWidth, job.layerHeight);
+		}
+		timing.bLoaded = true;
+		timing.decodeMs = ElapsedMilliseconds(start, std::chrono::steady_clock::now());
+		return;
+	}
+
+	int width = 0;
+	int height = 0;
+	int colorChannels = 0;
+	std::vector<unsigned char> image;
+
+	if (DecodeImage(job.filename, image, width, height, colorChannels))
+	{
+		if ((width != job.layerWidth) || (height != job.layerHeight))
+		{
+			TextureArrays::ResizeImage(image.data(), width, height, job.pixels, job.layerWidth, job.layerHeight);
+		}
+		else
+		{
+			job.pixels.swap(image);
+		}
+
+		timing.channels = colorChannels;
+		timing.bLoaded = true;
+	}
+	else
+	{
+		// keep the layer black rather than undefined
+		job.pixels.assign((size_t)job.layerWidth * job.layerHeight * BYTES_PER_PIXEL, 0);
+		timing.bLoaded = false;
+	}
+
+	timing.decodeMs = ElapsedMilliseconds(start, std::chrono::steady_clock::now());
+}
+
+/***********************************************************
+ *  DecodeImage()
+ *
+ *  This method is used to decode an image file into RGBA
+ *  pixels and to flip it vertically for OpenGL.  The rows
+ *  are flipped here rather than by stb_image, since its flip
+ *  setting is shared by all of the threads.
+ ***********************************************************/
+bool TextureLoader::DecodeImage(const std::string& filename, std::vector<unsigned char>& pixels,
+	int& width, int& height, int& channels)
+{
+	unsigned char* image = stbi_load(filename.c_str(), &width, &height, &channels, BYTES_PER_PIXEL);
+	if (image == NULL)
+	{
+		return false;
+	}
+
+	size_t rowBytes = (size_t)width * BYTES_PER_PIXEL;
+	pixels.resize((size_t)height * rowBytes);
+	for (int y = 0; y < height; y++)
+	{
+		memcpy(&pixels[(size_t)(height - 1 - y) * rowBytes], image + (size_t)y * rowBytes, rowBytes);
+	}
+	stbi_image_free(image);
+
+	return true;
+}
+
+/***********************************************************
+ *  UploadJob()
+ *
+ *  This method is used to copy the decoded pixels of a job
+ *  into a pixel buffer object and to start the transfer into
+ *  its array layer from there.  The buffer is orphaned
+ *  first, so the copy never waits for an earlier transfer.
+ *  The upload time only covers the work on this thread, as
+ *  the transfer itself runs asynchronously.  A compressed
+ *  job copies all of its mipmap levels into the buffer and
+ *  uploads each level from its offset.
+ ***********************************************************/
+void TextureLoader::UploadJob(int jobIndex, TextureArrays* pTextureArrays, int uploadBuffer)
+{
+	LOAD_JOB& job = m_jobs[jobIndex];
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	bool bCompressed = (job.compressedFilename.empty() == false);
+	const std::vector<unsigned char>& data = bCompressed ? job.compressed.GetData() : job.pixels;
+	GLsizeiptr size = (GLsizeiptr)data.size();
+
+	// a compressed layer that could not be read is left empty
+	if (size == 0)
+	{
+		return;
+	}
+
+	GLStateCache::BindBuffer(GL_PIXEL_UNPACK_BUFFER, m_uploadBufferIDs[uploadBuffer]);
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+	void* pMapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+
+	// with the pixel buffer bound, the pixels are an offset into it,
+	// otherwise they are uploaded straight from memory
+	const unsigned char* pSource = NULL;
+	if (pMapped != NULL)
+	{
+		memcpy(pMapped, data.data(), (size_t)size);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+	}
+	else
+	{
+		GLStateCache::BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		pSource = data.data();
+	}
+
+	if (bCompressed)
+	{
+		for (int level = 0; level < job.compressed.GetLevelCount(); level++)
+		{
+			pTextureArrays->UploadCompressedLevel(job.textureIndex, level,
+				pSource + job.compressed.GetLevelOffset(level), (GLsizei)job.compressed.GetLevelSize(level));
+		}
+	}
+	else
+	{
+		pTextureArrays->UploadTexture(job.textureIndex, pSource);
+	}
+	GLStateCache::BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	// the pixels are no longer needed once they are copied
+	std::vector<unsigned char>().swap(job.pixels);
+	job.compressed = CompressedTexture();
+
+	m_timings[jobIndex].uploadMs = ElapsedMilliseconds(start, std::chrono::steady_clock::now());
+}
+
+/***********************************************************
+ *  UploadPackedJob()
+ *
+ *  This method is used to upload a texture straight from the
+ *  mapped pages of the asset pack, without copying it into a
+ *  pixel buffer first.
+ ***********************************************************/
+void TextureLoader::UploadPackedJob(int jobIndex, TextureArrays* pTextureArrays)
+{
+	const LOAD_JOB& job = m_jobs[jobIndex];
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	if (job.packed.internalFormat == GL_RGBA8)
+	{
+		pTextureArrays->UploadTexture(job.textureIndex, job.packed.data);
+	}
+	else
+	{
+		size_t offset = 0;
+		for (int level = 0; level < (int)job.packed.levelCount; level++)
+		{
+			size_t size = CompressedTexture::CalculateLevelSize(job.packed.internalFormat,
+				job.packed.width, job.packed.height, level);
+			if (offset + size > job.packed.size)
+			{
+				std::cout << "Asset pack texture is truncated:" << job.filename << std::endl;
+				break;
+			}
+
+			pTextureArrays->UploadCompressedLevel(job.textureIndex, level, job.packed.data + offset, (GLsizei)size);
+			offset += size;
+		}
+	}
+
+	m_timings[jobIndex].uploadMs = ElapsedMilliseconds(start, std::chrono::steady_clock::now());
+}
+
+/***********************************************************
+ *  LoadTextures()
+ *
+ *  This method is used to load all of the added files into
+ *  the texture arrays.  The headers are read first so that
+ *  the arrays can be created, then the worker threads decode
+ *  the images while this thread uploads each one as soon as
+ *  it is finished.  This must be called on the thread of the
+ *  OpenGL context.
+ ***********************************************************/
+bool TextureLoader::LoadTextures(TextureArrays* pTextureArrays, int threadCount)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	if (pTextureArrays == NULL)
+	{
+		return false;
+	}
+
+	m_timings.clear();
+	m_timings.resize(m_jobs.size());
+
+	// the DDS files hold S3TC blocks, which need the extension
+	bool bUseCompressed = (GLEW_EXT_texture_compression_s3tc != 0);
+
+	// read the image sizes and reserve the array layers
+	std::vector<int> decodeJobs;
+	for (int i = 0; i < (int)m_jobs.size(); i++)
+	{
+		LOAD_JOB& job = m_jobs[i];
+		LOAD_TIMING& timing = m_timings[i];
+		timing.filename = job.filename;
+		timing.tag = job.tag;
+		timing.width = 0;
+		timing.height = 0;
+		timing.channels = 0;
+		timing.format = "RGBA8";
+		timing.bLoaded = false;
+		timing.decodeMs = 0.0;
+		timing.uploadMs = 0.0;
+
+		if (ReservePackedJob(i, pTextureArrays, bUseCompressed))
+		{
+			decodeJobs.push_back(i);
+			continue;
+		}
+
+		if (bUseCompressed && ReserveCompressedJob(i, pTextureArrays))
+		{
+			decodeJobs.push_back(i);
+			continue;
+		}
+
+		if (stbi_info(job.filename.c_str(), &timing.width, &timing.height, &timing.channels) == 0)
+		{
+			std::cout << "Could not load image:" << job.filename << std::endl;
+			continue;
+		}
+
+		job.textureIndex = pTextureArrays->ReserveTexture(job.tag, timing.width, timing.height);
+		if (job.textureIndex >= 0)
+		{
+			decodeJobs.push_back(i);
+		}
+	}
+
+	pTextureArrays->CreateArrays();
+	for (int i = 0; i < (int)decodeJobs.size(); i++)
+	{
+		LOAD_JOB& job = m_jobs[decodeJobs[i]];
+		pTextureArrays->GetLayerSize(job.textureIndex, job.layerWidth, job.layerHeight);
+	}
+
+	if (m_uploadBufferIDs[0] == 0)
+	{
+		glGenBuffers(UPLOAD_BUFFER_COUNT, m_uploadBufferIDs);
+	}
+
+	if (threadCount <= 0)
+	{
+		threadCount = (int)std::thread::hardware_concurrency();
+	}
+	threadCount = std::max(1, std::min(threadCount, (int)decodeJobs.size()));
+
+	// the rows are flipped by the workers themselves
+	stbi_set_flip_vertically_on_load(false);
+
+	std::atomic<int> nextJob(0);
+	std::mutex finishedMutex;
+	std::condition_variable finishedCondition;
+	std::deque<int> finishedJobs;
+	std::vector<std::thread> workers;
+
+	for (int i = 0; (i < threadCount) && !decodeJobs.empty(); i++)
+	{
+		workers.push_back(std::thread([&]()
+		{
+			int next = 0;
+			while ((next = nextJob++) < (int)decodeJobs.size())
+			{
+				DecodeJob(decodeJobs[next]);
+
+				std::lock_guard<std::mutex> lock(finishedMutex);
+				finishedJobs.push_back(decodeJobs[next]);
+				finishedCondition.notify_one();
+			}
+		}));
+	}
+
+	// upload the images in the order they finish decoding
+	for (int uploaded = 0; uploaded < (int)decodeJobs.size(); uploaded++)
+	{
+		int jobIndex = 0;
+		{
+			std::unique_lock<std::mutex> lock(finishedMutex);
+			finishedCondition.wait(lock, [&]() { return !finishedJobs.empty(); });
+			jobIndex = finishedJobs.front();
+			finishedJobs.pop_front();
+		}
+
+		if (m_timings[jobIndex].bLoaded == false)
+		{
+			std::cout << "Could not decode image:" << m_timings[jobIndex].filename << std::endl;
+		}
+		if (m_jobs[jobIndex].bPacked && m_jobs[jobIndex].pixels.empty())
+		{
+			UploadPackedJob(jobIndex, pTextureArrays);
+		}
+		else
+		{
+			UploadJob(jobIndex, pTextureArrays, uploaded % UPLOAD_BUFFER_COUNT);
+		}
+	}
+
+	for (int i = 0; i < (int)workers.size(); i++)
+	{
+		workers[i].join();
+	}
+
+	pTextureArrays->FinishArrays();
+
+	// the files are loaded, so a later call only loads new ones
+	m_jobs.clear();
+	m_totalMs = ElapsedMilliseconds(start, std::chrono::steady_clock::now());
+
+	return true;
+}
+
+/***********************************************************
+ *  GetTimings()
+ *
+ *  This method is used to get the timings of every file of
+ *  the last load.
+ ***********************************************************/
+const std::vector<TextureLoader::LOAD_TIMING>& TextureLoader::GetTimings() const
+{
+	return m_timings;
+}
+
+/***********************************************************
+ *  GetTotalMs()
+ *
+ *  This method is used to get the total time of the last
+ *  load, from reading the headers to the mipmaps.
+ ***********************************************************/
+double TextureLoader::GetTotalMs() const
+{
+	return m_totalMs;
+}
+
+/***********************************************************
+ *  PrintTimings()
+ *
+ *  This method is used to write the decode and upload time
+ *  of every file of the last load to the console.
+ ***********************************************************/
+void TextureLoader::PrintTimings() const
+{
+	double totalDecodeMs = 0.0;
+	double totalUploadMs = 0.0;
+
+	std::cout << std::fixed << std::setprecision(2);
+	std::cout << "Texture loading: " << m_timings.size() << " files in " << m_totalMs << " ms" << std::endl;
+	std::cout << "  decode ms  upload ms  size        format  file" << std::endl;
+
+	for (size_t i = 0; i < m_timings.size(); i++)
+	{
+		const LOAD_TIMING& timing = m_timings[i];
+		std::string size = std::to_string(timing.width) + "x" + std::to_string(timing.height) + "x" + std::to_string(timing.channels);
+
+		std::cout << "  " << std::setw(9) << timing.decodeMs
+			<< "  " << std::setw(9) << timing.uploadMs
+			<< "  " << std::left << std::setw(10) << size << "  " << std::setw(6) << timing.format << std::right
+			<< "  " << timing.filename << (timing.bLoaded ? "" : " (failed)") << std::endl;
+
+		totalDecodeMs += timing.decodeMs;
+		totalUploadMs += timing.uploadMs;
+	}
+
+	std::cout << "  " << std::setw(9) << totalDecodeMs << "  " << std::setw(9) << totalUploadMs
+		<< "  total" << std::endl;
+	std::cout.unsetf(std::ios::floatfield);
+	std::cout << std::setprecision(6);
+}
@@ -0,0 +1,115 @@
+///////////////////////////////////////////////////////////////////////////////
+// textureloader.h
+// ============
+// decode texture images on worker threads and stream them to the GPU
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "AssetPack.h"
+#include "CompressedTexture.h"
+#include "TextureArrays.h"
+
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  TextureLoader
+ *
+ *  This class loads a list of texture image files into the
+ *  texture arrays.  The image headers are read first so the
+ *  arrays can be created up front.  The images are then
+ *  decoded by a pool of worker threads, while the OpenGL
+ *  thread uploads each finished image through a pixel
+ *  buffer object as soon as it arrives.
+ *
+ *  When a DDS file made by CompressedTexture::CompressFile()
+ *  sits next to an image, its blocks and mipmaps are loaded
+ *  instead, and the image is only decoded if the GPU or the
+ *  texture arrays cannot use them.  Textures found in the
+ *  asset pack are uploaded straight from its mapped pages.
+ ***********************************************************/
+class TextureLoader
+{
+public:
+	// timings of one loaded file
+	struct LOAD_TIMING
+	{
+		std::string filename;
+		std::string tag;
+		int width;
+		int height;
+		int channels;
+		// format the texture is stored in on the GPU
+		std::string format;
+		bool bLoaded;
+		double decodeMs;
+		double uploadMs;
+	};
+
+	// constructor
+	TextureLoader();
+	// destructor
+	~TextureLoader();
+
+	// use the textures in an asset pack before the files
+	void SetAssetPack(const AssetPack* pAssetPack);
+	// add an image file to be loaded by LoadTextures()
+	void AddFile(const char* filename, const std::string& tag);
+	// load all of the added files into the texture arrays - a
+	// thread count of zero uses one thread per CPU core
+	bool LoadTextures(TextureArrays* pTextureArrays, int threadCount = 0);
+
+	// get the timings of the files from the last load
+	const std::vector<LOAD_TIMING>& GetTimings() const;
+	// get the total time of the last load
+	double GetTotalMs() const;
+	// write the timings of the last load to the console
+	void PrintTimings() const;
+
+	// decode an image file into RGBA pixels with the bottom row
+	// first, as OpenGL expects them - safe to call from any thread
+	static bool DecodeImage(const std::string& filename, std::vector<unsigned char>& pixels,
+		int& width, int& height, int& channels);
+
+private:
+	// number of pixel buffer objects used in turn for uploads
+	static const int UPLOAD_BUFFER_COUNT = 2;
+
+	// a file to load and its decoded pixels
+	struct LOAD_JOB
+	{
+		std::string filename;
+		std::string tag;
+		int textureIndex;
+		// size of the array layer the image is resized to
+		int layerWidth;
+		int layerHeight;
+		std::vector<unsigned char> pixels;
+		// the DDS file loaded instead of the image, if any
+		std::string compressedFilename;
+		CompressedTexture compressed;
+		// the texture in the asset pack, if it is used
+		bool bPacked;
+		AssetPack::TEXTURE_VIEW packed;
+	};
+
+	std::vector<LOAD_JOB> m_jobs;
+	std::vector<LOAD_TIMING> m_timings;
+	double m_totalMs;
+	GLuint m_uploadBufferIDs[UPLOAD_BUFFER_COUNT];
+	const AssetPack* m_pAssetPack;
+
+	// reserve a layer for a job if its texture is in the pack
+	bool ReservePackedJob(int jobIndex, TextureArrays* pTextureArrays, bool bUseCompressed);
+	// reserve a compressed layer for a job if it has a usable
+	// DDS file next to its image
+	bool ReserveCompressedJob(int jobIndex, TextureArrays* pTextureArrays);
+	// decode, flip and resize the image of one job, or read
+	// the blocks of its DDS file
+	void DecodeJob(int jobIndex);
+	// copy the pixels of a decoded job into its array layer
+	void UploadJob(int jobIndex, TextureArrays* pTextureArrays, int uploadBuffer);
+	// copy a texture from the mapped pack into its array layer
+	void UploadPackedJob(int jobIndex, TextureArrays* pTextureArrays);
+};
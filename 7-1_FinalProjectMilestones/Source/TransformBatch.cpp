@@ -0,0 +1,540 @@
+///////////////////////////////////////////////////////////////////////////////
+// transformbatch.cpp
+// ============
+// build the model matrices of many objects at once with SIMD kernels
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TransformBatch.h"
+#include "TransformHierarchy.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <sstream>
+#include <vector>
+
+#include <emmintrin.h>
+#include <immintrin.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// MSVC compiles AVX2 intrinsics in any function, while GCC and
+// Clang need the functions that use them marked for the target
+#if defined(_MSC_VER)
+#define TARGET_AVX2
+#else
+#define TARGET_AVX2 __attribute__((target("avx2,fma")))
+#endif
+
+// declare the global variables
+namespace
+{
+	const float DEGREES_TO_RADIANS = 0.01745329251994329577f;
+	const float TWO_OVER_PI = 0.63661977236758134308f;
+	// pi / 2 split into three parts, so the range reduction
+	// stays exact for the larger angles
+	const float PI_OVER_TWO_1 = 1.5703125f;
+	const float PI_OVER_TWO_2 = 4.837512969970703125e-4f;
+	const float PI_OVER_TWO_3 = 7.54978995489188216e-8f;
+	// minimax polynomials for sine and cosine on [-pi/4, pi/4]
+	const float SIN_C1 = -1.6666654611e-1f;
+	const float SIN_C2 = 8.3321608736e-3f;
+	const float SIN_C3 = -1.9515295891e-4f;
+	const float COS_C1 = 4.166664568298827e-2f;
+	const float COS_C2 = -1.388731625493765e-3f;
+	const float COS_C3 = 2.443315711809948e-5f;
+
+	// largest allowed difference from the GLM matrices, per unit
+	// of scale, and the largest scale of the checked transforms
+	const float CHECK_TOLERANCE = 1.0e-5f;
+	const float CHECK_MAX_SCALE = 4.0f;
+
+	/***********************************************************
+	 *  ComposeScalar()
+	 *
+	 *  Build the matrices of a range of objects one at a time.
+	 *  The rotation matrix is the product X * Y * Z of the
+	 *  three axis rotations written out in closed form.
+	 ***********************************************************/
+	void ComposeScalar(const TransformBatch::TRANSFORM_ARRAYS& t, int first, int count, glm::mat4* matrices)
+	{
+		for (int i = first; i < first + count; i++)
+		{
+			float sx = std::sin(t.rotationX[i] * DEGREES_TO_RADIANS);
+			float cx = std::cos(t.rotationX[i] * DEGREES_TO_RADIANS);
+			float sy = std::sin(t.rotationY[i] * DEGREES_TO_RADIANS);
+			float cy = std::cos(t.rotationY[i] * DEGREES_TO_RADIANS);
+			float sz = std::sin(t.rotationZ[i] * DEGREES_TO_RADIANS);
+			float cz = std::cos(t.rotationZ[i] * DEGREES_TO_RADIANS);
+
+			glm::mat4& m = matrices[i];
+			m[0] = glm::vec4(cy * cz, cx * sz + sx * sy * cz, sx * sz - cx * sy * cz, 0.0f) * t.scaleX[i];
+			m[1] = glm::vec4(-cy * sz, cx * cz - sx * sy * sz, sx * cz + cx * sy * sz, 0.0f) * t.scaleY[i];
+			m[2] = glm::vec4(sy, -sx * cy, cx * cy, 0.0f) * t.scaleZ[i];
+			m[3] = glm::vec4(t.positionX[i], t.positionY[i], t.positionZ[i], 1.0f);
+		}
+	}
+
+	/***********************************************************
+	 *  SinCos4()
+	 *
+	 *  Calculate the sine and cosine of four angles in degrees.
+	 *  The angle is reduced to [-pi/4, pi/4] around the nearest
+	 *  multiple of pi / 2, and the quadrant of that multiple
+	 *  decides which polynomial and sign each result takes.
+	 ***********************************************************/
+	inline void SinCos4(__m128 degrees, __m128& sine, __m128& cosine)
+	{
+		__m128 x = _mm_mul_ps(degrees, _mm_set1_ps(DEGREES_TO_RADIANS));
+		__m128i quadrant = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(TWO_OVER_PI)));
+		__m128 j = _mm_cvtepi32_ps(quadrant);
+		x = _mm_sub_ps(x, _mm_mul_ps(j, _mm_set1_ps(PI_OVER_TWO_1)));
+		x = _mm_sub_ps(x, _mm_mul_ps(j, _mm_set1_ps(PI_OVER_TWO_2)));
+		x = _mm_sub_ps(x, _mm_mul_ps(j, _mm_set1_ps(PI_OVER_TWO_3)));
+
+		__m128 x2 = _mm_mul_ps(x, x);
+		__m128 s = _mm_add_ps(_mm_mul_ps(x2, _mm_set1_ps(SIN_C3)), _mm_set1_ps(SIN_C2));
+		s = _mm_add_ps(_mm_mul_ps(s, x2), _mm_set1_ps(SIN_C1));
+		s = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(s, x2), x), x);
+		__m128 c = _mm_add_ps(_mm_mul_ps(x2, _mm_set1_ps(COS_C3)), _mm_set1_ps(COS_C2));
+		c = _mm_add_ps(_mm_mul_ps(c, x2), _mm_set1_ps(COS_C1));
+		c = _mm_mul_ps(_mm_mul_ps(c, x2), x2);
+		c = _mm_add_ps(_mm_sub_ps(c, _mm_mul_ps(x2, _mm_set1_ps(0.5f))), _mm_set1_ps(1.0f));
+
+		// odd quadrants swap the sine and cosine
+		__m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(
+			_mm_and_si128(quadrant, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+		sine = _mm_or_ps(_mm_and_ps(swap, c), _mm_andnot_ps(swap, s));
+		cosine = _mm_or_ps(_mm_and_ps(swap, s), _mm_andnot_ps(swap, c));
+
+		// move bit 1 of the quadrant into the sign bit
+		__m128 sineSign = _mm_castsi128_ps(_mm_slli_epi32(
+			_mm_and_si128(quadrant, _mm_set1_epi32(2)), 30));
+		__m128 cosineSign = _mm_castsi128_ps(_mm_slli_epi32(
+			_mm_and_si128(_mm_add_epi32(quadrant, _mm_set1_epi32(1)), _mm_set1_epi32(2)), 30));
+		sine = _mm_xor_ps(sine, sineSign);
+		cosine = _mm_xor_ps(cosine, cosineSign);
+	}
+
+	/***********************************************************
+	 *  StoreColumn4()
+	 *
+	 *  Write one column of the matrices of four objects.  The
+	 *  inputs hold one row of the column for all four objects,
+	 *  so a transpose turns them into one column per object.
+	 ***********************************************************/
+	inline void StoreColumn4(__m128 x, __m128 y, __m128 z, __m128 w, glm::mat4* matrices, int column)
+	{
+		_MM_TRANSPOSE4_PS(x, y, z, w);
+		_mm_storeu_ps(&matrices[0][column][0], x);
+		_mm_storeu_ps(&matrices[1][column][0], y);
+		_mm_storeu_ps(&matrices[2][column][0], z);
+		_mm_storeu_ps(&matrices[3][column][0], w);
+	}
+
+	/***********************************************************
+	 *  ComposeSSE()
+	 *
+	 *  Build the matrices of four objects at a time with SSE2,
+	 *  which every x64 processor supports.
+	 ***********************************************************/
+	int ComposeSSE(const TransformBatch::TRANSFORM_ARRAYS& t, int count, glm::mat4* matrices)
+	{
+		int i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 sx, cx, sy, cy, sz, cz;
+			SinCos4(_mm_loadu_ps(t.rotationX + i), sx, cx);
+			SinCos4(_mm_loadu_ps(t.rotationY + i), sy, cy);
+			SinCos4(_mm_loadu_ps(t.rotationZ + i), sz, cz);
+			__m128 scaleX = _mm_loadu_ps(t.scaleX + i);
+			__m128 scaleY = _mm_loadu_ps(t.scaleY + i);
+			__m128 scaleZ = _mm_loadu_ps(t.scaleZ + i);
+			__m128 sxsy = _mm_mul_ps(sx, sy);
+			__m128 cxsy = _mm_mul_ps(cx, sy);
+			__m128 zero = _mm_setzero_ps();
+
+			StoreColumn4(
+				_mm_mul_ps(_mm_mul_ps(cy, cz), scaleX),
+				_mm_mul_ps(_mm_add_ps(_mm_mul_ps(cx, sz), _mm_mul_ps(sxsy, cz)), scaleX),
+				_mm_mul_ps(_mm_sub_ps(_mm_mul_ps(sx, sz), _mm_mul_ps(cxsy, cz)), scaleX),
+				zero, matrices + i, 0);
+			StoreColumn4(
+				_mm_mul_ps(_mm_sub_ps(zero, _mm_mul_ps(cy, sz)), scaleY),
+				_mm_mul_ps(_mm_sub_ps(_mm_mul_ps(cx, cz), _mm_mul_ps(sxsy, sz)), scaleY),
+				_mm_mul_ps(_mm_add_ps(_mm_mul_ps(sx, cz), _mm_mul_ps(cxsy, sz)), scaleY),
+				zero, matrices + i, 1);
+			StoreColumn4(
+				_mm_mul_ps(sy, scaleZ),
+				_mm_mul_ps(_mm_sub_ps(zero, _mm_mul_ps(sx, cy)), scaleZ),
+				_mm_mul_ps(_mm_mul_ps(cx, cy), scaleZ),
+				zero, matrices + i, 2);
+			StoreColumn4(
+				_mm_loadu_ps(t.positionX + i),
+				_mm_loadu_ps(t.positionY + i),
+				_mm_loadu_ps(t.positionZ + i),
+				_mm_set1_ps(1.0f), matrices + i, 3);
+		}
+		return i;
+	}
+
+	/***********************************************************
+	 *  SinCos8()
+	 *
+	 *  Calculate the sine and cosine of eight angles in degrees
+	 *  the same way as SinCos4(), with fused multiply adds.
+	 ***********************************************************/
+	TARGET_AVX2 inline void SinCos8(__m256 degrees, __m256& sine, __m256& cosine)
+	{
+		__m256 x = _mm256_mul_ps(degrees, _mm256_set1_ps(DEGREES_TO_RADIANS));
+		__m256i quadrant = _mm256_cvtps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(TWO_OVER_PI)));
+		__m256 j = _mm256_cvtepi32_ps(quadrant);
+		x = _mm256_fnmadd_ps(j, _mm256_set1_ps(PI_OVER_TWO_1), x);
+		x = _mm256_fnmadd_ps(j, _mm256_set1_ps(PI_OVER_TWO_2), x);
+		x = _mm256_fnmadd_ps(j, _mm256_set1_ps(PI_OVER_TWO_3), x);
+
+		__m256 x2 = _mm256_mul_ps(x, x);
+		__m256 s = _mm256_fmadd_ps(x2, _mm256_set1_ps(SIN_C3), _mm256_set1_ps(SIN_C2));
+		s = _mm256_fmadd_ps(s, x2, _mm256_set1_ps(SIN_C1));
+		s = _mm256_fmadd_ps(_mm256_mul_ps(s, x2), x, x);
+		__m256 c = _mm256_fmadd_ps(x2, _mm256_set1_ps(COS_C3), _mm256_set1_ps(COS_C2));
+		c = _mm256_fmadd_ps(c, x2, _mm256_set1_ps(COS_C1));
+		c = _mm256_mul_ps(_mm256_mul_ps(c, x2), x2);
+		c = _mm256_add_ps(_mm256_fnmadd_ps(x2, _mm256_set1_ps(0.5f), c), _mm256_set1_ps(1.0f));
+
+		// odd quadrants swap the sine and cosine
+		__m256 swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(
+			_mm256_and_si256(quadrant, _mm256_set1_epi32(1)), _mm256_set1_epi32(1)));
+		sine = _mm256_blendv_ps(s, c, swap);
+		cosine = _mm256_blendv_ps(c, s, swap);
+
+		// move bit 1 of the quadrant into the sign bit
+		__m256 sineSign = _mm256_castsi256_ps(_mm256_slli_epi32(
+			_mm256_and_si256(quadrant, _mm256_set1_epi32(2)), 30));
+		__m256 cosineSign = _mm256_castsi256_ps(_mm256_slli_epi32(
+			_mm256_and_si256(_mm256_add_epi32(quadrant, _mm256_set1_epi32(1)), _mm256_set1_epi32(2)), 30));
+		sine = _mm256_xor_ps(sine, sineSign);
+		cosine = _mm256_xor_ps(cosine, cosineSign);
+	}
+
+	/***********************************************************
+	 *  StoreColumn8()
+	 *
+	 *  Write one column of the matrices of eight objects, as two
+	 *  four object transposes of the lower and upper halves.
+	 ***********************************************************/
+	TARGET_AVX2 inline void StoreColumn8(__m256 x, __m256 y, __m256 z, __m256 w, glm::mat4* matrices, int column)
+	{
+		StoreColumn4(
+			_mm256_castps256_ps128(x), _mm256_castps256_ps128(y),
+			_mm256_castps256_ps128(z), _mm256_castps256_ps128(w),
+			matrices, column);
+		StoreColumn4(
+			_mm256_extractf128_ps(x, 1), _mm256_extractf128_ps(y, 1),
+			_mm256_extractf128_ps(z, 1), _mm256_extractf128_ps(w, 1),
+			matrices + 4, column);
+	}
+
+	/***********************************************************
+	 *  ComposeAVX2()
+	 *
+	 *  Build the matrices of eight objects at a time with AVX2
+	 *  and FMA.
+	 ***********************************************************/
+	TARGET_AVX2 int ComposeAVX2(const TransformBatch::TRANSFORM_ARRAYS& t, int count, glm::mat4* matrices)
+	{
+		int i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			__m256 sx, cx, sy, cy, sz, cz;
+			SinCos8(_mm256_loadu_ps(t.rotationX + i), sx, cx);
+			SinCos8(_mm256_loadu_ps(t.rotationY + i), sy, cy);
+			SinCos8(_mm256_loadu_ps(t.rotationZ + i), sz, cz);
+			__m256 scaleX = _mm256_loadu_ps(t.scaleX + i);
+			__m256 scaleY = _mm256_loadu_ps(t.scaleY + i);
+			__m256 scaleZ = _mm256_loadu_ps(t.scaleZ + i);
+			__m256 sxsy = _mm256_mul_ps(sx, sy);
+			__m256 cxsy = _mm256_mul_ps(cx, sy);
+			__m256 zero = _mm256_setzero_ps();
+
+			StoreColumn8(
+				_mm256_mul_ps(_mm256_mul_ps(cy, cz), scaleX),
+				_mm256_mul_ps(_mm256_fmadd_ps(sxsy, cz, _mm256_mul_ps(cx, sz)), scaleX),
+				_mm256_mul_ps(_mm256_fnmadd_ps(cxsy, cz, _mm256_mul_ps(sx, sz)), scaleX),
+				zero, matrices + i, 0);
+			StoreColumn8(
+				_mm256_mul_ps(_mm256_sub_ps(zero, _mm256_mul_ps(cy, sz)), scaleY),
+				_mm256_mul_ps(_mm256_fnmadd_ps(sxsy, sz, _mm256_mul_ps(cx, cz)), scaleY),
+				_mm256_mul_ps(_mm256_fmadd_ps(cxsy, sz, _mm256_mul_ps(sx, cz)), scaleY),
+				zero, matrices + i, 1);
+			StoreColumn8(
+				_mm256_mul_ps(sy, scaleZ),
+				_mm256_mul_ps(_mm256_sub_ps(zero, _mm256_mul_ps(sx, cy)), scaleZ),
+				_mm256_mul_ps(_mm256_mul_ps(cx, cy), scaleZ),
+				zero, matrices + i, 2);
+			StoreColumn8(
+				_mm256_loadu_ps(t.positionX + i),
+				_mm256_loadu_ps(t.positionY + i),
+				_mm256_loadu_ps(t.positionZ + i),
+				_mm256_set1_ps(1.0f), matrices + i, 3);
+		}
+		return i;
+	}
+
+	/***********************************************************
+	 *  DetectAVX2()
+	 *
+	 *  Check that the processor has AVX2 and FMA, and that the
+	 *  operating system saves the 256 bit registers.
+	 ***********************************************************/
+	bool DetectAVX2()
+	{
+#if defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7)
+		{
+			return false;
+		}
+		__cpuid(info, 1);
+		bool bFMA = (info[2] & (1 << 12)) != 0;
+		bool bOSXSAVE = (info[2] & (1 << 27)) != 0;
+		if (!bFMA || !bOSXSAVE || (_xgetbv(0) & 6) != 6)
+		{
+			return false;
+		}
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#else
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+	}
+
+	/***********************************************************
+	 *  MaxDifference()
+	 *
+	 *  Return the largest difference between the rotation and
+	 *  scale parts, the upper 3x3, of two lists of matrices.
+	 ***********************************************************/
+	float MaxDifference(const std::vector<glm::mat4>& a, const std::vector<glm::mat4>& b)
+	{
+		float maxDifference = 0.0f;
+		for (size_t i = 0; i < a.size(); i++)
+		{
+			for (int column = 0; column < 3; column++)
+			{
+				for (int row = 0; row < 3; row++)
+				{
+					maxDifference = std::max(maxDifference, std::fabs(a[i][column][row] - b[i][column][row]));
+				}
+			}
+		}
+		return maxDifference;
+	}
+
+	/***********************************************************
+	 *  IsSameTranslation()
+	 *
+	 *  Check that the translation columns and the bottom rows
+	 *  of two lists of matrices are exactly the same - they
+	 *  are copied, not computed, so they never differ.
+	 ***********************************************************/
+	bool IsSameTranslation(const std::vector<glm::mat4>& a, const std::vector<glm::mat4>& b)
+	{
+		for (size_t i = 0; i < a.size(); i++)
+		{
+			if (a[i][3] != b[i][3])
+			{
+				return false;
+			}
+			for (int column = 0; column < 3; column++)
+			{
+				if (a[i][column][3] != b[i][column][3])
+				{
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+}
+
+/***********************************************************
+ *  ComposeMatrices()
+ *
+ *  This method is used for building the model matrices of
+ *  a batch of objects with the best supported kernel.
+ ***********************************************************/
+void TransformBatch::ComposeMatrices(const TRANSFORM_ARRAYS& transforms, int count, glm::mat4* matrices)
+{
+	ComposeMatrices(GetBestKernel(), transforms, count, matrices);
+}
+
+/***********************************************************
+ *  ComposeMatrices()
+ *
+ *  This method is used for building the model matrices of
+ *  a batch of objects with one particular kernel.  The
+ *  objects left over after the last full SIMD batch are
+ *  finished by the scalar kernel.
+ ***********************************************************/
+bool TransformBatch::ComposeMatrices(KERNEL kernel, const TRANSFORM_ARRAYS& transforms, int count, glm::mat4* matrices)
+{
+	if (!IsKernelSupported(kernel))
+	{
+		return(false);
+	}
+
+	int done = 0;
+	if (kernel == KERNEL_AVX2)
+	{
+		done = ComposeAVX2(transforms, count, matrices);
+	}
+	else if (kernel == KERNEL_SSE)
+	{
+		done = ComposeSSE(transforms, count, matrices);
+	}
+	ComposeScalar(transforms, done, count - done, matrices);
+
+	return(true);
+}
+
+/***********************************************************
+ *  GetBestKernel()
+ *
+ *  This method is used for getting the fastest kernel the
+ *  processor supports, which is detected once.
+ ***********************************************************/
+TransformBatch::KERNEL TransformBatch::GetBestKernel()
+{
+	static const KERNEL bestKernel = DetectAVX2() ? KERNEL_AVX2 : KERNEL_SSE;
+	return(bestKernel);
+}
+
+/***********************************************************
+ *  IsKernelSupported()
+ *
+ *  This method is used for checking whether the processor
+ *  can run a kernel.
+ ***********************************************************/
+bool TransformBatch::IsKernelSupported(KERNEL kernel)
+{
+	return(kernel >= KERNEL_SCALAR && kernel <= GetBestKernel());
+}
+
+/***********************************************************
+ *  GetKernelName()
+ *
+ *  This method is used for getting the name of a kernel.
+ ***********************************************************/
+const char* TransformBatch::GetKernelName(KERNEL kernel)
+{
+	switch (kernel)
+	{
+	case KERNEL_SCALAR:
+		return("scalar");
+	case KERNEL_SSE:
+		return("sse2");
+	case KERNEL_AVX2:
+		return("avx2");
+	default:
+		return("unknown");
+	}
+}
+
+/***********************************************************
+ *  CheckKernels()
+ *
+ *  This method is used for comparing every supported kernel
+ *  against TransformHierarchy::ComposeMatrix() for a batch
+ *  of random transforms, and timing each of them.  The
+ *  angles cover several turns in both directions so every
+ *  quadrant of the sine and cosine is checked.
+ ***********************************************************/
+bool TransformBatch::CheckKernels(int count, std::string& report)
+{
+	std::mt19937 random(330);
+	std::uniform_real_distribution<float> angle(-720.0f, 720.0f);
+	std::uniform_real_distribution<float> scale(0.1f, CHECK_MAX_SCALE);
+	std::uniform_real_distribution<float> position(-50.0f, 50.0f);
+
+	// the transforms as structure of arrays
+	std::vector<float> values(9 * count);
+	for (size_t i = 0; i < values.size(); i++)
+	{
+		int component = (int)(i / count);
+		if (component < 3)
+		{
+			values[i] = scale(random);
+		}
+		else if (component < 6)
+		{
+			values[i] = angle(random);
+		}
+		else
+		{
+			values[i] = position(random);
+		}
+	}
+	TRANSFORM_ARRAYS transforms;
+	transforms.scaleX = &values[0 * count];
+	transforms.scaleY = &values[1 * count];
+	transforms.scaleZ = &values[2 * count];
+	transforms.rotationX = &values[3 * count];
+	transforms.rotationY = &values[4 * count];
+	transforms.rotationZ = &values[5 * count];
+	transforms.positionX = &values[6 * count];
+	transforms.positionY = &values[7 * count];
+	transforms.positionZ = &values[8 * count];
+
+	std::ostringstream output;
+	bool bPassed = true;
+
+	// the matrices built one at a time with GLM are the
+	// reference every kernel is measured against
+	std::vector<glm::mat4> expected(count);
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < count; i++)
+	{
+		expected[i] = TransformHierarchy::ComposeMatrix(
+			glm::vec3(transforms.scaleX[i], transforms.scaleY[i], transforms.scaleZ[i]),
+			glm::vec3(transforms.rotationX[i], transforms.rotationY[i], transforms.rotationZ[i]),
+			glm::vec3(transforms.positionX[i], transforms.positionY[i], transforms.positionZ[i]));
+	}
+	double referenceTime = std::chrono::duration<double, std::milli>(
+		std::chrono::high_resolution_clock::now() - start).count();
+	output << "glm     " << referenceTime << " ms for " << count << " objects\n";
+
+	std::vector<glm::mat4> matrices(count);
+	for (int kernel = KERNEL_SCALAR; kernel < KERNEL_COUNT; kernel++)
+	{
+		if (!IsKernelSupported((KERNEL)kernel))
+		{
+			output << GetKernelName((KERNEL)kernel) << "    not supported\n";
+			continue;
+		}
+
+		start = std::chrono::high_resolution_clock::now();
+		ComposeMatrices((KERNEL)kernel, transforms, count, &matrices[0]);
+		double kernelTime = std::chrono::duration<double, std::milli>(
+			std::chrono::high_resolution_clock::now() - start).count();
+
+		// only the rotation times the scale is computed, so the
+		// error grows with the scale and not with the position
+		float maxDifference = MaxDifference(expected, matrices);
+		bool bSameTranslation = IsSameTranslation(expected, matrices);
+		bool bKernelPassed = bSameTranslation && (maxDifference <= CHECK_TOLERANCE * CHECK_MAX_SCALE);
+		bPassed = bPassed && bKernelPassed;
+		output << GetKernelName((KERNEL)kernel) << "    " << kernelTime << " ms, "
+			<< referenceTime / std::max(kernelTime, 1.0e-6) << "x, max difference "
+			<< maxDifference << (bSameTranslation ? "" : ", translation differs")
+			<< (bKernelPassed ? "" : " FAILED") << "\n";
+	}
+
+	report = output.str();
+	return(bPassed);
+}
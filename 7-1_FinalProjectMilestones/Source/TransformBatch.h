@@ -0,0 +1,72 @@
+///////////////////////////////////////////////////////////////////////////////
+// transformbatch.h
+// ============
+// build the model matrices of many objects at once with SIMD kernels
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// GLM Math Header inclusions
+#include <glm/glm.hpp>
+
+#include <string>
+
+/***********************************************************
+ *  TransformBatch
+ *
+ *  This class turns the scale, rotation and position of
+ *  many objects into their model matrices - the same matrix
+ *  as TransformHierarchy::ComposeMatrix() - in one call.
+ *  The values are passed as structure of arrays, so a SIMD
+ *  kernel can load the same value of 4 or 8 objects into
+ *  one register.  The rotation matrix is written out in
+ *  closed form, and the sines and cosines come from a
+ *  polynomial that is evaluated for all lanes at once.  The
+ *  best kernel the processor supports is picked at runtime,
+ *  with a scalar kernel as the fallback.
+ ***********************************************************/
+class TransformBatch
+{
+public:
+	// the kernels that can build the matrices
+	enum KERNEL
+	{
+		KERNEL_SCALAR = 0,
+		KERNEL_SSE = 1,
+		KERNEL_AVX2 = 2,
+		KERNEL_COUNT
+	};
+
+	// the transforms of a batch of objects, one array for each
+	// component - rotations are in degrees around the X, Y
+	// and Z axes
+	struct TRANSFORM_ARRAYS
+	{
+		const float* scaleX;
+		const float* scaleY;
+		const float* scaleZ;
+		const float* rotationX;
+		const float* rotationY;
+		const float* rotationZ;
+		const float* positionX;
+		const float* positionY;
+		const float* positionZ;
+	};
+
+	// build the model matrices of a batch of objects with the
+	// best supported kernel
+	static void ComposeMatrices(const TRANSFORM_ARRAYS& transforms, int count, glm::mat4* matrices);
+	// build the model matrices with one particular kernel,
+	// returns false if the processor does not support it
+	static bool ComposeMatrices(KERNEL kernel, const TRANSFORM_ARRAYS& transforms, int count, glm::mat4* matrices);
+
+	// the fastest kernel the processor supports
+	static KERNEL GetBestKernel();
+	static bool IsKernelSupported(KERNEL kernel);
+	static const char* GetKernelName(KERNEL kernel);
+
+	// compare every supported kernel against the GLM matrices
+	// for a batch of random transforms and time them, returns
+	// false if any of them is off by more than the tolerance
+	static bool CheckKernels(int count, std::string& report);
+};
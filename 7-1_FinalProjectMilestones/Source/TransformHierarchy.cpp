@@ -0,0 +1,239 @@
+///////////////////////////////////////////////////////////////////////////////
+// transformhierarchy.cpp
+// ============
+// parent and child transforms with cached world matrices
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TransformHierarchy.h"
+#include "TransformBatch.h"
+
+#include <glm/gtx/transform.hpp>
+
+#include <algorithm>
+
+/***********************************************************
+ *  TransformHierarchy()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TransformHierarchy::TransformHierarchy()
+{
+	m_firstDirtyNode = 0;
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used to remove all of the nodes.
+ ***********************************************************/
+void TransformHierarchy::Clear()
+{
+	m_nodes.clear();
+	m_changedNodes.clear();
+	m_firstDirtyNode = 0;
+}
+
+/***********************************************************
+ *  AddNode()
+ *
+ *  This method is used to add a node with an identity
+ *  transform.  The parent must already be in the tree, which
+ *  keeps every parent in front of its children.
+ ***********************************************************/
+int TransformHierarchy::AddNode(int parent)
+{
+	TRANSFORM_NODE node;
+	node.parent = ((parent >= 0) && (parent < (int)m_nodes.size())) ? parent : NO_PARENT;
+	node.scale = glm::vec3(1.0f);
+	node.rotation = glm::vec3(0.0f);
+	node.position = glm::vec3(0.0f);
+	node.local = glm::mat4(1.0f);
+	node.world = glm::mat4(1.0f);
+	node.bLocalDirty = true;
+	node.bWorldChanged = false;
+	m_nodes.push_back(node);
+
+	int index = (int)m_nodes.size() - 1;
+	m_firstDirtyNode = std::min(m_firstDirtyNode, index);
+
+	return index;
+}
+
+/***********************************************************
+ *  SetLocalTransform()
+ *
+ *  This method is used to set the transform of a node
+ *  relative to its parent.  Setting the values it already
+ *  has does not mark it as changed.
+ ***********************************************************/
+void TransformHierarchy::SetLocalTransform(int node, const glm::vec3& scale, const glm::vec3& rotation, const glm::vec3& position)
+{
+	TRANSFORM_NODE& transform = m_nodes[node];
+	if ((transform.scale == scale) && (transform.rotation == rotation) && (transform.position == position))
+	{
+		return;
+	}
+
+	transform.scale = scale;
+	transform.rotation = rotation;
+	transform.position = position;
+	transform.bLocalDirty = true;
+	m_firstDirtyNode = std::min(m_firstDirtyNode, node);
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used to bring the cached world matrices up
+ *  to date.  Starting from the first changed node, a node is
+ *  recomputed when its own transform changed or its parent's
+ *  world matrix was just recomputed, so a change flows down
+ *  to all of the children below it.
+ ***********************************************************/
+int TransformHierarchy::Update()
+{
+	// clear the flags of the previous update
+	for (size_t i = 0; i < m_changedNodes.size(); i++)
+	{
+		m_nodes[m_changedNodes[i]].bWorldChanged = false;
+	}
+	m_changedNodes.clear();
+
+	ComposeDirtyLocals();
+
+	for (int i = m_firstDirtyNode; i < (int)m_nodes.size(); i++)
+	{
+		TRANSFORM_NODE& node = m_nodes[i];
+		bool bParentChanged = (node.parent != NO_PARENT) && m_nodes[node.parent].bWorldChanged;
+		if ((node.bLocalDirty == false) && (bParentChanged == false))
+		{
+			continue;
+		}
+
+		node.bLocalDirty = false;
+		node.world = (node.parent != NO_PARENT) ? m_nodes[node.parent].world * node.local : node.local;
+		node.bWorldChanged = true;
+		m_changedNodes.push_back(i);
+	}
+	m_firstDirtyNode = (int)m_nodes.size();
+
+	return (int)m_changedNodes.size();
+}
+
+/***********************************************************
+ *  ComposeDirtyLocals()
+ *
+ *  This method is used to rebuild the local matrices of all
+ *  of the changed nodes at once.  Their transforms are
+ *  gathered into one array per component and handed to the
+ *  SIMD kernels, which is much faster than composing the
+ *  rotations one node at a time when many objects move.
+ ***********************************************************/
+void TransformHierarchy::ComposeDirtyLocals()
+{
+	m_batchNodes.clear();
+	for (int i = m_firstDirtyNode; i < (int)m_nodes.size(); i++)
+	{
+		if (m_nodes[i].bLocalDirty)
+		{
+			m_batchNodes.push_back(i);
+		}
+	}
+
+	int count = (int)m_batchNodes.size();
+	if (count == 0)
+	{
+		return;
+	}
+
+	m_batchValues.resize(9 * count);
+	m_batchMatrices.resize(count);
+	float* values = &m_batchValues[0];
+	for (int i = 0; i < count; i++)
+	{
+		const TRANSFORM_NODE& node = m_nodes[m_batchNodes[i]];
+		for (int axis = 0; axis < 3; axis++)
+		{
+			values[axis * count + i] = node.scale[axis];
+			values[(3 + axis) * count + i] = node.rotation[axis];
+			values[(6 + axis) * count + i] = node.position[axis];
+		}
+	}
+
+	TransformBatch::TRANSFORM_ARRAYS transforms;
+	transforms.scaleX = values;
+	transforms.scaleY = values + count;
+	transforms.scaleZ = values + 2 * count;
+	transforms.rotationX = values + 3 * count;
+	transforms.rotationY = values + 4 * count;
+	transforms.rotationZ = values + 5 * count;
+	transforms.positionX = values + 6 * count;
+	transforms.positionY = values + 7 * count;
+	transforms.positionZ = values + 8 * count;
+	TransformBatch::ComposeMatrices(transforms, count, &m_batchMatrices[0]);
+
+	for (int i = 0; i < count; i++)
+	{
+		m_nodes[m_batchNodes[i]].local = m_batchMatrices[i];
+	}
+}
+
+/***********************************************************
+ *  GetChangedNodes()
+ *
+ *  This method is used to get the nodes whose world matrix
+ *  was recomputed by the last update, in tree order.
+ ***********************************************************/
+const std::vector<int>& TransformHierarchy::GetChangedNodes() const
+{
+	return m_changedNodes;
+}
+
+/***********************************************************
+ *  GetNodeCount()
+ *
+ *  This method is used to get the number of nodes.
+ ***********************************************************/
+int TransformHierarchy::GetNodeCount() const
+{
+	return (int)m_nodes.size();
+}
+
+/***********************************************************
+ *  GetParent()
+ *
+ *  This method is used to get the parent of a node, or
+ *  NO_PARENT for a node at the top of the tree.
+ ***********************************************************/
+int TransformHierarchy::GetParent(int node) const
+{
+	return m_nodes[node].parent;
+}
+
+/***********************************************************
+ *  GetWorldMatrix()
+ *
+ *  This method is used to get the cached world matrix of a
+ *  node, as of the last update.
+ ***********************************************************/
+const glm::mat4& TransformHierarchy::GetWorldMatrix(int node) const
+{
+	return m_nodes[node].world;
+}
+
+/***********************************************************
+ *  ComposeMatrix()
+ *
+ *  This method is used to build a transform matrix from a
+ *  scale, rotations in degrees and a position.  The object
+ *  is scaled first, then rotated around the Z, Y and X axes
+ *  and then moved into place.
+ ***********************************************************/
+glm::mat4 TransformHierarchy::ComposeMatrix(const glm::vec3& scale, const glm::vec3& rotation, const glm::vec3& position)
+{
+	glm::mat4 rotationX = glm::rotate(glm::radians(rotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
+	glm::mat4 rotationY = glm::rotate(glm::radians(rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
+	glm::mat4 rotationZ = glm::rotate(glm::radians(rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
+
+	return glm::translate(position) * rotationX * rotationY * rotationZ * glm::scale(scale);
+}
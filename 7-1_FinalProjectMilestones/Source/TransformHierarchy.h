@@ -0,0 +1,91 @@
+///////////////////////////////////////////////////////////////////////////////
+// transformhierarchy.h
+// ============
+// parent and child transforms with cached world matrices
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// GLM Math Header inclusions
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  TransformHierarchy
+ *
+ *  This class keeps the transforms of the scene objects as
+ *  a tree of nodes in one flat array.  Every node is added
+ *  after its parent, so walking the array in order always
+ *  reaches a parent before its children.  The local and
+ *  world matrix of every node is cached, and a node is only
+ *  recomputed when its own transform was changed or the
+ *  world matrix of its parent was.  When nothing changed
+ *  since the last update, updating does no work at all.
+ ***********************************************************/
+class TransformHierarchy
+{
+public:
+	// parent index of a node that has no parent
+	static const int NO_PARENT = -1;
+
+	// constructor
+	TransformHierarchy();
+
+	// remove all of the nodes
+	void Clear();
+	// add a node under a parent that was added before it, or
+	// NO_PARENT, and return its index
+	int AddNode(int parent);
+	// set the scale, the rotation in degrees around the X, Y
+	// and Z axes and the position of a node relative to its
+	// parent - the node is only marked as changed when one of
+	// the values differs
+	void SetLocalTransform(int node, const glm::vec3& scale, const glm::vec3& rotation, const glm::vec3& position);
+
+	// recompute the world matrices of the changed nodes and
+	// of everything below them, returns the number of nodes
+	// whose world matrix was recomputed
+	int Update();
+	// the nodes whose world matrix changed in the last update
+	const std::vector<int>& GetChangedNodes() const;
+
+	int GetNodeCount() const;
+	int GetParent(int node) const;
+	const glm::mat4& GetWorldMatrix(int node) const;
+
+	// build the matrix that scales, then rotates around the X,
+	// Y and Z axes and then moves by the passed in values
+	static glm::mat4 ComposeMatrix(const glm::vec3& scale, const glm::vec3& rotation, const glm::vec3& position);
+
+private:
+	// one transform of the tree
+	struct TRANSFORM_NODE
+	{
+		int parent;
+		glm::vec3 scale;
+		glm::vec3 rotation;
+		glm::vec3 position;
+		glm::mat4 local;
+		glm::mat4 world;
+		// the local values changed since the last update
+		bool bLocalDirty;
+		// the world matrix changed in the last update
+		bool bWorldChanged;
+	};
+
+	std::vector<TRANSFORM_NODE> m_nodes;
+	// the changed local transforms gathered as structure of
+	// arrays, so their matrices are built in one SIMD batch
+	std::vector<int> m_batchNodes;
+	std::vector<float> m_batchValues;
+	std::vector<glm::mat4> m_batchMatrices;
+	// first node changed since the last update - the nodes
+	// before it can not be affected by the change, and it is
+	// the node count when nothing changed
+	int m_firstDirtyNode;
+	std::vector<int> m_changedNodes;
+
+	// rebuild the local matrices of the changed nodes
+	void ComposeDirtyLocals();
+};
@@ -1,46 +1,61 @@
-///////////////////////////////////////////////////////////////////////////////
-// viewmanager.h
-// ============
-// manage the viewing of 3D objects within the viewport
-//
-//  AUTHOR: Brian Battersby - SNHU Instructor / Computer Science
-//	Created for CS-330-Computational Graphics and Visualization, Nov. 1st, 2023
-///////////////////////////////////////////////////////////////////////////////
-
-#pragma once
-
-#include "ShaderManager.h"
-#include "camera.h"
-
-// GLFW library
-#include "GLFW/glfw3.h"
-
-class ViewManager
-{
-public:
-    // constructor
-    ViewManager(ShaderManager* pShaderManager);
-    // destructor
-    ~ViewManager();
-
-    // mouse position callback for mouse interaction with the 3D scene
-    static void Mouse_Position_Callback(GLFWwindow* window, double xMousePos, double yMousePos);
-    // scroll callback for adjusting camera speed
-    static void Scroll_Callback(GLFWwindow* window, double xOffset, double yOffset);
-
-private:
-    // pointer to shader manager object
-    ShaderManager* m_pShaderManager;
-    // active OpenGL display window
-    GLFWwindow* m_pWindow;
-
-    // process keyboard events for interaction with the 3D scene
-    void ProcessKeyboardEvents();
-
-public:
-    // create the initial OpenGL display window
-    GLFWwindow* CreateDisplayWindow(const char* windowTitle);
-
-    // prepare the conversion from 3D object display to 2D scene display
-    void PrepareSceneView();
+///////////////////////////////////////////////////////////////////////////////
+// viewmanager.h
+// ============
+// manage the viewing of 3D objects within the viewport
+//
+//  AUTHOR: Brian Battersby - SNHU Instructor / Computer Science
+//	Created for CS-330-Computational Graphics and Visualization, Nov. 1st, 2023
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+#include "camera.h"
+
+// GLFW library
+#include "GLFW/glfw3.h"
+
+class ViewManager
+{
+public:
+    // constructor
+    ViewManager(ShaderManager* pShaderManager);
+    // destructor
+    ~ViewManager();
+
+    // mouse position callback for mouse interaction with the 3D scene
+    static void Mouse_Position_Callback(GLFWwindow* window, double xMousePos, double yMousePos);
+    // scroll callback for adjusting camera speed
+    static void Scroll_Callback(GLFWwindow* window, double xOffset, double yOffset);
+
+private:
+    // pointer to shader manager object
+    ShaderManager* m_pShaderManager;
+    // active OpenGL display window
+    GLFWwindow* m_pWindow;
+    // camera matrices of the most recently prepared view
+    glm::mat4 m_viewMatrix;
+    glm::mat4 m_projectionMatrix;
+    // use the orthographic projection in place of the camera's
+    // perspective one
+    bool m_bOrthographic;
+
+    // process keyboard events for interaction with the 3D scene
+    void ProcessKeyboardEvents();
+
+public:
+    // create the initial OpenGL display window
+    GLFWwindow* CreateDisplayWindow(const char* windowTitle);
+
+    // prepare the conversion from 3D object display to 2D scene display
+    void PrepareSceneView();
+
+    // get the camera matrices of the most recently prepared view
+    const glm::mat4& GetViewMatrix() const;
+    const glm::mat4& GetProjectionMatrix() const;
+    // switch between the perspective and orthographic projection
+    void SetOrthographic(bool bOrthographic);
+    bool IsOrthographic() const;
+    // move the camera, used for the camera of a scene file
+    void SetCamera(const glm::vec3& position, const glm::vec3& front, float zoom);
 };
\ No newline at end of file
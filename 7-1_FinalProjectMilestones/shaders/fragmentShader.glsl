@@ -0,0 +1,343 @@
+///////////////////////////////////////////////////////////////////////////////
+// fragmentShader.glsl
+// ============
+// shade the scene with clustered Phong lighting, shadows, textures and
+// indexed materials
+//
+// ShaderManager::GetVariant() defines the features of each variant of the
+// program after the #version line - USE_TEXTURE, USE_LIGHTING,
+// USE_ALPHA_TEST, USE_SHADOW_DEPTH, USE_GBUFFER and USE_DEFERRED_LIGHTING -
+// so no fragment branches on what the draw uses
+//
+// The deferred path draws the opaque objects with USE_GBUFFER, which keeps
+// the surface instead of lighting it, and then lights every pixel once
+// with USE_DEFERRED_LIGHTING, reading the surface back from the G-buffer
+///////////////////////////////////////////////////////////////////////////////
+
+#version 430 core
+
+// must match MAX_OBJECT_MATERIALS in SceneManager.cpp
+#define MAX_OBJECT_MATERIALS 256
+// must match TextureArrays::MAX_TEXTURE_ARRAYS
+#define MAX_TEXTURE_ARRAYS 8
+// must match the cluster grid in ClusteredLights.h
+#define CLUSTER_TILES_X 16
+#define CLUSTER_TILES_Y 9
+#define CLUSTER_DEPTH_SLICES 24
+// must match ShadowMaps::MAX_CUBE_SHADOWS
+#define MAX_CUBE_SHADOWS 2
+// alpha below which an alpha tested fragment is cut out
+#define ALPHA_TEST_CUTOFF 0.5f
+
+// material layout in the std140 material block:
+// ambientColor.rgb + ambientStrength, diffuseColor.rgb,
+// specularColor.rgb + shininess
+struct Material
+{
+	vec4 ambientColor;
+	vec4 diffuseColor;
+	vec4 specularColor;
+};
+
+// must match ClusteredLights::POINT_LIGHT
+struct LightSource
+{
+	vec3 position;
+	float range;
+	vec3 ambientColor;
+	float focalStrength;
+	vec3 diffuseColor;
+	float specularIntensity;
+	vec3 specularColor;
+	float padding;
+};
+
+#ifdef USE_DEFERRED_LIGHTING
+// the matrices that turn the depth of a pixel back into its
+// position in the world
+flat in mat4 fragmentInverseProjection;
+flat in mat4 fragmentInverseView;
+#else
+in vec3 fragmentPosition;
+in vec3 fragmentVertexNormal;
+in vec2 fragmentTextureCoordinate;
+in float fragmentViewDepth;
+flat in vec4 fragmentObjectColor;
+flat in vec2 fragmentUVscale;
+// texture array (-1 for the color), texture layer and material
+// of the instance - the texture array is the same for every
+// instance of a draw, so indexing the samplers with it stays
+// dynamically uniform
+flat in ivec3 fragmentInstanceIndices;
+#endif
+
+// the color, or the base color and material index of the
+// surface for the G-buffer
+layout (location = 0) out vec4 outFragmentColor;
+#ifdef USE_GBUFFER
+// the normal of the surface, and 1 in the alpha when it is lit
+layout (location = 1) out vec4 outFragmentNormal;
+#endif
+
+// every material of the scene, uploaded once when defined - the
+// binding must match MATERIAL_BLOCK_BINDING in SceneManager.cpp
+layout (std140, binding = 0) uniform MaterialBlock
+{
+	Material materials[MAX_OBJECT_MATERIALS];
+};
+
+// values of the frame shared by every variant of the program -
+// must match SceneManager::FRAME_UNIFORMS.  The cluster
+// parameters are the tile size in pixels, and the scale and bias
+// that turn the log of the view depth into a depth slice
+layout (std140, binding = 1) uniform FrameBlock
+{
+	mat4 view;
+	mat4 projection;
+	vec4 viewPosition;
+	vec4 clusterParameters;
+};
+
+// every texture array stays bound to its own unit, starting at
+// TextureArrays::FIRST_TEXTURE_UNIT, and each instance selects an
+// array and a layer in it
+layout (binding = 0) uniform sampler2DArray objectTextures[MAX_TEXTURE_ARRAYS];
+
+// the lights that cast shadows, as indices into the light buffer
+// or -1 for an unused map, the matrix of the overhead map, the
+// distance and the offset along the normal, per unit of distance
+// from the light, that keep a surface from shadowing itself, and
+// the matrix of every cube map face - must match
+// ShadowMaps::SHADOW_UNIFORMS
+layout (std140, binding = 2) uniform ShadowBlock
+{
+	ivec4 cubeShadowLights;
+	ivec4 overheadShadowLight;
+	mat4 overheadShadowMatrix;
+	vec4 shadowBias;
+	mat4 cubeShadowMatrices[MAX_CUBE_SHADOWS * 6];
+};
+
+// the distance from each shadow casting light to the nearest
+// caster, over the light's range, with the six faces of each cube
+// map as layers +x -x +y -y +z -z - the units must match
+// ShadowMaps::CUBE_TEXTURE_UNIT and OVERHEAD_TEXTURE_UNIT
+layout (binding = 8) uniform sampler2DArrayShadow cubeShadowMaps;
+layout (binding = 9) uniform sampler2DShadow overheadShadowMap;
+
+#ifdef USE_DEFERRED_LIGHTING
+// the surfaces the deferred path lights, written by the USE_GBUFFER
+// variants - the units must match DeferredShading::ALBEDO_TEXTURE_UNIT,
+// NORMAL_TEXTURE_UNIT and DEPTH_TEXTURE_UNIT
+layout (binding = 10) uniform sampler2D gBufferAlbedo;
+layout (binding = 11) uniform sampler2D gBufferNormal;
+layout (binding = 12) uniform sampler2D gBufferDepth;
+#endif
+
+// every light of the scene
+layout (std430, binding = 1) readonly buffer LightBuffer
+{
+	LightSource lightSources[];
+};
+
+// offset and count of the light list of every cluster
+layout (std430, binding = 2) readonly buffer ClusterBuffer
+{
+	uvec2 clusterRanges[];
+};
+
+// the light lists of all the clusters, one after another
+layout (std430, binding = 3) readonly buffer LightIndexBuffer
+{
+	uint lightIndices[];
+};
+
+uint FindCluster(float viewDepth);
+vec3 CalcLighting(Material material, vec3 position, vec3 lightNormal, float viewDepth);
+float CalcShadow(int lightIndex, LightSource light, vec3 position, vec3 lightNormal);
+vec3 CalcLightSource(LightSource light, Material material, vec3 lightNormal, vec3 vertexPosition, vec3 viewDirection, float shadow);
+
+#ifdef USE_DEFERRED_LIGHTING
+void main()
+{
+	ivec2 pixel = ivec2(gl_FragCoord.xy);
+	float depth = texelFetch(gBufferDepth, pixel, 0).r;
+	// nothing was drawn here, so the clear color stays
+	if (depth >= 1.0f)
+	{
+		discard;
+	}
+
+	vec4 albedo = texelFetch(gBufferAlbedo, pixel, 0);
+	vec4 normal = texelFetch(gBufferNormal, pixel, 0);
+	if (normal.a < 0.5f)
+	{
+		outFragmentColor = vec4(albedo.rgb, 1.0f);
+		return;
+	}
+
+	// back from the depth of the pixel to the view and the world
+	vec2 screenCoordinate = (vec2(pixel) + 0.5f) / vec2(textureSize(gBufferDepth, 0));
+	vec4 viewSpacePosition = fragmentInverseProjection * vec4(vec3(screenCoordinate, depth) * 2.0f - 1.0f, 1.0f);
+	viewSpacePosition /= viewSpacePosition.w;
+	vec3 position = vec3(fragmentInverseView * viewSpacePosition);
+
+	Material material = materials[int(albedo.a * 255.0f + 0.5f)];
+	vec3 phongResult = CalcLighting(material, position, normalize(normal.xyz * 2.0f - 1.0f), -viewSpacePosition.z);
+	outFragmentColor = vec4(phongResult * albedo.rgb, 1.0f);
+}
+#else
+void main()
+{
+#ifdef USE_TEXTURE
+	vec3 arrayCoordinate = vec3(fragmentTextureCoordinate * fragmentUVscale, float(fragmentInstanceIndices.y));
+	vec4 baseColor = texture(objectTextures[fragmentInstanceIndices.x], arrayCoordinate);
+#else
+	vec4 baseColor = fragmentObjectColor;
+#endif
+
+#ifdef USE_ALPHA_TEST
+	// cut out the see-through parts instead of blending them
+	if (baseColor.a < ALPHA_TEST_CUTOFF)
+	{
+		discard;
+	}
+#endif
+
+#if defined(USE_SHADOW_DEPTH)
+	// the views of a light hold its position and range in place
+	// of the camera position, and its maps store the distance to
+	// the light over the range
+	gl_FragDepth = length(fragmentPosition - viewPosition.xyz) / viewPosition.w;
+#elif defined(USE_GBUFFER)
+	// the material index takes the 8 bits of the alpha, which
+	// holds every one of the MAX_OBJECT_MATERIALS
+	outFragmentColor = vec4(baseColor.rgb, float(fragmentInstanceIndices.z) / 255.0f);
+#ifdef USE_LIGHTING
+	outFragmentNormal = vec4(normalize(fragmentVertexNormal) * 0.5f + 0.5f, 1.0f);
+#else
+	outFragmentNormal = vec4(0.5f, 0.5f, 0.5f, 0.0f);
+#endif
+#elif defined(USE_LIGHTING)
+	Material material = materials[fragmentInstanceIndices.z];
+	vec3 phongResult = CalcLighting(material, fragmentPosition, normalize(fragmentVertexNormal), fragmentViewDepth);
+
+#ifdef USE_TEXTURE
+	// textured objects are always drawn opaque
+	outFragmentColor = vec4(phongResult * baseColor.rgb, 1.0f);
+#else
+	outFragmentColor = vec4(phongResult * baseColor.rgb, baseColor.a);
+#endif
+#else
+	outFragmentColor = baseColor;
+#endif
+}
+#endif
+
+uint FindCluster(float viewDepth)
+{
+	uvec2 tile = uvec2(gl_FragCoord.xy / clusterParameters.xy);
+	int slice = int(floor(log(viewDepth) * clusterParameters.z + clusterParameters.w));
+
+	tile = min(tile, uvec2(CLUSTER_TILES_X - 1, CLUSTER_TILES_Y - 1));
+	uint depthSlice = uint(clamp(slice, 0, CLUSTER_DEPTH_SLICES - 1));
+
+	return tile.x + tile.y * CLUSTER_TILES_X + depthSlice * CLUSTER_TILES_X * CLUSTER_TILES_Y;
+}
+
+vec3 CalcLighting(Material material, vec3 position, vec3 lightNormal, float viewDepth)
+{
+	vec3 phongResult = vec3(0.0f);
+	vec3 viewDirection = normalize(viewPosition.xyz - position);
+
+	// only the lights whose range touches this cluster
+	uvec2 clusterRange = clusterRanges[FindCluster(viewDepth)];
+	for (uint i = 0u; i < clusterRange.y; i++)
+	{
+		uint lightIndex = lightIndices[clusterRange.x + i];
+		LightSource light = lightSources[lightIndex];
+		float shadow = CalcShadow(int(lightIndex), light, position, lightNormal);
+		phongResult += CalcLightSource(light, material, lightNormal, position, viewDirection, shadow);
+	}
+
+	return phongResult;
+}
+
+float CalcShadow(int lightIndex, LightSource light, vec3 position, vec3 lightNormal)
+{
+	// move the surface off itself along its normal, farther from
+	// the light where the texels of the maps are larger
+	float lightDistance = length(position - light.position);
+	vec3 shadowPosition = position + lightNormal * (shadowBias.y * lightDistance);
+	vec3 lightToPosition = shadowPosition - light.position;
+	float depth = (length(lightToPosition) - shadowBias.x) / light.range;
+
+	int cubeMap = -1;
+	for (int i = 0; i < MAX_CUBE_SHADOWS; i++)
+	{
+		if (cubeShadowLights[i] == lightIndex)
+		{
+			cubeMap = i;
+		}
+	}
+	if (cubeMap >= 0)
+	{
+		// the face is the one facing along the major axis
+		vec3 axis = abs(lightToPosition);
+		int face = 0;
+		if ((axis.x >= axis.y) && (axis.x >= axis.z))
+		{
+			face = (lightToPosition.x >= 0.0f) ? 0 : 1;
+		}
+		else if (axis.y >= axis.z)
+		{
+			face = (lightToPosition.y >= 0.0f) ? 2 : 3;
+		}
+		else
+		{
+			face = (lightToPosition.z >= 0.0f) ? 4 : 5;
+		}
+		int layer = cubeMap * 6 + face;
+		vec4 mapPosition = cubeShadowMatrices[layer] * vec4(shadowPosition, 1.0f);
+		vec2 mapCoordinate = (mapPosition.xy / mapPosition.w) * 0.5f + 0.5f;
+		return texture(cubeShadowMaps, vec4(mapCoordinate, float(layer), depth));
+	}
+
+	if (overheadShadowLight.x == lightIndex)
+	{
+		vec4 mapPosition = overheadShadowMatrix * vec4(shadowPosition, 1.0f);
+		vec2 mapCoordinate = (mapPosition.xy / mapPosition.w) * 0.5f + 0.5f;
+		// nothing outside of the overhead map casts a shadow
+		if ((mapPosition.w <= 0.0f) || any(lessThan(mapCoordinate, vec2(0.0f))) || any(greaterThan(mapCoordinate, vec2(1.0f))))
+		{
+			return 1.0f;
+		}
+		return texture(overheadShadowMap, vec3(mapCoordinate, depth));
+	}
+
+	return 1.0f;
+}
+
+vec3 CalcLightSource(LightSource light, Material material, vec3 lightNormal, vec3 vertexPosition, vec3 viewDirection, float shadow)
+{
+	// fade the light out smoothly to nothing at its range
+	float distanceRatio = length(light.position - vertexPosition) / light.range;
+	float falloff = clamp(1.0f - pow(distanceRatio, 4.0f), 0.0f, 1.0f);
+	falloff *= falloff;
+
+	// ambient lighting
+	vec3 ambient = light.ambientColor * material.ambientColor.rgb * material.ambientColor.a;
+
+	// diffuse lighting
+	vec3 lightDirection = normalize(light.position - vertexPosition);
+	float impact = max(dot(lightNormal, lightDirection), 0.0f);
+	vec3 diffuse = impact * light.diffuseColor * material.diffuseColor.rgb;
+
+	// specular lighting
+	vec3 reflectDirection = reflect(-lightDirection, lightNormal);
+	float specularComponent = pow(max(dot(viewDirection, reflectDirection), 0.0f), light.focalStrength);
+	vec3 specular = light.specularIntensity * specularComponent * light.specularColor * material.specularColor.rgb;
+
+	// the shadow only hides the direct light
+	return (ambient + (diffuse + specular) * shadow) * falloff;
+}
@@ -0,0 +1,91 @@
+///////////////////////////////////////////////////////////////////////////////
+// vertexShader.glsl
+// ============
+// transform the scene vertices into clip space for the lighting shader
+//
+// ShaderManager::GetVariant() defines the features of each variant of the
+// program after the #version line - USE_TEXTURE, USE_LIGHTING,
+// USE_ALPHA_TEST, USE_SHADOW_DEPTH, which draws the scene into the
+// views of a light, USE_GBUFFER and USE_DEFERRED_LIGHTING, which draws one
+// triangle over the whole screen instead of the meshes
+///////////////////////////////////////////////////////////////////////////////
+
+#version 430 core
+
+layout (location = 0) in vec3 inVertexPosition;
+layout (location = 1) in vec3 inVertexNormal;
+layout (location = 2) in vec2 inTextureCoordinate;
+// values of the drawn instance - must match
+// ShapeMeshes::INSTANCE_DATA, the matrix takes locations 3 to 6
+layout (location = 3) in mat4 inInstanceModel;
+layout (location = 7) in vec4 inInstanceColor;
+layout (location = 8) in vec2 inInstanceUVscale;
+// texture array (-1 for the color), texture layer and material
+layout (location = 9) in ivec3 inInstanceIndices;
+// scale and offset that turn the stored positions of the mesh
+// into its own space, for the packed vertex format
+layout (location = 10) in vec4 inInstancePositionScale;
+layout (location = 11) in vec4 inInstancePositionOffset;
+
+#ifdef USE_DEFERRED_LIGHTING
+// the matrices that turn the depth of a pixel back into its
+// position in the world
+flat out mat4 fragmentInverseProjection;
+flat out mat4 fragmentInverseView;
+#else
+out vec3 fragmentPosition;
+out vec3 fragmentVertexNormal;
+out vec2 fragmentTextureCoordinate;
+// distance in front of the camera, used to find the light cluster
+out float fragmentViewDepth;
+// the instance values the fragment shader needs
+flat out vec4 fragmentObjectColor;
+flat out vec2 fragmentUVscale;
+flat out ivec3 fragmentInstanceIndices;
+#endif
+
+// values of the frame shared by every variant of the program -
+// must match SceneManager::FRAME_UNIFORMS
+layout (std140, binding = 1) uniform FrameBlock
+{
+	mat4 view;
+	mat4 projection;
+	vec4 viewPosition;
+	vec4 clusterParameters;
+};
+
+#ifdef USE_DEFERRED_LIGHTING
+void main()
+{
+	// vertices 0, 1 and 2 make one triangle that covers the
+	// screen, without any vertex buffer
+	vec2 corner = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+	gl_Position = vec4(corner * 2.0f - 1.0f, 0.0f, 1.0f);
+
+	fragmentInverseProjection = inverse(projection);
+	fragmentInverseView = inverse(view);
+}
+#else
+void main()
+{
+	vec3 meshPosition = inVertexPosition * inInstancePositionScale.xyz + inInstancePositionOffset.xyz;
+	// world space position for the lighting calculations
+	fragmentPosition = vec3(inInstanceModel * vec4(meshPosition, 1.0f));
+#ifdef USE_LIGHTING
+	// keep the normals perpendicular under non-uniform scaling
+	fragmentVertexNormal = mat3(transpose(inverse(inInstanceModel))) * inVertexNormal;
+#else
+	fragmentVertexNormal = inVertexNormal;
+#endif
+	fragmentTextureCoordinate = inTextureCoordinate;
+
+	fragmentObjectColor = inInstanceColor;
+	fragmentUVscale = inInstanceUVscale;
+	fragmentInstanceIndices = inInstanceIndices;
+
+	vec4 viewSpacePosition = view * vec4(fragmentPosition, 1.0f);
+	fragmentViewDepth = -viewSpacePosition.z;
+
+	gl_Position = projection * viewSpacePosition;
+}
+#endif